@@ -1,7 +1,7 @@
 cmake_minimum_required (VERSION 3.22)
 
 function(raoe_add_cog)
-    set(options STATIC SHARED NO_GENERATED_COG NOT_CPP20)
+    set(options STATIC SHARED NO_GENERATED_COG NOT_CPP20 MAIN_THREAD)
     set(oneValueArgs NAME NAMESPACE)
     set(multiValueArgs CPP_SOURCE_FILES INCLUDE_DIRECTORIES GEARS COMPILE_DEFINITIONS DEPENDENCIES)
 
@@ -20,7 +20,12 @@ function(raoe_add_cog)
             ${raoe_add_cog_CPP_SOURCE_FILES}
         )        
     elseif(raoe_add_cog_SHARED)
-        message(FATAL_ERROR "Not Implemented")
+        add_library("${COG_LIBRARY_NAME}"
+            SHARED
+            ${raoe_add_cog_CPP_SOURCE_FILES}
+        )
+        #The manifest names the file, so keep it the same on every platform
+        set_target_properties(${COG_LIBRARY_NAME} PROPERTIES PREFIX "")
     else()
         message(FATAL_ERROR "Must Have Static or Shared")
     endif()
@@ -32,8 +37,25 @@ function(raoe_add_cog)
     set(raoe_cog_library_alias "Cog::${raoe_add_cog_NAME}")
     add_library("${raoe_cog_library_alias}" ALIAS ${COG_LIBRARY_NAME})
 
+    #The Cog:: dependencies are the cogs this one needs up first, at runtime as well as at link time
+    set(cog_dependency_names "")
+    foreach(cog_dependency ${raoe_add_cog_DEPENDENCIES})
+        if(cog_dependency MATCHES "^Cog::(.+)$")
+            list(APPEND cog_dependency_names ${CMAKE_MATCH_1})
+        endif()
+    endforeach()
+
     if(raoe_add_cog_STATIC)     
         set_property(GLOBAL APPEND PROPERTY RAOE_ALL_STATIC_COGS ${raoe_cog_library_alias})
+    else()
+        #Shared cogs go in the manifest, with the cogs they depend on, so the CogService can load them (and their dependencies) on demand
+        set(cog_manifest_dependencies "")
+        foreach(cog_dependency_name ${cog_dependency_names})
+            string(APPEND cog_manifest_dependencies " ${cog_dependency_name}")
+        endforeach()
+        set_property(GLOBAL APPEND PROPERTY RAOE_ALL_SHARED_COGS ${COG_LIBRARY_NAME})
+        set_property(GLOBAL APPEND PROPERTY RAOE_SHARED_COG_MANIFEST_LINES
+            "${raoe_add_cog_NAME} $<TARGET_FILE_NAME:${COG_LIBRARY_NAME}>${cog_manifest_dependencies}")
     endif()
 
     #add include directories    
@@ -47,13 +69,28 @@ function(raoe_add_cog)
     endif()
 
     #add dependencies, always depending on raoe::engine
-    target_link_libraries(
-    ${COG_LIBRARY_NAME}
-    ${raoe_add_cog_DEPENDENCIES}
-    PUBLIC    
-        raoe::core
-        raoe::engine
-    )
+    if(raoe_add_cog_STATIC)
+        target_link_libraries(
+        ${COG_LIBRARY_NAME}
+        ${raoe_add_cog_DEPENDENCIES}
+        PUBLIC    
+            raoe::core
+            raoe::engine
+        )
+    else()
+        #A shared cog binds to the engine already in the executable (see raoe_link_shared_cogs_to_target).
+        #Linking its own copy would give it a second set of singletons and static registrations
+        if(CMAKE_VERSION VERSION_LESS 3.27)
+            message(FATAL_ERROR "Shared cogs need CMake 3.27 or newer")
+        endif()
+        target_link_libraries(
+        ${COG_LIBRARY_NAME}
+        ${raoe_add_cog_DEPENDENCIES}
+        PRIVATE
+            $<COMPILE_ONLY:raoe::core>
+            $<COMPILE_ONLY:raoe::engine>
+        )
+    endif()
 
     #add compile definitions. 
     string(TOUPPER "${raoe_add_cog_NAME}_API" cog_api)
@@ -61,6 +98,7 @@ function(raoe_add_cog)
     PRIVATE
     "${cog_api}=1"
     "COG_NAME=${raoe_add_cog_NAME}"
+    $<$<BOOL:${raoe_add_cog_SHARED}>:RAOE_SHARED_COG=1>
     ${raoe_add_cog_COMPILE_DEFINITIONS}
     )
 
@@ -76,8 +114,21 @@ function(raoe_add_cog)
         endforeach()
         
 
+        list(LENGTH cog_dependency_names cog_generated_dependency_count)
+        set(cog_generated_dependencies "")
+        foreach(cog_dependency_name ${cog_dependency_names})
+            string(APPEND cog_generated_dependencies "\"${cog_dependency_name}\", ")
+        endforeach()
+        if(raoe_add_cog_MAIN_THREAD)
+            set(cog_generated_main_thread_only "true")
+        else()
+            set(cog_generated_main_thread_only "false")
+        endif()
+
         set(cog_generated_external_function_name "__GENERATED__${raoe_add_cog_NAME}")
-        set_property(GLOBAL APPEND PROPERTY RAOE_STATIC_COG_FUNCTION_NAMES ${cog_generated_external_function_name})
+        if(raoe_add_cog_STATIC)
+            set_property(GLOBAL APPEND PROPERTY RAOE_STATIC_COG_FUNCTION_NAMES ${cog_generated_external_function_name})
+        endif()
 
         set(cog_generated_FILE_NAME "generated_cog.cpp")
         set(cog_generated_FULL_FILE_PATH "${CMAKE_CURRENT_BINARY_DIR}/src/${cog_generated_FILE_NAME}")
@@ -132,4 +183,46 @@ function(raoe_link_static_cogs_to_target target_to_add_deps_to)
         PRIVATE
         ${all_static_cogs}
     )        
-endfunction()
\ No newline at end of file
+endfunction()
+
+#Links every shared cog against the target, copies them next to it in cogs/, and writes cogs/cogs.manifest listing them.
+#Shared cogs call back into the engine, so the target exports the whole engine for them to bind to
+function(raoe_link_shared_cogs_to_target target_to_add_deps_to)
+    if(NOT target_to_add_deps_to)
+        message(ERROR "Must have a target to set shared cogs to load")
+    endif()
+
+    get_property(all_shared_cogs GLOBAL PROPERTY RAOE_ALL_SHARED_COGS)
+    get_property(all_manifest_lines GLOBAL PROPERTY RAOE_SHARED_COG_MANIFEST_LINES)
+
+    set_target_properties(${target_to_add_deps_to} PROPERTIES ENABLE_EXPORTS ON)
+    if(CMAKE_VERSION VERSION_GREATER_EQUAL 3.24)
+        #Libraries the target links pull the engine in without a feature too, which CMake refuses to mix with WHOLE_ARCHIVE
+        #unless the target overrides every mention of it
+        get_target_property(engine_target raoe::engine ALIASED_TARGET)
+        target_link_libraries(${target_to_add_deps_to} PRIVATE "$<LINK_LIBRARY:WHOLE_ARCHIVE,raoe::engine>")
+        set_property(TARGET ${target_to_add_deps_to} APPEND PROPERTY LINK_LIBRARY_OVERRIDE "WHOLE_ARCHIVE,${engine_target}")
+    elseif(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang" AND NOT APPLE AND NOT WIN32)
+        target_link_libraries(${target_to_add_deps_to}
+            PRIVATE
+            "-Wl,--whole-archive" raoe::engine "-Wl,--no-whole-archive"
+        )
+    endif()
+
+    string(REPLACE ";" "\n" manifest_content "${all_manifest_lines}")
+    file(GENERATE
+        OUTPUT "$<TARGET_FILE_DIR:${target_to_add_deps_to}>/cogs/cogs.manifest"
+        CONTENT "# name library dependencies...\n${manifest_content}\n"
+    )
+
+    foreach(shared_cog ${all_shared_cogs})
+        #Resolves the cog's engine symbols against the target (an import library on Windows, -bundle_loader on Apple),
+        #so the cog builds after the target and copies itself over
+        target_link_libraries(${shared_cog} PRIVATE ${target_to_add_deps_to})
+        add_custom_command(TARGET ${shared_cog} POST_BUILD
+            COMMAND ${CMAKE_COMMAND} -E make_directory $<TARGET_FILE_DIR:${target_to_add_deps_to}>/cogs
+            COMMAND ${CMAKE_COMMAND} -E copy_if_different
+                $<TARGET_FILE:${shared_cog}>
+                $<TARGET_FILE_DIR:${target_to_add_deps_to}>/cogs/)
+    endforeach()
+endfunction()
@@ -31,7 +31,10 @@ int main(int argc, char* argv[])
     RAOE::Engine engine(argc, argv);
 
 #if RAOE_STATIC_COGS
-    RAOE::_GENERATED::LoadStaticCogs(engine);
+    {
+        RAOE_STARTUP_TRACE_SCOPE("engine", "load static cogs");
+        RAOE::_GENERATED::LoadStaticCogs(engine);
+    }
 #endif
 
     engine.Startup();
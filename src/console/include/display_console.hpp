@@ -18,7 +18,8 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "core.hpp"
 #include <string>
-#include "spdlog/sinks/ringbuffer_sink.h"
+#include "log_store.hpp"
+#include "console/completion.hpp"
 
 namespace RAOE
 {
@@ -31,7 +32,7 @@ namespace RAOE::Console
     {
     public:
         DisplayConsole(RAOE::Engine&);
-        ~DisplayConsole() = default;
+        ~DisplayConsole();
 
         void Draw(const std::string& title, bool* p_open);
 
@@ -44,8 +45,11 @@ namespace RAOE::Console
         int32 history_pos;        
         std::vector<std::string> history;
     private:
-        std::shared_ptr<spdlog::sinks::ringbuffer_sink_mt> ring_buffer;
+        std::shared_ptr<raoe::log::line_store_sink> log_sink;
+        raoe::log::line_filter log_filter;
+        std::string filter_buffer;
         std::string input_buffer;
+        CompletionIndex completion_index;
 
         RAOE::Engine& m_engine;
     };
@@ -29,4 +29,4 @@ namespace RAOE::Gears
 
 }
 
-RAOE_DEFINE_GEAR(ConsoleGear, RAOE::Gears::ConsoleGear)
\ No newline at end of file
+RAOE_DEFINE_EAGER_GEAR(ConsoleGear, RAOE::Gears::ConsoleGear)
\ No newline at end of file
@@ -20,28 +20,32 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "spdlog/spdlog.h"
 #include "misc/cpp/imgui_stdlib.h"
 #include "string.hpp"
+#include "frame_arena.hpp"
 
 #include "console/console.hpp"
-#include "rapidfuzz/fuzz.hpp"
-#include <map>
 
 namespace RAOE::Console
 {
     const int32 Max_History = 32;
-    const int32 Ringbuffer_Size = 40;
+    const char* const Level_Names[] = {"trace", "debug", "info", "warning", "error", "critical"};
 
     DisplayConsole::DisplayConsole(RAOE::Engine& in_engine)
         : m_engine(in_engine)
         , history_pos(-1)
     {
-        ring_buffer = std::make_shared<spdlog::sinks::ringbuffer_sink_mt>(Ringbuffer_Size);
-        spdlog::default_logger()->sinks().push_back(ring_buffer);
+        log_sink = std::make_shared<raoe::log::line_store_sink>();
+        raoe::log::add_sink(log_sink);
 
         history.reserve(Max_History);
 
         input_buffer.reserve(128); //NOLINT Magic Number.  128 is a decent number, and we don't use it anywhere else
     }
 
+    DisplayConsole::~DisplayConsole()
+    {
+        raoe::log::remove_sink(log_sink);
+    }
+
     void DisplayConsole::Draw(const std::string& title, bool* p_open)
     {
         ImGui::SetNextWindowSize(ImVec2(520, 600), ImGuiCond_FirstUseEver);
@@ -60,6 +64,19 @@ namespace RAOE::Console
             ImGui::EndPopup();
         }
 
+        //Log filter.  Changing it rebuilds the filter's index once, not every frame
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.7f);
+        if(ImGui::InputTextWithHint("##Filter", "filter", &filter_buffer))
+        {
+            log_filter.set_text(filter_buffer);
+        }
+        ImGui::SameLine();
+        int32 min_level = static_cast<int32>(log_filter.min_level());
+        if(ImGui::Combo("##Level", &min_level, Level_Names, IM_ARRAYSIZE(Level_Names)))
+        {
+            log_filter.set_min_level(static_cast<spdlog::level::level_enum>(min_level));
+        }
+
         ImGui::Separator();
 
         const float footer_height_to_reserve = ImGui::GetStyle().ItemSpacing.y + ImGui::GetFrameHeightWithSpacing();
@@ -68,17 +85,41 @@ namespace RAOE::Console
         {
             if(ImGui::Selectable("Clear"))
             {
-                //Clear the console
+                //Clearing just hides everything logged so far, the store recycles old lines on its own
+                log_filter.set_first_line(log_sink->store().size());
             }
             ImGui::EndPopup();
         }
 
         ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(4, 1));
 
-        std::vector<std::string> log_messages = ring_buffer->last_formatted(40);
-        for(const std::string& str : log_messages)
+        //Only the visible rows are touched, so this costs the same with 40 lines of scrollback or 100,000
+        const raoe::log::line_store& store = log_sink->store();
+        const bool new_lines = log_filter.update(store);
+        const bool was_at_bottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(log_filter.rows()));
+        std::string text;
+        spdlog::level::level_enum level = spdlog::level::info;
+        while(clipper.Step())
+        {
+            for(int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                //A line recycled since the filter last caught up shows as blank for a frame
+                if(!store.read(log_filter.line_index(row), text, level))
+                {
+                    text.clear();
+                }
+                ImGui::TextUnformatted(text.data(), text.data() + text.size());
+            }
+        }
+        clipper.End();
+
+        //Follow new lines, unless the user has scrolled up to read something
+        if(new_lines && was_at_bottom)
         {
-            ImGui::TextUnformatted(str.c_str());
+            ImGui::SetScrollHereY(1.0f);
         }
        
         ImGui::PopStyleVar();
@@ -163,42 +204,22 @@ namespace RAOE::Console
         {            
             const bool show_hint = history.size() > 0 || !input_buffer.empty(); //NOLINT TODO: Implement this
 
-            std::vector<std::string> matching_possible_commands;
-            //If the input buffer isn't empty, lets try fuzzy matching the input text to all of the possible commands
-            if(!input_buffer.empty())
+            //Everything in here is thrown away at the end of the frame, so build it in the frame arena
+            raoe::frame_vector<std::string_view> source_text(raoe::frame_allocator());
+            if(input_buffer.empty())
             {
-                std::map<double, RAOE::Console::IConsoleElement*> ordered_command_match;
-                for(const auto& command : RAOE::Console::CommandRegistry::Get().elements())
-                {
-                    double score = rapidfuzz::fuzz::partial_ratio(command->name(), input_buffer);
-                    if(score > 51)
-                    {
-                        ordered_command_match.insert({score, command.get()});
-                    }
-                    
-                }
-
-                //Get the top 15 matches (or fewer, if there are less matches)
-                auto back_inserter = std::back_inserter(matching_possible_commands);
-                for(int32 i = 0; i < 15; i++)
+                source_text.assign(history.begin(), history.end());
+            }
+            else
+            {
+                //If the input buffer isn't empty, fuzzy match it against the commands.  The index caches the results
+                //until the input changes, so this is free on frames where nothing was typed
+                for(const RAOE::Console::IConsoleElement* element : completion_index.query(input_buffer))
                 {
-                    if(ordered_command_match.size() <= i)
-                    {
-                        break;
-                    }
-                    
-                    auto element = ordered_command_match.begin();
-                    for(int j = 0; j < i; j++)
-                    {
-                        element++;
-                    }
-
-                    *(back_inserter++) = fmt::format("{}", element->second->name());
+                    source_text.push_back(element->name());
                 }
             }
 
-            std::vector<std::string>& source_text = input_buffer.empty() ? history : matching_possible_commands;
-
             ImGuiWindowFlags popup_flags = ImGuiWindowFlags_NoDecoration 
                 | ImGuiWindowFlags_AlwaysAutoResize 
                 | ImGuiWindowFlags_NoSavedSettings
@@ -215,9 +236,9 @@ namespace RAOE::Console
             {    
                 for(int32 i = 0; i < source_text.size(); i++)
                 {
-                    const std::string& str = source_text[i];
+                    const std::string_view str = source_text[i];
                     ImGui::PushID(i);
-                    if(ImGui::Selectable(str.c_str()))
+                    if(ImGui::Selectable(raoe::frame_string(str).c_str()))
                     {
                         input_buffer = str;
                         p_open = false;
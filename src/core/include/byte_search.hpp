@@ -0,0 +1,288 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+
+#include <bit>
+#include <cstring>
+#include <string_view>
+
+/***
+ * Byte Search
+ * Finds bytes of a class (one byte, any of a set, or whitespace) in a string_view, 32 or 16 bytes at a time.
+ *
+ * Each block is compared against the class to get one bit per byte, and the lowest (or highest, searching backwards) set bit
+ * is the answer.  Whatever is left over at the end is searched a byte at a time.
+ * AVX2 is used when the compiler targets it (-mavx2, /arch:AVX2), SSE2 otherwise on x86, and plain loops everywhere else.
+ * Define RAOE_BYTE_SEARCH_SCALAR to force the plain loops.
+*/
+
+#if !defined(RAOE_BYTE_SEARCH_SCALAR)
+#if defined(__AVX2__)
+#define RAOE_BYTE_SEARCH_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAOE_BYTE_SEARCH_SSE2 1
+#endif
+#endif
+
+#if defined(RAOE_BYTE_SEARCH_AVX2) || defined(RAOE_BYTE_SEARCH_SSE2)
+#include <immintrin.h>
+#endif
+
+namespace raoe::string
+{
+    namespace byte_class
+    {
+        //Matches one byte
+        struct equals
+        {
+            char value;
+
+            [[nodiscard]] bool scalar(char c) const noexcept { return c == value; }
+#if defined(RAOE_BYTE_SEARCH_SSE2)
+            [[nodiscard]] __m128i simd(__m128i block) const noexcept { return _mm_cmpeq_epi8(block, _mm_set1_epi8(value)); }
+#endif
+#if defined(RAOE_BYTE_SEARCH_AVX2)
+            [[nodiscard]] __m256i simd(__m256i block) const noexcept { return _mm256_cmpeq_epi8(block, _mm256_set1_epi8(value)); }
+#endif
+        };
+
+        //Matches what std::isspace does in the C locale: space, and \t \n \v \f \r (9 through 13)
+        struct whitespace
+        {
+            [[nodiscard]] bool scalar(char c) const noexcept { return c == ' ' || static_cast<uint8>(c - '\t') <= '\r' - '\t'; }
+#if defined(RAOE_BYTE_SEARCH_SSE2)
+            [[nodiscard]] __m128i simd(__m128i block) const noexcept
+            {
+                //c - 9 <= 4, unsigned, is true exactly when min(c - 9, 4) == c - 9
+                const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+                const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+                return _mm_or_si128(control, _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+            }
+#endif
+#if defined(RAOE_BYTE_SEARCH_AVX2)
+            [[nodiscard]] __m256i simd(__m256i block) const noexcept
+            {
+                const __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+                const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+                return _mm256_or_si256(control, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')));
+            }
+#endif
+        };
+
+        //Matches any byte in a set.  Costs one compare per byte in the set per block, so it's meant for small sets
+        struct any_of
+        {
+            std::string_view set;
+
+            [[nodiscard]] bool scalar(char c) const noexcept { return set.find(c) != std::string_view::npos; }
+#if defined(RAOE_BYTE_SEARCH_SSE2)
+            [[nodiscard]] __m128i simd(__m128i block) const noexcept
+            {
+                __m128i matches = _mm_setzero_si128();
+                for(const char c : set)
+                {
+                    matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+                }
+                return matches;
+            }
+#endif
+#if defined(RAOE_BYTE_SEARCH_AVX2)
+            [[nodiscard]] __m256i simd(__m256i block) const noexcept
+            {
+                __m256i matches = _mm256_setzero_si256();
+                for(const char c : set)
+                {
+                    matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c)));
+                }
+                return matches;
+            }
+#endif
+        };
+    }
+
+    namespace _
+    {
+        //One bit per byte of the block that matches (or with Negate, doesn't)
+        template<bool Negate, typename ByteClass>
+        [[nodiscard]] inline uint32 block_mask([[maybe_unused]] const ByteClass& byte_class, [[maybe_unused]] const char* data, [[maybe_unused]] size_t width) noexcept
+        {
+#if defined(RAOE_BYTE_SEARCH_AVX2)
+            if(width == 32)
+            {
+                const uint32 mask = static_cast<uint32>(_mm256_movemask_epi8(byte_class.simd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data))))); //NOLINT unaligned loads take a pointer to the vector type
+                return Negate ? ~mask : mask;
+            }
+#endif
+#if defined(RAOE_BYTE_SEARCH_SSE2)
+            const uint32 mask = static_cast<uint32>(_mm_movemask_epi8(byte_class.simd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data))))); //NOLINT
+            return Negate ? (~mask & 0xFFFFu) : mask;
+#else
+            return 0;
+#endif
+        }
+
+#if defined(RAOE_BYTE_SEARCH_AVX2)
+        inline constexpr size_t block_widths[] = { 32, 16 };
+#elif defined(RAOE_BYTE_SEARCH_SSE2)
+        inline constexpr size_t block_widths[] = { 16 };
+#else
+        inline constexpr size_t block_widths[] = { 0 };
+#endif
+
+        template<bool Negate, typename ByteClass>
+        [[nodiscard]] inline size_t find(std::string_view s, const ByteClass& byte_class, size_t from) noexcept
+        {
+            const char* const data = s.data();
+            size_t i = from;
+            for(const size_t width : block_widths)
+            {
+                for(; width != 0 && i + width <= s.size(); i += width)
+                {
+                    if(const uint32 mask = block_mask<Negate>(byte_class, data + i, width))
+                    {
+                        return i + static_cast<size_t>(std::countr_zero(mask));
+                    }
+                }
+            }
+            for(; i < s.size(); i++)
+            {
+                if(byte_class.scalar(data[i]) != Negate)
+                {
+                    return i;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+        template<bool Negate, typename ByteClass>
+        [[nodiscard]] inline size_t rfind(std::string_view s, const ByteClass& byte_class) noexcept
+        {
+            const char* const data = s.data();
+            size_t end = s.size();
+            for(const size_t width : block_widths)
+            {
+                for(; width != 0 && end >= width; end -= width)
+                {
+                    if(const uint32 mask = block_mask<Negate>(byte_class, data + end - width, width))
+                    {
+                        return end - width + static_cast<size_t>(31 - std::countl_zero(mask));
+                    }
+                }
+            }
+            while(end > 0)
+            {
+                end--;
+                if(byte_class.scalar(data[end]) != Negate)
+                {
+                    return end;
+                }
+            }
+            return std::string_view::npos;
+        }
+    }
+
+    //The first byte at or after from that's in the class, or npos
+    template<typename ByteClass>
+    [[nodiscard]] inline size_t find_first(std::string_view s, const ByteClass& byte_class, size_t from = 0) noexcept
+    {
+        return from < s.size() ? _::find<false>(s, byte_class, from) : std::string_view::npos;
+    }
+
+    //The first byte at or after from that isn't in the class, or npos
+    template<typename ByteClass>
+    [[nodiscard]] inline size_t find_first_not(std::string_view s, const ByteClass& byte_class, size_t from = 0) noexcept
+    {
+        return from < s.size() ? _::find<true>(s, byte_class, from) : std::string_view::npos;
+    }
+
+    //The last byte that's in the class, or npos
+    template<typename ByteClass>
+    [[nodiscard]] inline size_t find_last(std::string_view s, const ByteClass& byte_class) noexcept
+    {
+        return _::rfind<false>(s, byte_class);
+    }
+
+    //The last byte that isn't in the class, or npos
+    template<typename ByteClass>
+    [[nodiscard]] inline size_t find_last_not(std::string_view s, const ByteClass& byte_class) noexcept
+    {
+        return _::rfind<true>(s, byte_class);
+    }
+
+    /***
+     * find_substring
+     * The first occurrence of needle at or after from, or npos.  Like std::string_view::find, but a block at a time:
+     * each block is checked for the needle's first and last bytes at the right distance apart, and only where both match
+     * is the middle compared.  That rules out almost every position without looking at it twice
+    */
+    [[nodiscard]] inline size_t find_substring(std::string_view s, std::string_view needle, size_t from = 0) noexcept
+    {
+        if(needle.empty())
+        {
+            return from <= s.size() ? from : std::string_view::npos;
+        }
+        if(needle.size() == 1)
+        {
+            return find_first(s, byte_class::equals { needle.front() }, from);
+        }
+        if(from > s.size() || s.size() - from < needle.size())
+        {
+            return std::string_view::npos;
+        }
+
+        const char* const data = s.data();
+        const size_t last_start = s.size() - needle.size();
+        const size_t last_offset = needle.size() - 1;
+        const byte_class::equals first { needle.front() };
+        const byte_class::equals last { needle.back() };
+        auto middle_matches = [&](size_t start) {
+            return std::memcmp(data + start + 1, needle.data() + 1, needle.size() - 2) == 0;
+        };
+
+        size_t i = from;
+#if defined(RAOE_BYTE_SEARCH_AVX2) || defined(RAOE_BYTE_SEARCH_SSE2)
+        for(const size_t width : _::block_widths)
+        {
+            //Both blocks have to fit: the one at i, and the one needle.size() - 1 bytes after it
+            for(; i + width <= last_start + 1; i += width)
+            {
+                uint32 candidates = _::block_mask<false>(first, data + i, width) & _::block_mask<false>(last, data + i + last_offset, width);
+                while(candidates != 0)
+                {
+                    const size_t start = i + static_cast<size_t>(std::countr_zero(candidates));
+                    if(middle_matches(start))
+                    {
+                        return start;
+                    }
+                    candidates &= candidates - 1;
+                }
+            }
+        }
+#endif
+        for(; i <= last_start; i++)
+        {
+            if(data[i] == first.value && data[i + last_offset] == last.value && middle_matches(i))
+            {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    }
+}
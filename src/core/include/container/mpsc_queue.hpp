@@ -0,0 +1,150 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include "types.hpp"
+
+namespace raoe::container
+{
+    /***
+     * mpsc_queue
+     * A bounded queue that any number of threads can push to and one thread pops from, without anyone taking a lock.
+     *
+     * Each slot carries a sequence number saying whose turn it is: a producer claims a position with one compare exchange
+     * on the tail, writes the value, then bumps the slot's sequence to hand it to the consumer.  The consumer owns the head
+     * outright, and bumps the sequence again a lap later to hand the slot back.  A full queue fails the push instead of
+     * waiting, so what to do about it (wait, drop, run it somewhere else) is up to the caller.
+     *
+     * Capacity must be a power of two.  Values are built in place in the slots, so nothing allocates after construction
+    */
+    template<typename T, size_t Capacity>
+    class mpsc_queue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "mpsc_queue capacity must be a power of two");
+        static constexpr size_t index_mask = Capacity - 1;
+        static constexpr size_t cache_line = 64;
+
+        struct slot
+        {
+            std::atomic<size_t> sequence;
+            alignas(T) std::byte storage[sizeof(T)]; //NOLINT raw storage, values are built in place
+
+            T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); } //NOLINT
+        };
+    public:
+        mpsc_queue() noexcept
+        {
+            for(size_t i = 0; i < Capacity; i++)
+            {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~mpsc_queue()
+        {
+            while(try_pop())
+            {
+            }
+        }
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+        mpsc_queue(mpsc_queue&&) = delete;
+        mpsc_queue& operator=(mpsc_queue&&) = delete;
+
+        /***
+         * try_emplace
+         * Builds a value at the back of the queue.  Safe from any thread.  Returns false, without building anything, if the queue is full
+        */
+        template<typename... Args>
+        bool try_emplace(Args&&... args)
+        {
+            size_t position = m_tail.load(std::memory_order_relaxed);
+            while(true)
+            {
+                slot& claimed = m_slots[position & index_mask];
+                const size_t sequence = claimed.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+                if(difference == 0)
+                {
+                    //The slot is free this lap.  Claim it, unless another producer got there first
+                    if(m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        std::construct_at(claimed.value(), std::forward<Args>(args)...);
+                        claimed.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if(difference < 0)
+                {
+                    //The consumer hasn't taken what was pushed here a lap ago
+                    return false;
+                }
+                else
+                {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_push(T&& value) { return try_emplace(std::move(value)); }
+        bool try_push(const T& value) { return try_emplace(value); }
+
+        /***
+         * try_pop
+         * Takes the value at the front of the queue.  Only the consumer thread may call it.
+         * Empty if the queue is, or if the next value's producer hasn't finished writing it yet
+        */
+        std::optional<T> try_pop()
+        {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            slot& front = m_slots[head & index_mask];
+            if(front.sequence.load(std::memory_order_acquire) != head + 1)
+            {
+                return std::nullopt;
+            }
+
+            std::optional<T> value(std::move(*front.value()));
+            std::destroy_at(front.value());
+            front.sequence.store(head + Capacity, std::memory_order_release);
+            m_head.store(head + 1, std::memory_order_relaxed);
+            return value;
+        }
+
+        //Roughly how many values are waiting.  Exact only when nothing is pushing or popping
+        [[nodiscard]] size_t size_approx() const noexcept
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        [[nodiscard]] static constexpr size_t capacity() noexcept { return Capacity; }
+
+    private:
+        alignas(cache_line) std::atomic<size_t> m_tail = 0;
+        alignas(cache_line) std::atomic<size_t> m_head = 0; //only the consumer writes it, it's atomic so size_approx can read it
+        alignas(cache_line) std::array<slot, Capacity> m_slots;
+    };
+}
@@ -0,0 +1,146 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#pragma once
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include "types.hpp"
+
+namespace raoe::container
+{
+    /***
+     * sharded_map
+     * An unordered_map split into ShardCount maps by key hash, each behind its own reader/writer lock, for tables that are
+     * read from many threads and written now and then.
+     *
+     * Readers only share a lock with readers of the same shard, so lookups of different keys rarely touch the same cache line,
+     * and a writer only holds up the one shard its key is in.  Shards are cache line aligned so their locks don't share one.
+     *
+     * The with_shard functions hand out a whole shard under its lock, for anything that has to check and then change it
+     * (find or insert) without a gap between.  Don't call back into the map from them: the locks aren't recursive
+    */
+    template<typename Key, typename Value, size_t ShardCount = 16, typename Hash = std::hash<Key>>
+    class sharded_map
+    {
+        static_assert(ShardCount > 0 && (ShardCount & (ShardCount - 1)) == 0, "sharded_map shard count must be a power of two");
+    public:
+        using map_type = std::unordered_map<Key, Value, Hash>;
+
+        sharded_map() = default;
+        sharded_map(const sharded_map&) = delete;
+        sharded_map& operator=(const sharded_map&) = delete;
+
+        //A copy of the value stored for key, if there is one
+        [[nodiscard]] std::optional<Value> find(const Key& key) const
+        {
+            return with_shard_shared(key, [&key](const map_type& map) -> std::optional<Value> {
+                auto itr = map.find(key);
+                return itr != map.end() ? std::optional<Value>(itr->second) : std::nullopt;
+            });
+        }
+
+        [[nodiscard]] bool contains(const Key& key) const
+        {
+            return with_shard_shared(key, [&key](const map_type& map) { return map.contains(key); });
+        }
+
+        void insert_or_assign(const Key& key, Value value)
+        {
+            with_shard(key, [&](map_type& map) { map.insert_or_assign(key, std::move(value)); });
+        }
+
+        bool erase(const Key& key)
+        {
+            return with_shard(key, [&key](map_type& map) { return map.erase(key) > 0; });
+        }
+
+        //Calls func with the shard key is in, locked for writing, and returns what it does
+        template<typename Func>
+        decltype(auto) with_shard(const Key& key, Func&& func)
+        {
+            shard& locked = shard_of(key);
+            const std::unique_lock lock(locked.mutex);
+            return std::invoke(std::forward<Func>(func), locked.map);
+        }
+
+        //Calls func with the shard key is in, locked for reading, and returns what it does
+        template<typename Func>
+        decltype(auto) with_shard_shared(const Key& key, Func&& func) const
+        {
+            const shard& locked = shard_of(key);
+            const std::shared_lock lock(locked.mutex);
+            return std::invoke(std::forward<Func>(func), std::as_const(locked.map));
+        }
+
+        /***
+         * for_each
+         * Calls func(key, value) for everything, a shard at a time, with each shard locked for reading while it's visited.
+         * Nothing else sees a consistent view of the whole map, and neither does this
+        */
+        template<typename Func>
+        void for_each(Func&& func) const
+        {
+            for(const shard& locked : m_shards)
+            {
+                const std::shared_lock lock(locked.mutex);
+                for(const auto& [key, value] : locked.map)
+                {
+                    func(key, value);
+                }
+            }
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            size_t total = 0;
+            for(const shard& locked : m_shards)
+            {
+                const std::shared_lock lock(locked.mutex);
+                total += locked.map.size();
+            }
+            return total;
+        }
+
+        [[nodiscard]] static constexpr size_t shard_count() noexcept { return ShardCount; }
+
+    private:
+        struct alignas(64) shard
+        {
+            mutable std::shared_mutex mutex;
+            map_type map;
+        };
+
+        [[nodiscard]] size_t shard_index(const Key& key) const
+        {
+            //Mix the hash first, since the low bits of some std::hash implementations (eg integers) are the key itself
+            uint64 hash = static_cast<uint64>(Hash{}(key));
+            hash ^= hash >> 33U;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33U;
+            return static_cast<size_t>(hash & (ShardCount - 1));
+        }
+        shard& shard_of(const Key& key) { return m_shards[shard_index(key)]; }
+        const shard& shard_of(const Key& key) const { return m_shards[shard_index(key)]; }
+
+        std::array<shard, ShardCount> m_shards;
+    };
+}
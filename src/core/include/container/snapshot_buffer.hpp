@@ -0,0 +1,90 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include <array>
+#include <atomic>
+#include "types.hpp"
+
+namespace raoe::container
+{
+    /***
+     * snapshot_buffer
+     * Hands whole values from one producer thread to one consumer thread without either side taking a lock.
+     *
+     * The producer fills back() and calls publish().  The consumer calls acquire() and reads front().
+     * There are three slots rather than two so that the slot the consumer is reading is never the one being written:
+     * publish() and acquire() just trade their slot with the "middle" one through a single atomic exchange.
+     *
+     * Slots are reused, so a T that keeps its capacity (like a cleared std::vector) does not allocate in steady state
+    */
+    template<typename T>
+    class snapshot_buffer
+    {
+        static constexpr uint8 index_mask = 0x3;
+        static constexpr uint8 fresh_bit = 0x4;
+    public:
+        snapshot_buffer() = default;
+        snapshot_buffer(const snapshot_buffer&) = delete;
+        snapshot_buffer& operator=(const snapshot_buffer&) = delete;
+
+        /***
+         * back
+         * The slot owned by the producer.  Only the producer thread may touch it
+        */
+        T& back() noexcept { return m_slots[m_back]; }
+
+        /***
+         * publish
+         * Makes the current back() visible to the consumer, and hands the producer a new slot to write into.
+         * The new back() still holds whatever stale value was in it, and should be overwritten
+        */
+        void publish() noexcept
+        {
+            const uint8 previous = m_middle.exchange(static_cast<uint8>(m_back | fresh_bit), std::memory_order_acq_rel);
+            m_back = previous & index_mask;
+        }
+
+        /***
+         * acquire
+         * Picks up the most recently published value, if there is one newer than front().
+         * Returns true if front() changed
+        */
+        bool acquire() noexcept
+        {
+            if((m_middle.load(std::memory_order_relaxed) & fresh_bit) == 0)
+            {
+                return false;
+            }
+
+            const uint8 previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+            m_front = previous & index_mask;
+            return true;
+        }
+
+        /***
+         * front
+         * The slot owned by the consumer.  Only the consumer thread may touch it
+        */
+        [[nodiscard]] const T& front() const noexcept { return m_slots[m_front]; }
+
+    private:
+        std::array<T, 3> m_slots {};
+        uint8 m_back = 0;
+        std::atomic<uint8> m_middle = 1;
+        uint8 m_front = 2;
+    };
+}
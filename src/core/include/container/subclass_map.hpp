@@ -80,6 +80,22 @@ namespace raoe::container
             return success ? std::dynamic_pointer_cast<T>((*itr).second) : nullptr;
         }
 
+        /***
+         * insert_object
+         * Insert an object of type T that's already been created, so it can be built somewhere the map isn't (eg without a lock held)
+         * Returns nullptr if T is already in this map, or a non-owning pointer to the object if it was inserted
+        */
+        template<std::derived_from<BaseClass> T>
+        std::weak_ptr<T> insert_object(std::shared_ptr<T> object)
+        {
+            auto [itr, success] = storage.emplace(typeid(T), object);
+            if(!success)
+            {
+                return std::weak_ptr<T>();
+            }
+            return object;
+        }
+
         /***
          *  Find
          *  Returns a pointer to the stored type, or nullptr if it doesn't exist
@@ -110,6 +126,16 @@ namespace raoe::container
            return storage.erase(typeid(T)) > 0;
         }
 
+        /***
+         * erase_if
+         * Erases every stored object the predicate returns true for.  Returns how many were erased
+        */
+        template<typename Predicate>
+        size_t erase_if(Predicate&& predicate)
+        {
+            return std::erase_if(storage, [&predicate](const auto& entry) { return predicate(entry.second); });
+        }
+
         size_t size() const noexcept
         {
             return storage.size();
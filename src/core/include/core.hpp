@@ -24,6 +24,9 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "time.hpp"
 #include "string.hpp"
 #include "tuple.hpp"
+#include "profile.hpp"
+#include "memory_tracking.hpp"
+#include "log.hpp"
 
 #include "typeinfo/typename.hpp"
 
@@ -0,0 +1,207 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace raoe
+{
+    /***
+     * frame_arena
+     * A double buffered bump allocator for temporaries that only need to live for a frame or so.
+     *
+     * Allocating is a pointer bump, freeing is a no-op.  end_frame() flips to the other buffer and resets it, so memory
+     * allocated during frame N stays valid through frame N+1 and is reclaimed when frame N+2 starts.
+     *
+     * When a frame needs more than the buffer holds, the rest comes from the global heap and that buffer grows to fit
+     * the next time it is reset.  After a warm up, steady state frames never touch the global heap.
+     *
+     * allocate() may be called from any thread, but end_frame() must not race with it (call it at the frame boundary).
+     * So an arena belongs to one frame loop: main() to the engine's, which only threads it joins with each frame may use.
+     * A thread that runs its own loop, like the server world, uses this_thread() and ends its frames itself
+    */
+    class frame_arena
+    {
+    public:
+        static constexpr size_t default_capacity = static_cast<size_t>(1) << 20;
+
+        struct frame_stats
+        {
+            size_t bytes = 0;          //everything allocated during the frame
+            size_t overflow_bytes = 0; //the part of that which had to come from the global heap
+        };
+
+        explicit frame_arena(size_t in_capacity = default_capacity)
+            : m_resource(*this)
+        {
+            for(buffer& buf : m_buffers)
+            {
+                buf.reserve(in_capacity);
+            }
+        }
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+        frame_arena(frame_arena&&) = delete;
+        frame_arena& operator=(frame_arena&&) = delete;
+        ~frame_arena() = default;
+
+        //The arena that the engine resets at the end of every frame
+        static frame_arena& main()
+        {
+            static frame_arena arena;
+            return arena;
+        }
+
+        //This thread's own arena, for threads that aren't in step with the engine's frames.  The thread calls end_frame() on it
+        static frame_arena& this_thread()
+        {
+            thread_local frame_arena arena;
+            return arena;
+        }
+
+        [[nodiscard]] void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+        {
+            buffer& current = m_buffers[m_current.load(std::memory_order_relaxed)];
+            const auto base = reinterpret_cast<uintptr_t>(current.memory.get()); //NOLINT pointer math
+
+            size_t offset = current.offset.load(std::memory_order_relaxed);
+            while(true)
+            {
+                const size_t aligned_offset = align_up(base + offset, alignment) - base;
+                const size_t new_offset = aligned_offset + bytes;
+                if(new_offset > current.capacity)
+                {
+                    return current.allocate_overflow(bytes, alignment);
+                }
+                if(current.offset.compare_exchange_weak(offset, new_offset, std::memory_order_relaxed))
+                {
+                    return current.memory.get() + aligned_offset; //NOLINT pointer math
+                }
+            }
+        }
+
+        /***
+         * end_frame
+         * Records this frame's usage, then switches to the other buffer and throws away what it held (the frame before this one)
+        */
+        void end_frame()
+        {
+            const uint32 finished_index = m_current.load(std::memory_order_relaxed);
+            const buffer& finished = m_buffers[finished_index];
+            m_last_frame = frame_stats { finished.offset.load(std::memory_order_relaxed) + finished.overflow_bytes, finished.overflow_bytes };
+            m_high_water_mark = std::max(m_high_water_mark, m_last_frame.bytes);
+
+            const uint32 next_index = finished_index ^ 1U;
+            m_buffers[next_index].reset();
+            m_current.store(next_index, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::pmr::memory_resource* resource() noexcept { return &m_resource; }
+
+        [[nodiscard]] const frame_stats& last_frame() const { return m_last_frame; }
+        [[nodiscard]] size_t high_water_mark() const { return m_high_water_mark; }
+        [[nodiscard]] size_t capacity() const { return m_buffers[m_current.load(std::memory_order_relaxed)].capacity; }
+
+    private:
+        static uintptr_t align_up(uintptr_t value, size_t alignment) { return (value + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1); }
+
+        struct buffer
+        {
+            std::unique_ptr<std::byte[]> memory; //NOLINT raw storage
+            size_t capacity = 0;
+            std::atomic<size_t> offset = 0;
+
+            std::mutex overflow_mutex;
+            std::vector<std::unique_ptr<std::byte[]>> overflow; //NOLINT raw storage
+            size_t overflow_bytes = 0;
+
+            void reserve(size_t in_capacity)
+            {
+                memory = std::make_unique<std::byte[]>(in_capacity); //NOLINT raw storage
+                capacity = in_capacity;
+            }
+
+            void* allocate_overflow(size_t bytes, size_t alignment)
+            {
+                const std::scoped_lock lock(overflow_mutex);
+                auto& block = overflow.emplace_back(std::make_unique<std::byte[]>(bytes + alignment)); //NOLINT raw storage
+                overflow_bytes += bytes;
+                const auto base = reinterpret_cast<uintptr_t>(block.get()); //NOLINT pointer math
+                return block.get() + (align_up(base, alignment) - base); //NOLINT pointer math
+            }
+
+            void reset()
+            {
+                //If we spilled onto the heap, grow so the same load fits next time
+                if(overflow_bytes > 0)
+                {
+                    reserve(std::bit_ceil(offset.load(std::memory_order_relaxed) + overflow_bytes));
+                    overflow.clear();
+                    overflow_bytes = 0;
+                }
+                offset.store(0, std::memory_order_relaxed);
+            }
+        };
+
+        //Adapter so std::pmr containers can allocate out of the arena
+        class arena_resource : public std::pmr::memory_resource
+        {
+        public:
+            explicit arena_resource(frame_arena& in_arena) : m_arena(in_arena) {}
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override { return m_arena.allocate(bytes, alignment); }
+            void do_deallocate(void*, size_t, size_t) override {} //freed all at once when the frame is reset
+            [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            frame_arena& m_arena;
+        };
+
+        std::array<buffer, 2> m_buffers;
+        std::atomic<uint32> m_current = 0;
+        arena_resource m_resource;
+
+        frame_stats m_last_frame;
+        size_t m_high_water_mark = 0;
+    };
+
+    //Containers for per frame temporaries.  These are only valid until the end of the next frame
+    template<typename T>
+    using frame_vector = std::pmr::vector<T>;
+
+    inline std::pmr::polymorphic_allocator<> frame_allocator()
+    {
+        return std::pmr::polymorphic_allocator<>(frame_arena::main().resource());
+    }
+
+    //A null terminated copy of str that lives in the frame arena
+    inline std::pmr::string frame_string(std::string_view str)
+    {
+        return std::pmr::string(str, frame_allocator());
+    }
+}
@@ -35,11 +35,28 @@ namespace raoe::string
 
     inline bool from_string(std::string_view arg, real auto& value)
     {        
+        //The whole argument has to be a number, "12abc" isn't 12
         auto result = std::from_chars(arg.data(), arg.data() + arg.size(), value);
-        const bool success = result.ec != std::errc::invalid_argument;     
+        const bool success = result.ec == std::errc() && result.ptr == arg.data() + arg.size();     
         return success;      
     }
 
+    //Specialization for bools.  from_chars can't parse them, and "true" or "on" reads better than 1 in a config file
+    inline bool from_string(std::string_view arg, bool& value)
+    {
+        if(arg == "1" || arg == "true" || arg == "on")
+        {
+            value = true;
+            return true;
+        }
+        if(arg == "0" || arg == "false" || arg == "off")
+        {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
     //Specialization for strings.  This is because they do not need to be parsed
     inline bool from_string(std::string_view arg, std::string& value)
     {
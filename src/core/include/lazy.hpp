@@ -17,8 +17,11 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 //an implementation of the std::lazy coroutine from the P2506R0 paper, with modifications
 
+#include <atomic>
 #include <coroutine>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <utility>
 #include <concepts>
@@ -56,7 +59,7 @@ namespace raoe
                     const std::size_t count = (size + sizeof(Alloc) + alignment - 1) / sizeof(aligned_block);
                     void* const ptr = alloc.allocate(count);
                     const auto al_address = (reinterpret_cast<uintptr_t>(ptr) + size + alignof(Alloc) - 1) & ~(alignof(Alloc) - 1);
-                    new(reinterpret_cast<void*>(al_address)) Alloc(std::move(al));
+                    new(reinterpret_cast<void*>(al_address)) Alloc(std::move(alloc));
                     return ptr;
                 }
             }
@@ -70,14 +73,14 @@ namespace raoe
                 requires std::convertible_to<Alloc2, Allocator>
             static void* operator new(const size_t size, std::allocator_arg_t, Alloc2&& al, Args&...) //NOLINT tag type
             {
-                return allocate(static_cast<Alloc>(static_cast<Allocator>(std::forward<Alloc2(Al))), size);
+                return allocate(static_cast<Alloc>(static_cast<Allocator>(std::forward<Alloc2>(al))), size);
             }
 
              template<class This, class Alloc2, class... Args>
                 requires std::convertible_to<Alloc2, Allocator>
             static void* operator new(const size_t size, This&, std::allocator_arg_t, Alloc2&& al, Args&...) //NOLINT tag type
             {
-                return allocate(static_cast<Alloc>(static_cast<Allocator>(std::forward<Alloc2(Al))), size);
+                return allocate(static_cast<Alloc>(static_cast<Allocator>(std::forward<Alloc2>(al))), size);
             }
 
             static void operator delete(void* const ptr, const size_t size) noexcept
@@ -129,7 +132,7 @@ namespace raoe
                 }
                 else
                 {
-                    static constexpr size_t align = std::max(alignof(Alloc, sizeof(aligned_block)));
+                    static constexpr size_t align = std::max(alignof(Alloc), sizeof(aligned_block));
                     const DeallocFunc dealloc = [](void* const ptr, size_t size)
                     {
                         size += sizeof(DeallocFunc);
@@ -147,7 +150,7 @@ namespace raoe
                     std::memcpy(static_cast<char*>(ptr) + size, &dealloc, sizeof(dealloc));
                     size += sizeof(DeallocFunc);
 
-                    const auto al_addr = (static_cast<uintptr_t>(ptr) + size + alignof(Alloc) - 1) & ~(alignof(Alloc) - 1);
+                    const auto al_addr = (reinterpret_cast<uintptr_t>(ptr) + size + alignof(Alloc) - 1) & ~(alignof(Alloc) - 1);
                     new (reinterpret_cast<void*>(al_addr)) Alloc{std::move(al)};
                     return ptr;
                 }
@@ -230,8 +233,21 @@ namespace raoe
 
     inline namespace _
     {
+        /***
+         * lazy_promise_link
+         * Every lazy's promise points at the lazy it is currently co_awaiting, if any.
+         * When a nested lazy suspends on something that isn't a lazy (like std::suspend_always to wait a frame),
+         * control goes back to whoever resumed the outermost lazy.  Following these links from the outermost lazy finds
+         * the innermost one, which is where execution has to pick up again (see lazy::resume)
+        */
+        struct lazy_promise_link
+        {
+            std::coroutine_handle<> m_awaiting_handle;
+            lazy_promise_link* m_awaiting = nullptr;
+        };
+
         template<class T>
-        class lazy_promise_base  //NOLINT
+        class lazy_promise_base : public lazy_promise_link  //NOLINT
         {
         public:
             lazy_promise_base() noexcept {}
@@ -354,20 +370,38 @@ namespace raoe
             struct Awaiter
             {
                 std::coroutine_handle<lazy_promise_base> m_coro_handle;
+                lazy_promise_link* m_parent = nullptr;
 
                 [[nodiscard]] bool await_ready() noexcept
                 {
                     return !m_coro_handle;
                 }
 
-                [[nodiscard]] std::coroutine_handle<lazy_promise_base> await_suspend(std::coroutine_handle<> coro) noexcept
+                template<class Promise>
+                [[nodiscard]] std::coroutine_handle<lazy_promise_base> await_suspend(std::coroutine_handle<Promise> coro) noexcept
                 {
                     m_coro_handle.promise().m_coro_handle = coro;
+                    if constexpr (std::is_base_of_v<lazy_promise_link, Promise>)
+                    {
+                        m_parent = &coro.promise();
+                        m_parent->m_awaiting_handle = m_coro_handle;
+                        m_parent->m_awaiting = &m_coro_handle.promise();
+                    }
                     return m_coro_handle;
                 }
 
+                void unlink() noexcept
+                {
+                    if(m_parent)
+                    {
+                        m_parent->m_awaiting_handle = nullptr;
+                        m_parent->m_awaiting = nullptr;
+                    }
+                }
+
                 T await_resume()
                 {
+                    unlink();
                     auto& promise = m_coro_handle.promise();
                     switch(promise.m_discriminator)
                     {
@@ -410,13 +444,12 @@ namespace raoe
     
         template<class T>
             requires std::is_void_v<T>
-        class lazy_promise_base<T>  //NOLINT
+        class lazy_promise_base<T> : public lazy_promise_link  //NOLINT
         {
         public:
             lazy_promise_base() noexcept {}
 
             lazy_promise_base(lazy_promise_base&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
-                : m_has_exception(other.m_has_exception)
             {
                 if(other.m_exception)
                 {
@@ -478,20 +511,38 @@ namespace raoe
             struct Awaiter
             {
                 std::coroutine_handle<lazy_promise_base> m_coro_handle;
+                lazy_promise_link* m_parent = nullptr;
 
                 [[nodiscard]] bool await_ready() noexcept
                 {
                     return !m_coro_handle;
                 }
 
-                [[nodiscard]] std::coroutine_handle<lazy_promise_base> await_suspend(std::coroutine_handle<> coro) noexcept
+                template<class Promise>
+                [[nodiscard]] std::coroutine_handle<lazy_promise_base> await_suspend(std::coroutine_handle<Promise> coro) noexcept
                 {
                     m_coro_handle.promise().m_coro_handle = coro;
+                    if constexpr (std::is_base_of_v<lazy_promise_link, Promise>)
+                    {
+                        m_parent = &coro.promise();
+                        m_parent->m_awaiting_handle = m_coro_handle;
+                        m_parent->m_awaiting = &m_coro_handle.promise();
+                    }
                     return m_coro_handle;
                 }
 
+                void unlink() noexcept
+                {
+                    if(m_parent)
+                    {
+                        m_parent->m_awaiting_handle = nullptr;
+                        m_parent->m_awaiting = nullptr;
+                    }
+                }
+
                 T await_resume() 
                 {
+                    unlink();
                     auto& promise = m_coro_handle.promise();
                     if(promise.m_exception)
                     {
@@ -526,7 +577,15 @@ namespace raoe
         
         lazy& operator=(lazy&& other) noexcept
         {
-            m_coro_handle = std::exchange(other.m_coro_handle, {});
+            if(this != &other)
+            {
+                if(m_coro_handle)
+                {
+                    m_coro_handle.destroy();
+                }
+                m_coro_handle = std::exchange(other.m_coro_handle, {});
+            }
+            return *this;
         }
         
         ~lazy()
@@ -556,11 +615,35 @@ namespace raoe
         }
 
         [[nodiscard]] bool done() const { return m_coro_handle.done(); }
+        //Resumes the lazy where it last suspended, which may be inside a lazy it is co_awaiting
         void resume() const 
         { 
-            if(!done()) 
+            if(done()) 
             { 
-                m_coro_handle(); 
+                return;
+            }
+
+            std::coroutine_handle<> innermost = m_coro_handle;
+            for(const lazy_promise_link* link = &m_coro_handle.promise(); link->m_awaiting; link = link->m_awaiting)
+            {
+                innermost = link->m_awaiting_handle;
+            }
+            innermost.resume();
+        }
+
+        //Calls func with this lazy's coroutine, then each lazy it is co_awaiting, outermost first
+        template<std::invocable<std::coroutine_handle<>> Func>
+        void for_each_frame(Func&& func) const
+        {
+            if(!m_coro_handle)
+            {
+                return;
+            }
+
+            func(std::coroutine_handle<>(m_coro_handle));
+            for(const lazy_promise_link* link = &m_coro_handle.promise(); link->m_awaiting; link = link->m_awaiting)
+            {
+                func(link->m_awaiting_handle);
             }
         }
 
@@ -572,4 +655,394 @@ namespace raoe
         std::coroutine_handle<promise_type> m_coro_handle = nullptr;
     };
     
-}
\ No newline at end of file
+
+    template<class T = void, class Allocator = void>
+    class [[nodiscard]] shared_lazy;
+
+    inline namespace _
+    {
+        //A coroutine waiting on a shared_lazy.  Lives in the awaiter, so in the waiting coroutine's frame
+        struct shared_lazy_waiter
+        {
+            std::coroutine_handle<> m_continuation;
+            lazy_promise_link* m_parent = nullptr; //the waiting lazy's link, if it's a lazy, which is how it drives the coroutine
+            shared_lazy_waiter* m_next = nullptr;
+            //On the list, so it has to take itself off if it's destroyed before it's resumed.  Only changed with the promise's
+            //m_mutex held, but a waiter that isn't queued reads it without the lock
+            std::atomic<bool> m_queued = false;
+        };
+
+        //The result of a shared_lazy, which every awaiter reads in place
+        template<class T>
+        class shared_lazy_result
+        {
+        public:
+            shared_lazy_result() noexcept {}
+            shared_lazy_result(const shared_lazy_result&) = delete;
+            shared_lazy_result& operator=(const shared_lazy_result&) = delete;
+
+            ~shared_lazy_result()
+            {
+                if(m_has_value)
+                {
+                    std::destroy_at(std::addressof(m_value));
+                }
+            }
+
+            template<class U = T>
+                requires std::constructible_from<T, U>
+            void return_value(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>)
+            {
+                std::construct_at(std::addressof(m_value), std::forward<U>(value));
+                m_has_value = true;
+            }
+
+            [[nodiscard]] const T& result() const
+            {
+                if(m_exception)
+                {
+                    std::rethrow_exception(m_exception);
+                }
+                if(!m_has_value)
+                {
+                    std::terminate(); //the coroutine finished without a value or an exception, which can't happen
+                }
+                return m_value;
+            }
+
+        protected:
+            std::exception_ptr m_exception;
+        private:
+            union
+            {
+                T m_value;
+            };
+            bool m_has_value = false;
+        };
+
+        template<>
+        class shared_lazy_result<void>
+        {
+        public:
+            void return_void() noexcept {}
+
+            void result() const
+            {
+                if(m_exception)
+                {
+                    std::rethrow_exception(m_exception);
+                }
+            }
+
+        protected:
+            std::exception_ptr m_exception;
+        };
+
+        /***
+         * shared_lazy_promise_base
+         * m_state is how far along the coroutine is: not started, running, or ready, once it has finished and the result is
+         * there to read.  Only becoming ready is read without the lock, so a finished coroutine is awaited without taking it.
+         * m_mutex guards the list of waiters and m_driver, the waiter whose lazy resumes the coroutine (see Awaiter::link).
+         * Waiters can be destroyed while they wait, so they take themselves off the list, and if the driver goes, the next
+         * waiter that's a lazy takes over driving it
+        */
+        template<class T>
+        class shared_lazy_promise_base : public lazy_promise_link, public shared_lazy_result<T>
+        {
+        public:
+            shared_lazy_promise_base() noexcept {}
+
+            [[nodiscard]] std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            [[nodiscard]] auto final_suspend() noexcept
+            {
+                return FinalAwaiter{};
+            }
+
+            void unhandled_exception() noexcept
+            {
+                this->m_exception = std::current_exception();
+            }
+
+        private:
+            template<class, class> friend class raoe::shared_lazy;
+
+            enum class EState : uint8
+            {
+                NotStarted,
+                Running,
+                Ready,
+            };
+
+            [[nodiscard]] bool is_ready() const noexcept { return m_state.load(std::memory_order_acquire) == EState::Ready; }
+
+            //Makes the waiter the one whose lazy resumes the coroutine.  Call with m_mutex held
+            void drive_from(shared_lazy_waiter& waiter) noexcept
+            {
+                m_driver = &waiter;
+                if(waiter.m_parent)
+                {
+                    waiter.m_parent->m_awaiting_handle = std::coroutine_handle<shared_lazy_promise_base>::from_promise(*this);
+                    waiter.m_parent->m_awaiting = this;
+                }
+            }
+
+            struct FinalAwaiter
+            {
+                [[nodiscard]] bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                template<class Promise>
+                [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coro) noexcept
+                {
+                    shared_lazy_promise_base& promise = coro.promise();
+                    //A waiter that sees it's ready may drop the last reference right away, so this holds one until it's done with
+                    //the promise.  Nothing can touch the promise after that
+                    promise.m_references.fetch_add(1, std::memory_order_relaxed);
+                    {
+                        const std::scoped_lock lock(promise.m_mutex);
+                        promise.m_driver = nullptr;
+                        promise.m_state.store(EState::Ready, std::memory_order_release);
+                    }
+
+                    //Once it's ready nobody joins the list, but resuming one waiter can destroy others still on it.  So they're
+                    //taken one at a time, and the ones destroyed before their turn take themselves off the list first
+                    while(true)
+                    {
+                        std::coroutine_handle<> continuation;
+                        bool last = false;
+                        {
+                            const std::scoped_lock lock(promise.m_mutex);
+                            shared_lazy_waiter* const waiter = promise.m_waiters;
+                            if(waiter != nullptr)
+                            {
+                                continuation = waiter->m_continuation;
+                                promise.m_waiters = waiter->m_next;
+                                waiter->m_queued.store(false, std::memory_order_release);
+                            }
+                            last = promise.m_waiters == nullptr;
+                        }
+
+                        if(last)
+                        {
+                            if(promise.m_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            {
+                                coro.destroy();
+                            }
+                            //The last one takes over this thread
+                            return continuation ? continuation : std::noop_coroutine();
+                        }
+                        continuation.resume();
+                    }
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            struct Awaiter
+            {
+                std::coroutine_handle<shared_lazy_promise_base> m_coro_handle;
+                shared_lazy_waiter m_waiter;
+                lazy_promise_link m_parked; //see link
+
+                Awaiter(std::coroutine_handle<shared_lazy_promise_base> in_coro_handle) noexcept : m_coro_handle(in_coro_handle) {}
+                Awaiter(const Awaiter&) = delete;
+                Awaiter& operator=(const Awaiter&) = delete;
+
+                //Only does anything if the waiting coroutine is destroyed while it waits
+                ~Awaiter()
+                {
+                    if(!m_waiter.m_queued.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+
+                    shared_lazy_promise_base& promise = m_coro_handle.promise();
+                    const std::scoped_lock lock(promise.m_mutex);
+                    if(!m_waiter.m_queued.load(std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                    shared_lazy_waiter** next = &promise.m_waiters;
+                    while(*next != &m_waiter)
+                    {
+                        next = &(*next)->m_next;
+                    }
+                    *next = m_waiter.m_next;
+                    m_waiter.m_queued.store(false, std::memory_order_relaxed);
+
+                    if(promise.m_driver == &m_waiter)
+                    {
+                        promise.m_driver = nullptr;
+                        for(shared_lazy_waiter* waiter = promise.m_waiters; waiter != nullptr; waiter = waiter->m_next)
+                        {
+                            if(waiter->m_parent)
+                            {
+                                promise.drive_from(*waiter);
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                [[nodiscard]] bool await_ready() noexcept
+                {
+                    return m_coro_handle.promise().is_ready();
+                }
+
+                template<class Promise>
+                [[nodiscard]] bool await_suspend(std::coroutine_handle<Promise> coro) noexcept
+                {
+                    shared_lazy_promise_base& promise = m_coro_handle.promise();
+                    m_waiter.m_continuation = coro;
+                    link(coro);
+
+                    {
+                        const std::scoped_lock lock(promise.m_mutex);
+                        if(promise.m_state.load(std::memory_order_relaxed) == EState::Running)
+                        {
+                            //Nobody drives it if the lazy that did was destroyed while no other lazy was waiting
+                            if(promise.m_driver == nullptr && m_waiter.m_parent)
+                            {
+                                promise.drive_from(m_waiter);
+                            }
+                            return wait(promise);
+                        }
+                        if(promise.m_state.load(std::memory_order_relaxed) == EState::Ready)
+                        {
+                            return false;
+                        }
+                        promise.m_state.store(EState::Running, std::memory_order_relaxed);
+                        promise.drive_from(m_waiter);
+                    }
+
+                    //The first awaiter runs it, until it finishes or suspends
+                    m_coro_handle.resume();
+                    const std::scoped_lock lock(promise.m_mutex);
+                    return promise.m_state.load(std::memory_order_relaxed) != EState::Ready && wait(promise);
+                }
+
+                //Joins the waiters.  Call with the promise's m_mutex held
+                bool wait(shared_lazy_promise_base& promise) noexcept
+                {
+                    m_waiter.m_next = promise.m_waiters;
+                    m_waiter.m_queued.store(true, std::memory_order_relaxed);
+                    promise.m_waiters = &m_waiter;
+                    return true;
+                }
+
+                /***
+                 * link
+                 * Points an awaiting lazy at what resuming it should resume (see lazy::resume).  The lazy driving the coroutine
+                 * resumes it (see drive_from), so whatever resumes that lazy each frame carries the shared one along.  Every other
+                 * lazy resumes a noop until the result is ready, because the coroutine resumes them itself when it finishes
+                */
+                template<class Promise>
+                void link(std::coroutine_handle<Promise> coro) noexcept
+                {
+                    if constexpr (std::is_base_of_v<lazy_promise_link, Promise>)
+                    {
+                        m_waiter.m_parent = &coro.promise();
+                        m_waiter.m_parent->m_awaiting_handle = std::noop_coroutine();
+                        m_waiter.m_parent->m_awaiting = &m_parked;
+                    }
+                }
+
+                void unlink() noexcept
+                {
+                    if(m_waiter.m_parent)
+                    {
+                        m_waiter.m_parent->m_awaiting_handle = nullptr;
+                        m_waiter.m_parent->m_awaiting = nullptr;
+                    }
+                }
+
+                decltype(auto) await_resume()
+                {
+                    unlink();
+                    return static_cast<const shared_lazy_promise_base&>(m_coro_handle.promise()).result();
+                }
+            };
+
+            std::atomic<uint32> m_references = 1;
+            std::atomic<EState> m_state = EState::NotStarted;
+            std::mutex m_mutex;
+            shared_lazy_waiter* m_waiters = nullptr; //newest first
+            shared_lazy_waiter* m_driver = nullptr;
+        };
+    }
+
+    /***
+     * shared_lazy
+     * A lazy any number of coroutines can co_await, on any threads.  It runs once, started by the first to await it, and
+     * every awaiter gets the same result: a const reference to the value it returned, or the exception it threw, rethrown.
+     * Copies share the coroutine and its result, which lives until the last copy is gone, so keep one alive while using the result.
+     *
+     * Awaiters that arrive while it's running wait in a list, and are resumed by whichever thread finishes it.  Once it has
+     * finished, awaiting it takes no lock.  When a lazy driven by the TaskService awaits one, resuming that lazy each frame
+     * carries the shared one along if it's the one driving it, and does nothing until the result is ready if it isn't.
+     * The lazy that started it drives it.  If that lazy is destroyed first, another waiting lazy takes over, or the next
+     * one to await it does.  Any waiter can be destroyed while it waits, on the thread that resumes the waiting lazies
+    */
+    template<class T, class Allocator>
+    class [[nodiscard]] shared_lazy
+    {
+    public:
+        static_assert(std::is_void_v<T> || std::is_object_v<T>, "shared_lazy's first template argument must be void or an object type");
+
+        struct promise_type : _::promise_allocator<Allocator>, shared_lazy_promise_base<T>
+        {
+            [[nodiscard]] shared_lazy get_return_object() noexcept
+            {
+                return shared_lazy{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+        };
+
+        shared_lazy(const shared_lazy& other) noexcept
+            : m_coro_handle(other.m_coro_handle)
+        {
+            if(m_coro_handle)
+            {
+                m_coro_handle.promise().m_references.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        shared_lazy(shared_lazy&& other) noexcept
+            : m_coro_handle(std::exchange(other.m_coro_handle, {}))
+        {
+        }
+
+        shared_lazy& operator=(shared_lazy other) noexcept
+        {
+            std::swap(m_coro_handle, other.m_coro_handle);
+            return *this;
+        }
+
+        ~shared_lazy()
+        {
+            if(m_coro_handle && m_coro_handle.promise().m_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                m_coro_handle.destroy();
+            }
+        }
+
+        [[nodiscard]] typename shared_lazy_promise_base<T>::Awaiter operator co_await() const noexcept
+        {
+            auto& promise_base = static_cast<shared_lazy_promise_base<T>&>(m_coro_handle.promise());
+            return typename shared_lazy_promise_base<T>::Awaiter{ std::coroutine_handle<shared_lazy_promise_base<T>>::from_promise(promise_base) };
+        }
+
+        //Whether it has finished, so co_await won't suspend
+        [[nodiscard]] bool done() const noexcept { return m_coro_handle.promise().is_ready(); }
+
+    private:
+        explicit shared_lazy(std::coroutine_handle<promise_type> in_coro_handle) noexcept : m_coro_handle(in_coro_handle) {}
+
+        std::coroutine_handle<promise_type> m_coro_handle = nullptr;
+    };
+}
@@ -0,0 +1,199 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+#include "spdlog/spdlog.h"
+#include "spdlog/async.h"
+#include "spdlog/sinks/dist_sink.h"
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/***
+ * Logging
+ * Every logger writes through one bounded queue to a background thread, which does the formatting-to-sinks and I/O.
+ * The calling thread only pays for formatting the message and pushing it onto the queue.  Logging never blocks: if the
+ * queue is full, the oldest waiting message is dropped to make room, and counted (see dropped_messages()).
+ *
+ * Subsystems log through a raoe::log::category, which is a named logger with its own runtime level
+ * (see the log_level console command).  The RAOE_LOG_* macros also compile out entirely below RAOE_LOG_ACTIVE_LEVEL,
+ * so their arguments are never evaluated.
+ *
+ * Sinks are shared by every logger.  Add them through raoe::log::add_sink(), not by poking at a logger's sink list,
+ * since the writer thread may be using that list at the same time.
+*/
+
+#ifndef RAOE_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define RAOE_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+#else
+#define RAOE_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+#endif
+
+namespace raoe::log
+{
+    //How many messages can be waiting for the writer thread before the oldest start being dropped
+    inline constexpr size_t default_queue_size = 8192;
+
+    namespace _
+    {
+        inline std::shared_ptr<spdlog::sinks::dist_sink_mt> shared_sinks()
+        {
+            static std::shared_ptr<spdlog::sinks::dist_sink_mt> sinks = std::make_shared<spdlog::sinks::dist_sink_mt>(
+                std::vector<spdlog::sink_ptr> { std::make_shared<spdlog::sinks::stdout_color_sink_mt>() }
+            );
+            return sinks;
+        }
+
+        inline std::shared_ptr<spdlog::logger> make_logger(std::string name)
+        {
+            if(std::shared_ptr<spdlog::details::thread_pool> pool = spdlog::thread_pool())
+            {
+                return std::make_shared<spdlog::async_logger>(std::move(name), shared_sinks(), pool, spdlog::async_overflow_policy::overrun_oldest);
+            }
+            return std::make_shared<spdlog::logger>(std::move(name), shared_sinks());
+        }
+
+        inline std::mutex& create_mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+    }
+
+    /***
+     * init_async
+     * Starts the writer thread and makes the default logger (the one behind spdlog::info() and friends) asynchronous.
+     * Safe to call more than once, only the first call does anything
+    */
+    inline void init_async(size_t queue_size = default_queue_size)
+    {
+        const std::scoped_lock lock(_::create_mutex());
+        if(spdlog::thread_pool())
+        {
+            return;
+        }
+
+        spdlog::init_thread_pool(queue_size, 1);
+        std::shared_ptr<spdlog::logger> default_logger = _::make_logger("");
+        default_logger->flush_on(spdlog::level::err);
+        spdlog::set_default_logger(std::move(default_logger));
+    }
+
+    /***
+     * get
+     * Finds the logger for a subsystem, creating it at the default logger's level if it doesn't exist yet
+    */
+    inline std::shared_ptr<spdlog::logger> get(std::string_view name)
+    {
+        const std::scoped_lock lock(_::create_mutex());
+        if(std::shared_ptr<spdlog::logger> existing = spdlog::get(std::string(name)))
+        {
+            return existing;
+        }
+
+        std::shared_ptr<spdlog::logger> logger = _::make_logger(std::string(name));
+        logger->set_level(spdlog::default_logger_raw()->level());
+        logger->flush_on(spdlog::level::err);
+        spdlog::register_logger(logger);
+        return logger;
+    }
+
+    //How many messages have been dropped because the queue was full, since the writer thread started
+    inline size_t dropped_messages()
+    {
+        std::shared_ptr<spdlog::details::thread_pool> pool = spdlog::thread_pool();
+        return pool ? pool->overrun_counter() : 0;
+    }
+
+    inline void add_sink(const spdlog::sink_ptr& sink) { _::shared_sinks()->add_sink(sink); }
+    inline void remove_sink(const spdlog::sink_ptr& sink) { _::shared_sinks()->remove_sink(sink); }
+
+    //Asks every logger to flush.  With the async pipeline this returns before the flush actually happens
+    inline void flush_all()
+    {
+        spdlog::default_logger_raw()->flush();
+        spdlog::apply_all([](const std::shared_ptr<spdlog::logger>& logger) { logger->flush(); });
+    }
+
+    /***
+     * category
+     * A named logger for a subsystem.  Declare one per subsystem and log through the RAOE_LOG_* macros.
+     * The logger is looked up the first time it's used, after that it's a pointer load
+    */
+    class category
+    {
+    public:
+        explicit constexpr category(std::string_view in_name) : m_name(in_name) {}
+
+        [[nodiscard]] std::string_view name() const { return m_name; }
+
+        [[nodiscard]] spdlog::logger& logger() const
+        {
+            std::call_once(m_once, [this]() { m_logger = raoe::log::get(m_name); });
+            return *m_logger;
+        }
+
+        [[nodiscard]] bool should_log(spdlog::level::level_enum level) const { return logger().should_log(level); }
+    private:
+        std::string_view m_name;
+        mutable std::once_flag m_once;
+        mutable std::shared_ptr<spdlog::logger> m_logger;
+    };
+}
+
+#define RAOE_LOG_CALL(category, level, ...) (category).logger().log(level, __VA_ARGS__)
+
+#if RAOE_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define RAOE_LOG_TRACE(category, ...) RAOE_LOG_CALL(category, spdlog::level::trace, __VA_ARGS__)
+#else
+#define RAOE_LOG_TRACE(category, ...) (void)0
+#endif
+
+#if RAOE_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define RAOE_LOG_DEBUG(category, ...) RAOE_LOG_CALL(category, spdlog::level::debug, __VA_ARGS__)
+#else
+#define RAOE_LOG_DEBUG(category, ...) (void)0
+#endif
+
+#if RAOE_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define RAOE_LOG_INFO(category, ...) RAOE_LOG_CALL(category, spdlog::level::info, __VA_ARGS__)
+#else
+#define RAOE_LOG_INFO(category, ...) (void)0
+#endif
+
+#if RAOE_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define RAOE_LOG_WARN(category, ...) RAOE_LOG_CALL(category, spdlog::level::warn, __VA_ARGS__)
+#else
+#define RAOE_LOG_WARN(category, ...) (void)0
+#endif
+
+#if RAOE_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define RAOE_LOG_ERROR(category, ...) RAOE_LOG_CALL(category, spdlog::level::err, __VA_ARGS__)
+#else
+#define RAOE_LOG_ERROR(category, ...) (void)0
+#endif
+
+#if RAOE_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_CRITICAL
+#define RAOE_LOG_CRITICAL(category, ...) RAOE_LOG_CALL(category, spdlog::level::critical, __VA_ARGS__)
+#else
+#define RAOE_LOG_CRITICAL(category, ...) (void)0
+#endif
@@ -0,0 +1,352 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+#include "spdlog/sinks/base_sink.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace raoe::log
+{
+    /***
+     * line_store
+     * A ring of formatted log lines, for log views with a lot of scrollback.
+     *
+     * One thread appends (the line_store_sink does, under the sink's lock), and any number of threads can read at the
+     * same time without locking.  Lines are numbered from 0 in the order they were appended, and live in fixed size
+     * chunks, each with its own text blocks.  Once max_lines() have been appended, the chunk holding the oldest lines
+     * is recycled, text blocks and all, so the store never grows past its first lap.
+     *
+     * Because a line can be recycled while someone is reading it, lines are only read through read(), which copies the
+     * line out and then checks the chunk still holds it (a seqlock on the chunk's number).  Everything a reader copies,
+     * text included, is read and written through relaxed atomics, so a read that loses the race is thrown away rather
+     * than being undefined.
+    */
+    class line_store
+    {
+    public:
+        static constexpr size_t lines_per_chunk = 1024;
+        static constexpr size_t default_max_lines = 256 * lines_per_chunk;
+        static constexpr size_t text_block_size = 64 * 1024;
+        //Longer lines are cut short, so every line fits in a text block and blocks can always be reused
+        static constexpr size_t max_line_length = 16 * 1024;
+
+        explicit line_store(size_t max_lines = default_max_lines)
+            : m_max_chunks(std::max<size_t>((max_lines + lines_per_chunk - 1) / lines_per_chunk, 1))
+            , m_chunks(std::make_unique<std::atomic<chunk*>[]>(m_max_chunks))
+        {
+        }
+
+        line_store(const line_store&) = delete;
+        line_store& operator=(const line_store&) = delete;
+
+        ~line_store()
+        {
+            for(size_t i = 0; i < m_max_chunks; i++)
+            {
+                delete m_chunks[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        /***
+         * append
+         * Copies the text into the store and publishes it, recycling the oldest chunk if the store is full.
+         * Only one thread may append at a time
+        */
+        void append(spdlog::level::level_enum level, std::string_view text)
+        {
+            text = text.substr(0, max_line_length);
+            const size_t index = m_size.load(std::memory_order_relaxed);
+            const size_t number = index / lines_per_chunk;
+
+            std::atomic<chunk*>& slot = m_chunks[number % m_max_chunks];
+            chunk* target = slot.load(std::memory_order_relaxed);
+            if(!target)
+            {
+                target = new chunk();
+                target->number.store(number, std::memory_order_relaxed);
+                slot.store(target, std::memory_order_release);
+            }
+            else if(index % lines_per_chunk == 0)
+            {
+                //The lines this chunk held are gone from here on.  Readers that see any of the writes below see the
+                //new number, and throw away what they read
+                m_first.store((number + 1 - m_max_chunks) * lines_per_chunk, std::memory_order_relaxed);
+                target->number.store(number, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                target->text_block = 0;
+                target->text_used = 0;
+            }
+
+            line& written = target->lines[index % lines_per_chunk];
+            written.data.store(copy_text(*target, text), std::memory_order_relaxed);
+            written.size.store(static_cast<uint32>(text.size()), std::memory_order_relaxed);
+            written.level.store(level, std::memory_order_relaxed);
+
+            //Everything written above is visible to any reader that sees the new size
+            m_size.store(index + 1, std::memory_order_release);
+        }
+
+        //How many lines have ever been appended.  Also serves as a generation counter
+        [[nodiscard]] size_t size() const noexcept { return m_size.load(std::memory_order_acquire); }
+        //The oldest line that hasn't been recycled.  Lines [first(), size()) are in the store, as of the call
+        [[nodiscard]] size_t first() const noexcept { return m_first.load(std::memory_order_relaxed); }
+        [[nodiscard]] size_t max_lines() const noexcept { return m_max_chunks * lines_per_chunk; }
+
+        /***
+         * read
+         * Copies a line's text and level out of the store.
+         * Returns false if the line was recycled before or while it was being read, or hasn't been appended yet
+        */
+        bool read(size_t index, std::string& out_text, spdlog::level::level_enum& out_level) const
+        {
+            if(index >= size())
+            {
+                return false;
+            }
+
+            const size_t number = index / lines_per_chunk;
+            const chunk* source = m_chunks[number % m_max_chunks].load(std::memory_order_acquire);
+            if(source->number.load(std::memory_order_acquire) != number)
+            {
+                return false;
+            }
+
+            //Check the line itself wasn't torn before following its pointer.  Text blocks are never freed while the store
+            //is alive, so a pointer from an intact line is always safe to read from, even if the text is being overwritten
+            const line& stored = source->lines[index % lines_per_chunk];
+            char* const data = stored.data.load(std::memory_order_relaxed);
+            const uint32 length = stored.size.load(std::memory_order_relaxed);
+            const spdlog::level::level_enum level = stored.level.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(source->number.load(std::memory_order_relaxed) != number)
+            {
+                return false;
+            }
+
+            out_text.resize(length);
+            for(uint32 i = 0; i < length; i++)
+            {
+                out_text[i] = std::atomic_ref<char>(data[i]).load(std::memory_order_relaxed);
+            }
+            out_level = level;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return source->number.load(std::memory_order_relaxed) == number;
+        }
+
+    private:
+        struct line
+        {
+            std::atomic<char*> data = nullptr;
+            std::atomic<uint32> size = 0;
+            std::atomic<spdlog::level::level_enum> level = spdlog::level::info;
+        };
+
+        struct chunk
+        {
+            //Which chunk of the log this holds: lines [number * lines_per_chunk, (number + 1) * lines_per_chunk)
+            std::atomic<size_t> number = 0;
+            std::array<line, lines_per_chunk> lines {};
+
+            //Only touched by the appending thread.  Blocks are kept when the chunk is recycled, and filled again from the first
+            std::vector<std::unique_ptr<char[]>> text_blocks;
+            size_t text_block = 0; //the block being filled
+            size_t text_used = 0;
+        };
+
+        static char* copy_text(chunk& target, std::string_view text)
+        {
+            if(text.empty())
+            {
+                return nullptr;
+            }
+            if(target.text_used + text.size() > text_block_size)
+            {
+                target.text_block++;
+                target.text_used = 0;
+            }
+            if(target.text_block == target.text_blocks.size())
+            {
+                target.text_blocks.push_back(std::make_unique<char[]>(text_block_size));
+            }
+            char* destination = target.text_blocks[target.text_block].get() + target.text_used;
+            for(size_t i = 0; i < text.size(); i++)
+            {
+                std::atomic_ref<char>(destination[i]).store(text[i], std::memory_order_relaxed);
+            }
+            target.text_used += text.size();
+            return destination;
+        }
+
+        const size_t m_max_chunks;
+        std::unique_ptr<std::atomic<chunk*>[]> m_chunks;
+        std::atomic<size_t> m_size = 0;
+        std::atomic<size_t> m_first = 0;
+    };
+
+    /***
+     * line_store_sink
+     * A sink that formats each message once, into a line_store
+    */
+    class line_store_sink : public spdlog::sinks::base_sink<std::mutex>
+    {
+    public:
+        explicit line_store_sink(size_t max_lines = line_store::default_max_lines)
+            : m_store(max_lines)
+        {
+        }
+
+        [[nodiscard]] const line_store& store() const { return m_store; }
+
+    protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override
+        {
+            spdlog::memory_buf_t formatted;
+            formatter_->format(msg, formatted);
+            std::string_view text(formatted.data(), formatted.size());
+            while(!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+            {
+                text.remove_suffix(1);
+            }
+            m_store.append(msg.level, text);
+        }
+
+        void flush_() override {}
+
+    private:
+        line_store m_store;
+    };
+
+    /***
+     * line_filter
+     * The indices of the lines in a line_store that pass a level and substring filter.
+     *
+     * update() only looks at lines appended since the last update, unless the filter changed, so keeping a
+     * filtered view up to date costs nothing on frames where nothing was logged.  Lines the store has recycled fall off
+     * the front.  Lines before first_line() are skipped, which is how a view clears itself without touching the store
+    */
+    class line_filter
+    {
+    public:
+        void set_min_level(spdlog::level::level_enum level)
+        {
+            if(level != m_min_level)
+            {
+                m_min_level = level;
+                reset();
+            }
+        }
+
+        void set_text(std::string_view text)
+        {
+            if(text != m_text)
+            {
+                m_text = text;
+                reset();
+            }
+        }
+
+        void set_first_line(size_t first_line)
+        {
+            if(first_line != m_first_line)
+            {
+                m_first_line = first_line;
+                reset();
+            }
+        }
+
+        [[nodiscard]] spdlog::level::level_enum min_level() const { return m_min_level; }
+        [[nodiscard]] std::string_view text() const { return m_text; }
+        [[nodiscard]] size_t first_line() const { return m_first_line; }
+
+        //True if every line passes, in which case indices aren't built and row n is line first_visible() + n
+        [[nodiscard]] bool passes_everything() const { return m_text.empty() && m_min_level <= spdlog::level::trace; }
+
+        //Catches up with the store.  Returns true if the visible rows changed
+        bool update(const line_store& store)
+        {
+            const size_t size = store.size();
+            const size_t first_visible = std::max(m_first_line, store.first());
+            if(size == m_scanned && first_visible == m_first_visible && !m_dirty)
+            {
+                return false;
+            }
+            m_dirty = false;
+            m_first_visible = first_visible;
+
+            while(!m_indices.empty() && m_indices.front() < m_first_visible)
+            {
+                m_indices.pop_front();
+            }
+
+            m_scanned = std::max(m_scanned, m_first_visible);
+            if(!passes_everything())
+            {
+                spdlog::level::level_enum level = spdlog::level::info;
+                for(; m_scanned < size; m_scanned++)
+                {
+                    if(store.read(m_scanned, m_scratch, level) && level >= m_min_level 
+                        && (m_text.empty() || m_scratch.find(m_text) != std::string::npos))
+                    {
+                        m_indices.push_back(m_scanned);
+                    }
+                }
+            }
+            m_scanned = size;
+            return true;
+        }
+
+        //How many lines pass, as of the last update
+        [[nodiscard]] size_t rows() const
+        {
+            return passes_everything() ? m_scanned - std::min(m_scanned, m_first_visible) : m_indices.size();
+        }
+
+        //The store index of a row.  The store may have recycled it since the last update, so read it with line_store::read
+        [[nodiscard]] size_t line_index(size_t row) const
+        {
+            return passes_everything() ? m_first_visible + row : m_indices[row];
+        }
+
+    private:
+        void reset()
+        {
+            m_indices.clear();
+            m_scanned = 0;
+            m_dirty = true;
+        }
+
+        spdlog::level::level_enum m_min_level = spdlog::level::trace;
+        std::string m_text;
+        size_t m_first_line = 0;
+        size_t m_first_visible = 0;
+
+        std::deque<size_t> m_indices;
+        size_t m_scanned = 0;
+        bool m_dirty = true;
+        std::string m_scratch;
+    };
+}
@@ -0,0 +1,344 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/***
+ * Memory tracking
+ * Attributes heap usage to named tags ("cog:raoe", "gear:FlecsGear", "resource:raoe:type/text", ...).
+ *
+ * Every thread has an active tag, set with a scoped_tag.  Allocations are charged to whatever tag is active when they
+ * are made, and given back to the same tag when they are freed.  Engine code sets tags around cog transitions,
+ * gear construction and lifecycle, tasks, and resource loads.
+ *
+ * Memory is counted by tagged_resource (for std::pmr containers) and, if the engine is built with
+ * RAOE_TRACK_GLOBAL_ALLOCATIONS, by a replacement global operator new.  Each thread counts into its own block of counters,
+ * and report() adds the blocks up, so counting never touches a cache line another thread is writing.  A thread's block is
+ * folded into the shared counters when the thread exits.
+*/
+namespace raoe::memory
+{
+    using tag_id = uint16;
+    inline constexpr tag_id untagged = 0;
+    inline constexpr size_t max_tags = 1024;
+
+    struct tag_counters
+    {
+        std::atomic<int64> live_bytes = 0;
+        std::atomic<uint64> allocations = 0;     //ever made
+        std::atomic<uint64> allocated_bytes = 0; //ever made
+    };
+
+    //A copy of a tag's counters at the time report() was called
+    struct tag_report
+    {
+        tag_id id = untagged;
+        std::string name;
+        int64 live_bytes = 0;
+        uint64 allocations = 0;
+        uint64 allocated_bytes = 0;
+    };
+
+    namespace _
+    {
+        //constinit so that allocations during static init can be counted before anything else is constructed
+        //Counts from threads that have exited, and from threads too early or too late to have their own block
+        inline constinit std::array<tag_counters, max_tags> g_counters {};
+        inline constinit thread_local tag_id t_active_tag = untagged;
+        inline constinit std::atomic<bool> g_tracking_global_allocations = false;
+
+        //Only the owning thread writes to a block, so it can load and store instead of doing locked adds.  They are
+        //still atomics because report() reads them from another thread
+        struct thread_counters
+        {
+            std::array<tag_counters, max_tags> tags {};
+            thread_counters* next = nullptr;
+            thread_counters* previous = nullptr;
+        };
+
+        //Every live thread's block, guarded by g_thread_counters_mutex
+        inline constinit std::mutex g_thread_counters_mutex;
+        inline constinit thread_counters* g_thread_counters = nullptr;
+
+        inline constinit thread_local thread_counters* t_counters = nullptr;
+        inline constinit thread_local bool t_counters_retired = false;
+
+        //Folds a thread's block into g_counters and frees it when the thread exits
+        struct thread_counters_owner
+        {
+            thread_counters_owner() = default;
+            thread_counters_owner(const thread_counters_owner&) = delete;
+            thread_counters_owner& operator=(const thread_counters_owner&) = delete;
+            thread_counters_owner(thread_counters_owner&&) = delete;
+            thread_counters_owner& operator=(thread_counters_owner&&) = delete;
+
+            ~thread_counters_owner()
+            {
+                thread_counters* counters = t_counters;
+                //Anything this thread frees from here on goes straight to g_counters
+                t_counters = nullptr;
+                t_counters_retired = true;
+                if(counters == nullptr)
+                {
+                    return;
+                }
+
+                {
+                    const std::scoped_lock lock(g_thread_counters_mutex);
+                    for(size_t i = 0; i < max_tags; i++)
+                    {
+                        const tag_counters& from = counters->tags[i];
+                        tag_counters& to = g_counters[i];
+                        to.live_bytes.fetch_add(from.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                        to.allocations.fetch_add(from.allocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                        to.allocated_bytes.fetch_add(from.allocated_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    }
+                    (counters->previous != nullptr ? counters->previous->next : g_thread_counters) = counters->next;
+                    if(counters->next != nullptr)
+                    {
+                        counters->next->previous = counters->previous;
+                    }
+                }
+                counters->~thread_counters();
+                std::free(counters); //NOLINT paired with the malloc in local_counters
+            }
+        };
+
+        //This thread's block, made on first use.  Returns nullptr once the thread is exiting, or if the block can't be
+        //allocated.  Uses malloc so that counting an operator new never calls operator new
+        inline thread_counters* local_counters() noexcept
+        {
+            if(t_counters != nullptr || t_counters_retired)
+            {
+                return t_counters;
+            }
+
+            void* memory = std::malloc(sizeof(thread_counters)); //NOLINT see above
+            if(memory == nullptr)
+            {
+                return nullptr;
+            }
+            auto* counters = new(memory) thread_counters();
+            {
+                const std::scoped_lock lock(g_thread_counters_mutex);
+                counters->next = g_thread_counters;
+                if(g_thread_counters != nullptr)
+                {
+                    g_thread_counters->previous = counters;
+                }
+                g_thread_counters = counters;
+            }
+            t_counters = counters;
+            //Touching the owner is what registers its destructor for this thread
+            static thread_local thread_counters_owner owner;
+            (void)owner;
+            return counters;
+        }
+
+        template<typename T, typename U>
+        void add_local(std::atomic<T>& counter, U amount) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + static_cast<T>(amount), std::memory_order_relaxed);
+        }
+
+        struct tag_registry
+        {
+            std::mutex mutex;
+            std::vector<std::string> names { "untagged" };
+            std::map<std::string, tag_id, std::less<>> ids;
+        };
+
+        inline tag_registry& registry()
+        {
+            static tag_registry registry;
+            return registry;
+        }
+    }
+
+    /***
+     * register_tag
+     * Returns the id for a tag name, creating it if this is the first time the name is seen.
+     * Takes a lock, so look tags up once and hold on to the id where it matters.
+     * If every tag is used up, returns untagged
+    */
+    inline tag_id register_tag(std::string_view name)
+    {
+        _::tag_registry& registry = _::registry();
+        const std::scoped_lock lock(registry.mutex);
+        if(auto itr = registry.ids.find(name); itr != registry.ids.end())
+        {
+            return itr->second;
+        }
+        if(registry.names.size() >= max_tags)
+        {
+            return untagged;
+        }
+
+        const auto id = static_cast<tag_id>(registry.names.size());
+        registry.names.emplace_back(name);
+        registry.ids.emplace(std::string(name), id);
+        return id;
+    }
+
+    inline std::string tag_name(tag_id id)
+    {
+        _::tag_registry& registry = _::registry();
+        const std::scoped_lock lock(registry.mutex);
+        return id < registry.names.size() ? registry.names[id] : std::string();
+    }
+
+    inline tag_id active_tag() noexcept { return _::t_active_tag; }
+
+    //True if global operator new is being counted, not just tagged_resources
+    inline bool tracking_global_allocations() noexcept { return _::g_tracking_global_allocations.load(std::memory_order_relaxed); }
+
+    inline void record_allocation(tag_id tag, size_t bytes) noexcept
+    {
+        if(_::thread_counters* local = _::local_counters())
+        {
+            tag_counters& counters = local->tags[tag];
+            _::add_local(counters.live_bytes, bytes);
+            _::add_local(counters.allocations, 1);
+            _::add_local(counters.allocated_bytes, bytes);
+            return;
+        }
+
+        tag_counters& counters = _::g_counters[tag];
+        counters.live_bytes.fetch_add(static_cast<int64>(bytes), std::memory_order_relaxed);
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        counters.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    //Memory freed on another thread than it was allocated on leaves that thread's live_bytes negative, which the sum evens out
+    inline void record_deallocation(tag_id tag, size_t bytes) noexcept
+    {
+        if(_::thread_counters* local = _::local_counters())
+        {
+            _::add_local(local->tags[tag].live_bytes, -static_cast<int64>(bytes));
+            return;
+        }
+        _::g_counters[tag].live_bytes.fetch_sub(static_cast<int64>(bytes), std::memory_order_relaxed);
+    }
+
+    /***
+     * scoped_tag
+     * Makes a tag active on this thread until the scope ends
+    */
+    class scoped_tag
+    {
+    public:
+        explicit scoped_tag(tag_id tag) noexcept
+            : m_previous(_::t_active_tag)
+        {
+            _::t_active_tag = tag;
+        }
+        explicit scoped_tag(std::string_view name)
+            : scoped_tag(register_tag(name))
+        {
+        }
+        ~scoped_tag() { _::t_active_tag = m_previous; }
+
+        scoped_tag(const scoped_tag&) = delete;
+        scoped_tag& operator=(const scoped_tag&) = delete;
+        scoped_tag(scoped_tag&&) = delete;
+        scoped_tag& operator=(scoped_tag&&) = delete;
+    private:
+        tag_id m_previous;
+    };
+
+    /***
+     * tagged_resource
+     * A std::pmr::memory_resource that charges everything allocated through it to one tag
+    */
+    class tagged_resource : public std::pmr::memory_resource
+    {
+    public:
+        explicit tagged_resource(tag_id in_tag, std::pmr::memory_resource* in_upstream = std::pmr::get_default_resource())
+            : m_tag(in_tag)
+            , m_upstream(in_upstream)
+        {
+        }
+
+        [[nodiscard]] tag_id tag() const { return m_tag; }
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            void* ptr = m_upstream->allocate(bytes, alignment);
+            record_allocation(m_tag, bytes);
+            return ptr;
+        }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+        {
+            record_deallocation(m_tag, bytes);
+            m_upstream->deallocate(ptr, bytes, alignment);
+        }
+
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        tag_id m_tag;
+        std::pmr::memory_resource* m_upstream;
+    };
+
+    /***
+     * report
+     * Snapshots the counters of every registered tag, adding up every thread's counts
+    */
+    inline std::vector<tag_report> report()
+    {
+        std::vector<tag_report> reports;
+        _::tag_registry& registry = _::registry();
+        const std::scoped_lock lock(registry.mutex);
+        reports.reserve(registry.names.size());
+        for(size_t i = 0; i < registry.names.size(); i++)
+        {
+            const tag_counters& counters = _::g_counters[i];
+            reports.push_back(tag_report {
+                static_cast<tag_id>(i),
+                registry.names[i],
+                counters.live_bytes.load(std::memory_order_relaxed),
+                counters.allocations.load(std::memory_order_relaxed),
+                counters.allocated_bytes.load(std::memory_order_relaxed),
+            });
+        }
+
+        const std::scoped_lock threads_lock(_::g_thread_counters_mutex);
+        for(const _::thread_counters* thread = _::g_thread_counters; thread != nullptr; thread = thread->next)
+        {
+            for(tag_report& report : reports)
+            {
+                const tag_counters& counters = thread->tags[report.id];
+                report.live_bytes += counters.live_bytes.load(std::memory_order_relaxed);
+                report.allocations += counters.allocations.load(std::memory_order_relaxed);
+                report.allocated_bytes += counters.allocated_bytes.load(std::memory_order_relaxed);
+            }
+        }
+        return reports;
+    }
+}
@@ -15,11 +15,13 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 */
 #pragma once
 
+#include <array>
 #include <string>
+#include <string_view>
 #include <tuple>
-#include <cctype>
 #include <iterator>
-#include <functional>
+#include <type_traits>
+#include <vector>
 #include "types.hpp"
 #include "from_string.hpp"
 
@@ -28,64 +30,75 @@ namespace raoe::core::parse
     inline namespace _
     {
         //Escaped checks if there is a \ before the cursor character (used when escaping sequences)
-        inline bool is_escaped(std::string_view sv, int32 cursor) 
+        constexpr bool is_escaped(std::string_view sv, size_t cursor) 
         {
-            const bool out_of_range = (cursor - 1) < 0;
-            return !out_of_range && sv[cursor-1] == '\\'; 
+            return cursor > 0 && sv[cursor - 1] == '\\'; 
         };
 
         //Checks for if the cursor is on a whitespace char
-        inline bool is_whitespace(std::string_view sv, int32 cursor) 
+        constexpr bool is_whitespace(std::string_view sv, size_t cursor) 
         { 
-            return !!(std::isblank(sv.at(cursor))); 
+            return sv[cursor] == ' ' || sv[cursor] == '\t'; 
         };
 
-        inline bool is_quote(std::string_view sv, int32 cursor)
+        constexpr bool is_quote(std::string_view sv, size_t cursor)
         { 
             return sv[cursor] == '\"' && !is_escaped(sv, cursor); 
         }; 
         //Parse ", but if we see a \" skip that.             
-        inline bool is_control(std::string_view sv, int32 cursor) 
+        constexpr bool is_control(std::string_view sv, size_t cursor) 
         { 
             return is_whitespace(sv, cursor) || is_quote(sv, cursor);
         };
-        
-        inline void parse_split(std::string_view from, std::output_iterator<std::string_view> auto out_itr)
-        {          
-            using ScanFunc_T = std::function<bool(std::string_view, int32)>;
 
-            int32 cursor = 0;   
-            while(cursor < from.length())
+        /***
+         * next_token
+         * Scans one token starting at cursor, and leaves cursor just past it.  Returns false when there are no tokens left.
+         * A token is a run of non-whitespace, or everything up to the closing quote if it was opened with a quote.
+        */
+        constexpr bool next_token(std::string_view from, size_t& cursor, std::string_view& out_token)
+        {
+            //Walk the cursor up to the first non-control character
+            while(cursor < from.length() && is_control(from, cursor))
             {
-                //Walk the cursor up to the first non-control character
-                while(cursor < from.length() && is_control(from, cursor))
-                {
-                    cursor++;
-                }
+                cursor++;
+            }
 
-                //if we are at the end of the string, we're done
-                if(cursor >= from.length())
-                {
-                    return;
-                }
+            //if we are at the end of the string, we're done
+            if(cursor >= from.length())
+            {
+                return false;
+            }
 
-                int32 start = cursor;
-                //Determine if the character right before the cursor is what we are looking for
-                ScanFunc_T search_query = is_whitespace;
-                if(((cursor - 1) >= 0) && is_quote(from, cursor - 1))
+            const size_t start = cursor;
+            //If the character right before the token is a quote, the token runs to the next quote.  Otherwise to the next whitespace
+            if(cursor > 0 && is_quote(from, cursor - 1))
+            {
+                while(cursor < from.length() && !is_quote(from, cursor))
                 {
-                    search_query = is_quote;
+                    cursor++;
                 }
-
-                //Walk the cursor forward until we match what we are looking for (or we hit the end of the string)
-                while(cursor < from.length() && !search_query(from, cursor))
+            }
+            else
+            {
+                while(cursor < from.length() && !is_whitespace(from, cursor))
                 {
                     cursor++;
-                }             
+                }
+            }
 
-                //substring from start to cursor, add it to the out iterator   
-                *out_itr++ = from.substr(start, cursor - start);  
-            }  
+            out_token = from.substr(start, cursor - start);  
+            return true;
+        }
+        
+        inline void parse_split(std::string_view from, std::output_iterator<std::string_view> auto out_itr)
+        {          
+            size_t cursor = 0;
+            std::string_view token;
+            while(next_token(from, cursor, token))
+            {
+                *out_itr++ = token;
+            }
         }
 
         inline std::vector<std::string_view> parse_split(std::string_view from)
@@ -95,32 +108,92 @@ namespace raoe::core::parse
             return elems;
         }
 
-        template<typename Tuple, std::size_t... I>
-        std::array<bool, sizeof...(I)> parse_string_as_tuple(std::string_view command_line, Tuple& value, std::index_sequence<I...>)
+        //The tokens of a line, split into storage sized for exactly the number of arguments expected
+        template<size_t N>
+        struct split_tokens
         {
-            using namespace raoe::string;
+            std::array<std::string_view, N> tokens {};
+            size_t count = 0;                //how many of tokens were filled in
+            std::string_view first_extra {}; //the first token past N, if there were too many
+        };
 
-            std::vector<std::string_view> elems = parse_split(command_line);
-            //Pad out the elements in the vector if there are fewer elements than we expect.  
-            //this means we will pass "" for strings not provided by the user
-            //this is fine, as the from_string() call will return false if it fails to parse an empty string
-            for(int32 i = elems.size(); i < sizeof...(I); i++)
+        template<size_t N>
+        constexpr split_tokens<N> parse_split_fixed(std::string_view from)
+        {
+            split_tokens<N> result;
+            size_t cursor = 0;
+            std::string_view token;
+            while(next_token(from, cursor, token))
             {
-                elems.push_back(std::string_view());
+                if(result.count == N)
+                {
+                    result.first_extra = token;
+                    break;
+                }
+                result.tokens[result.count++] = token;
             }
-
-            return { from_string(elems[I], std::get<I>(value))... };
-        }   
+            return result;
+        }
     }
 
-   
+    enum class argument_error : uint8
+    {
+        none,
+        missing, //the line ran out of tokens before this argument
+        invalid, //the token couldn't be converted to the argument's type
+    };
+
+    template<size_t N>
+    struct argument_errors
+    {
+        std::array<argument_error, N> arguments {};
+        std::array<std::string_view, N> tokens {}; //the token each argument was parsed from
+        std::string_view first_extra {};           //not empty if the line had more tokens than arguments
 
+        [[nodiscard]] bool too_many() const { return !first_extra.empty(); }
+        [[nodiscard]] bool ok() const
+        {
+            for(const argument_error error : arguments)
+            {
+                if(error != argument_error::none)
+                {
+                    return false;
+                }
+            }
+            return !too_many();
+        }
+    };
+
+    /***
+     * parse_arguments
+     * Splits str and converts each token into the matching element of out_values, without allocating 
+     * (unless an argument type itself allocates, like std::string).  Reports what went wrong for each argument
+    */
+    template<typename... Args>
+    argument_errors<sizeof...(Args)> parse_arguments(std::string_view str, std::tuple<Args...>& out_values)
+    {
+        constexpr size_t N = sizeof...(Args);
+        const split_tokens<N> split = parse_split_fixed<N>(str);
+
+        argument_errors<N> errors;
+        errors.tokens = split.tokens;
+        errors.first_extra = split.first_extra;
+        [&]<size_t... I>(std::index_sequence<I...>)
+        {
+            using raoe::string::from_string;
+            ((errors.arguments[I] = I >= split.count ? argument_error::missing
+                : from_string(split.tokens[I], std::get<I>(out_values)) ? argument_error::none 
+                : argument_error::invalid), ...);
+        }(std::make_index_sequence<N>{});
+        return errors;
+    }
+
+    //Parses what it can out of str.  Arguments that are missing or don't parse are left default constructed
     template<typename... Args>       
     std::tuple<Args...> parse_tuple(std::string_view str)
     {
         std::tuple<Args...> tuple;
-        auto results = parse_string_as_tuple(str, tuple, std::make_index_sequence<sizeof...(Args)>{});
-
+        parse_arguments(str, tuple);
         return tuple;
     }
 }
\ No newline at end of file
@@ -0,0 +1,384 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//Set RAOE_PROFILING to 0 to compile every profile zone out of the build
+#ifndef RAOE_PROFILING
+#define RAOE_PROFILING 1
+#endif
+
+namespace raoe::profile
+{
+    //Timestamps come from the TSC where we have it, as it's a single instruction.  Otherwise use the steady clock
+    inline uint64 now_ticks() noexcept
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /***
+     * clock_reference
+     * A (ticks, steady_clock) pair taken at startup.  Converting ticks to real time compares against a second pair taken
+     * when the conversion is needed, so nothing has to sit and calibrate the TSC
+    */
+    struct clock_reference
+    {
+        uint64 ticks = now_ticks();
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+    };
+
+    inline const clock_reference& startup_reference()
+    {
+        static const clock_reference reference;
+        return reference;
+    }
+
+    //Nanoseconds per tick, measured over everything since startup
+    inline double ns_per_tick()
+    {
+        const clock_reference& start = startup_reference();
+        const clock_reference now;
+        const double elapsed_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time - start.time).count());
+        const double elapsed_ticks = static_cast<double>(now.ticks - start.ticks);
+        return elapsed_ticks > 0 ? elapsed_ns / elapsed_ticks : 1.0;
+    }
+
+    struct zone_event
+    {
+        std::string_view name; //must outlive the profiler data, so string literals, or intern() anything else
+        uint64 start = 0;
+        uint64 end = 0;
+        uint32 depth = 0;
+    };
+
+    /***
+     * thread_buffer
+     * A ring of the most recent zones recorded on one thread.  Only the owning thread writes to it.
+     * Readers copy out of it without stopping the writer and throw away anything the writer may have lapped while they were copying.
+     * Buffers are created and freed under the registry's mutex, which readers hold while they copy (see capture)
+    */
+    class thread_buffer
+    {
+    public:
+        static constexpr size_t capacity = 1 << 16;
+
+        explicit thread_buffer(std::thread::id in_thread_id, uint32 in_index)
+            : thread_id(in_thread_id)
+            , index(in_index)
+        {
+        }
+
+        void write(const zone_event& event) noexcept
+        {
+            const uint64 position = m_written.load(std::memory_order_relaxed);
+            //A reader that copies any of the new event also sees this slot's position was published, so it knows the slot is
+            //being overwritten (see read)
+            std::atomic_thread_fence(std::memory_order_release);
+            slot& target = m_events[position % capacity];
+            std::atomic_ref(target.name_data).store(event.name.data(), std::memory_order_relaxed);
+            std::atomic_ref(target.name_size).store(event.name.size(), std::memory_order_relaxed);
+            std::atomic_ref(target.start).store(event.start, std::memory_order_relaxed);
+            std::atomic_ref(target.end).store(event.end, std::memory_order_relaxed);
+            std::atomic_ref(target.depth).store(event.depth, std::memory_order_relaxed);
+            m_written.store(position + 1, std::memory_order_release);
+        }
+
+        //Copies out every event that is still in the ring, oldest first
+        void read(std::vector<zone_event>& out_events) const
+        {
+            const uint64 written = m_written.load(std::memory_order_acquire);
+            const uint64 first = std::max(written > capacity ? written - capacity : 0, first_valid);
+            out_events.reserve(out_events.size() + static_cast<size_t>(written - first));
+            const size_t read_start = out_events.size();
+            for(uint64 i = first; i < written; i++)
+            {
+                //The writer may be filling it as we read, so its fields are read atomically, and checked below
+                slot& source = m_events[i % capacity];
+                const char* const name_data = std::atomic_ref(source.name_data).load(std::memory_order_relaxed);
+                const size_t name_size = std::atomic_ref(source.name_size).load(std::memory_order_relaxed);
+                out_events.push_back(zone_event {
+                    .name = std::string_view(name_data, name_size),
+                    .start = std::atomic_ref(source.start).load(std::memory_order_relaxed),
+                    .end = std::atomic_ref(source.end).load(std::memory_order_relaxed),
+                    .depth = std::atomic_ref(source.depth).load(std::memory_order_relaxed),
+                });
+            }
+
+            if(retired)
+            {
+                return; //nobody is writing any more
+            }
+
+            //Anything the writer may have overwritten while we were copying is garbage, including the slot it's filling now.
+            //The fence keeps the copy above from being read after this
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64 written_after = m_written.load(std::memory_order_relaxed);
+            const uint64 lapped = written_after + 1 > capacity ? written_after + 1 - capacity : 0;
+            if(lapped > first)
+            {
+                const auto garbage = static_cast<std::ptrdiff_t>(std::min(lapped - first, written - first));
+                out_events.erase(out_events.begin() + static_cast<std::ptrdiff_t>(read_start), out_events.begin() + static_cast<std::ptrdiff_t>(read_start) + garbage);
+            }
+        }
+
+        [[nodiscard]] uint64 written() const noexcept { return m_written.load(std::memory_order_acquire); }
+
+        const std::thread::id thread_id;
+        const uint32 index;
+        //Guarded by the registry's mutex
+        bool retired = false; //its thread has exited
+        uint64 first_valid = 0; //events before this were discarded
+    private:
+        //A zone_event, split into fields that std::atomic_ref can read and write
+        struct slot
+        {
+            const char* name_data = nullptr;
+            size_t name_size = 0;
+            uint64 start = 0;
+            uint64 end = 0;
+            uint32 depth = 0;
+        };
+
+        std::atomic<uint64> m_written = 0;
+        mutable std::array<slot, capacity> m_events {};
+    };
+
+    namespace _
+    {
+        inline std::atomic<uint32> g_thread_count = 0;
+        inline std::atomic<bool> g_enabled = true;
+
+        //The buffers of every thread that's recording, and of the last few threads that exited, so their zones can still be read
+        struct buffer_registry
+        {
+            static constexpr size_t MaxRetiredBuffers = 4;
+
+            std::mutex mutex;
+            std::vector<std::unique_ptr<thread_buffer>> buffers;
+            std::deque<thread_buffer*> retired; //oldest first
+        };
+
+        //Never destroyed, the main thread's buffer can be retired after static destructors have run
+        inline buffer_registry& registry()
+        {
+            static buffer_registry* registry = new buffer_registry(); //NOLINT intentionally leaked
+            return *registry;
+        }
+
+        //Hands the buffer back to the registry when its thread exits, which frees the oldest retired buffers past MaxRetiredBuffers
+        struct thread_buffer_owner
+        {
+            thread_buffer* buffer;
+
+            thread_buffer_owner()
+            {
+                buffer_registry& buffers = registry();
+                const std::lock_guard lock(buffers.mutex);
+                buffer = buffers.buffers.emplace_back(std::make_unique<thread_buffer>(std::this_thread::get_id(), g_thread_count.fetch_add(1, std::memory_order_relaxed))).get();
+            }
+
+            ~thread_buffer_owner()
+            {
+                buffer_registry& buffers = registry();
+                const std::lock_guard lock(buffers.mutex);
+                buffer->retired = true;
+                buffers.retired.push_back(buffer);
+                while(buffers.retired.size() > buffer_registry::MaxRetiredBuffers)
+                {
+                    const thread_buffer* const oldest = buffers.retired.front();
+                    buffers.retired.pop_front();
+                    std::erase_if(buffers.buffers, [oldest](const std::unique_ptr<thread_buffer>& stored) { return stored.get() == oldest; });
+                }
+            }
+
+            thread_buffer_owner(const thread_buffer_owner&) = delete;
+            thread_buffer_owner& operator=(const thread_buffer_owner&) = delete;
+        };
+
+        inline thread_buffer& this_thread_buffer()
+        {
+            thread_local thread_buffer_owner owner;
+            return *owner.buffer;
+        }
+
+        inline uint32& this_thread_depth()
+        {
+            thread_local uint32 depth = 0;
+            return depth;
+        }
+    }
+
+    inline bool enabled() { return _::g_enabled.load(std::memory_order_relaxed); }
+    inline void set_enabled(bool in_enabled) { _::g_enabled.store(in_enabled, std::memory_order_relaxed); }
+
+    /***
+     * scoped_zone
+     * Records the time between construction and destruction as a zone on this thread.  Use RAOE_PROFILE_SCOPE instead of this directly
+    */
+    class scoped_zone
+    {
+    public:
+        explicit scoped_zone(std::string_view in_name) noexcept
+            : m_name(in_name)
+            , m_active(enabled())
+        {
+            if(m_active)
+            {
+                m_depth = _::this_thread_depth()++;
+                m_start = now_ticks();
+            }
+        }
+
+        ~scoped_zone()
+        {
+            if(m_active)
+            {
+                const uint64 end = now_ticks();
+                _::this_thread_depth()--;
+                _::this_thread_buffer().write(zone_event { m_name, m_start, end, m_depth });
+            }
+        }
+
+        scoped_zone(const scoped_zone&) = delete;
+        scoped_zone& operator=(const scoped_zone&) = delete;
+        scoped_zone(scoped_zone&&) = delete;
+        scoped_zone& operator=(scoped_zone&&) = delete;
+    private:
+        std::string_view m_name;
+        uint64 m_start = 0;
+        uint32 m_depth = 0;
+        bool m_active;
+    };
+
+    struct thread_capture
+    {
+        std::thread::id thread_id;
+        uint32 index = 0;
+        std::vector<zone_event> events;
+    };
+
+    //Copies the current contents of every thread's ring buffer.  Safe to call from any thread while others are recording
+    inline std::vector<thread_capture> capture()
+    {
+        std::vector<thread_capture> captures;
+        _::buffer_registry& registry = _::registry();
+        const std::lock_guard lock(registry.mutex);
+        for(const std::unique_ptr<thread_buffer>& buffer : registry.buffers)
+        {
+            thread_capture& captured = captures.emplace_back(thread_capture { buffer->thread_id, buffer->index, {} });
+            buffer->read(captured.events);
+        }
+        std::ranges::sort(captures, {}, &thread_capture::index);
+        return captures;
+    }
+
+    /***
+     * discard_recorded
+     * Forgets every zone recorded so far.  Zone names are only pointed at, so call this before unloading a library whose
+     * string literals may name some of them
+    */
+    inline void discard_recorded()
+    {
+        _::buffer_registry& registry = _::registry();
+        const std::lock_guard lock(registry.mutex);
+        for(const std::unique_ptr<thread_buffer>& buffer : registry.buffers)
+        {
+            buffer->first_valid = buffer->written();
+        }
+    }
+
+    //A copy of name that lives as long as the program, for naming zones after things that don't, like a cog.  Takes a lock, so not for hot paths
+    inline std::string_view intern(std::string_view name)
+    {
+        static std::mutex mutex;
+        static std::unordered_set<std::string> names;
+        const std::lock_guard lock(mutex);
+        return *names.emplace(name).first;
+    }
+
+    //Writes a capture in the Chrome trace event format (load it in chrome://tracing or https://ui.perfetto.dev)
+    inline void write_chrome_trace(std::ostream& out, const std::vector<thread_capture>& captures)
+    {
+        const uint64 origin = startup_reference().ticks;
+        const double us_per_tick = ns_per_tick() / 1000.0;
+
+        auto write_escaped = [&out](std::string_view str)
+        {
+            for(char c : str)
+            {
+                if(c == '"' || c == '\\')
+                {
+                    out << '\\';
+                }
+                out << c;
+            }
+        };
+
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for(const thread_capture& captured : captures)
+        {
+            for(const zone_event& event : captured.events)
+            {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                out << "{\"name\":\"";
+                write_escaped(event.name);
+                out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << captured.index
+                    << ",\"ts\":" << static_cast<double>(event.start - origin) * us_per_tick
+                    << ",\"dur\":" << static_cast<double>(event.end - event.start) * us_per_tick << "}";
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+}
+
+#define RAOE_PROFILE_CONCAT_2(a, b) a##b
+#define RAOE_PROFILE_CONCAT(a, b) RAOE_PROFILE_CONCAT_2(a, b)
+
+#if RAOE_PROFILING
+    #define RAOE_PROFILE_SCOPE(name) const raoe::profile::scoped_zone RAOE_PROFILE_CONCAT(raoe_profile_zone_, __LINE__)(name)
+    #define RAOE_PROFILE_FUNCTION() RAOE_PROFILE_SCOPE(std::source_location::current().function_name())
+#else
+    #define RAOE_PROFILE_SCOPE(name)
+    #define RAOE_PROFILE_FUNCTION()
+#endif
@@ -0,0 +1,242 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "types.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/***
+ * Startup Trace
+ * A timeline of how the engine got to its first frame: static initialization, service and cog startup, every gear,
+ * startup task and resource load.  Unlike the profiler's rings, nothing is overwritten, and span names are copied,
+ * so the trace is still complete (and its names still valid) long after startup.
+ *
+ * Spans can only start while the trace is recording.  finish() stops it, once the first frame is done, but spans already
+ * started (like a startup task that runs for a few frames) are still recorded when they end.  Recording is a lock and a
+ * push_back per span, which is nothing next to what's being measured
+*/
+
+namespace raoe::startup_trace
+{
+    struct span
+    {
+        std::string category; //what kind of thing this is: "engine", "cog", "gear", "task", "resource"
+        std::string name;
+        uint64 start = 0; //profile ticks, see raoe::profile::now_ticks
+        uint64 end = 0;
+        uint32 thread = 0; //the order threads first recorded a span in, the main thread (usually) being 0
+    };
+
+    namespace _
+    {
+        struct trace_data
+        {
+            std::mutex mutex;
+            std::vector<span> spans;
+            std::vector<std::thread::id> threads;
+        };
+
+        inline trace_data& data()
+        {
+            static trace_data trace;
+            return trace;
+        }
+
+        inline std::atomic<bool> g_recording = true;
+        inline std::atomic<uint64> g_first_static_init = 0;
+        inline std::atomic<uint64> g_last_static_init = 0;
+        inline std::atomic<uint32> g_static_init_count = 0;
+        inline std::atomic<uint64> g_finished_at = 0;
+    }
+
+    [[nodiscard]] inline bool recording() { return _::g_recording.load(std::memory_order_relaxed); }
+
+    //Adds a span that has already ended.  Ignored if the trace isn't recording and the span started after it stopped
+    inline void record(std::string_view category, std::string_view name, uint64 start, uint64 end)
+    {
+        const uint64 finished_at = _::g_finished_at.load(std::memory_order_relaxed);
+        if(finished_at != 0 && start > finished_at)
+        {
+            return;
+        }
+
+        _::trace_data& trace = _::data();
+        const std::scoped_lock lock(trace.mutex);
+        auto thread = std::ranges::find(trace.threads, std::this_thread::get_id());
+        if(thread == trace.threads.end())
+        {
+            thread = trace.threads.insert(trace.threads.end(), std::this_thread::get_id());
+        }
+        trace.spans.push_back(span { std::string(category), std::string(name), start, end, static_cast<uint32>(thread - trace.threads.begin()) });
+    }
+
+    /***
+     * mark_static_init
+     * Notes that something was registered during static initialization.  The registrations become one span, from the first
+     * to the last.  Doesn't allocate or lock, so it's safe from any static constructor
+    */
+    inline void mark_static_init() noexcept
+    {
+        if(!recording())
+        {
+            return;
+        }
+        //Pins the trace's origin (the profiler's clock reference) at or before the first registration
+        (void)profile::startup_reference();
+        const uint64 now = profile::now_ticks();
+        uint64 expected = 0;
+        _::g_first_static_init.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+        _::g_last_static_init.store(now, std::memory_order_relaxed);
+        _::g_static_init_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /***
+     * scoped_span
+     * Records the time between construction and destruction, if the trace was recording when it was constructed.
+     * Use it directly where the name is built at runtime, or RAOE_STARTUP_TRACE_SCOPE
+    */
+    class scoped_span
+    {
+    public:
+        scoped_span(std::string_view in_category, std::string_view in_name)
+            : m_active(recording())
+        {
+            if(m_active)
+            {
+                m_category = in_category;
+                m_name = in_name;
+                m_start = profile::now_ticks();
+            }
+        }
+
+        ~scoped_span()
+        {
+            end();
+        }
+
+        //Ends the span early.  Does nothing after the first call
+        void end()
+        {
+            if(m_active)
+            {
+                m_active = false;
+                record(m_category, m_name, m_start, profile::now_ticks());
+            }
+        }
+
+        scoped_span(const scoped_span&) = delete;
+        scoped_span& operator=(const scoped_span&) = delete;
+        scoped_span(scoped_span&&) = delete;
+        scoped_span& operator=(scoped_span&&) = delete;
+    private:
+        std::string m_category;
+        std::string m_name;
+        uint64 m_start = 0;
+        bool m_active;
+    };
+
+    //Stops new spans from starting, and records the static initialization span.  The engine calls it after the first frame
+    inline void finish()
+    {
+        if(!_::g_recording.exchange(false))
+        {
+            return;
+        }
+        const uint64 now = profile::now_ticks();
+        if(const uint32 count = _::g_static_init_count.load(std::memory_order_relaxed); count > 0)
+        {
+            record("static init", std::to_string(count) + " registrations", _::g_first_static_init.load(), _::g_last_static_init.load());
+        }
+        record("engine", "startup to first frame", profile::startup_reference().ticks, now);
+        _::g_finished_at.store(now, std::memory_order_relaxed);
+    }
+
+    //A copy of every span recorded so far, in the order they ended
+    [[nodiscard]] inline std::vector<span> spans()
+    {
+        _::trace_data& trace = _::data();
+        const std::scoped_lock lock(trace.mutex);
+        return trace.spans;
+    }
+
+    //Starts the trace over.  Only for tests
+    inline void reset()
+    {
+        _::trace_data& trace = _::data();
+        const std::scoped_lock lock(trace.mutex);
+        trace.spans.clear();
+        trace.threads.clear();
+        _::g_recording = true;
+        _::g_finished_at = 0;
+        _::g_first_static_init = 0;
+        _::g_last_static_init = 0;
+        _::g_static_init_count = 0;
+    }
+
+    //Writes spans in the Chrome trace event format, with the category as each event's cat (load it in chrome://tracing or https://ui.perfetto.dev)
+    inline void write_chrome_trace(std::ostream& out, const std::vector<span>& in_spans)
+    {
+        const uint64 origin = profile::startup_reference().ticks;
+        const double us_per_tick = profile::ns_per_tick() / 1000.0;
+
+        auto write_escaped = [&out](std::string_view str)
+        {
+            for(char c : str)
+            {
+                if(c == '"' || c == '\\')
+                {
+                    out << '\\';
+                }
+                out << c;
+            }
+        };
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for(const span& traced : in_spans)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"";
+            write_escaped(traced.name);
+            out << "\",\"cat\":\"";
+            write_escaped(traced.category);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << traced.thread
+                << ",\"ts\":" << static_cast<double>(traced.start - origin) * us_per_tick
+                << ",\"dur\":" << static_cast<double>(traced.end - traced.start) * us_per_tick << "}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    //The spans, longest first
+    [[nodiscard]] inline std::vector<span> sorted_by_duration(std::vector<span> in_spans)
+    {
+        std::ranges::stable_sort(in_spans, std::ranges::greater(), [](const span& traced) { return traced.end - traced.start; });
+        return in_spans;
+    }
+}
+
+//Unlike RAOE_PROFILE_SCOPE, this stays in every build, so startup can be compared release to release
+#define RAOE_STARTUP_TRACE_SCOPE(category, name) raoe::startup_trace::scoped_span RAOE_PROFILE_CONCAT(raoe_startup_span_, __LINE__)(category, name)
@@ -16,13 +16,16 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #pragma once
 
+#include "byte_search.hpp"
+
 #include <algorithm>
 #include <locale>
 #include <cctype>
-#include <sstream>
 #include <iterator>
+#include <ranges>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <iterator>
 
 namespace raoe::string
 {    
@@ -75,68 +78,265 @@ namespace raoe::string
         return s;
     }
 
-    static inline void split(const std::string& s, char delim, std::output_iterator<std::string> auto out_itr)
+    //Left Trim a string_view.  Removes whitespace (space, \t, \n, \v, \f and \r) from the left side
+    inline std::string_view trim_l(std::string_view s)
     {
-        std::istringstream iss(s);
-        std::string item;
-        while(std::getline(iss, item, delim))
+        const size_t first = find_first_not(s, byte_class::whitespace {});
+        return first == std::string_view::npos ? std::string_view() : s.substr(first);
+    }
+
+    //Right Trim a string_view.  Removes whitespace from the right side
+    inline std::string_view trim_r(std::string_view s)
+    {
+        const size_t last = find_last_not(s, byte_class::whitespace {});
+        return last == std::string_view::npos ? std::string_view() : s.substr(0, last + 1);
+    }
+
+    inline std::string_view trim(std::string_view s)
+    {
+        return trim_r(trim_l(s));
+    }
+
+    /***
+     * split_view
+     * The fields of a string_view between delimiters, found as the view is iterated.  Nothing is allocated or copied:
+     * each field is a view into the source, so the source has to outlive them.
+     *
+     * Like std::views::split, every delimiter ends a field, so adjacent delimiters give empty fields and a trailing
+     * delimiter gives an empty last field.  An empty source has no fields, and an empty delimiter never matches
+    */
+    template<typename Delimiter>
+    class split_view : public std::ranges::view_interface<split_view<Delimiter>>
+    {
+    public:
+        class iterator
         {
-            if(!item.empty())
+        public:
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+            using iterator_category = std::forward_iterator_tag;
+
+            iterator() = default;
+            iterator(std::string_view in_source, Delimiter in_delimiter)
+                : m_source(in_source)
+                , m_delimiter(in_delimiter)
+                , m_field_end(in_source.empty() ? 0 : field_end(0))
+                , m_done(in_source.empty())
+            {
+            }
+
+            [[nodiscard]] std::string_view operator*() const { return m_source.substr(m_field_begin, m_field_end - m_field_begin); }
+
+            iterator& operator++()
             {
-                *out_itr++ = item;
+                if(m_field_end == m_source.size())
+                {
+                    m_done = true;
+                }
+                else
+                {
+                    m_field_begin = m_field_end + delimiter_size();
+                    m_field_end = field_end(m_field_begin);
+                }
+                return *this;
             }
+
+            iterator operator++(int)
+            {
+                iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const iterator& lhs, const iterator& rhs)
+            {
+                return lhs.m_done == rhs.m_done && (lhs.m_done || lhs.m_field_begin == rhs.m_field_begin);
+            }
+            friend bool operator==(const iterator& itr, std::default_sentinel_t) { return itr.m_done; }
+
+        private:
+            [[nodiscard]] size_t delimiter_size() const
+            {
+                if constexpr (std::is_same_v<Delimiter, char>)
+                {
+                    return 1;
+                }
+                else
+                {
+                    return m_delimiter.size();
+                }
+            }
+
+            //Where the field starting at from ends: the next delimiter, or the end of the source
+            [[nodiscard]] size_t field_end(size_t from) const
+            {
+                size_t end = std::string_view::npos;
+                if constexpr (std::is_same_v<Delimiter, char>)
+                {
+                    end = find_first(m_source, byte_class::equals { m_delimiter }, from);
+                }
+                else if(!m_delimiter.empty())
+                {
+                    end = find_substring(m_source, m_delimiter, from);
+                }
+                return end == std::string_view::npos ? m_source.size() : end;
+            }
+
+            std::string_view m_source;
+            Delimiter m_delimiter {};
+            size_t m_field_begin = 0;
+            size_t m_field_end = 0;
+            bool m_done = true;
+        };
+
+        split_view() = default;
+        split_view(std::string_view in_source, Delimiter in_delimiter)
+            : m_source(in_source)
+            , m_delimiter(in_delimiter)
+        {
         }
-    }
 
-    static inline std::vector<std::string> split(const std::string& s, char delim)
+        [[nodiscard]] iterator begin() const { return iterator(m_source, m_delimiter); }
+        [[nodiscard]] std::default_sentinel_t end() const { return {}; }
+
+    private:
+        std::string_view m_source;
+        Delimiter m_delimiter {};
+    };
+
+    /***
+     * tokenize_view
+     * The runs of a string_view between bytes of a byte_class, found as the view is iterated.  Unlike split_view,
+     * runs of delimiters count as one and there are never empty tokens, so it's what to use for words separated by whitespace.
+     * Tokens are views into the source, so the source has to outlive them
+    */
+    template<typename ByteClass>
+    class tokenize_view : public std::ranges::view_interface<tokenize_view<ByteClass>>
     {
-        std::vector<std::string> elems;
-        split(s, delim, std::back_inserter(elems));
-        return elems;
-    }
+    public:
+        class iterator
+        {
+        public:
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+            using iterator_category = std::forward_iterator_tag;
 
-    inline std::string_view trim_l(std::string_view s)
+            iterator() = default;
+            iterator(std::string_view in_source, ByteClass in_delimiters)
+                : m_source(in_source)
+                , m_delimiters(in_delimiters)
+            {
+                find_token(0);
+            }
+
+            [[nodiscard]] std::string_view operator*() const { return m_source.substr(m_token_begin, m_token_end - m_token_begin); }
+
+            iterator& operator++()
+            {
+                find_token(m_token_end);
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const iterator& lhs, const iterator& rhs)
+            {
+                return lhs.m_done == rhs.m_done && (lhs.m_done || lhs.m_token_begin == rhs.m_token_begin);
+            }
+            friend bool operator==(const iterator& itr, std::default_sentinel_t) { return itr.m_done; }
+
+        private:
+            void find_token(size_t from)
+            {
+                m_token_begin = find_first_not(m_source, m_delimiters, from);
+                m_done = m_token_begin == std::string_view::npos;
+                if(!m_done)
+                {
+                    const size_t end = find_first(m_source, m_delimiters, m_token_begin);
+                    m_token_end = end == std::string_view::npos ? m_source.size() : end;
+                }
+            }
+
+            std::string_view m_source;
+            ByteClass m_delimiters {};
+            size_t m_token_begin = 0;
+            size_t m_token_end = 0;
+            bool m_done = true;
+        };
+
+        tokenize_view() = default;
+        tokenize_view(std::string_view in_source, ByteClass in_delimiters)
+            : m_source(in_source)
+            , m_delimiters(in_delimiters)
+        {
+        }
+
+        [[nodiscard]] iterator begin() const { return iterator(m_source, m_delimiters); }
+        [[nodiscard]] std::default_sentinel_t end() const { return {}; }
+
+    private:
+        std::string_view m_source;
+        ByteClass m_delimiters {};
+    };
+
+    //Every field of s between delimiter bytes, lazily.  See split_view
+    [[nodiscard]] inline split_view<char> split(std::string_view s, char delimiter)
     {
-        return s.substr(s.find_first_not_of(' '));
+        return split_view<char>(s, delimiter);
     }
 
-    inline std::string_view trim_r(std::string_view s)
+    //Every field of s between occurrences of delimiter, lazily.  See split_view
+    [[nodiscard]] inline split_view<std::string_view> split(std::string_view s, std::string_view delimiter)
     {
-        return s.substr(0, s.find_last_not_of(' ') + 1);
+        return split_view<std::string_view>(s, delimiter);
     }
 
-    inline std::string_view trim(std::string_view s)
+    //The whitespace separated words of s, lazily.  See tokenize_view
+    [[nodiscard]] inline tokenize_view<byte_class::whitespace> tokenize(std::string_view s)
     {
-        return trim_r(trim_l(s));
+        return tokenize_view<byte_class::whitespace>(s, {});
     }
 
-    inline void split(std::string_view sv, std::string_view delimiter, std::output_iterator<std::string_view> auto out_itr)
+    //The tokens of s separated by any of the bytes in delimiters, lazily.  See tokenize_view
+    [[nodiscard]] inline tokenize_view<byte_class::any_of> tokenize(std::string_view s, std::string_view delimiters)
     {
-        size_t start = 0;
-        size_t cursor = start;
-        while(cursor != sv.length())
-        {           
-            while(cursor != sv.length() && sv.substr(cursor, delimiter.length()).compare(delimiter) != 0)
-            {
-                cursor++;
-            }
-            
-           
-            using namespace std::literals::string_view_literals;
-            *out_itr++ = sv.substr(start, cursor - start);
+        return tokenize_view<byte_class::any_of>(s, byte_class::any_of { delimiters });
+    }
 
-            if(cursor == sv.length())
+    //Copies every non empty field of s between delim bytes into out_itr
+    static inline void split(const std::string& s, char delim, std::output_iterator<std::string> auto out_itr)
+    {
+        for(const std::string_view field : split(std::string_view(s), delim))
+        {
+            if(!field.empty())
             {
-                return;
+                *out_itr++ = std::string(field);
             }
-
-            cursor++;
-            start = cursor;
         }
     }
 
+    //Writes every field of sv between occurrences of delimiter to out_itr, including empty ones.  See split_view
+    inline void split(std::string_view sv, std::string_view delimiter, std::output_iterator<std::string_view> auto out_itr)
+    {
+        std::ranges::copy(split(sv, delimiter), out_itr);
+    }
+
+    //Everything before the first byte that's in token, or all of sv if there isn't one
     inline std::string_view token(std::string_view sv, std::string_view token)
     {
-        return sv.substr(0, sv.find_first_of(token));
+        return sv.substr(0, find_first(sv, byte_class::any_of { token }));
     }
-}
\ No newline at end of file
+}
+
+template<typename Delimiter>
+inline constexpr bool std::ranges::enable_borrowed_range<raoe::string::split_view<Delimiter>> = true;
+
+template<typename ByteClass>
+inline constexpr bool std::ranges::enable_borrowed_range<raoe::string::tokenize_view<ByteClass>> = true;
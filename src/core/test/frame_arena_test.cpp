@@ -0,0 +1,103 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "frame_arena.hpp"
+#include <cstring>
+#include <thread>
+
+TEST(FrameArenaTest, AllocationsAreAligned)
+{
+    raoe::frame_arena arena(1024);
+    (void)arena.allocate(1, 1);
+    void* ptr = arena.allocate(16, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+}
+
+TEST(FrameArenaTest, MemorySurvivesOneFrame)
+{
+    raoe::frame_arena arena(1024);
+    char* first = static_cast<char*>(arena.allocate(6));
+    std::memcpy(first, "hello", 6);
+    arena.end_frame();
+
+    //The next frame allocates out of the other buffer, so last frame's data is still intact
+    char* second = static_cast<char*>(arena.allocate(6));
+    std::memcpy(second, "world", 6);
+    EXPECT_STREQ(first, "hello");
+    arena.end_frame();
+
+    //Two frames later the first buffer is handed out again
+    EXPECT_EQ(arena.allocate(6), first);
+}
+
+TEST(FrameArenaTest, RecordsUsage)
+{
+    raoe::frame_arena arena(1024);
+    (void)arena.allocate(100, 1);
+    (void)arena.allocate(200, 1);
+    arena.end_frame();
+    EXPECT_EQ(arena.last_frame().bytes, 300);
+    EXPECT_EQ(arena.last_frame().overflow_bytes, 0);
+
+    (void)arena.allocate(50, 1);
+    arena.end_frame();
+    EXPECT_EQ(arena.last_frame().bytes, 50);
+    EXPECT_EQ(arena.high_water_mark(), 300);
+}
+
+TEST(FrameArenaTest, OverflowGrowsTheBuffer)
+{
+    raoe::frame_arena arena(64);
+    (void)arena.allocate(48, 1);
+    (void)arena.allocate(48, 1); //doesn't fit, comes from the heap
+    arena.end_frame();
+    EXPECT_EQ(arena.last_frame().bytes, 96);
+    EXPECT_EQ(arena.last_frame().overflow_bytes, 48);
+
+    //When that buffer comes back around it is big enough for the whole load
+    arena.end_frame();
+    EXPECT_GE(arena.capacity(), 96);
+    (void)arena.allocate(48, 1);
+    (void)arena.allocate(48, 1);
+    arena.end_frame();
+    EXPECT_EQ(arena.last_frame().overflow_bytes, 0);
+}
+
+TEST(FrameArenaTest, PmrContainers)
+{
+    raoe::frame_arena arena(4096);
+    std::pmr::vector<int32> values(arena.resource());
+    for(int32 i = 0; i < 100; i++)
+    {
+        values.push_back(i);
+    }
+    EXPECT_EQ(values[99], 99);
+
+    arena.end_frame();
+    EXPECT_GE(arena.last_frame().bytes, 100 * sizeof(int32));
+    EXPECT_EQ(arena.last_frame().overflow_bytes, 0);
+}
+
+TEST(FrameArenaTest, EachThreadHasItsOwn)
+{
+    raoe::frame_arena* other_thread_arena = nullptr;
+    std::thread([&other_thread_arena]() { other_thread_arena = &raoe::frame_arena::this_thread(); }).join();
+    EXPECT_NE(other_thread_arena, &raoe::frame_arena::this_thread());
+    EXPECT_NE(&raoe::frame_arena::main(), &raoe::frame_arena::this_thread());
+}
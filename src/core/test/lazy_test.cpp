@@ -20,6 +20,12 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "spdlog/spdlog.h"
 #include "lazy.hpp"
 
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 raoe::lazy<int> f(int x)
 {
     co_return x;
@@ -57,4 +63,281 @@ raoe::lazy<void> basic_handle_test(int value)
 TEST(lazy, basic_coro)
 {
     EXPECT_NO_THROW(basic_handle_test(42).sync_await());
-}
\ No newline at end of file
+}
+raoe::lazy<int> wait_frames(int frames)
+{
+    for(int i = 0; i < frames; i++)
+    {
+        co_await std::suspend_always();
+    }
+    co_return frames;
+}
+
+raoe::lazy<void> wait_nested(int& result)
+{
+    result = co_await wait_frames(2);
+    result += co_await wait_frames(1);
+}
+
+//A nested lazy that waits a frame has to pick up where it suspended, not in the lazy awaiting it
+TEST(lazy, NestedSuspendResumesInnermost)
+{
+    int result = 0;
+    raoe::lazy<> task = wait_nested(result);
+    int resumes = 0;
+    while(!task.done())
+    {
+        task.resume();
+        resumes++;
+    }
+    EXPECT_EQ(result, 3);
+    EXPECT_EQ(resumes, 4);
+}
+
+namespace SharedLazyTest
+{
+    //Counts how many times it was copied, to check the result is handed out in place
+    struct copy_counter
+    {
+        static inline int32 copies = 0;
+        int32 value = 0;
+
+        explicit copy_counter(int32 in_value) : value(in_value) {}
+        copy_counter(copy_counter&& other) noexcept = default;
+        copy_counter(const copy_counter& other) : value(other.value) { copies++; }
+    };
+
+    raoe::shared_lazy<copy_counter> compute(int32& runs)
+    {
+        runs++;
+        co_return copy_counter(42);
+    }
+
+    raoe::shared_lazy<int> fail()
+    {
+        throw std::runtime_error("failed");
+        co_return 0;
+    }
+
+    raoe::shared_lazy<int> wait_a_frame(int32& runs)
+    {
+        runs++;
+        co_await std::suspend_always();
+        co_return 7;
+    }
+
+    template<class T>
+    raoe::lazy<const T*> address_of(const raoe::shared_lazy<T>& shared)
+    {
+        co_return &(co_await shared);
+    }
+
+    template<class T>
+    raoe::lazy<> store_address(const raoe::shared_lazy<T>& shared, const T*& address)
+    {
+        address = &(co_await shared);
+    }
+
+    //Destroys another waiter once it's resumed
+    template<class T>
+    raoe::lazy<> destroy_after(const raoe::shared_lazy<T>& shared, std::optional<raoe::lazy<>>& victim)
+    {
+        (void)co_await shared;
+        victim.reset();
+    }
+
+    //Suspends until whoever is holding the handle resumes it
+    struct gate
+    {
+        std::atomic<void*> waiting = nullptr;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> coro) noexcept { waiting.store(coro.address(), std::memory_order_release); }
+        void await_resume() const noexcept {}
+    };
+
+    raoe::shared_lazy<int> wait_for(gate& in_gate, int32& runs)
+    {
+        runs++;
+        co_await in_gate;
+        co_return 99;
+    }
+}
+
+TEST(shared_lazy, RunsOnceForEveryAwaiter)
+{
+    using namespace SharedLazyTest;
+    copy_counter::copies = 0;
+    int32 runs = 0;
+    const raoe::shared_lazy<copy_counter> shared = compute(runs);
+    EXPECT_EQ(runs, 0);
+    EXPECT_FALSE(shared.done());
+
+    const copy_counter* first = address_of(shared).sync_await();
+    const raoe::shared_lazy<copy_counter> copy = shared;
+    const copy_counter* second = address_of(copy).sync_await();
+    EXPECT_TRUE(shared.done());
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->value, 42);
+    EXPECT_EQ(copy_counter::copies, 0);
+}
+
+TEST(shared_lazy, RethrowsForEveryAwaiter)
+{
+    const raoe::shared_lazy<int> shared = SharedLazyTest::fail();
+    EXPECT_THROW((void)SharedLazyTest::address_of(shared).sync_await(), std::runtime_error);
+    EXPECT_THROW((void)SharedLazyTest::address_of(shared).sync_await(), std::runtime_error);
+}
+
+TEST(shared_lazy, WaitersResumeWhenItFinishes)
+{
+    //Resumed the way the TaskService resumes tasks: each one, once a frame
+    int32 runs = 0;
+    const raoe::shared_lazy<int> shared = SharedLazyTest::wait_a_frame(runs);
+    const int* started_address = nullptr;
+    const int* waiting_address = nullptr;
+    raoe::lazy<> started = SharedLazyTest::store_address(shared, started_address);
+    raoe::lazy<> waiting = SharedLazyTest::store_address(shared, waiting_address);
+
+    started.resume();
+    waiting.resume();
+    EXPECT_EQ(runs, 1);
+    EXPECT_FALSE(shared.done());
+
+    //Resuming a lazy that didn't start it does nothing until it's finished
+    waiting.resume();
+    EXPECT_FALSE(waiting.done());
+    EXPECT_FALSE(shared.done());
+
+    //Resuming the one that started it carries it on, and it resumes everything waiting when it finishes
+    started.resume();
+    EXPECT_TRUE(shared.done());
+    EXPECT_TRUE(started.done());
+    EXPECT_TRUE(waiting.done());
+    ASSERT_NE(started_address, nullptr);
+    EXPECT_EQ(started_address, waiting_address);
+    EXPECT_EQ(*started_address, 7);
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(shared_lazy, WaitersCanBeDestroyedWhileTheyWait)
+{
+    int32 runs = 0;
+    const raoe::shared_lazy<int> shared = SharedLazyTest::wait_a_frame(runs);
+    const int* started_address = nullptr;
+    const int* waiting_address = nullptr;
+    raoe::lazy<> started = SharedLazyTest::store_address(shared, started_address);
+    std::optional<raoe::lazy<>> waiting = SharedLazyTest::store_address(shared, waiting_address);
+    started.resume();
+    waiting->resume();
+
+    //It takes itself off the list, so finishing doesn't resume a destroyed frame
+    waiting.reset();
+    started.resume();
+    EXPECT_TRUE(shared.done());
+    EXPECT_TRUE(started.done());
+    ASSERT_NE(started_address, nullptr);
+    EXPECT_EQ(*started_address, 7);
+    EXPECT_EQ(waiting_address, nullptr);
+}
+
+TEST(shared_lazy, AWaiterCanDestroyAnotherWhenItsResumed)
+{
+    int32 runs = 0;
+    const raoe::shared_lazy<int> shared = SharedLazyTest::wait_a_frame(runs);
+    const int* started_address = nullptr;
+    const int* victim_address = nullptr;
+    raoe::lazy<> started = SharedLazyTest::store_address(shared, started_address);
+    std::optional<raoe::lazy<>> victim = SharedLazyTest::store_address(shared, victim_address);
+    raoe::lazy<> destroyer = SharedLazyTest::destroy_after(shared, victim);
+    started.resume();
+    victim->resume();
+    destroyer.resume();
+
+    //The destroyer is resumed first, while the victim is still waiting its turn.  The victim has to leave the list, not be resumed
+    started.resume();
+    EXPECT_TRUE(shared.done());
+    EXPECT_TRUE(started.done());
+    EXPECT_TRUE(destroyer.done());
+    EXPECT_FALSE(victim.has_value());
+    EXPECT_EQ(victim_address, nullptr);
+    ASSERT_NE(started_address, nullptr);
+    EXPECT_EQ(*started_address, 7);
+}
+
+TEST(shared_lazy, AWaiterTakesOverWhenTheStarterIsDestroyed)
+{
+    int32 runs = 0;
+    const raoe::shared_lazy<int> shared = SharedLazyTest::wait_a_frame(runs);
+    const int* started_address = nullptr;
+    const int* waiting_address = nullptr;
+    std::optional<raoe::lazy<>> started = SharedLazyTest::store_address(shared, started_address);
+    raoe::lazy<> waiting = SharedLazyTest::store_address(shared, waiting_address);
+    started->resume();
+    waiting.resume();
+
+    //The waiting lazy now carries it along
+    started.reset();
+    waiting.resume();
+    EXPECT_TRUE(shared.done());
+    EXPECT_TRUE(waiting.done());
+    ASSERT_NE(waiting_address, nullptr);
+    EXPECT_EQ(*waiting_address, 7);
+    EXPECT_EQ(started_address, nullptr);
+    EXPECT_EQ(runs, 1);
+
+    //With nobody waiting when the starter goes, the next lazy to await it takes over
+    runs = 0;
+    const raoe::shared_lazy<int> orphaned = SharedLazyTest::wait_a_frame(runs);
+    const int* late_address = nullptr;
+    started = SharedLazyTest::store_address(orphaned, started_address);
+    started->resume();
+    started.reset();
+    raoe::lazy<> late = SharedLazyTest::store_address(orphaned, late_address);
+    late.resume();
+    EXPECT_FALSE(orphaned.done());
+    late.resume();
+    EXPECT_TRUE(orphaned.done());
+    EXPECT_TRUE(late.done());
+    ASSERT_NE(late_address, nullptr);
+    EXPECT_EQ(*late_address, 7);
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(shared_lazy, AwaitedFromManyThreads)
+{
+    constexpr int32 thread_count = 8;
+    SharedLazyTest::gate gate;
+    int32 runs = 0;
+    const raoe::shared_lazy<int> shared = SharedLazyTest::wait_for(gate, runs);
+
+    std::vector<const int*> addresses(thread_count, nullptr);
+    std::vector<raoe::lazy<>> awaiters;
+    for(int32 i = 0; i < thread_count; i++)
+    {
+        awaiters.push_back(SharedLazyTest::store_address(shared, addresses[static_cast<size_t>(i)]));
+    }
+    {
+        std::vector<std::jthread> threads;
+        for(raoe::lazy<>& awaiter : awaiters)
+        {
+            threads.emplace_back([&awaiter]() { awaiter.resume(); });
+        }
+    }
+    EXPECT_EQ(runs, 1);
+    EXPECT_FALSE(shared.done());
+
+    //Finishing it on this thread resumes every waiter here
+    void* const waiting = gate.waiting.load(std::memory_order_acquire);
+    ASSERT_NE(waiting, nullptr);
+    std::coroutine_handle<>::from_address(waiting).resume();
+    EXPECT_TRUE(shared.done());
+    for(int32 i = 0; i < thread_count; i++)
+    {
+        EXPECT_TRUE(awaiters[static_cast<size_t>(i)].done());
+        ASSERT_NE(addresses[static_cast<size_t>(i)], nullptr);
+        EXPECT_EQ(*addresses[static_cast<size_t>(i)], 99);
+        EXPECT_EQ(addresses[static_cast<size_t>(i)], addresses[0]);
+    }
+}
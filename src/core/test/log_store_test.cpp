@@ -0,0 +1,194 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "log_store.hpp"
+#include "spdlog/spdlog.h"
+
+#include <thread>
+
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    //The line's text, or "<recycled>" if the store doesn't have it any more
+    std::string text_of(const raoe::log::line_store& store, size_t index)
+    {
+        std::string text;
+        spdlog::level::level_enum level = spdlog::level::info;
+        return store.read(index, text, level) ? text : std::string("<recycled>");
+    }
+}
+
+TEST(LineStore, AppendAcrossChunks)
+{
+    raoe::log::line_store store;
+    for(size_t i = 0; i < raoe::log::line_store::lines_per_chunk * 3; i++)
+    {
+        store.append(spdlog::level::info, fmt::format("line {}", i));
+    }
+
+    EXPECT_EQ(store.size(), raoe::log::line_store::lines_per_chunk * 3);
+    EXPECT_EQ(store.first(), 0);
+    EXPECT_EQ(text_of(store, 0), "line 0"sv);
+    EXPECT_EQ(text_of(store, raoe::log::line_store::lines_per_chunk), fmt::format("line {}", raoe::log::line_store::lines_per_chunk));
+    EXPECT_EQ(text_of(store, store.size() - 1), fmt::format("line {}", store.size() - 1));
+    EXPECT_EQ(text_of(store, store.size()), "<recycled>"sv);
+}
+
+TEST(LineStore, RecyclesTheOldestChunkWhenFull)
+{
+    constexpr size_t chunk = raoe::log::line_store::lines_per_chunk;
+    raoe::log::line_store store(chunk * 2);
+    for(size_t i = 0; i < chunk * 2 + 10; i++)
+    {
+        store.append(spdlog::level::info, fmt::format("line {}", i));
+    }
+
+    //Nothing new is dropped, the first chunk made room for it
+    EXPECT_EQ(store.size(), chunk * 2 + 10);
+    EXPECT_EQ(store.first(), chunk);
+    EXPECT_EQ(text_of(store, chunk - 1), "<recycled>"sv);
+    EXPECT_EQ(text_of(store, chunk), fmt::format("line {}", chunk));
+    EXPECT_EQ(text_of(store, chunk * 2 + 9), fmt::format("line {}", chunk * 2 + 9));
+}
+
+TEST(LineStore, LongLinesAreCut)
+{
+    raoe::log::line_store store;
+    const std::string huge(raoe::log::line_store::text_block_size * 2, 'h');
+    store.append(spdlog::level::info, "before"sv);
+    store.append(spdlog::level::info, huge);
+    store.append(spdlog::level::info, "after"sv);
+
+    EXPECT_EQ(text_of(store, 0), "before"sv);
+    EXPECT_EQ(text_of(store, 1), huge.substr(0, raoe::log::line_store::max_line_length));
+    EXPECT_EQ(text_of(store, 2), "after"sv);
+}
+
+TEST(LineStore, ReadWhileAppendingAndRecycling)
+{
+    //Small enough that the writer laps it many times while the reader is checking
+    raoe::log::line_store store(raoe::log::line_store::lines_per_chunk * 2);
+    constexpr size_t line_count = 100000;
+    std::thread writer([&]()
+    {
+        for(size_t i = 0; i < line_count; i++)
+        {
+            store.append(spdlog::level::info, fmt::format("{}", i));
+        }
+    });
+
+    //Every line a reader gets back is complete.  Lines recycled under it are reported as such, never torn
+    std::string text;
+    spdlog::level::level_enum level = spdlog::level::info;
+    size_t read = 0;
+    size_t checked = 0;
+    while(checked < line_count)
+    {
+        const size_t size = store.size();
+        for(checked = std::max(checked, store.first()); checked < size; checked++)
+        {
+            if(store.read(checked, text, level))
+            {
+                ASSERT_EQ(text, fmt::format("{}", checked));
+                read++;
+            }
+        }
+    }
+    writer.join();
+    EXPECT_GT(read, 0);
+}
+
+TEST(LineFilter, FiltersIncrementally)
+{
+    raoe::log::line_store store;
+    raoe::log::line_filter filter;
+    store.append(spdlog::level::info, "loading cog"sv);
+    store.append(spdlog::level::warn, "missing asset"sv);
+
+    EXPECT_TRUE(filter.update(store));
+    EXPECT_TRUE(filter.passes_everything());
+    EXPECT_EQ(filter.rows(), 2);
+    EXPECT_FALSE(filter.update(store)); //Nothing new
+
+    filter.set_min_level(spdlog::level::warn);
+    EXPECT_TRUE(filter.update(store));
+    ASSERT_EQ(filter.rows(), 1);
+    EXPECT_EQ(text_of(store, filter.line_index(0)), "missing asset"sv);
+
+    store.append(spdlog::level::err, "missing cog"sv);
+    filter.set_text("cog");
+    filter.update(store);
+    ASSERT_EQ(filter.rows(), 1);
+    EXPECT_EQ(text_of(store, filter.line_index(0)), "missing cog"sv);
+}
+
+TEST(LineFilter, FirstLineClears)
+{
+    raoe::log::line_store store;
+    raoe::log::line_filter filter;
+    store.append(spdlog::level::info, "old"sv);
+    filter.set_first_line(store.size());
+    store.append(spdlog::level::info, "new"sv);
+
+    filter.update(store);
+    ASSERT_EQ(filter.rows(), 1);
+    EXPECT_EQ(text_of(store, filter.line_index(0)), "new"sv);
+}
+
+TEST(LineFilter, RecycledLinesFallOffTheFront)
+{
+    constexpr size_t chunk = raoe::log::line_store::lines_per_chunk;
+    raoe::log::line_store store(chunk);
+    raoe::log::line_filter filter;
+    filter.set_text("keep");
+    store.append(spdlog::level::info, "keep first"sv);
+    filter.update(store);
+    ASSERT_EQ(filter.rows(), 1);
+
+    for(size_t i = 0; i < chunk; i++)
+    {
+        store.append(spdlog::level::info, "filler"sv);
+    }
+    store.append(spdlog::level::info, "keep second"sv);
+
+    EXPECT_TRUE(filter.update(store));
+    ASSERT_EQ(filter.rows(), 1);
+    EXPECT_EQ(text_of(store, filter.line_index(0)), "keep second"sv);
+
+    filter.set_text("");
+    filter.update(store);
+    EXPECT_EQ(filter.rows(), 2); //The filler in the newest chunk, and "keep second"
+    EXPECT_EQ(filter.line_index(0), store.first());
+}
+
+TEST(LineStoreSink, StoresFormattedLines)
+{
+    auto sink = std::make_shared<raoe::log::line_store_sink>();
+    sink->set_pattern("%l:%v");
+    spdlog::logger logger("line_store_test", sink);
+
+    logger.warn("hello {}", 42);
+    ASSERT_EQ(sink->store().size(), 1);
+    std::string text;
+    spdlog::level::level_enum level = spdlog::level::info;
+    ASSERT_TRUE(sink->store().read(0, text, level));
+    EXPECT_EQ(text, "warning:hello 42"sv);
+    EXPECT_EQ(level, spdlog::level::warn);
+}
@@ -0,0 +1,93 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+//Compile out everything below info in this file, so the test can check that filtered calls never evaluate their arguments
+#define RAOE_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "log.hpp"
+#include "spdlog/sinks/ringbuffer_sink.h"
+
+namespace
+{
+    //Captures everything written through the shared sinks for the lifetime of the test
+    struct captured_log
+    {
+        captured_log()
+        {
+            sink->set_pattern("%n:%v");
+            raoe::log::add_sink(sink);
+        }
+        ~captured_log() { raoe::log::remove_sink(sink); }
+
+        captured_log(const captured_log&) = delete;
+        captured_log& operator=(const captured_log&) = delete;
+        captured_log(captured_log&&) = delete;
+        captured_log& operator=(captured_log&&) = delete;
+
+        std::vector<std::string> lines() const { return sink->last_formatted(); }
+
+        std::shared_ptr<spdlog::sinks::ringbuffer_sink_mt> sink = std::make_shared<spdlog::sinks::ringbuffer_sink_mt>(16);
+    };
+
+    int32 count_evaluations(int32& counter)
+    {
+        return ++counter;
+    }
+}
+
+TEST(LogTest, CategoryLogsUnderItsName)
+{
+    const raoe::log::category log_category {"log_test_name"};
+    captured_log capture;
+
+    RAOE_LOG_WARN(log_category, "hello {}", 42);
+    raoe::log::flush_all();
+
+    EXPECT_THAT(capture.lines(), testing::ElementsAre(testing::HasSubstr("log_test_name:hello 42")));
+    EXPECT_EQ(raoe::log::get("log_test_name").get(), &log_category.logger());
+}
+
+TEST(LogTest, RuntimeLevelIsPerCategory)
+{
+    const raoe::log::category quiet {"log_test_quiet"};
+    const raoe::log::category loud {"log_test_loud"};
+    quiet.logger().set_level(spdlog::level::err);
+    loud.logger().set_level(spdlog::level::info);
+    captured_log capture;
+
+    RAOE_LOG_INFO(quiet, "filtered");
+    RAOE_LOG_INFO(loud, "kept");
+    raoe::log::flush_all();
+
+    EXPECT_THAT(capture.lines(), testing::ElementsAre(testing::HasSubstr("log_test_loud:kept")));
+}
+
+TEST(LogTest, CompiledOutCallsDontEvaluateArguments)
+{
+    const raoe::log::category log_category {"log_test_compiled_out"};
+    log_category.logger().set_level(spdlog::level::trace);
+    int32 evaluations = 0;
+
+    RAOE_LOG_TRACE(log_category, "{}", count_evaluations(evaluations));
+    RAOE_LOG_DEBUG(log_category, "{}", count_evaluations(evaluations));
+    EXPECT_EQ(evaluations, 0);
+
+    RAOE_LOG_INFO(log_category, "{}", count_evaluations(evaluations));
+    EXPECT_EQ(evaluations, 1);
+}
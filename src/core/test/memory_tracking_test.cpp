@@ -0,0 +1,113 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "memory_tracking.hpp"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    raoe::memory::tag_report find_report(raoe::memory::tag_id id)
+    {
+        for(raoe::memory::tag_report& report : raoe::memory::report())
+        {
+            if(report.id == id)
+            {
+                return report;
+            }
+        }
+        return {};
+    }
+}
+
+TEST(MemoryTrackingTest, RegisteringTwiceGivesTheSameTag)
+{
+    const raoe::memory::tag_id first = raoe::memory::register_tag("test:same");
+    const raoe::memory::tag_id second = raoe::memory::register_tag("test:same");
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, raoe::memory::untagged);
+    EXPECT_EQ(raoe::memory::tag_name(first), "test:same");
+    EXPECT_NE(raoe::memory::register_tag("test:different"), first);
+}
+
+TEST(MemoryTrackingTest, ScopedTagNests)
+{
+    const raoe::memory::tag_id outer = raoe::memory::register_tag("test:outer");
+    const raoe::memory::tag_id inner = raoe::memory::register_tag("test:inner");
+
+    EXPECT_EQ(raoe::memory::active_tag(), raoe::memory::untagged);
+    {
+        const raoe::memory::scoped_tag outer_scope(outer);
+        EXPECT_EQ(raoe::memory::active_tag(), outer);
+        {
+            const raoe::memory::scoped_tag inner_scope(inner);
+            EXPECT_EQ(raoe::memory::active_tag(), inner);
+        }
+        EXPECT_EQ(raoe::memory::active_tag(), outer);
+    }
+    EXPECT_EQ(raoe::memory::active_tag(), raoe::memory::untagged);
+}
+
+TEST(MemoryTrackingTest, TaggedResourceCountsLiveBytes)
+{
+    const raoe::memory::tag_id tag = raoe::memory::register_tag("test:resource");
+    raoe::memory::tagged_resource resource(tag);
+    {
+        std::pmr::vector<int32> values(&resource);
+        values.reserve(256);
+
+        const raoe::memory::tag_report during = find_report(tag);
+        EXPECT_EQ(during.name, "test:resource");
+        EXPECT_EQ(during.live_bytes, 256 * sizeof(int32));
+        EXPECT_EQ(during.allocations, 1);
+    }
+
+    //Freed memory is no longer live, but still counts toward the totals
+    const raoe::memory::tag_report after = find_report(tag);
+    EXPECT_EQ(after.live_bytes, 0);
+    EXPECT_EQ(after.allocations, 1);
+    EXPECT_EQ(after.allocated_bytes, 256 * sizeof(int32));
+}
+
+TEST(MemoryTrackingTest, CountsFromOtherThreadsAreMerged)
+{
+    const raoe::memory::tag_id tag = raoe::memory::register_tag("test:threads");
+    raoe::memory::tagged_resource resource(tag);
+    void* kept = nullptr;
+
+    std::thread worker([&]() {
+        kept = resource.allocate(64);
+        resource.deallocate(resource.allocate(32), 32);
+
+        //Counted on the worker, seen from here while it is still running
+        const raoe::memory::tag_report during = find_report(tag);
+        EXPECT_EQ(during.live_bytes, 64);
+        EXPECT_EQ(during.allocations, 2);
+    });
+    worker.join();
+
+    //The worker's counts outlive it, and freeing its memory here evens out
+    EXPECT_EQ(find_report(tag).live_bytes, 64);
+    resource.deallocate(kept, 64);
+    const raoe::memory::tag_report after = find_report(tag);
+    EXPECT_EQ(after.live_bytes, 0);
+    EXPECT_EQ(after.allocations, 2);
+    EXPECT_EQ(after.allocated_bytes, 96);
+}
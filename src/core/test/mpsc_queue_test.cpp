@@ -0,0 +1,108 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "container/mpsc_queue.hpp"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(MpscQueueTest, FirstInFirstOut)
+{
+    raoe::container::mpsc_queue<int32, 4> queue;
+    EXPECT_FALSE(queue.try_pop());
+
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.try_push(2));
+    EXPECT_EQ(queue.size_approx(), 2);
+    EXPECT_EQ(queue.try_pop(), 1);
+    EXPECT_EQ(queue.try_pop(), 2);
+    EXPECT_FALSE(queue.try_pop());
+}
+
+TEST(MpscQueueTest, FullQueueRejectsPushes)
+{
+    raoe::container::mpsc_queue<std::unique_ptr<int32>, 2> queue;
+    EXPECT_TRUE(queue.try_push(std::make_unique<int32>(1)));
+    EXPECT_TRUE(queue.try_push(std::make_unique<int32>(2)));
+
+    //A rejected value isn't moved from
+    auto rejected = std::make_unique<int32>(3);
+    EXPECT_FALSE(queue.try_push(std::move(rejected)));
+    ASSERT_TRUE(rejected);
+
+    EXPECT_EQ(**queue.try_pop(), 1);
+    EXPECT_TRUE(queue.try_push(std::move(rejected)));
+    EXPECT_EQ(**queue.try_pop(), 2);
+    EXPECT_EQ(**queue.try_pop(), 3);
+}
+
+TEST(MpscQueueTest, DestroysWhatsLeft)
+{
+    auto counted = std::make_shared<int32>(0);
+    {
+        raoe::container::mpsc_queue<std::shared_ptr<int32>, 8> queue;
+        queue.try_push(counted);
+        queue.try_push(counted);
+        EXPECT_EQ(counted.use_count(), 3);
+    }
+    EXPECT_EQ(counted.use_count(), 1);
+}
+
+TEST(MpscQueueTest, ManyProducers)
+{
+    constexpr int32 producer_count = 4;
+    constexpr int32 per_producer = 20000;
+    struct item
+    {
+        int32 producer;
+        int32 sequence;
+    };
+    raoe::container::mpsc_queue<item, 64> queue;
+
+    std::vector<std::jthread> producers;
+    for(int32 producer = 0; producer < producer_count; producer++)
+    {
+        producers.emplace_back([&queue, producer]() {
+            for(int32 i = 0; i < per_producer; i++)
+            {
+                while(!queue.try_push(item { producer, i }))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    //Each producer's items come out in the order it pushed them, and none are lost
+    std::vector<int32> next(producer_count, 0);
+    int32 received = 0;
+    while(received < producer_count * per_producer)
+    {
+        if(std::optional<item> popped = queue.try_pop())
+        {
+            ASSERT_EQ(popped->sequence, next[popped->producer]);
+            next[popped->producer]++;
+            received++;
+        }
+    }
+    EXPECT_FALSE(queue.try_pop());
+    EXPECT_THAT(next, testing::Each(per_producer));
+}
@@ -120,3 +120,74 @@ TEST(LineParse, ThreeArguments_FirstAndThirdInQuotes_WhitespaceBetween)
     EXPECT_EQ(results, matching_vector);
 }
 
+
+//Fixed size splitting
+
+TEST(LineParse, Fixed_IsConstexpr)
+{
+    constexpr auto split = raoe::core::parse::_::parse_split_fixed<2>("one \"two three\""sv);
+    static_assert(split.count == 2);
+    static_assert(split.tokens[0] == "one"sv);
+    static_assert(split.tokens[1] == "two three"sv);
+    static_assert(split.first_extra.empty());
+}
+
+TEST(LineParse, Fixed_TooManyTokens)
+{
+    auto split = raoe::core::parse::_::parse_split_fixed<2>("one two three four"sv);
+    EXPECT_EQ(split.count, 2);
+    EXPECT_EQ(split.first_extra, "three"sv);
+}
+
+TEST(LineParse, Fixed_TooFewTokens)
+{
+    auto split = raoe::core::parse::_::parse_split_fixed<3>(" one "sv);
+    EXPECT_EQ(split.count, 1);
+    EXPECT_EQ(split.tokens[0], "one"sv);
+}
+
+//Argument parsing
+
+TEST(ArgumentParse, AllArgumentsValid)
+{
+    std::tuple<int32, float, std::string_view> values;
+    auto errors = raoe::core::parse::parse_arguments(" 12 3.5 \"some text\""sv, values);
+
+    EXPECT_TRUE(errors.ok());
+    EXPECT_EQ(std::get<0>(values), 12);
+    EXPECT_FLOAT_EQ(std::get<1>(values), 3.5F);
+    EXPECT_EQ(std::get<2>(values), "some text"sv);
+}
+
+TEST(ArgumentParse, ReportsEachArgument)
+{
+    using raoe::core::parse::argument_error;
+    std::tuple<int32, int32, int32> values;
+    auto errors = raoe::core::parse::parse_arguments("7 12abc"sv, values);
+
+    EXPECT_FALSE(errors.ok());
+    EXPECT_THAT(errors.arguments, testing::ElementsAre(argument_error::none, argument_error::invalid, argument_error::missing));
+    EXPECT_EQ(errors.tokens[1], "12abc"sv);
+    EXPECT_FALSE(errors.too_many());
+}
+
+TEST(ArgumentParse, TooManyArguments)
+{
+    std::tuple<int32> values;
+    auto errors = raoe::core::parse::parse_arguments("1 2"sv, values);
+
+    EXPECT_FALSE(errors.ok());
+    EXPECT_TRUE(errors.too_many());
+    EXPECT_EQ(errors.first_extra, "2"sv);
+    EXPECT_EQ(std::get<0>(values), 1);
+}
+
+TEST(ArgumentParse, Bools)
+{
+    std::tuple<bool, bool, bool> arguments;
+    EXPECT_TRUE(raoe::core::parse::parse_arguments(" on false 1"sv, arguments).ok());
+    EXPECT_EQ(arguments, std::make_tuple(true, false, true));
+
+    std::tuple<bool> invalid;
+    EXPECT_EQ(raoe::core::parse::parse_arguments(" yes"sv, invalid).arguments[0], raoe::core::parse::argument_error::invalid);
+}
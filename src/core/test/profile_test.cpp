@@ -0,0 +1,184 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "profile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    //Finds the zones with this name that this thread recorded
+    std::vector<raoe::profile::zone_event> zones_named(std::string_view name, std::thread::id thread_id = std::this_thread::get_id())
+    {
+        std::vector<raoe::profile::zone_event> found;
+        for(const auto& captured : raoe::profile::capture())
+        {
+            if(captured.thread_id != thread_id)
+            {
+                continue;
+            }
+            for(const auto& event : captured.events)
+            {
+                if(event.name == name)
+                {
+                    found.push_back(event);
+                }
+            }
+        }
+        return found;
+    }
+}
+
+TEST(Profile, NestedZones)
+{
+    {
+        RAOE_PROFILE_SCOPE("ProfileTest::Outer");
+        {
+            RAOE_PROFILE_SCOPE("ProfileTest::Inner");
+        }
+    }
+
+    auto outer = zones_named("ProfileTest::Outer"sv);
+    auto inner = zones_named("ProfileTest::Inner"sv);
+    ASSERT_EQ(outer.size(), 1);
+    ASSERT_EQ(inner.size(), 1);
+
+    EXPECT_EQ(inner[0].depth, outer[0].depth + 1);
+    EXPECT_LE(outer[0].start, inner[0].start);
+    EXPECT_GE(outer[0].end, inner[0].end);
+}
+
+TEST(Profile, Disabled)
+{
+    raoe::profile::set_enabled(false);
+    {
+        RAOE_PROFILE_SCOPE("ProfileTest::Disabled");
+    }
+    raoe::profile::set_enabled(true);
+
+    EXPECT_TRUE(zones_named("ProfileTest::Disabled"sv).empty());
+}
+
+TEST(Profile, PerThreadBuffers)
+{
+    std::thread::id worker_id;
+    std::thread worker([&worker_id]() {
+        worker_id = std::this_thread::get_id();
+        RAOE_PROFILE_SCOPE("ProfileTest::Worker");
+    });
+    worker.join();
+
+    EXPECT_EQ(zones_named("ProfileTest::Worker"sv, worker_id).size(), 1);
+    EXPECT_TRUE(zones_named("ProfileTest::Worker"sv).empty());
+}
+
+//The ring keeps the newest zones once it wraps
+TEST(Profile, RingWraps)
+{
+    std::thread worker([]() {
+        for(size_t i = 0; i < raoe::profile::thread_buffer::capacity + 10; i++)
+        {
+            RAOE_PROFILE_SCOPE("ProfileTest::Wrap");
+        }
+        RAOE_PROFILE_SCOPE("ProfileTest::Last");
+    });
+    const std::thread::id worker_id = worker.get_id();
+    worker.join();
+
+    EXPECT_EQ(zones_named("ProfileTest::Wrap"sv, worker_id).size(), raoe::profile::thread_buffer::capacity - 1);
+    EXPECT_EQ(zones_named("ProfileTest::Last"sv, worker_id).size(), 1);
+}
+
+TEST(Profile, ChromeTrace)
+{
+    {
+        RAOE_PROFILE_SCOPE("ProfileTest::\"Quoted\"");
+    }
+
+    std::ostringstream out;
+    raoe::profile::write_chrome_trace(out, raoe::profile::capture());
+    const std::string trace = out.str();
+
+    EXPECT_TRUE(trace.starts_with("{\"traceEvents\":["));
+    EXPECT_NE(trace.find("\"name\":\"ProfileTest::\\\"Quoted\\\"\",\"ph\":\"X\""), std::string::npos);
+}
+
+//Buffers of exited threads are kept for a while, so their zones can be read, but not forever
+TEST(Profile, RetiredBuffersAreFreed)
+{
+    constexpr size_t thread_count = raoe::profile::_::buffer_registry::MaxRetiredBuffers + 4;
+    for(size_t i = 0; i < thread_count; i++)
+    {
+        std::thread([]() { RAOE_PROFILE_SCOPE("ProfileTest::Retired"); }).join();
+    }
+
+    //Thread ids get reused, so count the zones rather than looking them up by thread
+    size_t kept = 0;
+    for(const auto& captured : raoe::profile::capture())
+    {
+        kept += static_cast<size_t>(std::ranges::count(captured.events, "ProfileTest::Retired"sv, &raoe::profile::zone_event::name));
+    }
+    EXPECT_EQ(kept, raoe::profile::_::buffer_registry::MaxRetiredBuffers);
+}
+
+TEST(Profile, DiscardRecorded)
+{
+    {
+        RAOE_PROFILE_SCOPE("ProfileTest::Discarded");
+    }
+    raoe::profile::discard_recorded();
+    {
+        RAOE_PROFILE_SCOPE("ProfileTest::AfterDiscard");
+    }
+
+    EXPECT_TRUE(zones_named("ProfileTest::Discarded"sv).empty());
+    EXPECT_EQ(zones_named("ProfileTest::AfterDiscard"sv).size(), 1);
+    EXPECT_EQ(raoe::profile::intern(std::string("ProfileTest::Interned")).data(), raoe::profile::intern("ProfileTest::Interned"sv).data());
+}
+
+//A reader racing the writer only ever gets whole events, never half of an old one and half of a new one
+TEST(Profile, ReadsWhileWritingAreNeverTorn)
+{
+    raoe::profile::thread_buffer buffer(std::this_thread::get_id(), 0);
+    std::atomic<bool> done = false;
+    std::jthread writer([&buffer, &done]() {
+        for(uint64 i = 0; i < raoe::profile::thread_buffer::capacity * 8; i++)
+        {
+            buffer.write({ .name = (i % 2 == 0) ? "ProfileTest::Even"sv : "ProfileTest::Odd"sv, .start = i, .end = i * 3, .depth = static_cast<uint32>(i % 7) });
+        }
+        done = true;
+    });
+
+    std::vector<raoe::profile::zone_event> events;
+    while(!done)
+    {
+        events.clear();
+        buffer.read(events);
+        for(const raoe::profile::zone_event& event : events)
+        {
+            ASSERT_EQ(event.name, (event.start % 2 == 0) ? "ProfileTest::Even"sv : "ProfileTest::Odd"sv);
+            ASSERT_EQ(event.end, event.start * 3);
+            ASSERT_EQ(event.depth, event.start % 7);
+        }
+    }
+}
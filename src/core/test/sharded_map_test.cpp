@@ -0,0 +1,89 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "container/sharded_map.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(ShardedMapTest, FindInsertErase)
+{
+    raoe::container::sharded_map<std::string, int32, 4> map;
+    EXPECT_FALSE(map.find("a"));
+    map.insert_or_assign("a", 1);
+    map.insert_or_assign("b", 2);
+    map.insert_or_assign("a", 3);
+    EXPECT_EQ(map.find("a"), 3);
+    EXPECT_TRUE(map.contains("b"));
+    EXPECT_EQ(map.size(), 2);
+
+    EXPECT_TRUE(map.erase("a"));
+    EXPECT_FALSE(map.erase("a"));
+    EXPECT_FALSE(map.contains("a"));
+
+    int32 sum = 0;
+    map.for_each([&sum](const std::string&, int32 value) { sum += value; });
+    EXPECT_EQ(sum, 2);
+}
+
+TEST(ShardedMapTest, KeysSpreadAcrossShards)
+{
+    raoe::container::sharded_map<int32, int32, 8> map;
+    for(int32 i = 0; i < 64; i++)
+    {
+        map.insert_or_assign(i, i);
+    }
+    //Integer keys hash to themselves, so without mixing the hash they'd bunch up.  No shard should have most of them
+    for(int32 i = 0; i < 64; i++)
+    {
+        map.with_shard_shared(i, [&](const auto& shard) {
+            EXPECT_TRUE(shard.contains(i));
+            EXPECT_LT(shard.size(), 32);
+        });
+    }
+}
+
+TEST(ShardedMapTest, FindOrInsertFromManyThreads)
+{
+    raoe::container::sharded_map<int32, int32> map;
+    constexpr int32 key_count = 1000;
+    std::vector<std::vector<int32>> seen(4);
+    {
+        std::vector<std::jthread> threads;
+        for(int32 t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&map, &seen, t]() {
+                for(int32 key = 0; key < key_count; key++)
+                {
+                    //The first thread to get to a key decides its value, and everyone sees that one
+                    seen[t].push_back(map.with_shard(key, [key, t](auto& shard) { return shard.try_emplace(key, key * 10 + t).first->second; }));
+                }
+            });
+        }
+    }
+    EXPECT_EQ(map.size(), key_count);
+    for(int32 t = 0; t < 4; t++)
+    {
+        for(int32 key = 0; key < key_count; key++)
+        {
+            EXPECT_EQ(seen[t][key], map.find(key));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "container/snapshot_buffer.hpp"
+#include <thread>
+#include <vector>
+
+TEST(SnapshotBufferTest, NothingPublished)
+{
+    raoe::container::snapshot_buffer<int32> buffer;
+    EXPECT_FALSE(buffer.acquire());
+}
+
+TEST(SnapshotBufferTest, PublishThenAcquire)
+{
+    raoe::container::snapshot_buffer<int32> buffer;
+    buffer.back() = 42;
+    buffer.publish();
+
+    EXPECT_TRUE(buffer.acquire());
+    EXPECT_EQ(buffer.front(), 42);
+
+    //Nothing new was published, so the front stays the same
+    EXPECT_FALSE(buffer.acquire());
+    EXPECT_EQ(buffer.front(), 42);
+}
+
+TEST(SnapshotBufferTest, ConsumerSeesLatest)
+{
+    raoe::container::snapshot_buffer<int32> buffer;
+    for(int32 i = 1; i <= 3; i++)
+    {
+        buffer.back() = i;
+        buffer.publish();
+    }
+
+    EXPECT_TRUE(buffer.acquire());
+    EXPECT_EQ(buffer.front(), 3);
+}
+
+//Every snapshot the consumer sees must be whole (all elements from the same publish), and ticks must never go backwards
+TEST(SnapshotBufferTest, ThreadedHandoff)
+{
+    constexpr int32 snapshot_count = 100000;
+    constexpr size_t snapshot_size = 16;
+    raoe::container::snapshot_buffer<std::vector<int32>> buffer;
+
+    std::thread producer([&buffer]() {
+        for(int32 tick = 1; tick <= snapshot_count; tick++)
+        {
+            std::vector<int32>& back = buffer.back();
+            back.assign(snapshot_size, tick);
+            buffer.publish();
+        }
+    });
+
+    int32 last_seen = 0;
+    bool torn = false;
+    while(last_seen < snapshot_count)
+    {
+        if(buffer.acquire())
+        {
+            const std::vector<int32>& front = buffer.front();
+            for(int32 value : front)
+            {
+                torn |= value != front[0];
+            }
+            torn |= front[0] < last_seen;
+            last_seen = front[0];
+        }
+    }
+    producer.join();
+
+    EXPECT_FALSE(torn);
+    EXPECT_EQ(last_seen, snapshot_count);
+}
@@ -0,0 +1,98 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "startup_trace.hpp"
+#include <sstream>
+#include <thread>
+
+TEST(StartupTrace, RecordsSpansUntilFinished)
+{
+    raoe::startup_trace::reset();
+    {
+        RAOE_STARTUP_TRACE_SCOPE("engine", "StartupTraceTest::Before");
+    }
+    raoe::startup_trace::mark_static_init();
+    raoe::startup_trace::mark_static_init();
+    raoe::startup_trace::finish();
+    EXPECT_FALSE(raoe::startup_trace::recording());
+    {
+        RAOE_STARTUP_TRACE_SCOPE("engine", "StartupTraceTest::After");
+    }
+
+    const std::vector<raoe::startup_trace::span> spans = raoe::startup_trace::spans();
+    auto named = [&spans](std::string_view name) {
+        return std::ranges::count_if(spans, [name](const raoe::startup_trace::span& traced) { return traced.name == name; });
+    };
+    EXPECT_EQ(named("StartupTraceTest::Before"), 1);
+    EXPECT_EQ(named("StartupTraceTest::After"), 0);
+    EXPECT_EQ(named("2 registrations"), 1);
+    EXPECT_EQ(named("startup to first frame"), 1);
+    for(const raoe::startup_trace::span& traced : spans)
+    {
+        EXPECT_LE(traced.start, traced.end);
+    }
+    raoe::startup_trace::reset();
+}
+
+TEST(StartupTrace, SpansStartedBeforeFinishAreKept)
+{
+    raoe::startup_trace::reset();
+    {
+        raoe::startup_trace::scoped_span span("task", "StartupTraceTest::Straddles");
+        raoe::startup_trace::finish();
+    }
+    const std::vector<raoe::startup_trace::span> spans = raoe::startup_trace::spans();
+    EXPECT_TRUE(std::ranges::any_of(spans, [](const raoe::startup_trace::span& traced) { return traced.name == "StartupTraceTest::Straddles"; }));
+    raoe::startup_trace::reset();
+}
+
+TEST(StartupTrace, ThreadsAreNumberedInOrder)
+{
+    raoe::startup_trace::reset();
+    raoe::startup_trace::record("engine", "main", 1, 2);
+    std::thread([] { raoe::startup_trace::record("cog", "worker", 1, 2); }).join();
+
+    const std::vector<raoe::startup_trace::span> spans = raoe::startup_trace::spans();
+    ASSERT_EQ(spans.size(), 2);
+    EXPECT_EQ(spans[0].thread, 0u);
+    EXPECT_EQ(spans[1].thread, 1u);
+    raoe::startup_trace::reset();
+}
+
+TEST(StartupTrace, SortsAndWritesChromeTrace)
+{
+    const uint64 origin = raoe::profile::startup_reference().ticks;
+    const std::vector<raoe::startup_trace::span> spans = raoe::startup_trace::sorted_by_duration({
+        { "gear", "short", origin, origin + 10, 0 },
+        { "resource", "long \"quoted\"", origin, origin + 1000, 1 },
+        { "task", "middle", origin + 5, origin + 105, 0 },
+    });
+    ASSERT_EQ(spans.size(), 3);
+    EXPECT_EQ(spans[0].category, "resource");
+    EXPECT_EQ(spans[1].name, "middle");
+    EXPECT_EQ(spans[2].name, "short");
+
+    std::ostringstream out;
+    raoe::startup_trace::write_chrome_trace(out, spans);
+    const std::string json = out.str();
+    EXPECT_THAT(json, ::testing::StartsWith("{\"traceEvents\":["));
+    EXPECT_THAT(json, ::testing::HasSubstr("\"name\":\"long \\\"quoted\\\"\",\"cat\":\"resource\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0"));
+    EXPECT_THAT(json, ::testing::HasSubstr("\"cat\":\"gear\""));
+}
@@ -19,6 +19,11 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "core.hpp"
 
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
 
 using namespace std::literals::string_view_literals;
 
@@ -35,6 +40,8 @@ TEST(StringViewOperations, trim_l)
 TEST(StringViewOperations, trim)
 {
     EXPECT_EQ(raoe::string::trim("    asdf       "sv), "asdf"sv);
+    EXPECT_EQ(raoe::string::trim("       "sv), ""sv);
+    EXPECT_EQ(raoe::string::trim(""sv), ""sv);
 }
 
 TEST(StringViewOperations, split)
@@ -54,4 +61,151 @@ TEST(StringViewOperations, split)
 TEST(StringViewOperations, token)
 {
     EXPECT_EQ(raoe::string::token("these words of power"sv, " "sv), "these"sv);
-}
\ No newline at end of file
+}
+
+TEST(StringViewOperations, trim_whitespace)
+{
+    EXPECT_EQ(raoe::string::trim("\t\r\n asdf jkl\v\f \n"sv), "asdf jkl"sv);
+    EXPECT_EQ(raoe::string::trim_l(" \t\n"sv), ""sv);
+    EXPECT_EQ(raoe::string::trim_r(" \t\n"sv), ""sv);
+}
+
+TEST(StringViewOperations, split_view)
+{
+    using testing::ElementsAre;
+    auto fields = [](auto view) {
+        std::vector<std::string_view> result;
+        std::ranges::copy(view, std::back_inserter(result));
+        return result;
+    };
+    static_assert(std::ranges::forward_range<raoe::string::split_view<char>>);
+    static_assert(std::ranges::borrowed_range<raoe::string::split_view<char>>);
+
+    EXPECT_THAT(fields(raoe::string::split("a,b,,c"sv, ',')), ElementsAre("a"sv, "b"sv, ""sv, "c"sv));
+    EXPECT_THAT(fields(raoe::string::split(",a,"sv, ',')), ElementsAre(""sv, "a"sv, ""sv));
+    EXPECT_THAT(fields(raoe::string::split("abc"sv, ',')), ElementsAre("abc"sv));
+    EXPECT_THAT(fields(raoe::string::split(""sv, ',')), testing::IsEmpty());
+
+    //Multi byte delimiters skip the whole delimiter
+    EXPECT_THAT(fields(raoe::string::split("one::two:three::"sv, "::"sv)), ElementsAre("one"sv, "two:three"sv, ""sv));
+    EXPECT_THAT(fields(raoe::string::split("no delimiter"sv, ""sv)), ElementsAre("no delimiter"sv));
+
+    //Long enough to go through the vector loops, with the delimiter straddling a block boundary
+    const std::string long_source = std::string(31, 'x') + "<>" + std::string(40, 'y') + "<>z";
+    EXPECT_THAT(fields(raoe::string::split(long_source, "<>"sv)), ElementsAre(std::string(31, 'x'), std::string(40, 'y'), "z"sv));
+}
+
+TEST(StringViewOperations, tokenize_view)
+{
+    using testing::ElementsAre;
+    auto tokens = [](auto view) {
+        std::vector<std::string_view> result;
+        std::ranges::copy(view, std::back_inserter(result));
+        return result;
+    };
+    static_assert(std::ranges::forward_range<raoe::string::tokenize_view<raoe::string::byte_class::whitespace>>);
+
+    EXPECT_THAT(tokens(raoe::string::tokenize("  log_level\t net   debug \n"sv)), ElementsAre("log_level"sv, "net"sv, "debug"sv));
+    EXPECT_THAT(tokens(raoe::string::tokenize(" \t\n "sv)), testing::IsEmpty());
+    EXPECT_THAT(tokens(raoe::string::tokenize("a;b,,c;"sv, ",;"sv)), ElementsAre("a"sv, "b"sv, "c"sv));
+}
+
+TEST(ByteSearch, MatchesStandardFind)
+{
+    //Random text over a small alphabet, so every search hits somewhere, at every length and start up to a few blocks
+    std::mt19937 random(1234); //NOLINT fixed seed, so failures reproduce
+    const std::string_view alphabet = "ab \t\ncd,"sv;
+    const std::string_view whitespace = " \t\n\v\f\r"sv;
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+
+    for(size_t length = 0; length < 100; length++)
+    {
+        std::string text;
+        for(size_t i = 0; i < length; i++)
+        {
+            text.push_back(alphabet[pick(random)]);
+        }
+        const std::string_view s = text;
+        for(size_t from = 0; from <= length; from++)
+        {
+            ASSERT_EQ(raoe::string::find_first(s, raoe::string::byte_class::equals { ',' }, from), s.find(',', from)) << s << " from " << from;
+            ASSERT_EQ(raoe::string::find_first(s, raoe::string::byte_class::whitespace {}, from), s.find_first_of(whitespace, from));
+            ASSERT_EQ(raoe::string::find_first_not(s, raoe::string::byte_class::whitespace {}, from), s.find_first_not_of(whitespace, from));
+            ASSERT_EQ(raoe::string::find_first(s, raoe::string::byte_class::any_of { "cd"sv }, from), s.find_first_of("cd"sv, from));
+            ASSERT_EQ(raoe::string::find_substring(s, "ab"sv, from), s.find("ab"sv, from)) << s << " from " << from;
+            ASSERT_EQ(raoe::string::find_substring(s, "a c"sv, from), s.find("a c"sv, from)) << s << " from " << from;
+        }
+        ASSERT_EQ(raoe::string::find_last(s, raoe::string::byte_class::equals { 'a' }), s.find_last_of('a'));
+        ASSERT_EQ(raoe::string::find_last_not(s, raoe::string::byte_class::whitespace {}), s.find_last_not_of(whitespace));
+    }
+}
+
+namespace StringTest
+{
+    //How split(const std::string&, char) used to work, to measure against
+    std::vector<std::string> split_with_stringstream(const std::string& s, char delim)
+    {
+        std::vector<std::string> elems;
+        std::istringstream iss(s);
+        std::string item;
+        while(std::getline(iss, item, delim))
+        {
+            if(!item.empty())
+            {
+                elems.push_back(item);
+            }
+        }
+        return elems;
+    }
+
+    template<typename Func>
+    int64 time_us(Func&& func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TEST(StringViewOperations, Benchmark)
+{
+    using namespace StringTest;
+
+    //About 8MB of comma separated words, with a line break every so often
+    std::string text;
+    std::mt19937 random(42); //NOLINT
+    std::uniform_int_distribution<int32> word_length(1, 12);
+    while(text.size() < 8 * 1024 * 1024)
+    {
+        text.append(static_cast<size_t>(word_length(random)), 'w');
+        text.push_back(text.size() % 97 == 0 ? '\n' : ',');
+    }
+
+    size_t stream_fields = 0;
+    const int64 stream_us = time_us([&] { stream_fields = split_with_stringstream(text, ',').size(); });
+
+    size_t view_fields = 0;
+    const int64 view_us = time_us([&] {
+        for(const std::string_view field : raoe::string::split(text, ','))
+        {
+            view_fields += field.empty() ? 0 : 1;
+        }
+    });
+    EXPECT_EQ(view_fields, stream_fields);
+
+    size_t tokens = 0;
+    const int64 tokenize_us = time_us([&] { tokens = static_cast<size_t>(std::ranges::distance(raoe::string::tokenize(text, ",\n"sv))); });
+    EXPECT_GE(tokens, view_fields);
+
+    //A needle that's only at the very end, so the whole text is searched
+    text += "needle";
+    size_t found = 0;
+    const int64 substring_us = time_us([&] { found = raoe::string::find_substring(text, "needle"sv); });
+    EXPECT_EQ(found, text.size() - 6);
+    size_t std_found = 0;
+    const int64 std_substring_us = time_us([&] { std_found = std::string_view(text).find("needle"sv); });
+    EXPECT_EQ(std_found, found);
+
+    std::cout << "Split " << text.size() / 1024 << "KB into " << view_fields << " fields: istringstream " << stream_us << "us, split view " << view_us << "us, "
+        << "tokenize " << tokenize_us << "us.  Substring search " << substring_us << "us, string_view::find " << std_substring_us << "us" << std::endl;
+}
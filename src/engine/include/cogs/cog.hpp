@@ -21,9 +21,12 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include <string>
 #include <memory>
 #include <concepts>
+#include <span>
+#include <string_view>
 #include "resource/iresource.hpp"
 #include "resource/tag.hpp"
 #include "engine_fwd.hpp"
+#include "memory_tracking.hpp"
 
 namespace RAOE
 {
@@ -38,6 +41,8 @@ namespace RAOE
 
 namespace RAOE::Cogs
 {       
+    inline constinit const raoe::log::category LogCogs {"cogs"};
+
     enum class ECogStatus : uint8
     {
         Created,
@@ -47,6 +52,9 @@ namespace RAOE::Cogs
         Shutdown,
     };
 
+    //The enumerator's name, eg "PreActivate"
+    [[nodiscard]] std::string_view status_name(ECogStatus status);
+
     class BaseCog : public RAOE::Resource::IResource
     {
         friend class RAOE::Service::CogService;
@@ -63,6 +71,7 @@ namespace RAOE::Cogs
             : m_engine(in_engine)
             , m_status(ECogStatus::Created)
             , m_tag(in_name)
+            , m_memory_tag(raoe::memory::register_tag("cog:" + std::string(name())))
         {
         }     
        
@@ -74,11 +83,20 @@ namespace RAOE::Cogs
 
         [[nodiscard]] virtual bool is_engine_cog() const { return false; }
 
+        //Names of the cogs this one depends on (the Cog:: DEPENDENCIES in raoe_add_cog).  Their gears are built and activated first
+        [[nodiscard]] virtual std::span<const std::string_view> dependencies() const { return {}; }
+
+        //True if this cog's gears have to be built on the main thread (eg they touch SDL or ImGui).  Set by MAIN_THREAD in raoe_add_cog
+        [[nodiscard]] virtual bool main_thread_only() const { return false; }
+
         //BEGIN: IResource Interface
         [[nodiscard]] RAOE::Resource::IResource::ELoadStatus loadstatus() const override { return RAOE::Resource::IResource::ELoadStatus::Loaded; }
         //END: IResource Interface
         
         [[nodiscard]] const RAOE::Resource::Tag& tag() const { return m_tag; }
+
+        //Heap usage made on behalf of this cog is charged to this tag (see memory_tracking.hpp)
+        [[nodiscard]] raoe::memory::tag_id memory_tag() const { return m_memory_tag; }
     protected:
 
 
@@ -86,6 +104,7 @@ namespace RAOE::Cogs
         RAOE::Engine& m_engine;
         ECogStatus m_status;
         RAOE::Resource::Tag m_tag;      
+        raoe::memory::tag_id m_memory_tag;
     };
 
     template<typename T> 
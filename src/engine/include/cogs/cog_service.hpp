@@ -19,15 +19,59 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "core.hpp"
 #include "services/iservice.hpp"
 #include "cogs/cog.hpp"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <optional>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <concepts>
+#include <vector>
 #include "container/subclass_map.hpp"
 
 namespace RAOE
 {
     class Engine;
+
+    //What each cog transition does to the cog's gears.  Defined with the engine
+    namespace TransitionFunc
+    {
+        void no_op(RAOE::Cogs::BaseCog&);
+        void register_gears(RAOE::Cogs::BaseCog& cog);
+        void activate_gears(RAOE::Cogs::BaseCog& for_cog);
+        void ShutdownGears(RAOE::Cogs::BaseCog& for_cog);
+        void LockCogForShutdown(RAOE::Cogs::BaseCog&);
+    }
+}
+
+namespace RAOE::Cogs
+{
+    /***
+     * CogManifestEntry
+     * A shared cog that can be loaded on demand: its name, its library, and the cogs it needs loaded first.
+     * raoe_link_shared_cogs_to_target writes these to cogs/cogs.manifest, one "name library dependencies..." line each
+    */
+    struct CogManifestEntry
+    {
+        std::string name;
+        std::filesystem::path library;
+        std::vector<std::string> dependencies;
+    };
+
+    //Parses manifest text.  Libraries are relative to directory.  Blank lines and lines starting with # are skipped
+    [[nodiscard]] std::vector<CogManifestEntry> parse_cog_manifest(std::string_view text, const std::filesystem::path& directory);
+
+    //Where the engine looks for the manifest: cogs/cogs.manifest next to the executable
+    [[nodiscard]] std::filesystem::path cog_manifest_path();
+
+    //Where a transition's function runs for each cog
+    enum class ETransitionThreading : uint8
+    {
+        MainThread, //one cog at a time on the calling thread, in dependency order
+        Parallel,   //cogs that don't depend on each other at the same time on worker threads.  main_thread_only cogs still run on the calling thread
+    };
 }
 
 namespace RAOE::Service
@@ -55,14 +99,86 @@ namespace RAOE::Service
         {
             if(auto cog = m_cogs.find<T>().lock())
             {
-                transition_func(*(cog.get()));
-                spdlog::info("Transitioning Cog {} from {} to {}", cog->name(), cog->status(), transition_to);
-                cog->m_status = transition_to;
+                transition_single_cog(*cog, transition_to, transition_func);
             }    
         }
 
-        void transition_cogs(ECogStatus transition_to, std::function<void(BaseCog&)> transition_func);
+        /***
+         * transition_cogs
+         * Runs transition_func for every cog that isn't at transition_to yet, then moves them all there.
+         * Going up (to Activated), a cog's dependencies go before it.  Going down (PreShutdown on), they go after it.
+         * With ETransitionThreading::Parallel, the calling thread waits until every cog is done.  Going down always runs on the calling thread
+        */
+        void transition_cogs(ECogStatus transition_to, std::function<void(BaseCog&)> transition_func, RAOE::Cogs::ETransitionThreading threading = RAOE::Cogs::ETransitionThreading::MainThread);
+
+        //Every cog but the engine cog, each after the cogs it depends on.  A dependency that isn't registered is skipped with a warning
+        [[nodiscard]] std::vector<std::shared_ptr<BaseCog>> dependency_order() const;
+
+        //The cog with this name, if it's registered
+        [[nodiscard]] std::weak_ptr<BaseCog> find_cog(std::string_view name) const;
+
+        //Adds the shared cogs listed in a manifest.  Nothing is loaded until something requires it.  Returns false if it can't be read
+        bool load_manifest(const std::filesystem::path& path);
+        void add_manifest_entry(RAOE::Cogs::CogManifestEntry entry);
+        [[nodiscard]] const std::vector<RAOE::Cogs::CogManifestEntry>& manifest() const { return m_manifest; }
+
+        /***
+         * require_cog
+         * The cog with this name.  If it isn't registered, it's loaded from the shared library the manifest names for it,
+         * after the cogs it depends on, and brought up to where transition_cogs last took every other cog
+         * (so a cog loaded after startup has its gears registered and activated straight away).
+         * Returns nothing, and logs why, if it or a dependency can't be loaded
+        */
+        std::weak_ptr<BaseCog> require_cog(std::string_view name);
+
+        [[nodiscard]] bool is_shared_cog(std::string_view name) const;
+        [[nodiscard]] const raoe::container::subclass_map<BaseCog>& cogs() const { return m_cogs; }
+
+        /***
+         * unload_shared_cogs
+         * Shuts down every cog loaded from a shared library (if it isn't already), destroys its gears and the cog,
+         * removes its console elements, and closes its library, newest first.
+         * Pending tasks are discarded first, since their coroutines may live in a library.  The engine calls this after the
+         * Shutdown transition
+        */
+        void unload_shared_cogs();
+
+        /***
+         * reload_cog
+         * Swaps a shared cog for what's in its library now, without restarting the engine.  The cog, and any loaded shared cogs
+         * that depend on it, are taken through PreShutdown and unloaded, then loaded again (from a copy of the library,
+         * so the build can keep writing the original) and brought back up.  Gears can carry state across with
+         * Gear::save_reload_state.  Resources stay loaded.  Returns false, and logs why, if the cog isn't a loaded shared cog
+         * or can't be loaded again
+        */
+        bool reload_cog(std::string_view name);
+
+        /***
+         * reload_changed_cogs
+         * Reloads every shared cog whose library has changed on disk, once the file has stopped changing.
+         * Cheap enough to call every frame: it only looks at the files every ReloadPollInterval, and only when cog_hot_reload is set
+        */
+        void reload_changed_cogs();
+        static constexpr std::chrono::milliseconds ReloadPollInterval { 250 };
     private:
+        struct SharedCogLibrary
+        {
+            std::string name;
+            void* handle = nullptr;
+            const void* base_address = nullptr; //used to find what static objects (like console commands) belong to it
+            std::filesystem::path loaded_from; //a copy of the manifest's library, if this was reloaded
+            std::filesystem::file_time_type write_time = {}; //of the manifest's library when it was loaded
+            std::optional<std::filesystem::file_time_type> changed_write_time = std::nullopt; //set when the library changed, until it settles
+        };
+
+        //Gear state saved across a reload, by gear tag
+        using ReloadStates = std::unordered_map<std::string, std::string>;
+
+        void transition_single_cog(BaseCog& cog, ECogStatus transition_to, const std::function<void(BaseCog&)>& transition_func);
+        std::weak_ptr<BaseCog> require_cog(std::string_view name, std::vector<std::string>& requiring);
+        std::weak_ptr<BaseCog> load_shared_cog(const RAOE::Cogs::CogManifestEntry& entry, const ReloadStates* reload_states = nullptr, uint32 reload_count = 0);
+        void unload_library(SharedCogLibrary library);
+
         template<RAOE::Cogs::is_cog T>
         std::weak_ptr<RAOE::Cogs::BaseCog> find_or_create_cog()
         {           
@@ -79,8 +195,23 @@ namespace RAOE::Service
         void register_cog_resource(std::weak_ptr<BaseCog> cog_ptr);
 
         raoe::container::subclass_map<RAOE::Cogs::BaseCog> m_cogs;
+
+        std::vector<RAOE::Cogs::CogManifestEntry> m_manifest;
+        std::vector<SharedCogLibrary> m_libraries; //in the order they were loaded
+        uint32 m_reload_count = 0;
+        std::chrono::steady_clock::time_point m_next_reload_poll;
+        ECogStatus m_status = ECogStatus::Created; //where transition_cogs last took every cog
     };
 }
 
+//The registration function is how the CogService finds a shared cog, so it has to be exported from the library
+#if defined(RAOE_SHARED_COG) && defined(_WIN32)
+#define RAOE_COG_EXPORT __declspec(dllexport)
+#elif defined(RAOE_SHARED_COG)
+#define RAOE_COG_EXPORT __attribute__((visibility("default")))
+#else
+#define RAOE_COG_EXPORT
+#endif
+
 #define __GENERATED_REGISTER_COG(CogName, CogTypename, CogQualifiedName, CogFunctionName) \
-    extern "C" void CogFunctionName(RAOE::Engine& engine) { if(auto service = engine.get_service<RAOE::Service::CogService>().lock()) service->register_static_cog<CogTypename>(); }
\ No newline at end of file
+    extern "C" RAOE_COG_EXPORT void CogFunctionName(RAOE::Engine& engine) { if(auto service = engine.get_service<RAOE::Service::CogService>().lock()) service->register_static_cog<CogTypename>(); }
\ No newline at end of file
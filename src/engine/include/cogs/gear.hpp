@@ -23,14 +23,27 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "lazy.hpp"
 #include "services/task_service.hpp"
 #include <list>
+#include <optional>
+#include <string>
 
 namespace RAOE
 {
     class Engine;
+    namespace Service
+    {
+        class GearService;
+    }
 }
 
 namespace RAOE::Cogs
 {  
+    //When a registered gear is built.  See GearService::register_gear
+    enum class EGearStartup : uint8
+    {
+        Lazy, //on the first get_gear for it, or when a gear that requires it is built
+        Eager, //as soon as its cog registers its gears
+    };
+
     class Gear : public RAOE::Resource::IResource, public RAOE::Service::task_provider
     {
     public:
@@ -45,6 +58,7 @@ namespace RAOE::Cogs
         Gear(RAOE::Cogs::BaseCog& in_cog, std::string_view name)
             : m_cog(in_cog)
             , m_tag(in_cog.tag().prefix(), "gear/" + std::string(name))
+            , m_memory_tag(raoe::memory::register_tag(memory_tag_name(name)))
         {
 
         }
@@ -53,6 +67,16 @@ namespace RAOE::Cogs
         virtual void activated() {}
         virtual void deactivated() {}
 
+        /***
+         * save_reload_state / restore_reload_state
+         * Opt in to keeping state across a hot reload of the gear's cog (see CogService::reload_cog).
+         * save is called on the old gear after it's deactivated, and whatever it returns is given to restore on the new gear,
+         * after it's built and before it's activated.  Returning nothing (the default) keeps nothing.
+         * The old library is gone by the time restore runs, so the state must not point into it
+        */
+        [[nodiscard]] virtual std::optional<std::string> save_reload_state() const { return std::nullopt; }
+        virtual void restore_reload_state(std::string_view state) { (void)state; }
+
         [[nodiscard]] RAOE::Engine& engine() const { return m_cog.engine(); }
         [[nodiscard]] const RAOE::Cogs::BaseCog& cog() const { return m_cog; }
 
@@ -62,13 +86,25 @@ namespace RAOE::Cogs
         
         [[nodiscard]] const RAOE::Resource::Tag& tag() const { return m_tag; }
 
+        //Heap usage made on behalf of this gear is charged to this tag (see memory_tracking.hpp)
+        [[nodiscard]] raoe::memory::tag_id memory_tag() const { return m_memory_tag; }
+        static std::string memory_tag_name(std::string_view gear_name) { return "gear:" + std::string(gear_name); }
+
     private:
+        friend class RAOE::Service::GearService;
+
         RAOE::Cogs::BaseCog& m_cog;
         RAOE::Resource::Tag m_tag;
+        raoe::memory::tag_id m_memory_tag;
+        bool m_active = false; //between activated() and deactivated()
     };
 
     template<typename T>
     concept is_gear = std::constructible_from<T, RAOE::Cogs::BaseCog&, std::string_view> && std::derived_from<T, RAOE::Cogs::Gear>;
+
+    //A gear can name the gears it needs with `using required_gears = std::tuple<OtherGear, ...>;`.  They're built before it is
+    template<typename T>
+    concept has_required_gears = is_gear<T> && requires { typename T::required_gears; };
 }
 
 #include "cogs/gear_service.hpp"
@@ -78,9 +114,17 @@ namespace RAOE::Cogs
 #define RAOE_GEAR_GENERATE_FUNC_DECL(GearName) extern void RAOE_GEAR_GENERATE_FUNC_NAME(GearName)(RAOE::Cogs::BaseCog& owning_cog)
 #define RAOE_GEAR_GENERATE_FUNC_CALL(GearName) RAOE_GEAR_GENERATE_FUNC_NAME(GearName)(*this)
 
+//Gears are built the first time they're asked for (see RAOE::Cogs::EGearStartup)
 #define RAOE_DEFINE_GEAR(GearName, GearClass) \
     RAOE_GEAR_GENERATE_FUNC_DECL(GearName) \
     { \
-        owning_cog.engine().get_service<RAOE::Service::GearService>().lock()->register_gear<GearClass>(owning_cog, #GearName); \
+        owning_cog.engine().get_service<RAOE::Service::GearService>().lock()->register_gear<GearClass>(owning_cog, #GearName, RAOE::Cogs::EGearStartup::Lazy); \
+    }
+
+//For gears that have to run whether or not anything asks for them, eg ones that only start tasks or hook into other systems
+#define RAOE_DEFINE_EAGER_GEAR(GearName, GearClass) \
+    RAOE_GEAR_GENERATE_FUNC_DECL(GearName) \
+    { \
+        owning_cog.engine().get_service<RAOE::Service::GearService>().lock()->register_gear<GearClass>(owning_cog, #GearName, RAOE::Cogs::EGearStartup::Eager); \
     }
 
@@ -20,6 +20,19 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "cogs/gear.hpp"
 #include "services/iservice.hpp"
 #include "container/subclass_map.hpp"
+#include "startup_trace.hpp"
+#include "typeinfo/typename.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace RAOE
 {
@@ -32,6 +45,12 @@ namespace RAOE
 
 namespace RAOE::Service
 {
+    /***
+     * GearService
+     * Owns every gear.  Cogs register their gears as factories, and a gear is only built (and activated, if its cog is)
+     * when something needs it: the first get_gear for it, a gear that lists it in required_gears, or its cog registering
+     * it as EGearStartup::Eager.  Gears nothing asks for cost a factory, and nothing else
+    */
     class GearService : public IService
     {
     public:
@@ -42,24 +61,157 @@ namespace RAOE::Service
         {
         }
 
+        /***
+         * get_gear
+         * The gear of type T, building it first if it's registered and hasn't been.  A gear built after its cog was activated is
+         * activated here on the main thread.  Asked from another thread, the gear is built there and returned right away, but
+         * its activation is posted to the main thread, so it isn't active until the next process_tasks.  Empty if no cog
+         * registered a T.  A gear that's been built is found in the published snapshot, without taking the lock
+        */
         template<RAOE::Cogs::is_gear T>
         std::weak_ptr<T> get_gear()
         {
-            return m_gears.find<T>();
+            if(const std::shared_ptr<const GearSnapshot> snapshot = m_snapshot.load(std::memory_order_acquire))
+            {
+                if(auto itr = snapshot->find(typeid(T)); itr != snapshot->end())
+                {
+                    return std::static_pointer_cast<T>(itr->second);
+                }
+            }
+            {
+                const std::scoped_lock lock(m_mutex);
+                std::weak_ptr<T> gear = m_gears.find<T>();
+                if(!gear.expired() || !m_factories.contains(typeid(T)))
+                {
+                    return gear;
+                }
+            }
+            return std::dynamic_pointer_cast<T>(build_registered_gear(typeid(T)));
         }
 
+        //The gear with this tag, building it first like get_gear<T> does
+        std::weak_ptr<RAOE::Cogs::Gear> get_gear(const RAOE::Resource::Tag& tag);
+
+        /***
+         * register_gear
+         * Adds a factory for a T, owned by the cog.  An Eager gear is built right away, and returned.  Cogs that don't depend on
+         * each other register their gears in parallel (see CogService::transition_cogs), so gears are built outside the lock,
+         * and only adding them is serialized.  Returns nothing for a Lazy gear, or if a T was already registered
+        */
         template<RAOE::Cogs::is_gear T>
-        std::weak_ptr<T> register_gear(RAOE::Cogs::BaseCog& owning_cog, std::string_view name)
+        std::weak_ptr<T> register_gear(RAOE::Cogs::BaseCog& owning_cog, std::string_view name, RAOE::Cogs::EGearStartup startup = RAOE::Cogs::EGearStartup::Lazy)
         {
-            auto gear = m_gears.insert<T>(owning_cog, name);
-            internal_register_gear(std::static_pointer_cast<RAOE::Cogs::Gear>(gear.lock()));
-            return gear;
+            {
+                const std::scoped_lock lock(m_mutex);
+                if(m_gears.contains<T>() || m_factories.contains(typeid(T)))
+                {
+                    return {};
+                }
+                if(startup == RAOE::Cogs::EGearStartup::Lazy)
+                {
+                    m_factories.emplace(typeid(T), GearFactory {
+                        .type = &typeid(T),
+                        .cog = &owning_cog,
+                        .tag = RAOE::Resource::Tag(owning_cog.tag().prefix(), "gear/" + std::string(name)),
+                        .build = [this, &owning_cog, gear_name = std::string(name)]() { return std::static_pointer_cast<RAOE::Cogs::Gear>(build_gear<T>(owning_cog, gear_name)); },
+                    });
+                    return {};
+                }
+            }
+            return build_gear<T>(owning_cog, name);
         }
 
+        //Every gear that's been built, by type.  Only walk this from the main thread, outside a cog transition
         [[nodiscard]] const raoe::container::subclass_map<RAOE::Cogs::Gear>& all_gears() const { return m_gears; }
+
+        //The gears of a cog that have been built, in the order they were
+        [[nodiscard]] std::vector<std::shared_ptr<RAOE::Cogs::Gear>> gears_of(const RAOE::Cogs::BaseCog& owning_cog) const;
+
+        //How many gears are registered but haven't been built
+        [[nodiscard]] size_t unbuilt_gear_count() const;
+
+        /***
+         * activate_gears / deactivate_gears
+         * Activate every built gear of the cog, queueing their startup tasks, and any gear of the cog built after, until
+         * deactivate_gears deactivates them.  Gears that are never built are never activated or deactivated
+        */
+        void activate_gears(const RAOE::Cogs::BaseCog& owning_cog);
+        void deactivate_gears(const RAOE::Cogs::BaseCog& owning_cog);
+
+        //Destroys every gear the cog registered, built or not.  Returns how many were built
+        size_t remove_gears(const RAOE::Cogs::BaseCog& owning_cog);
+
+        /***
+         * register_gear_resources
+         * Gives every gear built so far its resource handle.  Handles are only written from the main thread, so gears built on
+         * other threads (a parallel cog transition, or a lazy get_gear) wait for this.  Called from another thread, it's posted
+         * to the main thread.  CogService calls it once a parallel transition's workers are done, so their gears have handles
+         * when it returns
+        */
+        void register_gear_resources();
     private:
+        struct GearFactory
+        {
+            const std::type_info* type;
+            const RAOE::Cogs::BaseCog* cog;
+            RAOE::Resource::Tag tag;
+            std::function<std::shared_ptr<RAOE::Cogs::Gear>()> build;
+        };
+
+        template<RAOE::Cogs::is_gear T>
+        std::shared_ptr<T> build_gear(RAOE::Cogs::BaseCog& owning_cog, std::string_view name)
+        {
+            if constexpr(RAOE::Cogs::has_required_gears<T>)
+            {
+                require_gears<T>(std::type_identity<typename T::required_gears>());
+            }
+
+            std::shared_ptr<T> gear;
+            {
+                //Charge whatever the gear allocates while it's being built to the gear, not whatever asked for it
+                const raoe::memory::scoped_tag memory_tag(RAOE::Cogs::Gear::memory_tag_name(name));
+                const raoe::startup_trace::scoped_span span("gear", std::string(owning_cog.name()) + ":gear/" + std::string(name) + " constructor");
+                gear = std::make_shared<T>(owning_cog, name);
+            }
+
+            {
+                const std::scoped_lock lock(m_mutex);
+                if(m_gears.insert_object(gear).expired())
+                {
+                    return {};
+                }
+                internal_register_gear(std::static_pointer_cast<RAOE::Cogs::Gear>(gear));
+                publish_snapshot();
+            }
+            register_gear_resources();
+            return gear;
+        }
+
+        template<typename T, typename... Required>
+        void require_gears(std::type_identity<std::tuple<Required...>>)
+        {
+            ((get_gear<Required>().expired() ? missing_required_gear(raoe::core::name_of<T>(), raoe::core::name_of<Required>()) : void()), ...);
+        }
+
+        //Builds a registered gear, activating it (on the main thread) if its cog is active.  Lazy builds happen one at a time
+        std::shared_ptr<RAOE::Cogs::Gear> build_registered_gear(const std::type_info& type);
+        //Does nothing to a gear that's already active
+        void activate_gear(RAOE::Cogs::Gear& gear);
+        //Call with m_mutex held.  The gear's resource handle waits for register_gear_resources
         void internal_register_gear(const std::shared_ptr<RAOE::Cogs::Gear>& in_gear);
+        static void missing_required_gear(std::string_view gear_name, std::string_view required_name);
+        //Replaces the snapshot lookups read with a copy of m_gears.  Call with m_mutex held
+        void publish_snapshot();
 
         raoe::container::subclass_map<RAOE::Cogs::Gear> m_gears;
+        //Every built gear, by type.  Never changed once it's published, only replaced, so lookups can read it while gears are added
+        using GearSnapshot = std::unordered_map<std::type_index, std::shared_ptr<RAOE::Cogs::Gear>>;
+        std::atomic<std::shared_ptr<const GearSnapshot>> m_snapshot;
+        std::unordered_map<std::type_index, GearFactory> m_factories; //registered, but not built yet
+        std::unordered_map<const RAOE::Cogs::BaseCog*, std::vector<std::shared_ptr<RAOE::Cogs::Gear>>> m_cog_gears;
+        std::unordered_set<const RAOE::Cogs::BaseCog*> m_active_cogs;
+        std::vector<std::weak_ptr<RAOE::Cogs::Gear>> m_unregistered_gears; //built, but without a resource handle yet
+        mutable std::mutex m_mutex;
+        std::recursive_mutex m_build_mutex; //recursive, since building a gear can build the gears it needs
     };
-}
\ No newline at end of file
+}
@@ -16,12 +16,15 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #pragma once
 
+#include <memory>
 #include <string>
-#include <functional>
 #include <vector>
 #include "console.hpp"
 #include "from_string.hpp"
 #include "parse.hpp"
+#include "typeinfo/typename.hpp"
+#include "lazy.hpp"
+#include <type_traits>
 
 namespace RAOE
 {
@@ -30,11 +33,16 @@ namespace RAOE
 
 namespace RAOE::Console
 {
+    /***
+     * BaseCommand
+     * The name and description are views, not copies.  They are expected to be string literals,
+     * or otherwise outlive the command
+    */
     class BaseCommand : public IConsoleElement
     {        
         BaseCommand() = delete;
     protected:
-        BaseCommand(
+        constexpr BaseCommand(
             std::string_view in_command_name, 
             std::string_view in_description, 
             EConsoleFlags in_flags = EConsoleFlags::None
@@ -50,21 +58,32 @@ namespace RAOE::Console
         virtual std::string_view description() const override { return m_description; }
         virtual EConsoleFlags flags() const override { return m_flags; }
 
-        std::string m_name;
-        std::string m_description;
+        std::string_view m_name;
+        std::string_view m_description;
         EConsoleFlags m_flags;
     };
 
-    template<typename... Args>
-    class ConsoleCommandWithArgs : public BaseCommand
+    //What a console command can return.  Commands that return a lazy are asynchronous: they are started on the task service,
+    //and the console log hears about it when they finish
+    template<typename T>
+    concept console_command_result = std::is_void_v<T> 
+        || std::same_as<T, raoe::lazy<>> 
+        || std::same_as<T, raoe::lazy<IConsoleElement::EExecuteError>>;
+
+    //Runs an asynchronous command's task on the task service, and logs when it finishes, how long it took and whether it failed
+    void start_async_command(RAOE::Engine& engine, std::string_view command_name, raoe::lazy<>&& task);
+    void start_async_command(RAOE::Engine& engine, std::string_view command_name, raoe::lazy<IConsoleElement::EExecuteError>&& task);
+
+    template<console_command_result Return, typename... Args>
+    class ConsoleCommand : public BaseCommand
     {
     public:
-        ConsoleCommandWithArgs() = delete; //Cannot construct a default console command
+        ConsoleCommand() = delete; //Cannot construct a default console command
 
-        ConsoleCommandWithArgs(
+        constexpr ConsoleCommand(
             std::string_view in_command_name, 
             std::string_view in_description, 
-            void(*in_functor)(Args...), 
+            Return(*in_functor)(Args...), 
             EConsoleFlags in_flags = EConsoleFlags::None
         )
             : BaseCommand(in_command_name, in_description, in_flags)
@@ -76,70 +95,222 @@ namespace RAOE::Console
         {
             if constexpr (requires () { functor(); })
             {
-                functor();                
-                return EExecuteError::Success;
+                return call(engine);
             }
             else if constexpr (requires (RAOE::Engine& e) { functor(e); })
             {
-                functor(engine);
-                return EExecuteError::Success;
+                return call(engine, engine);
             }
             else if constexpr (requires (RAOE::Engine& e, std::string_view sv) { functor(e, sv); })
             {
-                functor(engine, command_line);
-                return EExecuteError::Success;
+                return call(engine, engine, command_line);
             }      
             else if constexpr (requires (std::string_view sv) { functor(sv); })
             {
-                functor(command_line);
-                return EExecuteError::Success;
+                return call(engine, command_line);
             }          
-            else if constexpr (requires(RAOE::Engine& e, Args... args) { functor(e, args...); })
-            {
-                static_assert(true, "TODO: This");
-                std::tuple<Args...> parsed_arguments = raoe::core::parse::parse_tuple<Args...>(command_line);   
-                std::tuple<std::reference_wrapper<RAOE::Engine&>, Args...> combined_args = std::tuple_cat(std::tie(engine), parsed_arguments);
-                std::apply(functor, combined_args);
-            }
             else
             {
-                std::tuple<Args...> parsed_arguments = raoe::core::parse::parse_tuple<Args...>(command_line);   
-                std::apply(functor, parsed_arguments);
+                return bind_and_call(engine, command_line, std::type_identity<std::tuple<Args...>>{});
             }            
-            return EExecuteError::Success;
         }     
+
+        //Commands that take parsed arguments parse them here, once.  The rest have nothing to parse
+        std::unique_ptr<IBoundCall> bind(std::string_view command_line) const override
+        {
+            if constexpr (requires () { functor(); } 
+                || requires (RAOE::Engine& e) { functor(e); } 
+                || requires (RAOE::Engine& e, std::string_view sv) { functor(e, sv); }
+                || requires (std::string_view sv) { functor(sv); })
+            {
+                return BaseCommand::bind(command_line);
+            }
+            else
+            {
+                return bind_parsed(command_line, std::type_identity<std::tuple<Args...>>{});
+            }
+        }
+
+        [[nodiscard]] static constexpr bool is_async() { return !std::is_void_v<Return>; }
     private:
-        std::function<void(Args...)> functor;
+        //A command line parsed into the command's arguments.  Keeps its own copy of the line, since arguments can view it
+        template<bool TakesEngine, typename... Params>
+        class BoundArguments final : public IBoundCall
+        {
+        public:
+            BoundArguments(const ConsoleCommand& in_command, std::string_view in_command_line)
+                : m_command(in_command)
+                , m_command_line(in_command_line)
+            {
+            }
+
+            //False if the arguments didn't parse
+            bool parse() { return raoe::core::parse::parse_arguments(m_command_line, m_arguments).ok(); }
+
+            EExecuteError execute(RAOE::Engine& engine) const override
+            {
+                return std::apply([&](const auto&... values) {
+                    if constexpr (TakesEngine)
+                    {
+                        return m_command.call(engine, engine, values...);
+                    }
+                    else
+                    {
+                        return m_command.call(engine, values...);
+                    }
+                }, m_arguments);
+            }
+        private:
+            const ConsoleCommand& m_command;
+            std::string m_command_line;
+            std::tuple<std::remove_cvref_t<Params>...> m_arguments;
+        };
+
+        template<bool TakesEngine, typename... Params>
+        std::unique_ptr<IBoundCall> make_bound_arguments(std::string_view command_line) const
+        {
+            auto bound = std::make_unique<BoundArguments<TakesEngine, Params...>>(*this, command_line);
+            if(!bound->parse())
+            {
+                return BaseCommand::bind(command_line);
+            }
+            return bound;
+        }
+
+        template<typename... Params>
+        std::unique_ptr<IBoundCall> bind_parsed(std::string_view command_line, std::type_identity<std::tuple<RAOE::Engine&, Params...>>) const
+        {
+            return make_bound_arguments<true, Params...>(command_line);
+        }
+
+        template<typename... Params>
+        std::unique_ptr<IBoundCall> bind_parsed(std::string_view command_line, std::type_identity<std::tuple<Params...>>) const
+        {
+            return make_bound_arguments<false, Params...>(command_line);
+        }
+
+        //Calls the functor.  If the command is asynchronous, it's started here, and counts as a success until it finishes
+        template<typename... CallArgs>
+        EExecuteError call(RAOE::Engine& engine, CallArgs&&... call_args) const
+        {
+            if constexpr (is_async())
+            {
+                start_async_command(engine, name(), functor(std::forward<CallArgs>(call_args)...));
+            }
+            else
+            {
+                functor(std::forward<CallArgs>(call_args)...);
+            }
+            return EExecuteError::Success;
+        }
+
+        //Commands can take the engine as their first parameter, ahead of the parsed ones
+        template<typename... Params>
+        EExecuteError bind_and_call(RAOE::Engine& engine, std::string_view command_line, std::type_identity<std::tuple<RAOE::Engine&, Params...>>) const
+        {
+            std::tuple<std::remove_cvref_t<Params>...> parsed_arguments;
+            if(const EExecuteError error = bind_arguments(command_line, parsed_arguments); error != EExecuteError::Success)
+            {
+                return error;
+            }
+            return std::apply([&](auto&... values) { return call(engine, engine, values...); }, parsed_arguments);
+        }
+
+        template<typename... Params>
+        EExecuteError bind_and_call(RAOE::Engine& engine, std::string_view command_line, std::type_identity<std::tuple<Params...>>) const
+        {
+            std::tuple<std::remove_cvref_t<Params>...> parsed_arguments;
+            if(const EExecuteError error = bind_arguments(command_line, parsed_arguments); error != EExecuteError::Success)
+            {
+                return error;
+            }
+            return std::apply([&](auto&... values) { return call(engine, values...); }, parsed_arguments);
+        }
+
+        //Parses the command line into the arguments, logging what was wrong with each one that failed
+        template<typename... Params>
+        EExecuteError bind_arguments(std::string_view command_line, std::tuple<Params...>& out_arguments) const
+        {
+            const auto errors = raoe::core::parse::parse_arguments(command_line, out_arguments);
+            if(errors.ok())
+            {
+                return EExecuteError::Success;
+            }
+
+            EExecuteError result = EExecuteError::Success;
+            [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                auto report = [&]<size_t Index>(std::integral_constant<size_t, Index>)
+                {
+                    using Param = std::tuple_element_t<Index, std::tuple<Params...>>;
+                    switch(errors.arguments[Index])
+                    {
+                        case raoe::core::parse::argument_error::missing:
+                            spdlog::warn("{}: missing argument {} ({})", name(), Index + 1, raoe::core::name_of<Param>());
+                            result = result == EExecuteError::Success ? EExecuteError::Missing_Arguments : result;
+                            break;
+                        case raoe::core::parse::argument_error::invalid:
+                            spdlog::warn("{}: argument {} \"{}\" is not a valid {}", name(), Index + 1, errors.tokens[Index], raoe::core::name_of<Param>());
+                            result = EExecuteError::Invalid_Arguments;
+                            break;
+                        case raoe::core::parse::argument_error::none:
+                            break;
+                    }
+                };
+                (report(std::integral_constant<size_t, I>{}), ...);
+            }(std::index_sequence_for<Params...>{});
+
+            if(errors.too_many())
+            {
+                spdlog::warn("{}: takes {} arguments, unexpected \"{}\"", name(), sizeof...(Params), errors.first_extra);
+                result = result == EExecuteError::Success ? EExecuteError::Too_Many_Arguments : result;
+            }
+            return result;
+        }
+
+        //Called directly, there's no type erasure between the console and the command
+        Return(*functor)(Args...);
     };
 
-    struct AutoRegisterConsoleCommand : public AutoRegisterConsoleElement
+    //The usual, synchronous, command
+    template<typename... Args>
+    using ConsoleCommandWithArgs = ConsoleCommand<void, Args...>;
+
+    /***
+     * AutoRegisterConsoleCommand
+     * A console command that registers itself.  Declare one at namespace scope through CreateConsoleCommand:
+     *     static const AutoRegisterConsoleCommand my_command = RAOE::Console::CreateConsoleCommand("name", "description", function);
+     * The command lives in the static object itself, so declaring one doesn't allocate
+    */
+    template<console_command_result Return, typename... Args>
+    class AutoRegisterConsoleCommand : public ConsoleCommand<Return, Args...>
     {
-        AutoRegisterConsoleCommand(BaseCommand* in_command)
-            : AutoRegisterConsoleElement(in_command)
+    public:
+        AutoRegisterConsoleCommand(
+            std::string_view in_command_name, 
+            std::string_view in_description, 
+            Return(*in_functor)(Args...), 
+            EConsoleFlags in_flags = EConsoleFlags::None
+        )
+            : ConsoleCommand<Return, Args...>(in_command_name, in_description, in_functor, in_flags)
+            , m_registration(*this)
         {
         }
 
-        BaseCommand* GetConsoleCommand() { return static_cast<BaseCommand*>(console_element()); }
+        [[nodiscard]] const BaseCommand* GetConsoleCommand() const { return this; }
+
+    private:
+        AutoRegisterConsoleElement m_registration;
     };
 
-    template<typename... Args>
-    AutoRegisterConsoleCommand CreateConsoleCommand(std::string_view name,
+    template<console_command_result Return, typename... Args>
+    AutoRegisterConsoleCommand<Return, Args...> CreateConsoleCommand(std::string_view name,
         std::string_view description,
-        void(*functor)(Args...), 
+        Return(*functor)(Args...), 
         EConsoleFlags flags = EConsoleFlags::None
     )
     {
-        BaseCommand* cmd = dynamic_cast<BaseCommand*>(CommandRegistry::Get().register_console_element([=]() -> BaseCommand*
-            {
-                return new ConsoleCommandWithArgs<Args...>(
-                    name,
-                    description,
-                    functor,
-                    flags
-                );
-            }           
-        ));
-
-        return AutoRegisterConsoleCommand(cmd);
+        //Returned as a prvalue, so it's constructed directly in the caller's static, which is what gets registered
+        return AutoRegisterConsoleCommand<Return, Args...>(name, description, functor, flags);
     }      
 }
\ No newline at end of file
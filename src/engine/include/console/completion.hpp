@@ -0,0 +1,86 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "core.hpp"
+#include "console/console.hpp"
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace RAOE::Console
+{
+    /***
+     * CompletionIndex
+     * Fuzzy matches console input against the names of every registered element, for the console's completion popup.
+     *
+     * Names are indexed by trigram when the registry changes, so a query only looks at names that share a trigram with it.
+     * A name matches if it shares at least half of the query's trigrams (so typos still match), or for queries too short to 
+     * have trigrams, if it contains the query.  Matches that start with the query, then contain it, rank highest.
+     *
+     * Queries are incremental: typing another character only adds the postings of the one new trigram to the running counts,
+     * and asking again with the same input returns the cached results.
+    */
+    class CompletionIndex
+    {
+    public:
+        static constexpr size_t DefaultMaxResults = 15;
+
+        explicit CompletionIndex(const CommandRegistry& in_registry = CommandRegistry::Get(), size_t in_max_results = DefaultMaxResults)
+            : m_registry(in_registry)
+            , m_max_results(in_max_results)
+        {
+        }
+
+        //The best matches for the command name in input (everything before the first space), best first.
+        //Valid until the next call to query
+        [[nodiscard]] std::span<IConsoleElement* const> query(std::string_view input);
+
+    private:
+        struct Match
+        {
+            uint32 score;
+            uint32 name_index;
+        };
+
+        void rebuild();
+        void reset_counts();
+        void add_trigram_postings(std::string_view query, size_t first_trigram);
+        void collect_substring_candidates(std::string_view query, bool extends_previous);
+        [[nodiscard]] bool better(const Match& lhs, const Match& rhs) const;
+
+        const CommandRegistry& m_registry;
+        size_t m_max_results;
+        uint64 m_generation = ~uint64(0);
+
+        //Every distinct element, with its lowercased name
+        std::vector<IConsoleElement*> m_elements;
+        std::vector<std::string> m_names;
+        std::unordered_map<uint32, std::vector<uint32>> m_trigram_postings;
+
+        //Incremental state for m_query
+        std::string m_query;
+        std::vector<uint16> m_shared_trigrams;  //per name, how many of the query's trigrams it has
+        std::vector<uint32> m_touched;          //the names with a non zero count
+        std::vector<uint32> m_substring_candidates;
+        std::vector<Match> m_heap;
+        std::vector<IConsoleElement*> m_results;
+    };
+}
@@ -18,8 +18,13 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 
 #include "core.hpp"
+#include "startup_trace.hpp"
+#include <map>
 #include <string>
-#include <functional>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace RAOE
@@ -49,48 +54,149 @@ namespace RAOE::Console
         enum class EExecuteError : uint8
         {
             Success,
-            Invalid_Arguments,
+            Invalid_Arguments,  //an argument couldn't be converted to the type the command takes
+            Missing_Arguments,  //fewer arguments than the command takes
+            Too_Many_Arguments, //more arguments than the command takes
             Command_Error
         };
 
         virtual EExecuteError execute(RAOE::Engine& engine, std::string_view command_line)  const = 0;
+
+        /***
+         * IBoundCall
+         * A command line already parsed for one element, so it can be run over and over without parsing it again
+        */
+        class IBoundCall
+        {
+        public:
+            virtual ~IBoundCall() = default;
+            virtual EExecuteError execute(RAOE::Engine& engine) const = 0;
+        };
+
+        //Parses a command line once, for callers that run it many times (see CommandRegistry::bind).  By default the text is
+        //kept and handed to execute() on every call.  Elements that parse their arguments bind them instead, unless they
+        //don't parse, in which case the text is kept so the error is reported each time it runs
+        [[nodiscard]] virtual std::unique_ptr<IBoundCall> bind(std::string_view command_line) const;
     };
 
-    struct AutoRegisterConsoleElement
+    /***
+     * AutoRegisterConsoleElement
+     * Console elements declared at namespace scope (see CreateConsoleCommand and CreateCVar) are static objects that
+     * link themselves into an intrusive list while static initialization runs.  That's two pointer writes: nothing is
+     * allocated, and nothing touches the registry.  CommandRegistry::Get() picks up anything new on the list each time
+     * it's asked for, so the registry is built lazily, on first use.
+    */
+    class AutoRegisterConsoleElement
     {
-        AutoRegisterConsoleElement(IConsoleElement* in_constructed_element)
-            : constructed_element(in_constructed_element)
+        friend class CommandRegistry;
+    public:
+        explicit AutoRegisterConsoleElement(IConsoleElement& in_element) noexcept
+            : m_element(&in_element)
+            , m_next(s_head)
         {
+            s_head = this;
+            raoe::startup_trace::mark_static_init();
         }
 
-        IConsoleElement* console_element() { return constructed_element; }
+        AutoRegisterConsoleElement(const AutoRegisterConsoleElement&) = delete;
+        AutoRegisterConsoleElement& operator=(const AutoRegisterConsoleElement&) = delete;
+        AutoRegisterConsoleElement(AutoRegisterConsoleElement&&) = delete;
+        AutoRegisterConsoleElement& operator=(AutoRegisterConsoleElement&&) = delete;
+
+        [[nodiscard]] IConsoleElement* console_element() const { return m_element; }
+        [[nodiscard]] const AutoRegisterConsoleElement* next() const { return m_next; }
+
+        //The most recently linked element.  The list runs from the newest to the oldest
+        [[nodiscard]] static const AutoRegisterConsoleElement* head() { return s_head; }
 
     private:
-        IConsoleElement* constructed_element;
+        IConsoleElement* m_element;
+        //Mutable so an element can be unlinked when the library it was declared in is unloaded (see CommandRegistry::unregister_static_elements)
+        mutable const AutoRegisterConsoleElement* m_next;
+
+        static inline constinit const AutoRegisterConsoleElement* s_head = nullptr;
     };
 
+    enum class EConsoleError : uint8
+    {
+        None,
+        Command_Not_Found,
+        Incorrect_Arguments,
+        Not_Authorized,
+        Need_Cheats,
+    };
   
     class CommandRegistry
     {
     public:
+        //The registry every statically declared element lands in
         static CommandRegistry& Get();
         friend struct Command;       
        
-        IConsoleElement* register_console_element(std::function<IConsoleElement*()> factory);
+        //Registers an element that outlives the registry, like a static one.  Returns the element
+        IConsoleElement* register_console_element(IConsoleElement& element);
+
+        //Registers an element created at runtime, which the registry then owns.  Returns the element
+        IConsoleElement* register_console_element(std::unique_ptr<IConsoleElement> element);
+
+        /***
+         * unregister_static_elements
+         * Unlinks every statically declared element the predicate returns true for, and removes it from the registry.
+         * This is how the console forgets the elements a shared library declared before the library is unloaded.
+         * Returns how many were removed
+        */
+        template<typename Predicate>
+        static size_t unregister_static_elements(Predicate&& predicate)
+        {
+            return Get().unregister_static_elements_if(+[](const IConsoleElement& element, void* context) {
+                return (*static_cast<std::remove_reference_t<Predicate>*>(context))(element);
+            }, &predicate);
+        }
 
+        //Every element, in registration order
+        [[nodiscard]] std::span<IConsoleElement* const> elements() const { return m_elements; }
 
-        const std::vector<std::unique_ptr<IConsoleElement>>& elements() const { return element_registry; }    
+        //Finds an element by its exact name, or nullptr.  If two elements share a name, the first one registered wins
+        [[nodiscard]] IConsoleElement* find(std::string_view name) const;
+
+        //Every element whose name starts with prefix, sorted by name.  Invalidated by the next registration
+        [[nodiscard]] std::span<IConsoleElement* const> complete(std::string_view prefix) const;
+
+        /***
+         * bind
+         * The element's bound call for a command line, bound the first time it's asked for and shared after that.
+         * The registry owns it, and frees it when the element is unregistered, so like the element itself it's only
+         * good until generation() changes
+        */
+        [[nodiscard]] const IConsoleElement::IBoundCall& bind(const IConsoleElement& element, std::string_view command_line) const;
+
+        //Bumped on every registration and unregistration, so anything caching over the registry knows when to rebuild
+        [[nodiscard]] uint64 generation() const { return m_generation; }
+
+        EConsoleError execute(RAOE::Engine& engine, std::string_view command_line) const;
     private:        
-        std::vector<std::unique_ptr<IConsoleElement>> element_registry;
-    };
+        void add_element(IConsoleElement* element);
 
-    enum class EConsoleError : uint8
-    {
-        None,
-        Command_Not_Found,
-        Incorrect_Arguments,
-        Not_Authorized,
-        Need_Cheats,
+        //Registers everything linked onto the AutoRegisterConsoleElement list since the last call, oldest first
+        void register_static_elements();
+
+        size_t unregister_static_elements_if(bool(*predicate)(const IConsoleElement&, void*), void* context);
+
+        std::vector<IConsoleElement*> m_elements;
+        std::vector<std::unique_ptr<IConsoleElement>> m_owned_elements;
+        const AutoRegisterConsoleElement* m_registered_static_head = nullptr;
+
+        //Keys view the names owned by the elements, which live as long as the registry
+        std::unordered_map<std::string_view, IConsoleElement*> m_name_index;
+
+        //Every element sorted by name, for prefix completion.  Sorted lazily, since registration happens in bulk at startup
+        mutable std::vector<IConsoleElement*> m_sorted_elements;
+        mutable bool m_sorted = true;
+
+        //Bound calls by element, then by command line
+        mutable std::unordered_map<const IConsoleElement*, std::map<std::string, std::unique_ptr<IConsoleElement::IBoundCall>, std::less<>>> m_bound_calls;
+
+        uint64 m_generation = 0;
     };
 
     EConsoleError execute(RAOE::Engine& engine, std::string_view command_line);
@@ -0,0 +1,266 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "console/command.hpp"
+#include "from_string.hpp"
+
+#include <atomic>
+#include <concepts>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace RAOE::Console
+{
+    //CVars are read from hot loops, so only types that fit in a lock free atomic can be cvars
+    template<typename T>
+    concept cvar_value = (std::integral<T> || std::floating_point<T>) && std::atomic<T>::is_always_lock_free;
+
+    /***
+     * ICVar
+     * A console variable.  Executing it with no arguments prints its value, and with one argument sets it
+    */
+    class ICVar : public BaseCommand
+    {
+    public:
+        [[nodiscard]] virtual std::string value_string() const = 0;
+        [[nodiscard]] virtual std::string default_string() const = 0;
+
+        //Parses and sets the value, returns false if the string isn't a valid value
+        virtual bool set_from_string(std::string_view value) const = 0;
+
+        //Runs the change callback, if the value changed since the last time this was called.  Called by flush_cvar_changes
+        virtual void notify_changed() const = 0;
+
+    protected:
+        using BaseCommand::BaseCommand;
+
+        //Queues this cvar for flush_cvar_changes
+        void queue_change() const;
+
+        //Set while the cvar is on the queue, so it's only queued once per flush
+        mutable std::atomic<bool> m_change_queued = false;
+
+        friend void discard_cvar_change(const ICVar& cvar);
+    };
+
+    /***
+     * CVar
+     * A typed console variable.
+     *
+     * get() is a single relaxed atomic load, so it's fine to read a cvar every iteration of an inner loop.
+     * Writes can come from any thread.  The change callback doesn't run on the writer, it runs at the end of the frame
+     * (see flush_cvar_changes), once, with the latest value, no matter how many times the cvar was set during the frame
+    */
+    template<cvar_value T>
+    class CVar : public ICVar
+    {
+    public:
+        using change_callback = void(*)(T);
+
+        CVar(
+            std::string_view in_name,
+            std::string_view in_description,
+            T in_default_value,
+            change_callback in_on_changed = nullptr,
+            EConsoleFlags in_flags = EConsoleFlags::None
+        )
+            : ICVar(in_name, in_description, in_flags)
+            , m_default_value(in_default_value)
+            , m_value(in_default_value)
+            , m_notified_value(in_default_value)
+            , m_on_changed(in_on_changed)
+        {
+        }
+
+        [[nodiscard]] T get() const noexcept { return m_value.load(std::memory_order_relaxed); }
+        [[nodiscard]] T default_value() const noexcept { return m_default_value; }
+
+        void set(T value) const
+        {
+            m_value.store(value, std::memory_order_relaxed);
+            if(!m_change_queued.exchange(true, std::memory_order_acq_rel))
+            {
+                queue_change();
+            }
+        }
+
+        [[nodiscard]] std::string value_string() const override { return fmt::format("{}", get()); }
+        [[nodiscard]] std::string default_string() const override { return fmt::format("{}", m_default_value); }
+
+        bool set_from_string(std::string_view value) const override
+        {
+            T parsed {};
+            if(!raoe::string::from_string(value, parsed))
+            {
+                return false;
+            }
+            set(parsed);
+            return true;
+        }
+
+        EExecuteError execute(RAOE::Engine&, std::string_view command_line) const override
+        {
+            const auto split = raoe::core::parse::parse_split_fixed<1>(command_line);
+            if(split.count == 0)
+            {
+                spdlog::info("{} = {} (default {})", name(), value_string(), default_string());
+                return EExecuteError::Success;
+            }
+            if(!split.first_extra.empty())
+            {
+                spdlog::warn("{}: takes one value, unexpected \"{}\"", name(), split.first_extra);
+                return EExecuteError::Too_Many_Arguments;
+            }
+            if(!set_from_string(split.tokens[0]))
+            {
+                spdlog::warn("{}: \"{}\" is not a valid {}", name(), split.tokens[0], raoe::core::name_of<T>());
+                return EExecuteError::Invalid_Arguments;
+            }
+            return EExecuteError::Success;
+        }
+
+        //A line that sets the cvar is parsed once into the value
+        std::unique_ptr<IBoundCall> bind(std::string_view command_line) const override
+        {
+            const auto split = raoe::core::parse::parse_split_fixed<1>(command_line);
+            T parsed {};
+            if(split.count != 1 || !split.first_extra.empty() || !raoe::string::from_string(split.tokens[0], parsed))
+            {
+                return ICVar::bind(command_line);
+            }
+            return std::make_unique<BoundSet>(*this, parsed);
+        }
+
+        void notify_changed() const override
+        {
+            //A read-modify-write, so a set() whose exchange saw the flag still up is ordered before the get() below, and its
+            //value is the one notified.  A set() after this queues the cvar again
+            m_change_queued.exchange(false, std::memory_order_acq_rel);
+            const T value = get();
+            if(value == m_notified_value)
+            {
+                return; //Set and set back within a frame
+            }
+            m_notified_value = value;
+            if(m_on_changed)
+            {
+                m_on_changed(value);
+            }
+        }
+
+    private:
+        class BoundSet final : public IBoundCall
+        {
+        public:
+            BoundSet(const CVar& in_cvar, T in_value) : m_cvar(in_cvar), m_value(in_value) {}
+
+            EExecuteError execute(RAOE::Engine&) const override
+            {
+                m_cvar.set(m_value);
+                return EExecuteError::Success;
+            }
+        private:
+            const CVar& m_cvar;
+            T m_value;
+        };
+
+        const T m_default_value;
+
+        //Console elements are only ever executed through const pointers, so the value itself is mutable
+        mutable std::atomic<T> m_value;
+
+        //Only touched by flush_cvar_changes
+        mutable T m_notified_value;
+        change_callback m_on_changed;
+    };
+
+    template<cvar_value T>
+    class AutoRegisterCVar : public CVar<T>
+    {
+    public:
+        AutoRegisterCVar(
+            std::string_view in_name,
+            std::string_view in_description,
+            T in_default_value,
+            typename CVar<T>::change_callback in_on_changed = nullptr,
+            EConsoleFlags in_flags = EConsoleFlags::None
+        )
+            : CVar<T>(in_name, in_description, in_default_value, in_on_changed, in_flags)
+            , m_registration(*this)
+        {
+        }
+
+        [[nodiscard]] const CVar<T>& cvar() const { return *this; }
+
+    private:
+        AutoRegisterConsoleElement m_registration;
+    };
+
+    template<cvar_value T>
+    AutoRegisterCVar<T> CreateCVar(std::string_view name,
+        std::string_view description,
+        T default_value,
+        typename CVar<T>::change_callback on_changed = nullptr,
+        EConsoleFlags flags = EConsoleFlags::None
+    )
+    {
+        return AutoRegisterCVar<T>(name, description, default_value, on_changed, flags);
+    }
+
+    /***
+     * flush_cvar_changes
+     * Runs the change callbacks for every cvar set since the last flush.  The engine calls this once per frame
+    */
+    void flush_cvar_changes();
+
+    //Forgets a change queued for cvar without running its callback.  Unregistering a cvar does this, so a cvar from a
+    //library that's being unloaded isn't left on the queue
+    void discard_cvar_change(const ICVar& cvar);
+
+    //Where cvars are saved to and loaded from, in the working directory
+    [[nodiscard]] std::filesystem::path cvar_config_path();
+
+    /***
+     * load_cvars
+     * Reads "name value" lines from a config file and sets each cvar, in one pass.
+     * Blank lines and // or # comments are skipped, bad values are logged and skipped.  Entries for cvars that aren't
+     * registered are skipped quietly, since they're usually for a shared cog that hasn't been loaded yet.
+     * Returns false if the file couldn't be read
+    */
+    bool load_cvars(const std::filesystem::path& path, const CommandRegistry& registry = CommandRegistry::Get());
+
+    //Like load_cvars, but only sets the cvars the predicate returns true for.  A null predicate sets them all
+    bool load_cvars_if(const std::filesystem::path& path, const CommandRegistry& registry, bool(*predicate)(const ICVar&, void*), void* context);
+
+    /***
+     * load_cvars_if
+     * Applies the config to the cvars the predicate returns true for, such as the ones a shared cog registered as it loaded
+    */
+    template<typename Predicate>
+    bool load_cvars_if(const std::filesystem::path& path, Predicate&& predicate, const CommandRegistry& registry = CommandRegistry::Get())
+    {
+        return load_cvars_if(path, registry, +[](const ICVar& cvar, void* context) {
+            return (*static_cast<std::remove_reference_t<Predicate>*>(context))(cvar);
+        }, &predicate);
+    }
+
+    //Writes every cvar in the registry as a "name value" line that load_cvars can read
+    bool save_cvars(const std::filesystem::path& path, const CommandRegistry& registry = CommandRegistry::Get());
+}
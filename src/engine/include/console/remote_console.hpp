@@ -0,0 +1,122 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "core.hpp"
+#include "console/console.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RAOE
+{
+    class Engine;
+}
+
+namespace RAOE::Console
+{
+    class RemoteLogSink;
+
+    /***
+     * RemoteConsole
+     * Lets another process drive the console over a Unix domain socket, so scripts can run scenarios against a headless engine.
+     *
+     * The protocol is newline delimited text.  Each line a client sends is a console command, except for these:
+     *   :batch   starts collecting commands instead of running them
+     *   :end     runs every collected command back to back and reports how long each took
+     *   :quit    closes the connection
+     *
+     * Each line the engine sends starts with a word saying what it is:
+     *   ok <command>                                    a command ran
+     *   error <reason> <command>                        a command didn't run.  reason is one word, eg not_found or batch_full
+     *   time <index> <microseconds> <result> <command>  one per command in a batch.  result is ok or a reason
+     *   batch <count> <microseconds>                    ends a batch's report, with the time for the whole batch
+     *   log <line>                                      a log line, from any thread
+     *
+     * Logging is asynchronous, so a command's log lines can arrive after its ok.  Timings cover the part of a command
+     * that runs on the call; async commands carry on as tasks and log when they finish.
+     *
+     * Nothing blocks: poll() accepts, reads, runs commands and writes whatever it can, and is meant to be called once a frame
+     * from the main thread, which is the thread commands expect to run on.  Only implemented where Unix sockets are (not _WIN32)
+    */
+    class RemoteConsole
+    {
+    public:
+        //Output queued for a client that isn't reading is capped, past which log lines are dropped.  Replies never are
+        static constexpr size_t MaxPendingOutput = 4 * 1024 * 1024;
+        //A client that sends a line longer than this is disconnected
+        static constexpr size_t MaxLineLength = 64 * 1024;
+        //Commands past this many in one batch aren't collected, each gets an error batch_full instead
+        static constexpr size_t MaxBatchCommands = 4096;
+
+        explicit RemoteConsole(RAOE::Engine& in_engine);
+        ~RemoteConsole();
+
+        RemoteConsole(const RemoteConsole&) = delete;
+        RemoteConsole& operator=(const RemoteConsole&) = delete;
+
+        //Starts accepting connections on a socket at path, replacing any stale socket there.  Returns false and logs why if it can't
+        bool listen(const std::filesystem::path& path);
+
+        //Takes ownership of an already connected socket and serves it like an accepted client
+        void adopt_client(int socket);
+
+        //Does everything that can be done without blocking.  Call once a frame
+        void poll();
+
+        [[nodiscard]] bool listening() const { return m_listen_socket >= 0; }
+        [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
+        [[nodiscard]] size_t client_count() const { return m_clients.size(); }
+
+    private:
+        struct Client
+        {
+            int socket = -1;
+            std::string input = {};
+            std::string output = {};
+            std::optional<std::vector<std::string>> batch = std::nullopt; //set while collecting a batch
+            bool closing = false; //closes once its output is written
+        };
+
+        void accept_clients();
+        void read_client(Client& client);
+        //Runs the complete lines in the client's input and drops them from it.  Returns false if what's left is too long a line
+        bool handle_lines(Client& client);
+        void handle_line(Client& client, std::string_view line);
+        void run_batch(Client& client);
+        void write_client(Client& client);
+        void broadcast_log_lines();
+        void close();
+
+        RAOE::Engine& m_engine;
+        std::shared_ptr<RemoteLogSink> m_log_sink;
+        std::vector<Client> m_clients;
+        std::filesystem::path m_path;
+        int m_listen_socket = -1;
+    };
+
+    /***
+     * remote_console_path
+     * Where the RemoteConsole gear listens: the RAOE_REMOTE_CONSOLE environment variable, or nothing if it's unset,
+     * so an engine only opens a socket when whatever launched it asked for one
+    */
+    [[nodiscard]] std::optional<std::filesystem::path> remote_console_path();
+}
@@ -0,0 +1,119 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "core.hpp"
+#include "console/console.hpp"
+#include "resource/iresource.hpp"
+#include "resource/loader.hpp"
+#include "lazy.hpp"
+
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RAOE::Resource
+{
+    class Tag;
+}
+
+namespace RAOE::Console
+{
+    namespace Tags
+    {
+        extern const RAOE::Resource::Tag ScriptLoader;
+        extern const RAOE::Resource::Tag Script;
+    }
+
+    /***
+     * Script
+     * A console script (a .cfg file): one command per line, with // or # comments.
+     * `wait [frames]` pauses the script for a number of frames (default 1).
+     *
+     * The first time it runs, the script is compiled into a list of instructions that already point at their console
+     * element and at their arguments in the source, so running it again skips command lookup and line splitting.
+     * If new commands are registered after that, it's recompiled on the next run.
+    */
+    class Script : public RAOE::Resource::IResource
+    {
+    public:
+        struct Instruction
+        {
+            enum class EOp : uint8
+            {
+                Execute, //run element with the arguments
+                Wait,    //yield for the number of frames in the arguments
+                Unknown, //the command wasn't registered when this was compiled.  The arguments hold the command name
+            };
+
+            EOp op = EOp::Unknown;
+            IConsoleElement* element = nullptr;
+            const IConsoleElement::IBoundCall* call = nullptr; //the arguments, already parsed for element
+            uint32 arguments_offset = 0; //where the arguments are in the source
+            uint32 arguments_length = 0;
+            uint32 line = 0;             //1 based, for error messages
+        };
+        using Program = std::vector<Instruction>;
+
+        explicit Script(std::string in_source)
+            : m_source(std::move(in_source))
+        {
+        }
+
+        [[nodiscard]] ELoadStatus loadstatus() const override { return ELoadStatus::Loaded; }
+
+        [[nodiscard]] std::string_view source() const { return m_source; }
+        [[nodiscard]] std::string_view arguments(const Instruction& instruction) const 
+        { 
+            return source().substr(instruction.arguments_offset, instruction.arguments_length); 
+        }
+
+        //The compiled form of the script, good until registry.generation() changes
+        [[nodiscard]] std::shared_ptr<const Program> compiled(const CommandRegistry& registry = CommandRegistry::Get()) const;
+
+    private:
+        std::string m_source;
+        mutable std::shared_ptr<const Program> m_program;
+        mutable uint64 m_compiled_generation = 0;
+    };
+
+    class ScriptLoader : public RAOE::Resource::ILoader
+    {
+    public:
+        ScriptLoader()
+            : ILoader(Tags::ScriptLoader)
+        {
+            m_extensions = {".cfg"};
+        }
+        
+    protected:        
+        std::shared_ptr<RAOE::Resource::IResource> load_resource_internal(const std::istream& data_stream) override;
+    };
+
+    //How long a script may run each frame before it yields to the next one
+    constexpr std::chrono::microseconds DefaultScriptFrameBudget { 1000 };
+
+    /***
+     * run_script
+     * Runs every instruction in the script, spreading the work over as many frames as it takes to stay within frame_budget
+    */
+    raoe::lazy<> run_script(RAOE::Engine& engine, std::shared_ptr<const Script> script, std::chrono::microseconds frame_budget = DefaultScriptFrameBudget);
+}
@@ -22,6 +22,8 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "services/iservice.hpp"
 #include "container/subclass_map.hpp"
 #include "engine_fwd.hpp"
+#include "startup_trace.hpp"
+#include "typeinfo/typename.hpp"
 
 int main(int, char**);
 
@@ -61,6 +63,7 @@ namespace RAOE
         template<is_service T>
         std::weak_ptr<T> init_service()
         {
+            RAOE_STARTUP_TRACE_SCOPE("engine", raoe::core::name_of<T>());
             return services.insert<T>(*this);
         }
 
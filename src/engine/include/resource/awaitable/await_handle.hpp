@@ -16,6 +16,7 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #pragma once
 
 #include "resource/handle.hpp"
+#include "services/task_service.hpp"
 #include <coroutine>
 
 namespace RAOE::Resource
@@ -35,7 +36,12 @@ namespace RAOE::Resource
 
                 bool await_suspend(std::coroutine_handle<> awaiting_coro) noexcept
                 {
-                    return !m_handle->loaded();
+                    if(m_handle->loaded())
+                    {
+                        return false;
+                    }
+                    RAOE::task_waiting_on("resource load");
+                    return true;
                 }
 
                 void await_resume() noexcept {}
@@ -22,6 +22,8 @@ namespace RAOE::Resource
 {
     class Handle;
 
+    inline constinit const raoe::log::category LogResource {"resource"};
+
     class IResource
     {
     public:
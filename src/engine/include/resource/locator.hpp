@@ -21,6 +21,7 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "resource/handle.hpp"
 #include <filesystem>
 #include <string_view>
+#include <vector>
 
 namespace RAOE::Resource
 {
@@ -74,6 +75,9 @@ namespace RAOE::Resource
                 return;
             }
 
+            //The file types don't change while the directory is searched, so they're only looked up once
+            const std::vector<std::shared_ptr<Handle>> type_handles = handle->service()->handles_of_type(RAOE::Resource::TypeTags::Type);
+
             //search up all the files at the unresolved path's directory
             for(auto file : std::filesystem::directory_iterator(actual_path))
             {
@@ -88,22 +92,16 @@ namespace RAOE::Resource
                 auto extension = file.path().extension();
 
                 //Find the file type that matches this extension
-                for(const auto& [tag, weak_type_handle] : handle->service()->handle_map())
+                for(const std::shared_ptr<Handle>& type_handle : type_handles)
                 {
-                    if(auto type_handle = weak_type_handle.lock())
+                    for(const auto& weak_loader : type_handle->template get_ref<RAOE::Resource::Type>().loaders())
                     {
-                        if(type_handle->resource_type() == RAOE::Resource::TypeTags::Type)
+                        if(std::shared_ptr<RAOE::Resource::ILoader> loader = weak_loader.lock())
                         {
-                            for(const auto& weak_loader : type_handle->get_ref<RAOE::Resource::Type>().loaders())
+                            if(loader->loads_extension(extension.string()))
                             {
-                                if(std::shared_ptr<RAOE::Resource::ILoader> loader = weak_loader.lock())
-                                {
-                                    if(loader->loads_extension(extension.string()))
-                                    {
-                                        //build and return the resolved info
-                                        *(++out_itr) = ResolvedResource { file.path(), type_handle->tag(), loader };
-                                    }
-                                }
+                                //build and return the resolved info
+                                *(++out_itr) = ResolvedResource { file.path(), type_handle->tag(), loader };
                             }
                         }
                     }
@@ -21,9 +21,10 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "resource/tag.hpp"
 #include "resource/iresource.hpp"
 #include "resource/loader.hpp"
+#include "container/sharded_map.hpp"
 
-#include <unordered_map>
 #include <memory>
+#include <vector>
 
 namespace RAOE::Resource
 {
@@ -39,6 +40,12 @@ namespace RAOE::Resource
         extern const Tag Loader;
     }
 
+    /***
+     * Service
+     * Every resource's handle, by tag.  Lookups and inserts are safe from any thread: the tables are sharded maps
+     * (see raoe::container::sharded_map), so readers of different tags don't contend, and a loader thread adding a handle
+     * only holds up readers of the same shard.  What's in a handle is still only written from the main thread
+    */
     class Service : public RAOE::Service::IService
     {
     public:
@@ -75,7 +82,9 @@ namespace RAOE::Resource
             return std::static_pointer_cast<ILoader>(loader_asset);
         }
 
-        [[nodiscard]] const std::unordered_map<Tag, std::weak_ptr<Handle>>& handle_map() const { return m_handle_map; }
+        //Every live handle, or just those of one resource type.  A snapshot: handles created after it was taken aren't in it
+        [[nodiscard]] std::vector<std::shared_ptr<Handle>> handles() const;
+        [[nodiscard]] std::vector<std::shared_ptr<Handle>> handles_of_type(const Tag& resource_type) const;
     
     private:
         std::shared_ptr<Handle> find_or_create_handle(const Tag& tag);
@@ -84,8 +93,8 @@ namespace RAOE::Resource
         void manage_resource(const Tag& tag, const std::shared_ptr<IResource>& resource, const Tag& resource_type);
         void post_load_resource(const Tag& tag, const std::shared_ptr<IResource>& resource);
 
-        std::unordered_map<Tag, std::weak_ptr<Handle>> m_handle_map;
-        std::unordered_map<Tag, std::shared_ptr<Handle>> m_pinned_resources;
-        std::unordered_map<Tag, std::shared_ptr<IResource>> m_owned_resources;
+        raoe::container::sharded_map<Tag, std::weak_ptr<Handle>> m_handle_map;
+        raoe::container::sharded_map<Tag, std::shared_ptr<Handle>> m_pinned_resources;
+        raoe::container::sharded_map<Tag, std::shared_ptr<IResource>> m_owned_resources;
     };
 }
\ No newline at end of file
@@ -19,10 +19,89 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "core_minimal.hpp"
 #include "services/iservice.hpp"
 #include "lazy.hpp"
+#include "memory_tracking.hpp"
+#include "container/mpsc_queue.hpp"
+#include <array>
+#include <coroutine>
+#include <functional>
+#include <list>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
 
 namespace RAOE
 {
-    void enqueue_task(RAOE::Engine& engine, raoe::lazy<>&& task);
+    //How urgent a task is.  Within a phase, every Critical task runs, then every Frame task, then Background tasks until the budget runs out
+    enum class ETaskPriority : uint8
+    {
+        Critical, //has to run this frame, ahead of everything else in its phase
+        Frame, //has to run this frame
+        Background, //can wait.  Shares task_background_budget_ms a frame with every other background task
+    };
+
+    //When in the frame a task runs.  Phases run in order, once a frame
+    enum class ETaskPhase : uint8
+    {
+        PreECS, //input, commands, and anything the ECS should see this frame
+        ECS, //the ECS worlds progressing
+        PostECS, //anything that needs what the ECS did this frame
+    };
+
+    [[nodiscard]] std::string_view task_priority_name(ETaskPriority priority);
+    [[nodiscard]] std::string_view task_phase_name(ETaskPhase phase);
+
+    struct task_options
+    {
+        ETaskPriority priority = ETaskPriority::Frame;
+        ETaskPhase phase = ETaskPhase::PreECS;
+        const char* name = nullptr; //shown by the tasks command and panel.  Has to outlive the task, so it's meant for string literals
+    };
+
+    /***
+     * task_stats
+     * What TaskService measured of a task, so a slow frame can be traced to the task that took it.
+     * Times are in profiler ticks (see raoe::profile::ns_per_tick).  Reading the clock twice a resume would cost more than
+     * many resumes do, so only the first resume and every StatsSampleInterval-th after it are timed.  total_ticks is the
+     * timed ticks scaled up to every resume, filled in by collect_task_stats, and max_ticks is the slowest timed resume.
+     * Recorded while the task_stats cvar is on.  name, location and waiting_on point into the binary that set them, so
+     * TaskService::forget_stats_if has to clear them before that binary is unloaded
+    */
+    struct task_stats
+    {
+        static constexpr uint64 StatsSampleInterval = 16;
+
+        const char* name = nullptr;
+        std::source_location location; //where it was added
+        ETaskPriority priority = ETaskPriority::Frame;
+        ETaskPhase phase = ETaskPhase::PreECS;
+        uint64 resumes = 0;
+        uint64 total_ticks = 0;
+        uint64 max_ticks = 0;
+        uint64 timed_resumes = 0;
+        uint64 timed_ticks = 0;
+        const char* waiting_on = nullptr; //what it said it was waiting on when it last suspended.  See task_waiting_on
+        bool finished = false;
+
+        //The name, or where it was added if it has none
+        [[nodiscard]] std::string label() const;
+    };
+
+    /***
+     * task_waiting_on
+     * Tells the tasks command and panel what the running task is about to wait on, eg "resource load".  Call it right before a
+     * co_await that suspends.  It's forgotten on the next resume.  Does nothing outside a task TaskService is resuming.
+     * reason has to outlive the task, so it's meant for string literals
+    */
+    void task_waiting_on(const char* reason) noexcept;
+
+    //Adds a task to run each frame on the main thread.  Safe from any thread: from anywhere else, it's added at the start of the next frame
+    void enqueue_task(RAOE::Engine& engine, raoe::lazy<>&& task, task_options options = {}, std::source_location location = std::source_location::current());
+
+    //Runs func on the main thread, at the start of the next frame.  Safe from any thread
+    void post_to_main(RAOE::Engine& engine, std::function<void()> func);
 }
 
 namespace RAOE::Service
@@ -34,36 +113,200 @@ namespace RAOE::Service
     public:
         friend class RAOE::Service::TaskService;
 
-        void startup_task(raoe::lazy<>&& task) { m_startup_tasks.emplace_back(std::move(task)); }
-        void shutdown_task(raoe::lazy<>&& task) { m_shutdown_tasks.emplace_back(std::move(task)); }
+        struct provided_task
+        {
+            raoe::lazy<> task;
+            const char* name;
+            std::source_location location;
+        };
+
+        void startup_task(raoe::lazy<>&& task, const char* name = nullptr, std::source_location location = std::source_location::current())
+        {
+            m_startup_tasks.emplace_back(provided_task { std::move(task), name, location });
+        }
+        void shutdown_task(raoe::lazy<>&& task, const char* name = nullptr, std::source_location location = std::source_location::current())
+        {
+            m_shutdown_tasks.emplace_back(provided_task { std::move(task), name, location });
+        }
     private:
-        std::list<raoe::lazy<>> m_startup_tasks;
-        std::list<raoe::lazy<>> m_shutdown_tasks;    
+        std::list<provided_task> m_startup_tasks;
+        std::list<provided_task> m_shutdown_tasks;    
     };
 
     class TaskService : public IService
     {
     public:
+        //How much work other threads can post between frames before they have to wait for the main thread to catch up
+        static constexpr size_t PostedWorkCapacity = 1024;
+
+        //Built on the main thread, which is the thread everything posted runs on
         TaskService(Engine& in_engine)
             : IService(in_engine)
+            , m_main_thread(std::this_thread::get_id())
         {            
         }
 
+        /***
+         * process_tasks
+         * Runs whatever was posted since the last call, then resumes the tasks phase by phase: in each, the Critical tasks,
+         * then the Frame tasks, then Background tasks until the frame's background budget is spent.  Background tasks that
+         * didn't get a turn go first next frame, so a long one can't starve the rest, and one always gets a turn even once
+         * the budget is gone.  Main thread only
+        */
         void process_tasks();
-        void add_task(raoe::lazy<>&& task);
+        //Main thread only.  Use post_to_main from anywhere else
+        void add_task(raoe::lazy<>&& task, RAOE::task_options options = {}, std::source_location location = std::source_location::current());
+
+        /***
+         * post_to_main
+         * Hands work to the main thread, to run at the start of the next process_tasks.  Safe from any thread.
+         * Other threads push it onto a lock-free queue, and if it's full (the main thread is PostedWorkCapacity items behind)
+         * wait for room.  Work posted from the main thread skips the queue.
+         * A task is added like add_task would, and a coroutine handle is resumed.  Each runs under the memory tag that was
+         * active where it was posted.  A coroutine handle is borrowed, not owned: whatever owns the frame has to outlive the
+         * resume, or the handle has to be discarded first
+        */
+        void post_to_main(std::function<void()> func);
+        void post_to_main(raoe::lazy<>&& task, RAOE::task_options options = {}, std::source_location location = std::source_location::current());
+        void post_to_main(std::coroutine_handle<> continuation);
+
+        [[nodiscard]] bool on_main_thread() const { return std::this_thread::get_id() == m_main_thread; }
         
-        void enqueue_startup_tasks(task_provider& provider)
-        {
-            append_tasks(provider.m_startup_tasks);
-        }
+        //trace_name names the tasks in the startup trace, while it's recording.  Each is timed from its first resume to its end
+        void enqueue_startup_tasks(task_provider& provider, std::string_view trace_name = "startup task");
 
         void enqueue_shutdown_tasks(task_provider& provider)
         {
             append_tasks(provider.m_shutdown_tasks);
         }    
 
-        void append_tasks(std::list<raoe::lazy<>>& in_list);
+        void append_tasks(std::list<task_provider::provided_task>& in_list);
+
+        /***
+         * discard_tasks
+         * Destroys every pending task, and everything posted to the main thread, without running it.  A posted coroutine handle
+         * is only dropped, not destroyed: it's the continuation of a coroutine something else owns (the lazy it was started
+         * from), which stays suspended and is freed when that owner is destroyed
+        */
+        void discard_tasks();
+
+        //Destroys the pending tasks the predicate returns true for.  Returns how many there were
+        template<std::predicate<const raoe::lazy<>&> Predicate>
+        size_t discard_tasks_if(Predicate&& predicate)
+        {
+            size_t discarded = 0;
+            for(std::list<scheduled_task>& task_list : m_task_lists)
+            {
+                discarded += task_list.remove_if([&predicate](const scheduled_task& scheduled) { return predicate(scheduled.task); });
+            }
+            return discarded;
+        }
+
+        /***
+         * forget_stats_if
+         * Clears every task stat's name, location and wait reason that the predicate returns true for the address of, and
+         * forgets the finished tasks that were named or added there.  How a library's string literals stop being shown
+         * before it's unloaded
+        */
+        template<std::predicate<const void*> Predicate>
+        void forget_stats_if(Predicate&& predicate)
+        {
+            auto forget = [&predicate](RAOE::task_stats& stats) {
+                if(stats.name != nullptr && predicate(stats.name))
+                {
+                    stats.name = nullptr;
+                }
+                if(stats.waiting_on != nullptr && predicate(stats.waiting_on))
+                {
+                    stats.waiting_on = nullptr;
+                }
+                if(predicate(stats.location.file_name()))
+                {
+                    stats.location = {};
+                }
+            };
+            for(std::list<scheduled_task>& task_list : m_task_lists)
+            {
+                for(scheduled_task& scheduled : task_list)
+                {
+                    forget(scheduled.stats);
+                }
+            }
+
+            std::vector<RAOE::task_stats> kept;
+            kept.reserve(m_finished_stats.size());
+            for(size_t i = 0; i < m_finished_stats.size(); i++)
+            {
+                const RAOE::task_stats& finished = m_finished_stats[(m_next_finished + i) % m_finished_stats.size()];
+                if((finished.name == nullptr || !predicate(finished.name)) && !predicate(finished.location.file_name()))
+                {
+                    kept.push_back(finished);
+                }
+            }
+            m_finished_stats = std::move(kept);
+            m_next_finished = m_finished_stats.size() % FinishedStatsCapacity;
+        }
+
+        //How many tasks are waiting to be resumed
+        [[nodiscard]] size_t task_count() const;
+
+        //How many finished tasks collect_task_stats remembers
+        static constexpr size_t FinishedStatsCapacity = 64;
+        //The stats of every pending task, then of the last FinishedStatsCapacity tasks to finish
+        [[nodiscard]] std::vector<RAOE::task_stats> collect_task_stats() const;
     private:
-        std::list<raoe::lazy<>> m_task_list;
+        struct scheduled_task
+        {
+            raoe::lazy<> task;
+            raoe::memory::tag_id memory_tag; //the tag that was active when the task was added, restored whenever it runs
+            RAOE::task_stats stats;
+        };
+
+        static constexpr size_t PhaseCount = 3;
+        static constexpr size_t PriorityCount = 3;
+        static size_t list_index(RAOE::task_options options) { return static_cast<size_t>(options.phase) * PriorityCount + static_cast<size_t>(options.priority); }
+
+        void run_tasks(std::list<scheduled_task>& task_list, bool record_stats);
+        //Adds the ticks the tasks took to spent_ticks, and stops once that reaches budget_ticks
+        void run_background_tasks(std::list<scheduled_task>& task_list, uint64 budget_ticks, uint64& spent_ticks, bool record_stats);
+        static void resume_task(scheduled_task& scheduled, bool record_stats);
+        void remove_finished_tasks(std::list<scheduled_task>& task_list, bool record_stats);
+
+        std::array<std::list<scheduled_task>, PhaseCount * PriorityCount> m_task_lists; //by phase, then priority
+        std::vector<RAOE::task_stats> m_finished_stats; //a ring, oldest at m_next_finished once it's full
+        size_t m_next_finished = 0;
+
+        struct posted_work
+        {
+            std::variant<std::function<void()>, raoe::lazy<>, std::coroutine_handle<>> work;
+            raoe::memory::tag_id memory_tag;
+            RAOE::task_options options; //for a task
+            std::source_location location; //for a task
+        };
+        void post(posted_work&& posted);
+        void run_posted_work();
+
+        raoe::container::mpsc_queue<posted_work, PostedWorkCapacity> m_posted_work;
+        std::vector<posted_work> m_main_posted_work; //posted from the main thread
+        std::vector<posted_work> m_running_posted_work; //what m_main_posted_work had when run_posted_work started
+        std::thread::id m_main_thread;
+    };
+}
+
+namespace RAOE
+{
+    /***
+     * on_main_thread
+     * co_await it to carry on on the main thread.  On the main thread already, it doesn't suspend.  Otherwise the coroutine is
+     * posted to the main thread and resumed at the start of the next frame.  With no task service, it carries on where it is
+    */
+    struct main_thread_awaiter
+    {
+        RAOE::Service::TaskService* task_service;
+
+        [[nodiscard]] bool await_ready() const noexcept { return task_service == nullptr || task_service->on_main_thread(); }
+        void await_suspend(std::coroutine_handle<> continuation) const { task_service->post_to_main(continuation); }
+        void await_resume() const noexcept {}
     };
+    [[nodiscard]] main_thread_awaiter on_main_thread(RAOE::Engine& engine);
 }
\ No newline at end of file
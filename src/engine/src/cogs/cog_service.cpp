@@ -15,30 +15,802 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 */
 
 #include "cogs/cog_service.hpp"
+#include "cogs/gear_service.hpp"
 #include "engine.hpp"
 #include "resource/service.hpp"
+#include "services/task_service.hpp"
+#include "console/command.hpp"
+#include "console/cvar.hpp"
+#include "profile.hpp"
+#include "startup_trace.hpp"
+#include "string.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+#endif
+
+namespace RAOE::Cogs
+{
+    std::string_view status_name(ECogStatus status)
+    {
+        switch(status)
+        {
+            case ECogStatus::Created: return "Created";
+            case ECogStatus::PreActivate: return "PreActivate";
+            case ECogStatus::Activated: return "Activated";
+            case ECogStatus::PreShutdown: return "PreShutdown";
+            case ECogStatus::Shutdown: return "Shutdown";
+        }
+        return "Unknown";
+    }
+
+    std::vector<CogManifestEntry> parse_cog_manifest(std::string_view text, const std::filesystem::path& directory)
+    {
+        std::vector<CogManifestEntry> entries;
+        for(const std::string_view line : raoe::string::split(text, '\n'))
+        {
+            auto words = raoe::string::tokenize(line);
+            auto word = words.begin();
+            if(word == words.end() || (*word).starts_with('#'))
+            {
+                continue;
+            }
+
+            CogManifestEntry& entry = entries.emplace_back();
+            entry.name = *word;
+            if(++word == words.end())
+            {
+                RAOE_LOG_WARN(LogCogs, "Cog manifest entry for {} doesn't name a library", entry.name);
+                entries.pop_back();
+                continue;
+            }
+            entry.library = directory / std::filesystem::path(*word);
+            for(++word; word != words.end(); ++word)
+            {
+                entry.dependencies.emplace_back(*word);
+            }
+        }
+        return entries;
+    }
+
+    namespace
+    {
+        //The directory the running executable is in, or the working directory if that can't be found
+        std::filesystem::path executable_directory()
+        {
+#if defined(_WIN32)
+            std::wstring path(MAX_PATH, L'\0');
+            DWORD length = 0;
+            while((length = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()))) == path.size())
+            {
+                path.resize(path.size() * 2);
+            }
+            if(length == 0)
+            {
+                return std::filesystem::current_path();
+            }
+            path.resize(length);
+            return std::filesystem::path(path).parent_path();
+#elif defined(__APPLE__)
+            uint32_t size = 0;
+            _NSGetExecutablePath(nullptr, &size);
+            std::string path(size, '\0');
+            std::error_code error;
+            const std::filesystem::path resolved = _NSGetExecutablePath(path.data(), &size) == 0 ? std::filesystem::canonical(path.c_str(), error) : std::filesystem::path();
+            return resolved.empty() || error ? std::filesystem::current_path() : resolved.parent_path();
+#else
+            std::error_code error;
+            const std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+            return error ? std::filesystem::current_path() : path.parent_path();
+#endif
+        }
+    }
+
+    std::filesystem::path cog_manifest_path()
+    {
+        //raoe_link_shared_cogs_to_target puts the cogs next to the executable, wherever it's run from
+        return executable_directory() / "cogs" / "cogs.manifest";
+    }
+}
 
 namespace RAOE::Service
 {
+    static const RAOE::Console::AutoRegisterCVar<bool> cvar_cog_hot_reload = RAOE::Console::CreateCVar<bool>(
+        "cog_hot_reload",
+        "Reload shared cogs when their library changes on disk",
+        true
+    );
+
+    namespace
+    {
+        using register_cog_func = void(*)(RAOE::Engine&);
+
+        //GCC and Clang start a coroutine frame with pointers to its resume and destroy functions, which are in whatever library the
+        //coroutine was compiled into.  Destroy is still set once the coroutine is done.  Nothing promises that layout, so any other
+        //compiler has to be checked before unloading a library can tell which tasks use it
+#if defined(__GNUC__) || defined(__clang__)
+        const void* coroutine_code(std::coroutine_handle<> frame)
+        {
+            static_assert(sizeof(std::coroutine_handle<>) == sizeof(void*), "a coroutine handle is expected to be just the frame's address");
+            return static_cast<void* const*>(frame.address())[1];
+        }
+#else
+#error "coroutine_code only knows the GCC and Clang coroutine frame layout"
+#endif
+
+        //Where a reloaded library's copy goes.  One directory per process, so two running copies of the engine don't load each other's
+        std::filesystem::path reload_directory(std::error_code& error)
+        {
+#if defined(_WIN32)
+            const unsigned long process_id = GetCurrentProcessId();
+#else
+            const long process_id = getpid();
+#endif
+            return std::filesystem::temp_directory_path(error) / "raoe-cogs" / std::to_string(process_id);
+        }
+
+#if defined(_WIN32)
+        void* open_library(const std::filesystem::path& path) { return LoadLibraryW(path.c_str()); }
+        void close_library(void* library) { FreeLibrary(static_cast<HMODULE>(library)); }
+        std::string library_error() { return "error " + std::to_string(GetLastError()); }
+
+        register_cog_func find_register_func(void* library, const std::string& name)
+        {
+            return reinterpret_cast<register_cog_func>(GetProcAddress(static_cast<HMODULE>(library), name.c_str())); //NOLINT function pointers from a library are untyped
+        }
+
+        const void* library_base_of(const void* address)
+        {
+            HMODULE module = nullptr;
+            GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCWSTR>(address), &module);
+            return module;
+        }
+#else
+        void* open_library(const std::filesystem::path& path) { return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL); }
+        void close_library(void* library) { dlclose(library); }
+        std::string library_error()
+        {
+            const char* error = dlerror();
+            return error ? error : "unknown error";
+        }
+
+        register_cog_func find_register_func(void* library, const std::string& name)
+        {
+            return reinterpret_cast<register_cog_func>(dlsym(library, name.c_str())); //NOLINT function pointers from a library are untyped
+        }
+
+        const void* library_base_of(const void* address)
+        {
+            Dl_info info {};
+            return dladdr(address, &info) != 0 ? info.dli_fbase : nullptr;
+        }
+#endif
+    }
+
+    void CogService::transition_single_cog(BaseCog& cog, ECogStatus transition_to, const std::function<void(BaseCog&)>& transition_func)
+    {
+        {
+            const raoe::memory::scoped_tag memory_tag(cog.memory_tag());
+            transition_func(cog);
+        }
+        RAOE_LOG_INFO(RAOE::Cogs::LogCogs, "Transitioning Cog {} from {} to {}", cog.name(), cog.status(), transition_to);
+        cog.m_status = transition_to;
+    }
+
+    namespace
+    {
+        /***
+         * run_in_dependency_order
+         * Runs func for each cog, each only once the cogs before it that it depends on are done.  cogs must already be in dependency order.
+         * Worker threads pick up whatever is ready, and this thread helps, taking the main_thread_only cogs first.  If func throws,
+         * nothing else is started, and the first exception is rethrown here once the workers are done
+        */
+        void run_in_dependency_order(const std::vector<std::shared_ptr<RAOE::Cogs::BaseCog>>& cogs, const std::function<void(RAOE::Cogs::BaseCog&)>& func)
+        {
+            std::unordered_map<std::string_view, size_t> index_of;
+            for(size_t i = 0; i < cogs.size(); i++)
+            {
+                index_of.emplace(cogs[i]->name(), i);
+            }
+
+            //Only dependencies earlier in the order count, so a cycle can't leave anything waiting forever
+            std::vector<std::vector<size_t>> dependents(cogs.size());
+            std::vector<size_t> waiting_on(cogs.size(), 0);
+            for(size_t i = 0; i < cogs.size(); i++)
+            {
+                for(const std::string_view dependency : cogs[i]->dependencies())
+                {
+                    if(auto itr = index_of.find(dependency); itr != index_of.end() && itr->second < i)
+                    {
+                        dependents[itr->second].push_back(i);
+                        waiting_on[i]++;
+                    }
+                }
+            }
+
+            std::mutex mutex;
+            std::condition_variable ready_changed;
+            std::deque<size_t> ready;
+            std::deque<size_t> ready_main_thread;
+            size_t remaining = cogs.size();
+            std::exception_ptr failure;
+            auto make_ready = [&](size_t i) {
+                (cogs[i]->main_thread_only() ? ready_main_thread : ready).push_back(i);
+            };
+            for(size_t i = 0; i < cogs.size(); i++)
+            {
+                if(waiting_on[i] == 0)
+                {
+                    make_ready(i);
+                }
+            }
+
+            auto work = [&](bool main_thread) {
+                std::unique_lock lock(mutex);
+                while(true)
+                {
+                    ready_changed.wait(lock, [&]() { return remaining == 0 || failure || !ready.empty() || (main_thread && !ready_main_thread.empty()); });
+                    if(remaining == 0 || failure)
+                    {
+                        return;
+                    }
 
-    void CogService::transition_cogs(ECogStatus transition_to, std::function<void(BaseCog&)> transition_func)    
+                    std::deque<size_t>& queue = main_thread && !ready_main_thread.empty() ? ready_main_thread : ready;
+                    const size_t i = queue.front();
+                    queue.pop_front();
+
+                    lock.unlock();
+                    try
+                    {
+                        func(*cogs[i]);
+                    }
+                    catch(...)
+                    {
+                        //Escaping a worker would terminate, and the cogs that depend on this one can't run anyway
+                        lock.lock();
+                        if(!failure)
+                        {
+                            failure = std::current_exception();
+                        }
+                        ready_changed.notify_all();
+                        return;
+                    }
+                    lock.lock();
+
+                    remaining--;
+                    for(const size_t dependent : dependents[i])
+                    {
+                        if(--waiting_on[dependent] == 0)
+                        {
+                            make_ready(dependent);
+                        }
+                    }
+                    ready_changed.notify_all();
+                }
+            };
+
+            //This thread works too, so one fewer worker than there are cores
+            const size_t worker_count = std::min<size_t>(cogs.size() - 1, std::max(2u, std::thread::hardware_concurrency()) - 1);
+            std::vector<std::jthread> workers;
+            workers.reserve(worker_count);
+            for(size_t i = 0; i < worker_count; i++)
+            {
+                workers.emplace_back(work, false);
+            }
+            work(true);
+
+            workers.clear();
+            if(failure)
+            {
+                std::rethrow_exception(failure);
+            }
+        }
+    }
+
+    void CogService::transition_cogs(ECogStatus transition_to, std::function<void(BaseCog&)> transition_func, RAOE::Cogs::ETransitionThreading threading)    
     {   
+        RAOE_PROFILE_SCOPE("CogService::transition_cogs");
+        const raoe::startup_trace::scoped_span phase_span("cog", fmt::format("transition to {}", RAOE::Cogs::status_name(transition_to)));
+        m_status = transition_to;
+
+        std::vector<std::shared_ptr<BaseCog>> cogs = dependency_order();
+        std::erase_if(cogs, [transition_to](const std::shared_ptr<BaseCog>& cog) { return cog->status() >= transition_to; });
+        const bool going_down = transition_to >= ECogStatus::PreShutdown;
+        if(going_down)
+        {
+            std::ranges::reverse(cogs);
+        }
+
         //Run the transition funcs
-        for(const auto& [_, base_cog] : m_cogs)
+        auto run_transition = [&transition_func, transition_to](BaseCog& cog) {
+            RAOE_PROFILE_SCOPE(raoe::profile::intern(cog.name()));
+            const raoe::startup_trace::scoped_span span("cog", fmt::format("{} {}", cog.name(), RAOE::Cogs::status_name(transition_to)));
+            const raoe::memory::scoped_tag memory_tag(cog.memory_tag());
+            transition_func(cog);
+        };
+        if(threading == RAOE::Cogs::ETransitionThreading::Parallel && !going_down && cogs.size() > 1)
+        {
+            run_in_dependency_order(cogs, run_transition);
+            //Gears built on the workers get their resource handles here, on this thread
+            if(std::shared_ptr<GearService> gear_service = engine().get_service<GearService>().lock())
+            {
+                gear_service->register_gear_resources();
+            }
+        }
+        else
         {
-            if(base_cog && !base_cog->is_engine_cog() && base_cog->status() < transition_to)
+            for(const std::shared_ptr<BaseCog>& cog : cogs)
             {
-                 transition_func(*base_cog.get());
-            }           
+                run_transition(*cog);
+            }
         }
+
         //then set the value
+        for(const std::shared_ptr<BaseCog>& cog : cogs)
+        {
+            RAOE_LOG_INFO(RAOE::Cogs::LogCogs, "Transitioning Cog {} from {} to {}", cog->name(), cog->status(), transition_to);
+            cog->m_status = transition_to;
+        }
+    }
+
+    std::vector<std::shared_ptr<RAOE::Cogs::BaseCog>> CogService::dependency_order() const
+    {
+        std::unordered_map<std::string_view, std::shared_ptr<BaseCog>> by_name;
+        for(const auto& [_, base_cog] : m_cogs)
+        {
+            if(base_cog && !base_cog->is_engine_cog())
+            {
+                by_name.emplace(base_cog->name(), base_cog);
+            }
+        }
+
+        enum class EVisit : uint8 { Visiting, Done };
+        std::unordered_map<const BaseCog*, EVisit> visited;
+        std::vector<std::shared_ptr<BaseCog>> order;
+        order.reserve(by_name.size());
+
+        auto visit = [&](auto& self, const std::shared_ptr<BaseCog>& cog) -> void {
+            if(auto [itr, first_visit] = visited.try_emplace(cog.get(), EVisit::Visiting); !first_visit)
+            {
+                if(itr->second == EVisit::Visiting)
+                {
+                    RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Cog {} depends on itself, its dependencies may come up after it", cog->name());
+                }
+                return;
+            }
+
+            for(const std::string_view dependency : cog->dependencies())
+            {
+                if(auto itr = by_name.find(dependency); itr != by_name.end())
+                {
+                    self(self, itr->second);
+                }
+                else
+                {
+                    RAOE_LOG_WARN(RAOE::Cogs::LogCogs, "Cog {} depends on cog {}, which isn't registered", cog->name(), dependency);
+                }
+            }
+            visited[cog.get()] = EVisit::Done;
+            order.push_back(cog);
+        };
+
+        for(const auto& [_, cog] : by_name)
+        {
+            visit(visit, cog);
+        }
+        return order;
+    }
+
+    std::weak_ptr<RAOE::Cogs::BaseCog> CogService::find_cog(std::string_view name) const
+    {
         for(const auto& [_, base_cog] : m_cogs)
         {
-            if(base_cog && !base_cog->is_engine_cog() && base_cog->status() < transition_to)
+            if(base_cog && base_cog->name() == name)
+            {
+                return base_cog;
+            }
+        }
+        return {};
+    }
+
+    bool CogService::load_manifest(const std::filesystem::path& path)
+    {
+        std::ifstream file(path);
+        if(!file)
+        {
+            return false;
+        }
+        std::stringstream contents;
+        contents << file.rdbuf();
+
+        for(RAOE::Cogs::CogManifestEntry& entry : RAOE::Cogs::parse_cog_manifest(contents.str(), path.parent_path()))
+        {
+            add_manifest_entry(std::move(entry));
+        }
+        return true;
+    }
+
+    void CogService::add_manifest_entry(RAOE::Cogs::CogManifestEntry entry)
+    {
+        auto existing = std::ranges::find(m_manifest, entry.name, &RAOE::Cogs::CogManifestEntry::name);
+        if(existing != m_manifest.end())
+        {
+            *existing = std::move(entry);
+        }
+        else
+        {
+            m_manifest.push_back(std::move(entry));
+        }
+    }
+
+    bool CogService::is_shared_cog(std::string_view name) const
+    {
+        return std::ranges::find(m_libraries, name, &SharedCogLibrary::name) != m_libraries.end();
+    }
+
+    std::weak_ptr<RAOE::Cogs::BaseCog> CogService::require_cog(std::string_view name)
+    {
+        std::vector<std::string> requiring;
+        return require_cog(name, requiring);
+    }
+
+    std::weak_ptr<RAOE::Cogs::BaseCog> CogService::require_cog(std::string_view name, std::vector<std::string>& requiring)
+    {
+        if(std::shared_ptr<BaseCog> cog = find_cog(name).lock())
+        {
+            return cog;
+        }
+
+        auto entry = std::ranges::find(m_manifest, name, &RAOE::Cogs::CogManifestEntry::name);
+        if(entry == m_manifest.end())
+        {
+            RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to load cog {}: it isn't registered, and isn't in the cog manifest", name);
+            return {};
+        }
+        if(std::ranges::find(requiring, name) != requiring.end())
+        {
+            RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to load cog {}: it depends on itself through {}", name, fmt::join(requiring, " -> "));
+            return {};
+        }
+
+        //Copied, since loading a dependency could add to the manifest
+        const RAOE::Cogs::CogManifestEntry required = *entry;
+        requiring.push_back(required.name);
+        for(const std::string& dependency : required.dependencies)
+        {
+            if(require_cog(dependency, requiring).expired())
             {
-                spdlog::info("Transitioning Cog {} from {} to {}", base_cog->name(), base_cog->status(), transition_to);
-                base_cog->m_status = transition_to;                
-            }            
+                RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to load cog {}: its dependency {} couldn't be loaded", name, dependency);
+                requiring.pop_back();
+                return {};
+            }
+        }
+        requiring.pop_back();
+
+        return load_shared_cog(required);
+    }
+
+    std::weak_ptr<RAOE::Cogs::BaseCog> CogService::load_shared_cog(const RAOE::Cogs::CogManifestEntry& entry, const ReloadStates* reload_states, uint32 reload_count)
+    {
+        RAOE_PROFILE_SCOPE("CogService::load_shared_cog");
+        const auto start = std::chrono::steady_clock::now();
+
+        std::error_code error;
+        const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(entry.library, error);
+
+        std::filesystem::path load_path = entry.library;
+        if(reload_count > 0)
+        {
+            //A copy, so the build can overwrite the original while it's loaded, and the loader can't hand back the old library
+            //(which may not have been unmapped) just because the path is the same
+            load_path = reload_directory(error) / fmt::format("{}-{}{}", entry.library.stem().string(), reload_count, entry.library.extension().string());
+            std::filesystem::create_directories(load_path.parent_path(), error);
+            std::filesystem::copy_file(entry.library, load_path, std::filesystem::copy_options::overwrite_existing, error);
+            if(error)
+            {
+                RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to reload cog {}, couldn't copy {} to {}: {}", entry.name, entry.library.string(), load_path.string(), error.message());
+                return {};
+            }
+        }
+
+        void* library = open_library(load_path);
+        if(!library)
+        {
+            RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to load cog {} from {}: {}", entry.name, load_path.string(), library_error());
+            return {};
+        }
+
+        //The same function a static cog is registered through, see __GENERATED_REGISTER_COG
+        const std::string register_func_name = "__GENERATED__" + entry.name;
+        register_cog_func register_func = find_register_func(library, register_func_name);
+        if(!register_func)
+        {
+            RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to load cog {}: {} doesn't export {}", entry.name, entry.library.string(), register_func_name);
+            close_library(library);
+            return {};
+        }
+
+        m_libraries.push_back(SharedCogLibrary {
+            .name = entry.name,
+            .handle = library,
+            .base_address = library_base_of(reinterpret_cast<const void*>(register_func)), //NOLINT
+            .loaded_from = reload_count > 0 ? load_path : std::filesystem::path(),
+            .write_time = write_time,
+            .changed_write_time = std::nullopt,
+        });
+
+        //The cog's cvars registered themselves as the library loaded, long after the config was read at startup
+        RAOE::Console::load_cvars_if(RAOE::Console::cvar_config_path(), [base_address = m_libraries.back().base_address](const RAOE::Console::ICVar& cvar) {
+            return library_base_of(&cvar) == base_address;
+        });
+        register_func(engine());
+
+        std::shared_ptr<BaseCog> cog = find_cog(entry.name).lock();
+        if(!cog)
+        {
+            RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "{} didn't register a cog named {}", entry.library.string(), entry.name);
+            return {};
+        }
+
+        //Catch up with everything else
+        if(m_status >= ECogStatus::PreActivate && cog->status() < ECogStatus::PreActivate)
+        {
+            transition_single_cog(*cog, ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+        }
+        if(reload_states && !reload_states->empty())
+        {
+            if(std::shared_ptr<GearService> gear_service = engine().get_service<GearService>().lock())
+            {
+                //A gear that had state was in use before the reload, so it's built again now even if it's lazy
+                for(const auto& [tag, state] : *reload_states)
+                {
+                    const RAOE::Resource::Tag gear_tag(tag);
+                    if(gear_tag.prefix() != cog->tag().prefix())
+                    {
+                        continue;
+                    }
+                    if(std::shared_ptr<RAOE::Cogs::Gear> gear = gear_service->get_gear(gear_tag).lock())
+                    {
+                        gear->restore_reload_state(state);
+                    }
+                }
+            }
+        }
+        if(m_status >= ECogStatus::Activated && cog->status() < ECogStatus::Activated)
+        {
+            transition_single_cog(*cog, ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+        }
+
+        RAOE_LOG_INFO(RAOE::Cogs::LogCogs, "Loaded cog {} from {} in {:.2f}ms", entry.name, load_path.string(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return cog;
+    }
+
+    void CogService::unload_library(SharedCogLibrary library)
+    {
+        const void* base_address = library.base_address;
+        auto in_library = [base_address](const void* address) { return base_address && library_base_of(address) == base_address; };
+
+        //A task running code from the library can't outlive it
+        if(std::shared_ptr<TaskService> task_service = engine().get_service<TaskService>().lock())
+        {
+            task_service->discard_tasks_if([&in_library](const raoe::lazy<>& task) {
+                bool uses_library = false;
+                task.for_each_frame([&](std::coroutine_handle<> frame) { uses_library |= in_library(coroutine_code(frame)); });
+                return uses_library;
+            });
+            //Tasks that outlive it may still have been named by it, and the stats of finished ones point at its strings
+            task_service->forget_stats_if(in_library);
+        }
+
+        if(std::shared_ptr<BaseCog> cog = find_cog(library.name).lock())
+        {
+            if(cog->status() < ECogStatus::PreShutdown)
+            {
+                transition_single_cog(*cog, ECogStatus::PreShutdown, RAOE::TransitionFunc::ShutdownGears);
+            }
+            if(cog->status() < ECogStatus::Shutdown)
+            {
+                transition_single_cog(*cog, ECogStatus::Shutdown, RAOE::TransitionFunc::LockCogForShutdown);
+            }
+            if(std::shared_ptr<GearService> gear_service = engine().get_service<GearService>().lock())
+            {
+                gear_service->remove_gears(*cog);
+            }
+            m_cogs.erase_if([&cog](const std::shared_ptr<BaseCog>& stored) { return stored == cog; });
+        }
+
+        RAOE::Console::CommandRegistry::unregister_static_elements([&in_library](const RAOE::Console::IConsoleElement& element) {
+            return in_library(&element);
+        });
+
+        RAOE_LOG_INFO(RAOE::Cogs::LogCogs, "Unloading cog {}", library.name);
+        raoe::profile::discard_recorded(); //zones the cog recorded are named by its string literals
+        close_library(library.handle);
+        if(!library.loaded_from.empty())
+        {
+            std::error_code error;
+            std::filesystem::remove(library.loaded_from, error);
+            //Only goes once it's empty
+            std::filesystem::remove(library.loaded_from.parent_path(), error);
+        }
+        std::erase_if(m_libraries, [&library](const SharedCogLibrary& loaded) { return loaded.name == library.name; });
+    }
+
+    void CogService::unload_shared_cogs()
+    {
+        if(m_libraries.empty())
+        {
+            return;
+        }
+
+        //Nothing runs after this, so no task needs to survive it
+        if(std::shared_ptr<TaskService> task_service = engine().get_service<TaskService>().lock())
+        {
+            task_service->discard_tasks();
+        }
+
+        while(!m_libraries.empty())
+        {
+            unload_library(m_libraries.back());
+        }
+    }
+
+    bool CogService::reload_cog(std::string_view name)
+    {
+        RAOE_PROFILE_SCOPE("CogService::reload_cog");
+        const auto start = std::chrono::steady_clock::now();
+        if(!is_shared_cog(name))
+        {
+            RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Unable to reload cog {}, it isn't a loaded shared cog", name);
+            return false;
+        }
+
+        //The cog, then every loaded shared cog that needs it, in the order they were loaded
+        std::vector<std::string> reloading { std::string(name) };
+        for(const SharedCogLibrary& library : m_libraries)
+        {
+            auto entry = std::ranges::find(m_manifest, library.name, &RAOE::Cogs::CogManifestEntry::name);
+            if(entry != m_manifest.end() && std::ranges::find(reloading, library.name) == reloading.end()
+                && std::ranges::any_of(entry->dependencies, [&reloading](const std::string& dependency) { return std::ranges::find(reloading, dependency) != reloading.end(); }))
+            {
+                reloading.push_back(library.name);
+            }
+        }
+
+        //Take them down newest first, keeping whatever state the gears want to keep once they're deactivated, and the values of
+        //the cvars that were changed from their defaults
+        ReloadStates reload_states;
+        std::vector<std::pair<std::string, std::string>> cvar_values;
+        std::shared_ptr<GearService> gear_service = engine().get_service<GearService>().lock();
+        for(auto cog_name = reloading.rbegin(); cog_name != reloading.rend(); ++cog_name)
+        {
+            auto library = std::ranges::find(m_libraries, *cog_name, &SharedCogLibrary::name);
+            if(library == m_libraries.end())
+            {
+                continue;
+            }
+            if(std::shared_ptr<BaseCog> cog = find_cog(*cog_name).lock(); cog && gear_service)
+            {
+                if(cog->status() < ECogStatus::PreShutdown)
+                {
+                    transition_single_cog(*cog, ECogStatus::PreShutdown, RAOE::TransitionFunc::ShutdownGears);
+                }
+                for(const std::shared_ptr<RAOE::Cogs::Gear>& gear : gear_service->gears_of(*cog))
+                {
+                    if(std::optional<std::string> state = gear->save_reload_state())
+                    {
+                        reload_states.insert_or_assign(std::string(std::string_view(gear->tag())), std::move(*state));
+                    }
+                }
+            }
+            for(const RAOE::Console::IConsoleElement* element : RAOE::Console::CommandRegistry::Get().elements())
+            {
+                const auto* cvar = dynamic_cast<const RAOE::Console::ICVar*>(element);
+                if(cvar && library_base_of(cvar) == library->base_address && cvar->value_string() != cvar->default_string())
+                {
+                    cvar_values.emplace_back(cvar->name(), cvar->value_string());
+                }
+            }
+            unload_library(*library);
+        }
+
+        m_reload_count++;
+        bool reloaded = true;
+        for(const std::string& cog_name : reloading)
+        {
+            auto entry = std::ranges::find(m_manifest, cog_name, &RAOE::Cogs::CogManifestEntry::name);
+            if(entry == m_manifest.end() || load_shared_cog(RAOE::Cogs::CogManifestEntry(*entry), &reload_states, m_reload_count).expired())
+            {
+                RAOE_LOG_ERROR(RAOE::Cogs::LogCogs, "Cog {} was unloaded, but couldn't be loaded again", cog_name);
+                reloaded = false;
+            }
+        }
+
+        //Over whatever the config set, since they were changed after it was read
+        for(const auto& [cvar_name, value] : cvar_values)
+        {
+            if(const auto* cvar = dynamic_cast<const RAOE::Console::ICVar*>(RAOE::Console::CommandRegistry::Get().find(cvar_name)))
+            {
+                cvar->set_from_string(value);
+            }
+        }
+
+        RAOE_LOG_INFO(RAOE::Cogs::LogCogs, "Reloaded cog {} ({} cogs) in {:.2f}ms", name, reloading.size(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return reloaded;
+    }
+
+    void CogService::reload_changed_cogs()
+    {
+        if(m_libraries.empty() || !cvar_cog_hot_reload.get())
+        {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if(now < m_next_reload_poll)
+        {
+            return;
+        }
+        m_next_reload_poll = now + ReloadPollInterval;
+
+        auto current_write_time = [this](const SharedCogLibrary& library) -> std::optional<std::filesystem::file_time_type> {
+            auto entry = std::ranges::find(m_manifest, library.name, &RAOE::Cogs::CogManifestEntry::name);
+            std::error_code error;
+            const std::filesystem::file_time_type write_time = entry != m_manifest.end() ? std::filesystem::last_write_time(entry->library, error) : library.write_time;
+            return error ? std::nullopt : std::optional(write_time);
+        };
+
+        std::vector<std::string> changed;
+        for(SharedCogLibrary& library : m_libraries)
+        {
+            const std::optional<std::filesystem::file_time_type> write_time = current_write_time(library);
+            if(!write_time || *write_time == library.write_time)
+            {
+                library.changed_write_time.reset();
+            }
+            //Only once it's the same as the last poll, so a library the linker is still writing isn't loaded
+            else if(library.changed_write_time == write_time)
+            {
+                changed.push_back(library.name);
+            }
+            else
+            {
+                library.changed_write_time = write_time;
+            }
+        }
+
+        for(const std::string& name : changed)
+        {
+            //Reloading a cog also reloads the cogs that depend on it, which may have been on this list
+            auto library = std::ranges::find(m_libraries, name, &SharedCogLibrary::name);
+            if(library != m_libraries.end() && current_write_time(*library) != library->write_time)
+            {
+                reload_cog(name);
+            }
         }
     }
 
@@ -54,4 +826,66 @@ namespace RAOE::Service
         }
     }
 
-}
\ No newline at end of file
+}
+
+namespace RAOE::Cogs
+{
+    namespace
+    {
+        void print_cogs(RAOE::Engine& engine)
+        {
+            std::shared_ptr<RAOE::Service::CogService> cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+            if(!cog_service)
+            {
+                return;
+            }
+
+            spdlog::info("   | {:<20}|{:<8}|{:<12}|", "Cog", "Kind", "Status");
+            for(const auto& [_, cog] : cog_service->cogs())
+            {
+                if(cog && !cog->is_engine_cog())
+                {
+                    spdlog::info("   | {:<20}|{:<8}|{:<12}|", cog->name(), cog_service->is_shared_cog(cog->name()) ? "shared" : "static", status_name(cog->status()));
+                }
+            }
+            for(const CogManifestEntry& entry : cog_service->manifest())
+            {
+                if(cog_service->find_cog(entry.name).expired())
+                {
+                    spdlog::info("   | {:<20}|{:<8}|{:<12}|", entry.name, "shared", "not loaded");
+                }
+            }
+        }
+    }
+
+    using RAOE::Console::AutoRegisterConsoleCommand;
+    static const AutoRegisterConsoleCommand cogs_command = RAOE::Console::CreateConsoleCommand(
+        "cogs",
+        "Lists every cog, and the shared cogs in the manifest that aren't loaded",
+        print_cogs
+    );
+
+    static const AutoRegisterConsoleCommand cog_reload_command = RAOE::Console::CreateConsoleCommand(
+        "cog_reload",
+        "Reloads a shared cog from its library, and the shared cogs that depend on it.  eg: cog_reload Pong",
+        +[](RAOE::Engine& engine, std::string_view args) {
+            const std::string_view name = raoe::string::trim(args);
+            if(auto cog_service = engine.get_service<RAOE::Service::CogService>().lock(); cog_service && !name.empty())
+            {
+                cog_service->reload_cog(name);
+            }
+        }
+    );
+
+    static const AutoRegisterConsoleCommand cog_load_command = RAOE::Console::CreateConsoleCommand(
+        "cog_load",
+        "Loads a shared cog from the manifest, and the cogs it depends on.  eg: cog_load Pong",
+        +[](RAOE::Engine& engine, std::string_view args) {
+            const std::string_view name = raoe::string::trim(args);
+            if(auto cog_service = engine.get_service<RAOE::Service::CogService>().lock(); cog_service && !name.empty())
+            {
+                cog_service->require_cog(name);
+            }
+        }
+    );
+}
@@ -17,17 +17,249 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "cogs/gear_service.hpp"
 #include "resource/service.hpp"
+#include "services/task_service.hpp"
+
+#include <algorithm>
 
 namespace RAOE::Service
 {
 
     void GearService::internal_register_gear(const std::shared_ptr<RAOE::Cogs::Gear>& in_gear)    
     {   
+        m_cog_gears[&in_gear->cog()].push_back(in_gear);
+        m_unregistered_gears.push_back(in_gear);
+    }
+
+    void GearService::register_gear_resources()
+    {
+        std::shared_ptr<TaskService> task_service = engine().get_service<TaskService>().lock();
+        if(task_service && !task_service->on_main_thread())
+        {
+            task_service->post_to_main([&in_engine = engine()]() {
+                if(std::shared_ptr<GearService> gear_service = in_engine.get_service<GearService>().lock())
+                {
+                    gear_service->register_gear_resources();
+                }
+            });
+            return;
+        }
+
+        std::vector<std::weak_ptr<RAOE::Cogs::Gear>> gears;
+        {
+            const std::scoped_lock lock(m_mutex);
+            gears.swap(m_unregistered_gears);
+        }
         using ResourceService = RAOE::Resource::Service;
-        if(std::shared_ptr<ResourceService> resource_service = engine().get_service<ResourceService>().lock())
+        std::shared_ptr<ResourceService> resource_service = engine().get_service<ResourceService>().lock();
+        if(!resource_service)
+        {
+            return;
+        }
+        for(const std::weak_ptr<RAOE::Cogs::Gear>& weak_gear : gears)
+        {
+            //A gear removed before it got here doesn't need one
+            if(std::shared_ptr<RAOE::Cogs::Gear> gear = weak_gear.lock())
+            {
+                resource_service->emplace_resource(gear->tag(), gear, RAOE::Resource::TypeTags::Gear);
+            }
+        }
+    }
+
+    void GearService::missing_required_gear(std::string_view gear_name, std::string_view required_name)
+    {
+        spdlog::warn("Gear {} requires gear {}, but no cog registered one", gear_name, required_name);
+    }
+
+    void GearService::publish_snapshot()
+    {
+        auto snapshot = std::make_shared<GearSnapshot>();
+        snapshot->reserve(m_gears.size());
+        for(const auto& [type, gear] : m_gears)
+        {
+            snapshot->emplace(type.get(), gear);
+        }
+        m_snapshot.store(std::move(snapshot), std::memory_order_release);
+    }
+
+    std::shared_ptr<RAOE::Cogs::Gear> GearService::build_registered_gear(const std::type_info& type)
+    {
+        const std::scoped_lock build_lock(m_build_mutex);
+        std::function<std::shared_ptr<RAOE::Cogs::Gear>()> build;
+        const RAOE::Cogs::BaseCog* owning_cog = nullptr;
+        {
+            const std::scoped_lock lock(m_mutex);
+            //Someone else may have built it while we waited
+            if(std::shared_ptr<RAOE::Cogs::Gear> built = m_gears.find(type).lock())
+            {
+                return built;
+            }
+            auto itr = m_factories.find(type);
+            if(itr == m_factories.end())
+            {
+                return {};
+            }
+            //Copied, not taken: the factory stays until the gear is in m_gears, so get_gear never sees neither and gives up
+            build = itr->second.build;
+            owning_cog = itr->second.cog;
+        }
+
+        std::shared_ptr<RAOE::Cogs::Gear> gear = build();
+        bool cog_active = false;
         {
-            resource_service->emplace_resource(in_gear->tag(), in_gear, RAOE::Resource::TypeTags::Gear);
-        }    
+            const std::scoped_lock lock(m_mutex);
+            m_factories.erase(type);
+            if(!gear)
+            {
+                return {};
+            }
+            cog_active = m_active_cogs.contains(owning_cog);
+        }
+        if(cog_active)
+        {
+            //Activating queues the gear's startup tasks, which only the main thread can do
+            std::shared_ptr<TaskService> task_service = engine().get_service<TaskService>().lock();
+            if(task_service && !task_service->on_main_thread())
+            {
+                task_service->post_to_main([&in_engine = engine(), weak_gear = std::weak_ptr<RAOE::Cogs::Gear>(gear)]() {
+                    std::shared_ptr<GearService> gear_service = in_engine.get_service<GearService>().lock();
+                    std::shared_ptr<RAOE::Cogs::Gear> posted_gear = weak_gear.lock();
+                    if(!gear_service || !posted_gear)
+                    {
+                        return;
+                    }
+                    {
+                        //Its cog may have been deactivated since
+                        const std::scoped_lock lock(gear_service->m_mutex);
+                        if(!gear_service->m_active_cogs.contains(&posted_gear->cog()))
+                        {
+                            return;
+                        }
+                    }
+                    gear_service->activate_gear(*posted_gear);
+                });
+            }
+            else
+            {
+                activate_gear(*gear);
+            }
+        }
+        return gear;
+    }
+
+    std::weak_ptr<RAOE::Cogs::Gear> GearService::get_gear(const RAOE::Resource::Tag& tag)
+    {
+        if(const std::shared_ptr<const GearSnapshot> snapshot = m_snapshot.load(std::memory_order_acquire))
+        {
+            for(const auto& [type, gear] : *snapshot)
+            {
+                if(gear->tag() == tag)
+                {
+                    return gear;
+                }
+            }
+        }
+
+        const std::type_info* unbuilt = nullptr;
+        {
+            const std::scoped_lock lock(m_mutex);
+            for(const auto& [type, gear] : m_gears)
+            {
+                if(gear->tag() == tag)
+                {
+                    return gear;
+                }
+            }
+            auto factory = std::ranges::find_if(m_factories, [&tag](const auto& entry) { return entry.second.tag == tag; });
+            if(factory == m_factories.end())
+            {
+                return {};
+            }
+            unbuilt = factory->second.type;
+        }
+        return build_registered_gear(*unbuilt);
+    }
+
+    void GearService::activate_gear(RAOE::Cogs::Gear& gear)
+    {
+        if(gear.m_active)
+        {
+            return;
+        }
+        gear.m_active = true;
+
+        const raoe::memory::scoped_tag memory_tag(gear.memory_tag());
+        const std::string_view gear_name = gear.tag();
+        if(std::shared_ptr<TaskService> task_service = engine().get_service<TaskService>().lock())
+        {
+            task_service->enqueue_startup_tasks(gear, gear_name);
+        }
+        const raoe::startup_trace::scoped_span span("gear", std::string(gear_name) + " activated");
+        gear.activated();
+    }
+
+    void GearService::activate_gears(const RAOE::Cogs::BaseCog& owning_cog)
+    {
+        {
+            const std::scoped_lock lock(m_mutex);
+            m_active_cogs.insert(&owning_cog);
+        }
+
+        //By index, since activating a gear can build more of the cog's gears.  Those are activated as they're built
+        for(size_t i = 0; ; i++)
+        {
+            std::shared_ptr<RAOE::Cogs::Gear> gear;
+            {
+                const std::scoped_lock lock(m_mutex);
+                auto itr = m_cog_gears.find(&owning_cog);
+                if(itr == m_cog_gears.end() || i >= itr->second.size())
+                {
+                    break;
+                }
+                gear = itr->second[i];
+            }
+            activate_gear(*gear);
+        }
+    }
+
+    void GearService::deactivate_gears(const RAOE::Cogs::BaseCog& owning_cog)
+    {
+        {
+            const std::scoped_lock lock(m_mutex);
+            m_active_cogs.erase(&owning_cog);
+        }
+        for(const std::shared_ptr<RAOE::Cogs::Gear>& gear : gears_of(owning_cog))
+        {
+            if(gear->m_active)
+            {
+                const raoe::memory::scoped_tag memory_tag(gear->memory_tag());
+                gear->m_active = false;
+                gear->deactivated();
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<RAOE::Cogs::Gear>> GearService::gears_of(const RAOE::Cogs::BaseCog& owning_cog) const
+    {
+        const std::scoped_lock lock(m_mutex);
+        auto itr = m_cog_gears.find(&owning_cog);
+        return itr != m_cog_gears.end() ? itr->second : std::vector<std::shared_ptr<RAOE::Cogs::Gear>>();
+    }
+
+    size_t GearService::unbuilt_gear_count() const
+    {
+        const std::scoped_lock lock(m_mutex);
+        return m_factories.size();
+    }
+
+    size_t GearService::remove_gears(const RAOE::Cogs::BaseCog& owning_cog)
+    {
+        const std::scoped_lock lock(m_mutex);
+        m_cog_gears.erase(&owning_cog);
+        m_active_cogs.erase(&owning_cog);
+        std::erase_if(m_factories, [&owning_cog](const auto& entry) { return entry.second.cog == &owning_cog; });
+        const size_t removed = m_gears.erase_if([&owning_cog](const std::shared_ptr<RAOE::Cogs::Gear>& gear) { return gear && &gear->cog() == &owning_cog; });
+        publish_snapshot();
+        return removed;
     }
 
-}
\ No newline at end of file
+}
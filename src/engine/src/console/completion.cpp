@@ -0,0 +1,246 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "console/completion.hpp"
+
+#include <algorithm>
+
+namespace RAOE::Console
+{
+    namespace
+    {
+        constexpr char to_lower(char c)
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        constexpr uint32 trigram_at(std::string_view str, size_t index)
+        {
+            return static_cast<uint32>(static_cast<uint8>(str[index])) << 16
+                | static_cast<uint32>(static_cast<uint8>(str[index + 1])) << 8
+                | static_cast<uint32>(static_cast<uint8>(str[index + 2]));
+        }
+
+        constexpr size_t trigram_count(std::string_view str)
+        {
+            return str.size() < 3 ? 0 : str.size() - 2;
+        }
+
+        constexpr bool contains(std::string_view str, std::string_view part)
+        {
+            return str.find(part) != std::string_view::npos;
+        }
+    }
+
+    void CompletionIndex::rebuild()
+    {
+        m_generation = m_registry.generation();
+        m_elements.clear();
+        m_names.clear();
+        m_trigram_postings.clear();
+
+        for(IConsoleElement* element : m_registry.elements())
+        {
+            //Elements that lost a name collision can't be executed, so don't suggest them
+            if(m_registry.find(element->name()) != element)
+            {
+                continue;
+            }
+
+            std::string name(element->name());
+            std::transform(name.begin(), name.end(), name.begin(), to_lower);
+
+            const uint32 name_index = static_cast<uint32>(m_names.size());
+            for(size_t i = 0; i < trigram_count(name); i++)
+            {
+                std::vector<uint32>& postings = m_trigram_postings[trigram_at(name, i)];
+                //A name with a repeated trigram is only posted once
+                if(postings.empty() || postings.back() != name_index)
+                {
+                    postings.push_back(name_index);
+                }
+            }
+            m_elements.push_back(element);
+            m_names.push_back(std::move(name));
+        }
+
+        m_shared_trigrams.assign(m_names.size(), 0);
+        m_touched.clear();
+        m_substring_candidates.clear();
+        m_query.clear();
+        m_results.clear();
+    }
+
+    void CompletionIndex::reset_counts()
+    {
+        for(const uint32 name_index : m_touched)
+        {
+            m_shared_trigrams[name_index] = 0;
+        }
+        m_touched.clear();
+    }
+
+    void CompletionIndex::add_trigram_postings(std::string_view query, size_t first_trigram)
+    {
+        for(size_t i = first_trigram; i < trigram_count(query); i++)
+        {
+            if(auto found = m_trigram_postings.find(trigram_at(query, i)); found != m_trigram_postings.end())
+            {
+                for(const uint32 name_index : found->second)
+                {
+                    if(m_shared_trigrams[name_index]++ == 0)
+                    {
+                        m_touched.push_back(name_index);
+                    }
+                }
+            }
+        }
+    }
+
+    void CompletionIndex::collect_substring_candidates(std::string_view query, bool extends_previous)
+    {
+        //Anything that contains the longer query contains the shorter one, so the last candidates only need filtering
+        if(extends_previous)
+        {
+            std::erase_if(m_substring_candidates, [&](uint32 name_index) { return !contains(m_names[name_index], query); });
+            return;
+        }
+
+        m_substring_candidates.clear();
+        for(uint32 name_index = 0; name_index < m_names.size(); name_index++)
+        {
+            if(contains(m_names[name_index], query))
+            {
+                m_substring_candidates.push_back(name_index);
+            }
+        }
+    }
+
+    bool CompletionIndex::better(const Match& lhs, const Match& rhs) const
+    {
+        if(lhs.score != rhs.score)
+        {
+            return lhs.score > rhs.score;
+        }
+        const std::string& lhs_name = m_names[lhs.name_index];
+        const std::string& rhs_name = m_names[rhs.name_index];
+        if(lhs_name.size() != rhs_name.size())
+        {
+            return lhs_name.size() < rhs_name.size();
+        }
+        return lhs_name < rhs_name;
+    }
+
+    std::span<IConsoleElement* const> CompletionIndex::query(std::string_view input)
+    {
+        if(m_generation != m_registry.generation())
+        {
+            rebuild();
+        }
+
+        input = input.substr(0, input.find(' '));
+        std::string query(input);
+        std::transform(query.begin(), query.end(), query.begin(), to_lower);
+        if(query == m_query)
+        {
+            return m_results;
+        }
+        if(query.empty())
+        {
+            reset_counts();
+            m_query.clear();
+            m_results.clear();
+            return m_results;
+        }
+
+        const bool extends_previous = !m_query.empty() && query.starts_with(m_query);
+        const size_t query_trigrams = trigram_count(query);
+        if(extends_previous)
+        {
+            //Only the trigrams that end in the new characters are new
+            add_trigram_postings(query, trigram_count(m_query));
+        }
+        else
+        {
+            reset_counts();
+            add_trigram_postings(query, 0);
+        }
+
+        if(query_trigrams == 0)
+        {
+            collect_substring_candidates(query, extends_previous);
+        }
+
+        //Every candidate is scored, but only the best m_max_results are kept, in a heap with the worst match on top
+        m_heap.clear();
+        auto worse_on_top = [this](const Match& lhs, const Match& rhs) { return better(lhs, rhs); };
+        auto consider = [&](uint32 name_index, uint32 shared)
+        {
+            const std::string& name = m_names[name_index];
+            uint32 score = query_trigrams == 0 ? 100 : static_cast<uint32>(100 * shared / query_trigrams);
+            if(name.starts_with(query))
+            {
+                score += 100;
+            }
+            else if(query_trigrams == 0 || contains(name, query))
+            {
+                score += 50;
+            }
+
+            const Match match { score, name_index };
+            if(m_heap.size() < m_max_results)
+            {
+                m_heap.push_back(match);
+                std::push_heap(m_heap.begin(), m_heap.end(), worse_on_top);
+            }
+            else if(!m_heap.empty() && better(match, m_heap.front()))
+            {
+                std::pop_heap(m_heap.begin(), m_heap.end(), worse_on_top);
+                m_heap.back() = match;
+                std::push_heap(m_heap.begin(), m_heap.end(), worse_on_top);
+            }
+        };
+
+        if(query_trigrams == 0)
+        {
+            for(const uint32 name_index : m_substring_candidates)
+            {
+                consider(name_index, 0);
+            }
+        }
+        else
+        {
+            for(const uint32 name_index : m_touched)
+            {
+                const uint32 shared = std::min<uint32>(m_shared_trigrams[name_index], static_cast<uint32>(query_trigrams));
+                if(shared * 2 >= query_trigrams)
+                {
+                    consider(name_index, shared);
+                }
+            }
+        }
+
+        std::sort_heap(m_heap.begin(), m_heap.end(), worse_on_top);
+        m_results.clear();
+        for(const Match& match : m_heap)
+        {
+            m_results.push_back(m_elements[match.name_index]);
+        }
+
+        m_query = std::move(query);
+        return m_results;
+    }
+}
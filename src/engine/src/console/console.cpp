@@ -16,7 +16,11 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "console/console.hpp"
 #include "console/command.hpp"
+#include "console/cvar.hpp"
+#include "services/task_service.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <optional>
 #include "string.hpp"
 
@@ -29,13 +33,168 @@ namespace RAOE::Console
     }
     CommandRegistry& CommandRegistry::Get()
     {
-        return registry_singleton().value();
+        CommandRegistry& registry = registry_singleton().value();
+        if(registry.m_registered_static_head != AutoRegisterConsoleElement::head())
+        {
+            registry.register_static_elements();
+        }
+        return registry;
+    }
+
+    void CommandRegistry::register_static_elements()
+    {
+        RAOE_STARTUP_TRACE_SCOPE("engine", "register static console elements");
+        //New elements are linked at the head, so everything up to the last head we saw is new, newest first
+        const AutoRegisterConsoleElement* const head = AutoRegisterConsoleElement::head();
+        std::vector<IConsoleElement*> added;
+        for(const AutoRegisterConsoleElement* node = head; node != m_registered_static_head; node = node->next())
+        {
+            added.push_back(node->console_element());
+        }
+        m_registered_static_head = head;
+
+        for(auto itr = added.rbegin(); itr != added.rend(); ++itr)
+        {
+            add_element(*itr);
+        }
+    }
+
+    size_t CommandRegistry::unregister_static_elements_if(bool(*predicate)(const IConsoleElement&, void*), void* context)
+    {
+        //Anything still waiting on the list gets registered first, so every node on the list is in the registry
+        register_static_elements();
+
+        std::vector<const IConsoleElement*> removed;
+        const AutoRegisterConsoleElement* previous = nullptr;
+        for(const AutoRegisterConsoleElement* node = AutoRegisterConsoleElement::s_head; node != nullptr; node = node->m_next)
+        {
+            if(!predicate(*node->console_element(), context))
+            {
+                previous = node;
+                continue;
+            }
+
+            removed.push_back(node->console_element());
+            if(previous)
+            {
+                previous->m_next = node->m_next;
+            }
+            else
+            {
+                AutoRegisterConsoleElement::s_head = node->m_next;
+            }
+        }
+        m_registered_static_head = AutoRegisterConsoleElement::s_head;
+
+        if(removed.empty())
+        {
+            return 0;
+        }
+
+        auto is_removed = [&removed](const IConsoleElement* element) { return std::ranges::find(removed, element) != removed.end(); };
+        std::erase_if(m_elements, is_removed);
+        std::erase_if(m_sorted_elements, is_removed);
+        std::erase_if(m_name_index, [&is_removed](const auto& entry) { return is_removed(entry.second); });
+
+        for(const IConsoleElement* element : removed)
+        {
+            m_bound_calls.erase(element);
+            if(const ICVar* cvar = dynamic_cast<const ICVar*>(element))
+            {
+                discard_cvar_change(*cvar);
+            }
+        }
+
+        //A removed element may have been hiding another one with the same name
+        for(IConsoleElement* element : m_elements)
+        {
+            m_name_index.try_emplace(element->name(), element);
+        }
+        m_generation++;
+        return removed.size();
+    }
+
+    void CommandRegistry::add_element(IConsoleElement* element)    
+    {
+        m_elements.push_back(element);
+        m_name_index.try_emplace(element->name(), element);
+        m_sorted_elements.push_back(element);
+        m_sorted = false;
+        m_generation++;
     }
   
-    IConsoleElement* CommandRegistry::register_console_element(std::function<IConsoleElement*()> factory)    
+    IConsoleElement* CommandRegistry::register_console_element(IConsoleElement& element)    
     {
-        std::unique_ptr<IConsoleElement>& element = element_registry.emplace_back(std::unique_ptr<IConsoleElement>(factory()));
-        return element.get();
+        add_element(&element);
+        return &element;
+    }
+
+    IConsoleElement* CommandRegistry::register_console_element(std::unique_ptr<IConsoleElement> element)    
+    {
+        if(!element)
+        {
+            return nullptr;
+        }
+        IConsoleElement* registered = m_owned_elements.emplace_back(std::move(element)).get();
+        add_element(registered);
+        return registered;
+    }
+
+    IConsoleElement* CommandRegistry::find(std::string_view name) const    
+    {
+        auto itr = m_name_index.find(name);
+        return itr != m_name_index.end() ? itr->second : nullptr;
+    }
+
+    std::span<IConsoleElement* const> CommandRegistry::complete(std::string_view prefix) const    
+    {
+        if(!m_sorted)
+        {
+            //stable, so elements with the same name stay in registration order
+            std::ranges::stable_sort(m_sorted_elements, {}, &IConsoleElement::name);
+            m_sorted = true;
+        }
+
+        auto first = std::ranges::lower_bound(m_sorted_elements, prefix, {}, &IConsoleElement::name);
+        auto last = std::find_if(first, m_sorted_elements.end(), [prefix](const IConsoleElement* element) { 
+            return !element->name().starts_with(prefix); 
+        });
+        return { first, last };
+    }
+
+    const IConsoleElement::IBoundCall& CommandRegistry::bind(const IConsoleElement& element, std::string_view command_line) const
+    {
+        auto& calls = m_bound_calls[&element];
+        auto itr = calls.find(command_line);
+        if(itr == calls.end())
+        {
+            itr = calls.emplace(std::string(command_line), element.bind(command_line)).first;
+        }
+        return *itr->second;
+    }
+
+    namespace
+    {
+        //Keeps the command line, and has the element parse it on every call
+        class TextCall final : public IConsoleElement::IBoundCall
+        {
+        public:
+            TextCall(const IConsoleElement& in_element, std::string_view in_command_line)
+                : m_element(in_element)
+                , m_command_line(in_command_line)
+            {
+            }
+
+            IConsoleElement::EExecuteError execute(RAOE::Engine& engine) const override { return m_element.execute(engine, m_command_line); }
+        private:
+            const IConsoleElement& m_element;
+            std::string m_command_line;
+        };
+    }
+
+    std::unique_ptr<IConsoleElement::IBoundCall> IConsoleElement::bind(std::string_view command_line) const
+    {
+        return std::make_unique<TextCall>(*this, command_line);
     }
 
     std::tuple<std::string_view, std::string_view> split_command_args(std::string_view command_line)
@@ -44,24 +203,12 @@ namespace RAOE::Console
         return { start, command_line.substr(start.length())};
     }
 
-    EConsoleError execute(RAOE::Engine& engine, std::string_view command_line)    
+    EConsoleError CommandRegistry::execute(RAOE::Engine& engine, std::string_view command_line) const
     {
         //split this command into it's name and args
         auto [command, args] = split_command_args(command_line);
-     
-        IConsoleElement* found_element = nullptr;
-
-        //Find the console command this matches
-        for(auto& element : RAOE::Console::CommandRegistry::Get().elements())
-        {
-            if(element && element->name().compare(command) == 0)
-            {
-                found_element = element.get();
-                break;                
-            }
-        }
 
-        if(found_element)
+        if(IConsoleElement* found_element = find(command))
         {
             if(IConsoleElement::EExecuteError error = found_element->execute(engine, args); error != IConsoleElement::EExecuteError::Success )
             {
@@ -73,4 +220,72 @@ namespace RAOE::Console
 
         return EConsoleError::Command_Not_Found;
     }
+
+    namespace
+    {
+        using EExecuteError = IConsoleElement::EExecuteError;
+
+        std::string_view execute_error_name(EExecuteError error)
+        {
+            switch(error)
+            {
+                case EExecuteError::Success: return "success";
+                case EExecuteError::Invalid_Arguments: return "invalid arguments";
+                case EExecuteError::Missing_Arguments: return "missing arguments";
+                case EExecuteError::Too_Many_Arguments: return "too many arguments";
+                case EExecuteError::Command_Error: return "command error";
+            }
+            return "unknown error";
+        }
+
+        double elapsed_ms(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        template<typename T>
+        raoe::lazy<> report_async_command(std::string_view command_name, raoe::lazy<T> task)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    co_await task;
+                    spdlog::info("> {} finished in {:.2f}ms", command_name, elapsed_ms(start));
+                }
+                else
+                {
+                    const EExecuteError result = co_await task;
+                    if(result == EExecuteError::Success)
+                    {
+                        spdlog::info("> {} finished in {:.2f}ms", command_name, elapsed_ms(start));
+                    }
+                    else
+                    {
+                        spdlog::warn("> {} failed after {:.2f}ms: {}", command_name, elapsed_ms(start), execute_error_name(result));
+                    }
+                }
+            }
+            catch(const std::exception& exception)
+            {
+                spdlog::error("> {} threw after {:.2f}ms: {}", command_name, elapsed_ms(start), exception.what());
+            }
+        }
+    }
+
+    void start_async_command(RAOE::Engine& engine, std::string_view command_name, raoe::lazy<>&& task)
+    {
+        RAOE::enqueue_task(engine, report_async_command(command_name, std::move(task)));
+    }
+
+    void start_async_command(RAOE::Engine& engine, std::string_view command_name, raoe::lazy<EExecuteError>&& task)
+    {
+        RAOE::enqueue_task(engine, report_async_command(command_name, std::move(task)));
+    }
+
+    EConsoleError execute(RAOE::Engine& engine, std::string_view command_line)    
+    {
+        return CommandRegistry::Get().execute(engine, command_line);
+    }
 }
\ No newline at end of file
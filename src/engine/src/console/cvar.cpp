@@ -0,0 +1,244 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "console/cvar.hpp"
+#include "engine.hpp"
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace RAOE::Console
+{
+    namespace
+    {
+        //Writes are rare, so changes are queued under a plain lock.  Reads never touch it
+        std::mutex& pending_mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        std::vector<const ICVar*>& pending_changes()
+        {
+            static std::vector<const ICVar*> changes;
+            return changes;
+        }
+
+        constexpr std::string_view LineWhitespace = " \t\r";
+
+        struct config_line
+        {
+            std::string_view name;  //empty for blank lines and comments
+            std::string_view value; //everything after the name, trimmed
+            bool comment = false;
+        };
+
+        config_line parse_config_line(std::string_view line)
+        {
+            const size_t first = line.find_first_not_of(LineWhitespace);
+            if(first == std::string_view::npos)
+            {
+                return {};
+            }
+            line = line.substr(first, line.find_last_not_of(LineWhitespace) - first + 1);
+            if(line.starts_with("//") || line.starts_with('#'))
+            {
+                return { .name = {}, .value = {}, .comment = true };
+            }
+
+            const std::string_view name = line.substr(0, line.find_first_of(LineWhitespace));
+            const std::string_view value = line.substr(name.size());
+            const size_t value_start = value.find_first_not_of(LineWhitespace);
+            return {
+                .name = name,
+                .value = value_start == std::string_view::npos ? std::string_view() : value.substr(value_start),
+                .comment = false,
+            };
+        }
+    }
+
+    void ICVar::queue_change() const
+    {
+        std::scoped_lock lock(pending_mutex());
+        pending_changes().push_back(this);
+    }
+
+    void flush_cvar_changes()
+    {
+        std::vector<const ICVar*> changes;
+        {
+            std::scoped_lock lock(pending_mutex());
+            changes.swap(pending_changes());
+        }
+
+        //Callbacks run outside the lock, so they are free to set other cvars.  Those get picked up next frame
+        for(const ICVar* cvar : changes)
+        {
+            cvar->notify_changed();
+        }
+    }
+
+    void discard_cvar_change(const ICVar& cvar)
+    {
+        std::scoped_lock lock(pending_mutex());
+        if(std::erase(pending_changes(), &cvar) > 0)
+        {
+            cvar.m_change_queued.store(false, std::memory_order_release);
+        }
+    }
+
+    std::filesystem::path cvar_config_path()
+    {
+        return std::filesystem::current_path() / "config.cfg";
+    }
+
+    bool load_cvars(const std::filesystem::path& path, const CommandRegistry& registry)
+    {
+        return load_cvars_if(path, registry, nullptr, nullptr);
+    }
+
+    bool load_cvars_if(const std::filesystem::path& path, const CommandRegistry& registry, bool(*predicate)(const ICVar&, void*), void* context)
+    {
+        std::ifstream file(path);
+        if(!file)
+        {
+            return false;
+        }
+
+        std::string line;
+        uint32 line_number = 0;
+        while(std::getline(file, line))
+        {
+            line_number++;
+            const config_line entry = parse_config_line(line);
+            if(entry.name.empty())
+            {
+                continue;
+            }
+
+            const ICVar* cvar = dynamic_cast<const ICVar*>(registry.find(entry.name));
+            if(!cvar)
+            {
+                //Likely from a shared cog that hasn't been loaded.  It's applied when the cog is, see CogService
+                if(!predicate)
+                {
+                    spdlog::debug("{}:{}: {} isn't registered", path.filename().string(), line_number, entry.name);
+                }
+                continue;
+            }
+            if(predicate && !predicate(*cvar, context))
+            {
+                continue;
+            }
+
+            if(entry.value.empty() || !cvar->set_from_string(entry.value))
+            {
+                spdlog::warn("{}:{}: \"{}\" is not a valid value for {}", path.filename().string(), line_number, entry.value, entry.name);
+            }
+        }
+        return true;
+    }
+
+    bool save_cvars(const std::filesystem::path& path, const CommandRegistry& registry)
+    {
+        std::stringstream contents;
+        for(IConsoleElement* element : registry.elements())
+        {
+            if(const ICVar* cvar = dynamic_cast<const ICVar*>(element))
+            {
+                contents << "// " << cvar->description() << " (default " << cvar->default_string() << ")\n";
+                contents << cvar->name() << ' ' << cvar->value_string() << "\n";
+            }
+        }
+
+        //Entries for cvars that aren't registered right now, like ones from a shared cog that isn't loaded, are kept
+        //along with the comments right above them
+        if(std::ifstream existing(path); existing)
+        {
+            std::string kept;
+            std::string comments;
+            std::string line;
+            while(std::getline(existing, line))
+            {
+                const config_line entry = parse_config_line(line);
+                if(entry.comment)
+                {
+                    comments.append(line).push_back('\n');
+                    continue;
+                }
+                if(!entry.name.empty() && !dynamic_cast<const ICVar*>(registry.find(entry.name)))
+                {
+                    kept.append(comments).append(line).push_back('\n');
+                }
+                comments.clear();
+            }
+            contents << kept;
+        }
+
+        //Written next to the file and moved over it, so a failed write doesn't lose the old one
+        std::filesystem::path temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::trunc);
+            file << contents.str();
+            if(!file.flush())
+            {
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary_path, path, error);
+        return !error;
+    }
+
+    void list_cvars()
+    {
+        for(IConsoleElement* element : CommandRegistry::Get().elements())
+        {
+            if(const ICVar* cvar = dynamic_cast<const ICVar*>(element))
+            {
+                spdlog::info("\t{} = {} - {}", cvar->name(), cvar->value_string(), cvar->description());
+            }
+        }
+    }
+
+    void save_cvars_command()
+    {
+        const std::filesystem::path path = cvar_config_path();
+        if(save_cvars(path))
+        {
+            spdlog::info("Saved cvars to {}", path.string());
+        }
+        else
+        {
+            spdlog::error("Unable to save cvars to {}", path.string());
+        }
+    }
+
+    static const AutoRegisterConsoleCommand cvars_command = RAOE::Console::CreateConsoleCommand(
+        "cvars",
+        "Lists every cvar and its value",
+        list_cvars
+    );
+
+    static const AutoRegisterConsoleCommand cvars_save_command = RAOE::Console::CreateConsoleCommand(
+        "cvars_save",
+        "Saves every cvar to config.cfg, which is loaded at startup",
+        save_cvars_command
+    );
+}
@@ -0,0 +1,473 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "console/remote_console.hpp"
+#include "engine.hpp"
+#include "log.hpp"
+#include "spdlog/sinks/base_sink.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace RAOE::Console
+{
+    /***
+     * RemoteLogSink
+     * Formats log lines into a queue the main thread takes whole each frame.  Lines pile up only between polls,
+     * and past MaxQueuedLines they're counted and dropped instead
+    */
+    class RemoteLogSink : public spdlog::sinks::base_sink<std::mutex>
+    {
+    public:
+        static constexpr size_t MaxQueuedLines = 64 * 1024;
+
+        //Swaps the queued lines into lines, which should be empty.  Returns how many were dropped since the last take
+        size_t take(std::vector<std::string>& lines)
+        {
+            std::lock_guard lock(mutex_);
+            m_lines.swap(lines);
+            return std::exchange(m_dropped, 0);
+        }
+
+    protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override
+        {
+            if(m_lines.size() >= MaxQueuedLines)
+            {
+                m_dropped++;
+                return;
+            }
+
+            spdlog::memory_buf_t formatted;
+            formatter_->format(msg, formatted);
+            std::string_view text(formatted.data(), formatted.size());
+            while(!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+            {
+                text.remove_suffix(1);
+            }
+            m_lines.emplace_back(text);
+        }
+
+        void flush_() override {}
+
+    private:
+        std::vector<std::string> m_lines;
+        size_t m_dropped = 0;
+    };
+
+    namespace
+    {
+        //One word, so a reply can be split on spaces
+        std::string_view result_word(EConsoleError error)
+        {
+            switch(error)
+            {
+                case EConsoleError::None: return "ok";
+                case EConsoleError::Command_Not_Found: return "not_found";
+                case EConsoleError::Incorrect_Arguments: return "bad_arguments";
+                case EConsoleError::Not_Authorized: return "not_authorized";
+                case EConsoleError::Need_Cheats: return "need_cheats";
+            }
+            return "unknown";
+        }
+
+        //Control lines start with this, so they can't be mistaken for commands
+        constexpr std::string_view ControlPrefix = ":";
+    }
+
+    RemoteConsole::RemoteConsole(RAOE::Engine& in_engine)
+        : m_engine(in_engine)
+        , m_log_sink(std::make_shared<RemoteLogSink>())
+    {
+        raoe::log::add_sink(m_log_sink);
+    }
+
+    RemoteConsole::~RemoteConsole()
+    {
+        raoe::log::remove_sink(m_log_sink);
+        close();
+    }
+
+    void RemoteConsole::poll()
+    {
+        accept_clients();
+
+        //Indices rather than iterators, in case a command connects another client
+        for(size_t i = 0; i < m_clients.size(); i++)
+        {
+            if(!m_clients[i].closing)
+            {
+                read_client(m_clients[i]);
+            }
+        }
+
+        broadcast_log_lines();
+
+        for(Client& client : m_clients)
+        {
+            write_client(client);
+        }
+
+#if !defined(_WIN32)
+        std::erase_if(m_clients, [](const Client& client) {
+            if(client.closing && (client.output.empty() || client.socket < 0))
+            {
+                if(client.socket >= 0)
+                {
+                    ::close(client.socket);
+                }
+                return true;
+            }
+            return false;
+        });
+#endif
+    }
+
+    void RemoteConsole::handle_line(Client& client, std::string_view line)
+    {
+        if(!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        if(line.empty())
+        {
+            return;
+        }
+
+        if(line.starts_with(ControlPrefix))
+        {
+            const std::string_view control = line.substr(ControlPrefix.size());
+            if(control == "batch")
+            {
+                client.batch.emplace();
+            }
+            else if(control == "end")
+            {
+                run_batch(client);
+            }
+            else if(control == "quit")
+            {
+                client.closing = true;
+            }
+            else
+            {
+                fmt::format_to(std::back_inserter(client.output), "error unknown_control {}\n", line);
+            }
+            return;
+        }
+
+        if(client.batch)
+        {
+            if(client.batch->size() >= MaxBatchCommands)
+            {
+                fmt::format_to(std::back_inserter(client.output), "error batch_full {}\n", line);
+                return;
+            }
+            client.batch->emplace_back(line);
+            return;
+        }
+
+        const EConsoleError result = RAOE::Console::execute(m_engine, line);
+        if(result == EConsoleError::None)
+        {
+            fmt::format_to(std::back_inserter(client.output), "ok {}\n", line);
+        }
+        else
+        {
+            fmt::format_to(std::back_inserter(client.output), "error {} {}\n", result_word(result), line);
+        }
+    }
+
+    void RemoteConsole::run_batch(Client& client)
+    {
+        if(!client.batch)
+        {
+            client.output += "error not_batching :end\n";
+            return;
+        }
+
+        //Run everything before writing any of the report, so formatting doesn't land between commands
+        using clock = std::chrono::steady_clock;
+        const std::vector<std::string> commands = std::move(*client.batch);
+        client.batch.reset();
+
+        std::vector<std::pair<clock::duration, EConsoleError>> results;
+        results.reserve(commands.size());
+        const clock::time_point batch_start = clock::now();
+        for(const std::string& command : commands)
+        {
+            const clock::time_point start = clock::now();
+            const EConsoleError result = RAOE::Console::execute(m_engine, command);
+            results.emplace_back(clock::now() - start, result);
+        }
+        const clock::duration batch_time = clock::now() - batch_start;
+
+        auto microseconds = [](clock::duration duration) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        };
+        for(size_t i = 0; i < commands.size(); i++)
+        {
+            fmt::format_to(std::back_inserter(client.output), "time {} {} {} {}\n",
+                i, microseconds(results[i].first), result_word(results[i].second), commands[i]);
+        }
+        fmt::format_to(std::back_inserter(client.output), "batch {} {}\n", commands.size(), microseconds(batch_time));
+    }
+
+    void RemoteConsole::broadcast_log_lines()
+    {
+        std::vector<std::string> lines;
+        const size_t dropped = m_log_sink->take(lines);
+        if(m_clients.empty())
+        {
+            return;
+        }
+
+        for(Client& client : m_clients)
+        {
+            if(dropped > 0)
+            {
+                fmt::format_to(std::back_inserter(client.output), "log {} log lines dropped\n", dropped);
+            }
+            for(const std::string& line : lines)
+            {
+                if(client.output.size() + line.size() > MaxPendingOutput)
+                {
+                    break;
+                }
+                client.output.append("log ").append(line).push_back('\n');
+            }
+        }
+    }
+
+    std::optional<std::filesystem::path> remote_console_path()
+    {
+        if(const char* path = std::getenv("RAOE_REMOTE_CONSOLE"); path && *path)
+        {
+            return std::filesystem::path(path);
+        }
+        return std::nullopt;
+    }
+
+#if !defined(_WIN32)
+    namespace
+    {
+        bool set_nonblocking(int socket)
+        {
+            const int flags = fcntl(socket, F_GETFL, 0);
+            return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0 && fcntl(socket, F_SETFD, FD_CLOEXEC) == 0;
+        }
+
+        bool would_block(int error)
+        {
+            return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+        }
+    }
+
+    bool RemoteConsole::listen(const std::filesystem::path& path)
+    {
+        close();
+
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        const std::string native_path = path.string();
+        if(native_path.empty() || native_path.size() >= sizeof(address.sun_path))
+        {
+            spdlog::error("Remote console: socket path {} is empty or too long", native_path);
+            return false;
+        }
+        std::memcpy(address.sun_path, native_path.c_str(), native_path.size() + 1);
+
+        const int listen_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if(listen_socket < 0)
+        {
+            spdlog::error("Remote console: unable to create a socket: {}", std::strerror(errno));
+            return false;
+        }
+
+        //A socket file left behind by an engine that didn't shut down cleanly would make bind fail.  Anything else at the
+        //path is left alone
+        struct stat existing {};
+        if(::lstat(native_path.c_str(), &existing) == 0)
+        {
+            if(!S_ISSOCK(existing.st_mode))
+            {
+                spdlog::error("Remote console: {} already exists and isn't a socket", native_path);
+                ::close(listen_socket);
+                return false;
+            }
+            ::unlink(native_path.c_str());
+        }
+
+        //Anyone who can connect can run any command, so only this user may.  Nobody can connect until listen(), so
+        //tightening the file's permissions in between leaves no window
+        if(::bind(listen_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 //NOLINT sockaddr casts are how the socket api works
+            || ::chmod(native_path.c_str(), S_IRUSR | S_IWUSR) != 0
+            || ::listen(listen_socket, SOMAXCONN) != 0
+            || !set_nonblocking(listen_socket))
+        {
+            spdlog::error("Remote console: unable to listen on {}: {}", native_path, std::strerror(errno));
+            ::close(listen_socket);
+            return false;
+        }
+
+        m_listen_socket = listen_socket;
+        m_path = path;
+        spdlog::info("Remote console listening on {}", native_path);
+        return true;
+    }
+
+    void RemoteConsole::adopt_client(int socket)
+    {
+        if(socket < 0)
+        {
+            return;
+        }
+        set_nonblocking(socket);
+        m_clients.push_back(Client { .socket = socket });
+    }
+
+    void RemoteConsole::accept_clients()
+    {
+        if(m_listen_socket < 0)
+        {
+            return;
+        }
+
+        while(true)
+        {
+            const int socket = ::accept(m_listen_socket, nullptr, nullptr);
+            if(socket < 0)
+            {
+                if(!would_block(errno))
+                {
+                    spdlog::warn("Remote console: accept failed: {}", std::strerror(errno));
+                }
+                return;
+            }
+            adopt_client(socket);
+        }
+    }
+
+    void RemoteConsole::read_client(Client& client)
+    {
+        //Run the complete lines as they come in.  A partial line waits for the rest, as long as it isn't already too long
+        std::array<char, 4096> buffer; //NOLINT uninitialized, recv fills it
+        while(!client.closing)
+        {
+            const ssize_t received = ::recv(client.socket, buffer.data(), buffer.size(), 0);
+            if(received > 0)
+            {
+                client.input.append(buffer.data(), static_cast<size_t>(received));
+                if(!handle_lines(client))
+                {
+                    spdlog::warn("Remote console: dropping a client that sent a line longer than {} bytes", MaxLineLength);
+                    client.input.clear();
+                    client.closing = true;
+                }
+                continue;
+            }
+            if(received == 0 || !would_block(errno))
+            {
+                //The client hung up.  Whatever full lines it sent before it did have already run
+                client.closing = true;
+            }
+            break;
+        }
+    }
+
+    bool RemoteConsole::handle_lines(Client& client)
+    {
+        size_t consumed = 0;
+        for(size_t end = client.input.find('\n'); end != std::string::npos && !client.closing; end = client.input.find('\n', consumed))
+        {
+            handle_line(client, std::string_view(client.input).substr(consumed, end - consumed));
+            consumed = end + 1;
+        }
+        client.input.erase(0, consumed);
+        return client.input.size() <= MaxLineLength;
+    }
+
+    void RemoteConsole::write_client(Client& client)
+    {
+#if defined(MSG_NOSIGNAL)
+        constexpr int SendFlags = MSG_NOSIGNAL; //a client that hung up shouldn't kill the engine with SIGPIPE
+#else
+        constexpr int SendFlags = 0;
+#endif
+        size_t written = 0;
+        while(written < client.output.size())
+        {
+            const ssize_t sent = ::send(client.socket, client.output.data() + written, client.output.size() - written, SendFlags);
+            if(sent < 0)
+            {
+                if(!would_block(errno))
+                {
+                    //Nobody is left to read the rest
+                    client.closing = true;
+                    written = client.output.size();
+                }
+                break;
+            }
+            written += static_cast<size_t>(sent);
+        }
+        client.output.erase(0, written);
+    }
+
+    void RemoteConsole::close()
+    {
+        for(Client& client : m_clients)
+        {
+            ::close(client.socket);
+        }
+        m_clients.clear();
+
+        if(m_listen_socket >= 0)
+        {
+            ::close(m_listen_socket);
+            ::unlink(m_path.string().c_str());
+            m_listen_socket = -1;
+        }
+        m_path.clear();
+    }
+#else
+    bool RemoteConsole::listen(const std::filesystem::path& path)
+    {
+        spdlog::error("Remote console: unable to listen on {}, unix sockets aren't supported on this platform", path.string());
+        return false;
+    }
+
+    void RemoteConsole::adopt_client(int) {}
+    void RemoteConsole::accept_clients() {}
+    void RemoteConsole::read_client(Client&) {}
+    void RemoteConsole::write_client(Client&) {}
+    void RemoteConsole::close() {}
+#endif
+}
@@ -0,0 +1,216 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "console/script.hpp"
+#include "console/command.hpp"
+#include "console/cvar.hpp"
+#include "engine.hpp"
+#include "resource/service.hpp"
+#include "resource/handle.hpp"
+#include "services/task_service.hpp"
+#include "from_string.hpp"
+
+#include <sstream>
+
+namespace RAOE::Console
+{
+    namespace Tags
+    {
+        const RAOE::Resource::Tag ScriptLoader("raoe:loader/console_script");
+        const RAOE::Resource::Tag Script("raoe:type/console_script");
+    }
+
+    namespace
+    {
+        using namespace std::literals::string_view_literals;
+
+        constexpr std::string_view LineWhitespace = " \t\r";
+
+        std::string_view trim_line(std::string_view line)
+        {
+            const size_t first = line.find_first_not_of(LineWhitespace);
+            if(first == std::string_view::npos)
+            {
+                return {};
+            }
+            return line.substr(first, line.find_last_not_of(LineWhitespace) - first + 1);
+        }
+
+        bool is_comment(std::string_view line)
+        {
+            return line.starts_with("//"sv) || line.starts_with('#');
+        }
+    }
+
+    std::shared_ptr<const Script::Program> Script::compiled(const CommandRegistry& registry) const    
+    {
+        if(m_program && m_compiled_generation == registry.generation())
+        {
+            return m_program;
+        }
+
+        auto program = std::make_shared<Program>();
+        const std::string_view source_view = source();
+        uint32 line_number = 0;
+        size_t line_start = 0;
+        while(line_start <= source_view.size())
+        {
+            const size_t line_end = std::min(source_view.find('\n', line_start), source_view.size());
+            const std::string_view line = trim_line(source_view.substr(line_start, line_end - line_start));
+            line_number++;
+            line_start = line_end + 1;
+
+            if(line.empty() || is_comment(line))
+            {
+                continue;
+            }
+
+            //Arguments keep their leading whitespace, the same as a line typed into the console
+            const std::string_view command = line.substr(0, line.find_first_of(LineWhitespace));
+            const std::string_view arguments = line.substr(command.size());
+
+            Instruction instruction;
+            instruction.line = line_number;
+            instruction.arguments_offset = static_cast<uint32>(arguments.data() - source_view.data());
+            instruction.arguments_length = static_cast<uint32>(arguments.size());
+            if(command == "wait"sv)
+            {
+                instruction.op = Instruction::EOp::Wait;
+            }
+            else if(IConsoleElement* element = registry.find(command))
+            {
+                instruction.op = Instruction::EOp::Execute;
+                instruction.element = element;
+                instruction.call = &registry.bind(*element, arguments);
+            }
+            else
+            {
+                instruction.op = Instruction::EOp::Unknown;
+                instruction.arguments_offset = static_cast<uint32>(command.data() - source_view.data());
+                instruction.arguments_length = static_cast<uint32>(command.size());
+            }
+            program->push_back(instruction);
+        }
+
+        m_program = std::move(program);
+        m_compiled_generation = registry.generation();
+        return m_program;
+    }
+
+    std::shared_ptr<RAOE::Resource::IResource> ScriptLoader::load_resource_internal(const std::istream& data_stream)    
+    {
+        std::stringstream buffer;
+        buffer << data_stream.rdbuf();
+        return std::make_shared<Script>(buffer.str());
+    }
+
+    raoe::lazy<> run_script(RAOE::Engine& engine, std::shared_ptr<const Script> script, std::chrono::microseconds frame_budget)    
+    {
+        using clock = std::chrono::steady_clock;
+        const CommandRegistry& registry = CommandRegistry::Get();
+        std::shared_ptr<const Script::Program> program = script->compiled(registry);
+        uint64 generation = registry.generation();
+
+        clock::time_point frame_start = clock::now();
+        for(size_t index = 0; index < program->size(); index++)
+        {
+            //A command, or something that ran while the script waited, may have unregistered the elements the program
+            //points at.  Recompiling keeps every line where it was, so the run carries on from the same instruction
+            if(registry.generation() != generation)
+            {
+                program = script->compiled(registry);
+                generation = registry.generation();
+            }
+
+            const Script::Instruction& instruction = (*program)[index];
+            const std::string_view arguments = script->arguments(instruction);
+            switch(instruction.op)
+            {
+                case Script::Instruction::EOp::Execute:
+                    if(instruction.call->execute(engine) != IConsoleElement::EExecuteError::Success)
+                    {
+                        spdlog::warn("script line {}: {} failed", instruction.line, instruction.element->name());
+                    }
+                    break;
+                case Script::Instruction::EOp::Wait:
+                {
+                    int32 frames = 1;
+                    if(const std::string_view count = trim_line(arguments); !count.empty() && !raoe::string::from_string(count, frames))
+                    {
+                        spdlog::warn("script line {}: wait takes a number of frames, not \"{}\"", instruction.line, count);
+                    }
+                    for(int32 i = 0; i < frames; i++)
+                    {
+                        RAOE::task_waiting_on("script wait");
+                        co_await std::suspend_always();
+                    }
+                    frame_start = clock::now();
+                    continue;
+                }
+                case Script::Instruction::EOp::Unknown:
+                    spdlog::warn("script line {}: unknown command {}", instruction.line, arguments);
+                    break;
+            }
+
+            if(clock::now() - frame_start >= frame_budget)
+            {
+                RAOE::task_waiting_on("script frame budget");
+                co_await std::suspend_always();
+                frame_start = clock::now();
+            }
+        }
+    }
+
+    static const AutoRegisterCVar<int32> cvar_script_frame_budget = RAOE::Console::CreateCVar<int32>(
+        "script_frame_budget_us",
+        "How many microseconds a script run with exec may take each frame before it continues on the next frame",
+        static_cast<int32>(DefaultScriptFrameBudget.count())
+    );
+
+    void exec_script(RAOE::Engine& engine, std::string_view args)
+    {
+        const std::string_view tag_name = trim_line(args);
+        if(tag_name.empty())
+        {
+            spdlog::info("usage: exec <script tag>, eg: exec raoe:scripts/autoexec");
+            return;
+        }
+
+        std::shared_ptr<RAOE::Resource::Service> resource_service = engine.get_service<RAOE::Resource::Service>().lock();
+        if(!resource_service)
+        {
+            spdlog::error("exec: unable to find the resource service");
+            return;
+        }
+
+        const RAOE::Resource::Tag tag(tag_name);
+        std::shared_ptr<RAOE::Resource::Handle> handle = resource_service->load_resource(tag);
+        std::shared_ptr<Script> script = handle ? handle->get<Script>().lock() : nullptr;
+        if(!script)
+        {
+            spdlog::warn("exec: {} is not a console script", tag_name);
+            return;
+        }
+
+        RAOE::enqueue_task(engine, run_script(engine, std::move(script), std::chrono::microseconds(cvar_script_frame_budget.get())), { .name = "exec" });
+    }
+
+    static const AutoRegisterConsoleCommand exec_command = RAOE::Console::CreateConsoleCommand(
+        "exec",
+        "Runs a console script (a .cfg resource), eg: exec raoe:scripts/autoexec",
+        exec_script
+    );
+}
@@ -0,0 +1,121 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+//Replaces the global operator new/delete so every heap allocation is charged to the active memory tag (see memory_tracking.hpp)
+#if RAOE_TRACK_GLOBAL_ALLOCATIONS
+
+#include "memory_tracking.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    //Sits directly in front of every pointer we hand out, so delete knows who to credit and where the block starts
+    struct alignas(16) allocation_header
+    {
+        uint64 size;
+        uint32 offset; //from the start of the malloc'd block to the pointer handed out
+        raoe::memory::tag_id tag;
+    };
+    static_assert(sizeof(allocation_header) == 16);
+
+    //Lets reports know the global heap is being counted
+    [[maybe_unused]] const bool tracking_enabled = []() { 
+        raoe::memory::_::g_tracking_global_allocations.store(true, std::memory_order_relaxed); 
+        return true; 
+    }();
+
+    void* tracked_allocate(size_t size, size_t alignment) noexcept
+    {
+        alignment = std::max(alignment, alignof(allocation_header));
+        //malloc already gives us header alignment, only over-aligned requests need room to shift
+        const size_t padding = sizeof(allocation_header) + (alignment > alignof(allocation_header) ? alignment : 0);
+        void* block = std::malloc(size + padding); //NOLINT this is the allocator
+        if(block == nullptr)
+        {
+            return nullptr;
+        }
+
+        const auto block_address = reinterpret_cast<uintptr_t>(block); //NOLINT pointer math
+        const uintptr_t address = (block_address + sizeof(allocation_header) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+        const raoe::memory::tag_id tag = raoe::memory::active_tag();
+        auto* header = reinterpret_cast<allocation_header*>(address) - 1; //NOLINT pointer math
+        header->size = size;
+        header->offset = static_cast<uint32>(address - block_address);
+        header->tag = tag;
+        raoe::memory::record_allocation(tag, size);
+        return reinterpret_cast<void*>(address); //NOLINT pointer math
+    }
+
+    void* tracked_allocate_or_throw(size_t size, size_t alignment)
+    {
+        while(true)
+        {
+            if(void* ptr = tracked_allocate(size, alignment))
+            {
+                return ptr;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if(handler == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void tracked_free(void* ptr) noexcept
+    {
+        if(ptr == nullptr)
+        {
+            return;
+        }
+
+        const auto* header = static_cast<allocation_header*>(ptr) - 1; //NOLINT pointer math
+        raoe::memory::record_deallocation(header->tag, header->size);
+        std::free(static_cast<std::byte*>(ptr) - header->offset); //NOLINT this is the allocator
+    }
+
+    constexpr size_t default_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+}
+
+//NOLINTBEGIN(misc-new-delete-overloads)
+void* operator new(size_t size) { return tracked_allocate_or_throw(size, default_alignment); }
+void* operator new[](size_t size) { return tracked_allocate_or_throw(size, default_alignment); }
+void* operator new(size_t size, std::align_val_t alignment) { return tracked_allocate_or_throw(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return tracked_allocate_or_throw(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return tracked_allocate(size, default_alignment); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return tracked_allocate(size, default_alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return tracked_allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return tracked_allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free(ptr); }
+//NOLINTEND(misc-new-delete-overloads)
+
+#endif
@@ -0,0 +1,84 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "engine.hpp"
+#include "log.hpp"
+#include "string.hpp"
+#include "console/command.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace RAOE::Debug
+{
+    void print_log_levels()
+    {
+        spdlog::info("   | {:<20}|{:<10}|", "Logger", "Level");
+        spdlog::apply_all([](const std::shared_ptr<spdlog::logger>& logger) {
+            const spdlog::string_view_t level_name = spdlog::level::to_string_view(logger->level());
+            spdlog::info("   | {:<20}|{:<10}|", logger->name().empty() ? "(default)" : logger->name(), std::string_view(level_name.data(), level_name.size()));
+        });
+        if(const size_t dropped = raoe::log::dropped_messages(); dropped > 0)
+        {
+            spdlog::info("   {} messages were dropped because the log queue was full", dropped);
+        }
+    }
+
+    void set_log_level(std::string_view args)
+    {
+        std::vector<std::string_view> words;
+        std::ranges::copy(raoe::string::tokenize(args), std::back_inserter(words));
+
+        if(words.empty() || words.size() > 2)
+        {
+            spdlog::info("usage: log_level [logger] <trace|debug|info|warn|error|critical|off>");
+            print_log_levels();
+            return;
+        }
+
+        const std::string_view level_name = words.back();
+        const spdlog::level::level_enum level = spdlog::level::from_str(std::string(level_name));
+        if(level == spdlog::level::off && level_name != "off")
+        {
+            spdlog::warn("log_level: unknown level {}", level_name);
+            return;
+        }
+
+        if(words.size() == 1)
+        {
+            spdlog::set_level(level);
+            spdlog::info("log_level: all loggers set to {}", level_name);
+        }
+        else
+        {
+            raoe::log::get(words.front())->set_level(level);
+            spdlog::info("log_level: {} set to {}", words.front(), level_name);
+        }
+
+        if(static_cast<int32>(level) < RAOE_LOG_ACTIVE_LEVEL)
+        {
+            spdlog::info("log_level: note that this build compiles out everything below level {}", RAOE_LOG_ACTIVE_LEVEL);
+        }
+    }
+
+    using RAOE::Console::AutoRegisterConsoleCommand;
+    static const AutoRegisterConsoleCommand log_level_command = RAOE::Console::CreateConsoleCommand(
+        "log_level",
+        "Sets the level of one logger (log_level resource debug) or all of them (log_level warn).  With no arguments, lists the loggers",
+        set_log_level
+    );
+}
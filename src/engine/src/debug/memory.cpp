@@ -0,0 +1,71 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "engine.hpp"
+#include "frame_arena.hpp"
+#include "memory_tracking.hpp"
+#include "console/command.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+namespace RAOE::Debug
+{
+    void print_memory_report()
+    {
+        //Allocation rates are measured since the last time the report was printed
+        static std::unordered_map<raoe::memory::tag_id, uint64> last_allocations;
+        static std::chrono::steady_clock::time_point last_report_time;
+
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = last_allocations.empty() ? 0.0 : std::chrono::duration<double>(now - last_report_time).count();
+
+        std::vector<raoe::memory::tag_report> reports = raoe::memory::report();
+        std::ranges::sort(reports, std::ranges::greater(), &raoe::memory::tag_report::live_bytes);
+
+        if(!raoe::memory::tracking_global_allocations())
+        {
+            spdlog::info("Global allocations are not tracked (build with RAOE_TRACK_GLOBAL_ALLOCATIONS), only tagged pmr resources are counted");
+        }
+        spdlog::info("   | {:<40}|{:>14}|{:>14}|{:>12}|", "Tag", "Live Bytes", "Allocations", "Allocs/s");
+        for(const raoe::memory::tag_report& report : reports)
+        {
+            const double rate = seconds > 0.0 ? static_cast<double>(report.allocations - last_allocations[report.id]) / seconds : 0.0;
+            spdlog::info("   | {:<40}|{:>14}|{:>14}|{:>12.1f}|", report.name, report.live_bytes, report.allocations, rate);
+            last_allocations[report.id] = report.allocations;
+        }
+        last_report_time = now;
+    }
+
+    using RAOE::Console::AutoRegisterConsoleCommand;
+    static const AutoRegisterConsoleCommand memory_report_command = RAOE::Console::CreateConsoleCommand(
+        "memory_report",
+        "Prints live heap bytes and allocation counts for every memory tag (cogs, gears, resource types)",
+        print_memory_report
+    );
+
+    static const AutoRegisterConsoleCommand frame_arena_stats_command = RAOE::Console::CreateConsoleCommand(
+        "frame_arena_stats",
+        "Prints how much of the frame arena the last frame used, and the most any frame has used",
+        +[]() {
+            const raoe::frame_arena& arena = raoe::frame_arena::main();
+            const raoe::frame_arena::frame_stats& last_frame = arena.last_frame();
+            spdlog::info("Frame arena: last frame {} bytes ({} from the heap), high water mark {} bytes, capacity {} bytes",
+                last_frame.bytes, last_frame.overflow_bytes, arena.high_water_mark(), arena.capacity());
+        }
+    );
+}
@@ -0,0 +1,124 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "engine.hpp"
+#include "profile.hpp"
+#include "startup_trace.hpp"
+#include "string.hpp"
+#include "console/command.hpp"
+
+#include <charconv>
+#include <fstream>
+
+namespace RAOE::Debug
+{
+    void export_profile(std::string_view args)
+    {
+        std::string_view path = raoe::string::trim(args);
+        if(path.empty())
+        {
+            path = "profile.json";
+        }
+
+        std::ofstream file{std::string(path)};
+        if(!file)
+        {
+            spdlog::error("profile_export: unable to open {} for writing", path);
+            return;
+        }
+
+        const std::vector<raoe::profile::thread_capture> captures = raoe::profile::capture();
+        raoe::profile::write_chrome_trace(file, captures);
+
+        size_t event_count = 0;
+        for(const auto& captured : captures)
+        {
+            event_count += captured.events.size();
+        }
+        spdlog::info("profile_export: wrote {} zones from {} threads to {}", event_count, captures.size(), path);
+    }
+
+    void export_startup_trace(std::string_view args)
+    {
+        std::string_view path = raoe::string::trim(args);
+        if(path.empty())
+        {
+            path = "startup_trace.json";
+        }
+
+        std::ofstream file{std::string(path)};
+        if(!file)
+        {
+            spdlog::error("startup_trace_export: unable to open {} for writing", path);
+            return;
+        }
+
+        const std::vector<raoe::startup_trace::span> spans = raoe::startup_trace::spans();
+        raoe::startup_trace::write_chrome_trace(file, spans);
+        spdlog::info("startup_trace_export: wrote {} spans to {}{}", spans.size(), path, raoe::startup_trace::recording() ? " (startup isn't finished yet)" : "");
+    }
+
+    void print_startup_summary(std::string_view args)
+    {
+        const std::string_view count_arg = raoe::string::trim(args);
+        size_t count = 20;
+        if(!count_arg.empty() && std::from_chars(count_arg.data(), count_arg.data() + count_arg.size(), count).ec != std::errc())
+        {
+            spdlog::error("startup_summary: expected a number of spans to show, got {}", count_arg);
+            return;
+        }
+
+        const std::vector<raoe::startup_trace::span> spans = raoe::startup_trace::sorted_by_duration(raoe::startup_trace::spans());
+        spdlog::info("   | {:>10} | {:<9}| {}", "ms", "Category", "Span");
+        for(size_t i = 0; i < spans.size() && i < count; i++)
+        {
+            const double ms = static_cast<double>(spans[i].end - spans[i].start) * raoe::profile::ns_per_tick() / 1'000'000.0;
+            spdlog::info("   | {:>10.3f} | {:<9}| {}", ms, spans[i].category, spans[i].name);
+        }
+        if(spans.size() > count)
+        {
+            spdlog::info("   ({} shorter spans not shown)", spans.size() - count);
+        }
+    }
+
+    using RAOE::Console::AutoRegisterConsoleCommand;
+    static const AutoRegisterConsoleCommand profile_export_command = RAOE::Console::CreateConsoleCommand(
+        "profile_export",
+        "Writes the recorded profile zones to a Chrome trace file (default: profile.json)",
+        export_profile
+    );
+
+    static const AutoRegisterConsoleCommand profile_toggle_command = RAOE::Console::CreateConsoleCommand(
+        "profile_toggle",
+        "Pauses or resumes recording profile zones",
+        +[]() {
+            raoe::profile::set_enabled(!raoe::profile::enabled());
+            spdlog::info("Profiling {}", raoe::profile::enabled() ? "enabled" : "paused");
+        }
+    );
+
+    static const AutoRegisterConsoleCommand startup_trace_export_command = RAOE::Console::CreateConsoleCommand(
+        "startup_trace_export",
+        "Writes the startup timeline to a Chrome trace file (default: startup_trace.json)",
+        export_startup_trace
+    );
+
+    static const AutoRegisterConsoleCommand startup_summary_command = RAOE::Console::CreateConsoleCommand(
+        "startup_summary",
+        "Lists the longest spans of the startup timeline (default: 20)",
+        print_startup_summary
+    );
+}
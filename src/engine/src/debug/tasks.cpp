@@ -0,0 +1,76 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "engine.hpp"
+#include "profile.hpp"
+#include "services/task_service.hpp"
+#include "console/command.hpp"
+#include "string.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace RAOE::Debug
+{
+    void print_task_report(RAOE::Engine& engine, std::string_view args)
+    {
+        const std::string_view count_arg = raoe::string::trim(args);
+        size_t count = 20;
+        if(!count_arg.empty() && std::from_chars(count_arg.data(), count_arg.data() + count_arg.size(), count).ec != std::errc())
+        {
+            spdlog::error("tasks: expected a number of tasks to show, got {}", count_arg);
+            return;
+        }
+
+        auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+        if(!task_service)
+        {
+            spdlog::error("tasks: there is no task service");
+            return;
+        }
+
+        //Most expensive first
+        std::vector<RAOE::task_stats> stats = task_service->collect_task_stats();
+        std::ranges::stable_sort(stats, std::ranges::greater(), &RAOE::task_stats::total_ticks);
+
+        const double ms_per_tick = raoe::profile::ns_per_tick() / 1'000'000.0;
+        spdlog::info("   | {:>10} | {:>8} | {:>8} | {:<10} | {:<7} | {:<20} | {}", "Total ms", "Max ms", "Resumes", "Priority", "Phase", "Waiting On", "Task");
+        for(size_t i = 0; i < stats.size() && i < count; i++)
+        {
+            const RAOE::task_stats& task = stats[i];
+            spdlog::info("   | {:>10.3f} | {:>8.3f} | {:>8} | {:<10} | {:<7} | {:<20} | {}{}",
+                static_cast<double>(task.total_ticks) * ms_per_tick,
+                static_cast<double>(task.max_ticks) * ms_per_tick,
+                task.resumes,
+                RAOE::task_priority_name(task.priority),
+                RAOE::task_phase_name(task.phase),
+                task.waiting_on != nullptr ? task.waiting_on : "-",
+                task.label(),
+                task.finished ? " (finished)" : "");
+        }
+        if(stats.size() > count)
+        {
+            spdlog::info("   ({} cheaper tasks not shown)", stats.size() - count);
+        }
+    }
+
+    using RAOE::Console::AutoRegisterConsoleCommand;
+    static const AutoRegisterConsoleCommand tasks_command = RAOE::Console::CreateConsoleCommand(
+        "tasks",
+        "Lists the tasks that have taken the most time, pending and recently finished (default: 20).  See the task_stats cvar",
+        print_task_report
+    );
+}
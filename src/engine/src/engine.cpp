@@ -16,10 +16,13 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "engine.hpp"
 #include <cassert>
+#include "profile.hpp"
+#include "frame_arena.hpp"
 #include "cogs/cog.hpp"
 
 #include "console/console.hpp"
 #include "console/command.hpp"
+#include "console/cvar.hpp"
 
 #include "services/task_service.hpp"
 #include "cogs/cog_service.hpp"
@@ -63,17 +66,7 @@ namespace RAOE
         { 
             if(std::shared_ptr<RAOE::Service::GearService> gear_service = for_cog.engine().get_service<RAOE::Service::GearService>().lock())
             {
-                for(const auto& [_, gear_ptr] : gear_service->all_gears())
-                {
-                    if(gear_ptr && &gear_ptr->cog() == &for_cog)
-                    {
-                        if(auto task_service = for_cog.engine().get_service<RAOE::Service::TaskService>().lock())
-                        {
-                            task_service->enqueue_startup_tasks(*gear_ptr.get());
-                        }
-                        gear_ptr->activated();
-                    }
-                } 
+                gear_service->activate_gears(for_cog);
             }          
         };
 
@@ -81,13 +74,7 @@ namespace RAOE
         { 
             if(std::shared_ptr<RAOE::Service::GearService> gear_service = for_cog.engine().get_service<RAOE::Service::GearService>().lock())
             {
-                for(const auto& [_, gear_ptr] : gear_service->all_gears())
-                {
-                    if(gear_ptr && &gear_ptr->cog() == &for_cog)
-                    {
-                        gear_ptr->deactivated();
-                    }
-                }   
+                gear_service->deactivate_gears(for_cog);
             }
         };
 
@@ -96,7 +83,7 @@ namespace RAOE
         };
     }
 
-    using AutoRegisterConsoleCommand = RAOE::Console::AutoRegisterConsoleCommand;
+    using RAOE::Console::AutoRegisterConsoleCommand;
     static const AutoRegisterConsoleCommand quit_command = RAOE::Console::CreateConsoleCommand(
         "quit",
         "Exits the game",
@@ -132,10 +119,25 @@ namespace RAOE
         init_service<RAOE::Service::TaskService>();
         init_service<RAOE::Service::GearService>();
         init_service<RAOE::Resource::Service>();        
+
+        //Every cvar is registered by static initialization, so the saved config can be applied in one pass
+        RAOE::Console::load_cvars(RAOE::Console::cvar_config_path());
+
+        //Shared cogs are only listed here, and loaded when something requires them
+        if(auto cog_service = get_service<RAOE::Service::CogService>().lock())
+        {
+            if(const std::filesystem::path manifest_path = RAOE::Cogs::cog_manifest_path(); std::filesystem::exists(manifest_path))
+            {
+                cog_service->load_manifest(manifest_path);
+            }
+        }
     }
 
     Engine::Engine()    
     {
+        //Everything logs through the async pipeline from here on
+        raoe::log::init_async();
+
         init_service<RAOE::Service::CogService>();
 
         if(auto cog_service = get_service<RAOE::Service::CogService>().lock())
@@ -165,7 +167,8 @@ namespace RAOE
         
         if(std::shared_ptr<RAOE::Service::CogService> cog_service = get_service<RAOE::Service::CogService>().lock())
         {
-            cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, TransitionFunc::register_gears);
+            //Gears are built in parallel, then activated on this thread, each cog after the cogs it depends on
+            cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, TransitionFunc::register_gears, RAOE::Cogs::ETransitionThreading::Parallel);
             cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, TransitionFunc::activate_gears);
         }
         else
@@ -183,6 +186,7 @@ namespace RAOE
 
     bool Engine::Run()    
     {       
+        RAOE_PROFILE_SCOPE("Frame");
 
         std::shared_ptr<RAOE::Service::TaskService> task_service = get_service<RAOE::Service::TaskService>().lock();
         if(!task_service)
@@ -193,6 +197,24 @@ namespace RAOE
 
         task_service->process_tasks();
 
+        //Between tasks, so nothing from a shared cog is running while it's swapped out
+        if(std::shared_ptr<RAOE::Service::CogService> cog_service = get_service<RAOE::Service::CogService>().lock())
+        {
+            cog_service->reload_changed_cogs();
+        }
+
+        //Anything that changed a cvar this frame gets its callback now, on the main thread
+        RAOE::Console::flush_cvar_changes();
+
+        //Anything allocated in the frame arena two frames ago is no longer in use
+        raoe::frame_arena::main().end_frame();
+
+        //The startup trace covers everything up to the end of the first frame
+        if(raoe::startup_trace::recording())
+        {
+            raoe::startup_trace::finish();
+        }
+
         return m_should_shutdown;
     }
 
@@ -210,6 +232,20 @@ namespace RAOE
             spdlog::error("Unable to shut down engine cleanly, cog service doesn't exist");
             return;
         }
+
+        if(!RAOE::Console::save_cvars(RAOE::Console::cvar_config_path()))
+        {
+            spdlog::warn("Unable to save cvars to {}", RAOE::Console::cvar_config_path().string());
+        }
+
+        //Their gears, commands and cvars are gone after this, so it comes after anything that might use them
+        if(std::shared_ptr<RAOE::Service::CogService> cog_service = get_service<RAOE::Service::CogService>().lock())
+        {
+            cog_service->unload_shared_cogs();
+        }
+
+        //Logging is asynchronous, make sure the writer gets everything out before we exit
+        raoe::log::flush_all();
     }
 
  
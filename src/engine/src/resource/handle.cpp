@@ -21,6 +21,7 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "engine.hpp"
 #include "resource/type.hpp"
 #include "resource/locator.hpp"
+#include "startup_trace.hpp"
 
 #include <fstream>
 
@@ -42,18 +43,21 @@ namespace RAOE::Resource
 
     void Handle::load_resource_synchronously()    
     {   
+        const raoe::startup_trace::scoped_span span("resource", std::string_view(tag()));
         std::vector<RAOE::Resource::ResolvedResource> resolved_resources;
         RAOE::Resource::ResourceResolver resolver {};
     
         resolver(shared_from_this(), std::back_inserter(resolved_resources));
         if(resolved_resources.empty())
         {
-            spdlog::error("Attempted to load {} but no file found", tag());
+            RAOE_LOG_ERROR(LogResource, "Attempted to load {} but no file found", tag());
             return;
         }
 
         const RAOE::Resource::ResolvedResource& resolved_resource = resolved_resources[0];
 
+        //Whatever the loader allocates belongs to the resource type it's loading
+        const raoe::memory::scoped_tag memory_tag("resource:" + std::string(std::string_view(resolved_resource.filetype)));
         std::ifstream file(resolved_resource.resolved_path.string());
         std::shared_ptr<IResource> resource = resolved_resource.loader->load_resource(file);
         file.close();
@@ -62,11 +66,11 @@ namespace RAOE::Resource
             service()->emplaced_owned_resource(tag(), resource, resolved_resource.filetype);
             m_resource = resource;
             m_resource_type = resolved_resource.filetype;
-            spdlog::info("Loaded: {} as a {} from path {}", tag(), resource_type(), resolved_resource.resolved_path.string());
+            RAOE_LOG_INFO(LogResource, "Loaded: {} as a {} from path {}", tag(), resource_type(), resolved_resource.resolved_path.string());
         }
         else
         {
-            spdlog::error("Failed to load {}, loader {} failed to load", tag(), resolved_resource.loader->tag());
+            RAOE_LOG_ERROR(LogResource, "Failed to load {}, loader {} failed to load", tag(), resolved_resource.loader->tag());
         }
 
     }
@@ -24,6 +24,7 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "console/command.hpp"
 
 #include "resource/assets/text_asset.hpp"
+#include "console/script.hpp"
 
 namespace RAOE::Resource
 {
@@ -56,6 +57,9 @@ namespace RAOE::Resource
         init_resource_type(Asset::Tags::TextAsset);
         create_loader_for_type<Asset::TextAssetLoader>(Asset::Tags::TextAsset);       
 
+        init_resource_type(RAOE::Console::Tags::Script);
+        create_loader_for_type<RAOE::Console::ScriptLoader>(RAOE::Console::Tags::Script);
+
     }
 
     std::shared_ptr<Handle> Service::get_resource(const Tag& tag)
@@ -65,8 +69,7 @@ namespace RAOE::Resource
 
     std::weak_ptr<Handle> Service::get_resource_weak(const Tag& tag) const    
     {
-        auto found_handle = m_handle_map.find(tag);
-        return found_handle != m_handle_map.find(tag) ? found_handle->second : std::weak_ptr<Handle>();
+        return m_handle_map.find(tag).value_or(std::weak_ptr<Handle>());
     }
 
     std::shared_ptr<Handle> Service::load_resource(const Tag& tag)    
@@ -88,7 +91,7 @@ namespace RAOE::Resource
         }
         else
         {
-            spdlog::warn("Tried to emplace resource with unknown type {}.  Defaulting to raoe:type/unknown", resource_type);
+            RAOE_LOG_WARN(LogResource, "Tried to emplace resource with unknown type {}.  Defaulting to raoe:type/unknown", resource_type);
         }
   
         handle->m_resource = resource;
@@ -132,36 +135,63 @@ namespace RAOE::Resource
 
     std::shared_ptr<Handle> Service::find_or_create_handle(const Tag& tag)    
     {   
-        auto found_handle = m_handle_map.find(tag);
-        if(found_handle != m_handle_map.end())
+        //Most lookups find a live handle, and only need the shard for reading
+        std::shared_ptr<Handle> live_handle = m_handle_map.with_shard_shared(tag, [&tag](const auto& handles) {
+            auto found_handle = handles.find(tag);
+            return found_handle != handles.end() ? found_handle->second.lock() : std::shared_ptr<Handle>();
+        });
+        if(live_handle)
         {
-            auto weak_handle = found_handle->second;
-            if(std::shared_ptr<Handle> strong_handle = weak_handle.lock())
+            return live_handle;
+        }
+
+        //Look again with the shard locked for writing, in case another thread created it in between
+        std::shared_ptr<Handle> handle;
+        m_handle_map.with_shard(tag, [&](auto& handles) {
+            auto found_handle = handles.find(tag);
+            if(found_handle != handles.end())
             {
-                return strong_handle;
+                handle = found_handle->second.lock();
             }
-        }        
-
-        std::shared_ptr<Handle> handle = std::shared_ptr<Handle>(new Handle(*this, tag, Tag("raoe:type/unknown")));
-        m_handle_map.insert_or_assign(tag, handle);
+            if(!handle)
+            {
+                handle = std::shared_ptr<Handle>(new Handle(*this, tag, Tag("raoe:type/unknown")));
+                handles.insert_or_assign(tag, handle);
+            }
+        });
         return handle;
     }
+
+    std::vector<std::shared_ptr<Handle>> Service::handles() const
+    {
+        std::vector<std::shared_ptr<Handle>> live_handles;
+        m_handle_map.for_each([&live_handles](const Tag&, const std::weak_ptr<Handle>& weak_handle) {
+            if(std::shared_ptr<Handle> handle = weak_handle.lock())
+            {
+                live_handles.push_back(std::move(handle));
+            }
+        });
+        return live_handles;
+    }
+
+    std::vector<std::shared_ptr<Handle>> Service::handles_of_type(const Tag& resource_type) const
+    {
+        std::vector<std::shared_ptr<Handle>> typed_handles = handles();
+        std::erase_if(typed_handles, [&resource_type](const std::shared_ptr<Handle>& handle) { return handle->resource_type() != resource_type; });
+        return typed_handles;
+    }
    
     void Service::pin_resource(Handle* handle)    
     {   
         if(handle != nullptr)
         {
-            auto found_handle = m_handle_map.find(handle->tag());
-            if(found_handle != m_handle_map.end())
+            if(std::shared_ptr<Handle> shared_handle = get_resource_weak(handle->tag()).lock())
             {
-                if(auto shared_handle = found_handle->second.lock())
-                {
-                    m_pinned_resources.insert_or_assign(handle->tag(), found_handle->second.lock());
-                    return;
-                }            
+                m_pinned_resources.insert_or_assign(handle->tag(), std::move(shared_handle));
+                return;
             }
         }        
-        spdlog::error("Service::pin_resource: unable to pin resource {}, handle not valid.", handle->tag());
+        RAOE_LOG_ERROR(LogResource, "Service::pin_resource: unable to pin resource {}, handle not valid.", handle ? std::string_view(handle->tag()) : std::string_view("(null)"));
     }
 
 
@@ -189,12 +219,9 @@ namespace RAOE::Resource
         if(std::shared_ptr<Service> resource_service = engine.get_service<Service>().lock())
         {
             spdlog::info("   | {:<25}|{:<25}|{:^8}|{:^8}|", "Name", "Type", "Loaded", "Pinned");
-            for(const auto& [tag, handle] : resource_service->m_handle_map)
+            for(const std::shared_ptr<Handle>& handle : resource_service->handles())
             {
-                if(auto strong_handle = handle.lock())
-                {
-                    spdlog::info("   | {:<25}|{:<25}|{:^8}|{:^8}|", tag, strong_handle->resource_type(), strong_handle->loaded(), resource_service->m_pinned_resources.contains(tag));
-                }            
+                spdlog::info("   | {:<25}|{:<25}|{:^8}|{:^8}|", handle->tag(), handle->resource_type(), handle->loaded(), resource_service->m_pinned_resources.contains(handle->tag()));
             }
         }      
         else
@@ -202,7 +229,7 @@ namespace RAOE::Resource
             spdlog::error("print_handle_information: Unable to find resource service");
         }  
     }
-    using AutoRegisterConsoleCommand = RAOE::Console::AutoRegisterConsoleCommand;
+    using RAOE::Console::AutoRegisterConsoleCommand;
     static const AutoRegisterConsoleCommand print_handle_info_command = RAOE::Console::CreateConsoleCommand(
         "print_resource_info",
         "Prints resources to the console, in the format [Tag] - [LoadStatus]",
@@ -22,7 +22,7 @@ namespace RAOE::Resource
     {    
         if(loader.expired())
         {
-            spdlog::error("Attempted to add a loader to type {} but it was expired", tag());
+            RAOE_LOG_ERROR(LogResource, "Attempted to add a loader to type {} but it was expired", tag());
             return;
         }
         //clean up the loaders, removing any if they've expired
@@ -17,43 +17,372 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "services/task_service.hpp"
 #include "engine.hpp"
+#include "profile.hpp"
+#include "startup_trace.hpp"
+#include "console/cvar.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <type_traits>
 
 namespace RAOE::Service
 {
+    static const RAOE::Console::AutoRegisterCVar<float> cvar_task_background_budget = RAOE::Console::CreateCVar<float>(
+        "task_background_budget_ms",
+        "How many milliseconds background tasks may take each frame, between them, before the rest wait for the next frame",
+        2.0F
+    );
+
+    static const RAOE::Console::AutoRegisterCVar<bool> cvar_task_stats = RAOE::Console::CreateCVar<bool>(
+        "task_stats",
+        "Times every task resume, for the tasks command and panel",
+        true
+    );
+
+    namespace
+    {
+        thread_local RAOE::task_stats* t_resuming_stats = nullptr;
+    }
+
     void TaskService::process_tasks()
     {
-        for(const raoe::lazy<>& task : m_task_list)
+        RAOE_PROFILE_SCOPE("TaskService::process_tasks");
+        run_posted_work();
+
+        //Timed in profile ticks, which are much cheaper to read than a clock.  Converting the budget costs one clock read a frame.
+        //Only the time background tasks take is charged to it, so slow critical and frame tasks don't eat into it
+        const double budget_ns = static_cast<double>(std::max(cvar_task_background_budget.get(), 0.0F)) * 1'000'000.0;
+        const uint64 budget_ticks = static_cast<uint64>(budget_ns / raoe::profile::ns_per_tick());
+        uint64 background_ticks = 0;
+        const bool record_stats = cvar_task_stats.get();
+
+        for(size_t phase = 0; phase < PhaseCount; phase++)
+        {
+            run_tasks(m_task_lists[list_index({ RAOE::ETaskPriority::Critical, static_cast<RAOE::ETaskPhase>(phase) })], record_stats);
+            run_tasks(m_task_lists[list_index({ RAOE::ETaskPriority::Frame, static_cast<RAOE::ETaskPhase>(phase) })], record_stats);
+            run_background_tasks(m_task_lists[list_index({ RAOE::ETaskPriority::Background, static_cast<RAOE::ETaskPhase>(phase) })], budget_ticks, background_ticks, record_stats);
+        }
+    }
+
+    void TaskService::resume_task(scheduled_task& scheduled, bool record_stats)
+    {
+        RAOE_PROFILE_SCOPE("TaskService::resume");
+        RAOE::task_stats& stats = scheduled.stats;
+        const bool timed = record_stats && stats.resumes % RAOE::task_stats::StatsSampleInterval == 0;
+        const uint64 start = timed ? raoe::profile::now_ticks() : 0;
+        {
+            const raoe::memory::scoped_tag memory_tag(scheduled.memory_tag);
+            RAOE::task_stats* const outer_stats = std::exchange(t_resuming_stats, record_stats ? &stats : nullptr);
+            stats.waiting_on = nullptr;
+            scheduled.task.resume();
+            t_resuming_stats = outer_stats;
+        }
+
+        if(record_stats)
+        {
+            stats.resumes++;
+        }
+        if(timed)
+        {
+            const uint64 elapsed = raoe::profile::now_ticks() - start;
+            stats.timed_resumes++;
+            stats.timed_ticks += elapsed;
+            stats.max_ticks = std::max(stats.max_ticks, elapsed);
+        }
+    }
+
+    void TaskService::run_tasks(std::list<scheduled_task>& task_list, bool record_stats)
+    {
+        for(scheduled_task& scheduled : task_list)
         {
-            if(!task.done())
+            if(!scheduled.task.done())
             {
-                task.resume();
+                resume_task(scheduled, record_stats);
             }
         }
 
-        //Remove all done tasks
-        m_task_list.remove_if([](const raoe::lazy<>& task){ return task.done(); });
+        remove_finished_tasks(task_list, record_stats);
     }
 
-    void TaskService::add_task(raoe::lazy<>&& task)    
+    void TaskService::run_background_tasks(std::list<scheduled_task>& task_list, uint64 budget_ticks, uint64& spent_ticks, bool record_stats)
+    {
+        //At least one runs, even over budget, so background work always makes progress
+        const uint64 start = raoe::profile::now_ticks();
+        uint64 ticks = start;
+        auto scheduled = task_list.begin();
+        while(scheduled != task_list.end())
+        {
+            if(!scheduled->task.done())
+            {
+                resume_task(*scheduled, record_stats);
+            }
+            ++scheduled;
+            ticks = raoe::profile::now_ticks();
+            if(spent_ticks + (ticks - start) >= budget_ticks)
+            {
+                break;
+            }
+        }
+        spent_ticks += ticks - start;
+
+        //The ones that ran go to the back, so the ones that didn't are first in line next frame
+        task_list.splice(task_list.end(), task_list, task_list.begin(), scheduled);
+        remove_finished_tasks(task_list, record_stats);
+    }
+
+    void TaskService::remove_finished_tasks(std::list<scheduled_task>& task_list, bool record_stats)
+    {
+        task_list.remove_if([this, record_stats](const scheduled_task& scheduled) {
+            if(!scheduled.task.done())
+            {
+                return false;
+            }
+            if(record_stats)
+            {
+                RAOE::task_stats finished = scheduled.stats;
+                finished.finished = true;
+                finished.waiting_on = nullptr;
+                if(m_finished_stats.size() < FinishedStatsCapacity)
+                {
+                    m_finished_stats.push_back(finished);
+                }
+                else
+                {
+                    m_finished_stats[m_next_finished] = finished;
+                }
+                m_next_finished = (m_next_finished + 1) % FinishedStatsCapacity;
+            }
+            return true;
+        });
+    }
+
+    void TaskService::add_task(raoe::lazy<>&& task, RAOE::task_options options, std::source_location location)
     {   
-        m_task_list.emplace_back(std::move(task));
+        //The task lists aren't locked.  Traps in debug builds if another thread gets here instead of using post_to_main
+        raoe::debug::debug_break_if(on_main_thread());
+        RAOE::task_stats stats { .name = options.name, .location = location, .priority = options.priority, .phase = options.phase };
+        m_task_lists[list_index(options)].emplace_back(scheduled_task { std::move(task), raoe::memory::active_tag(), stats });
+    }
+
+    size_t TaskService::task_count() const
+    {
+        size_t count = 0;
+        for(const std::list<scheduled_task>& task_list : m_task_lists)
+        {
+            count += task_list.size();
+        }
+        return count;
+    }
+
+    std::vector<RAOE::task_stats> TaskService::collect_task_stats() const
+    {
+        std::vector<RAOE::task_stats> stats;
+        stats.reserve(task_count() + m_finished_stats.size());
+        for(const std::list<scheduled_task>& task_list : m_task_lists)
+        {
+            for(const scheduled_task& scheduled : task_list)
+            {
+                stats.push_back(scheduled.stats);
+            }
+        }
+        //Oldest first
+        for(size_t i = 0; i < m_finished_stats.size(); i++)
+        {
+            stats.push_back(m_finished_stats[(m_next_finished + i) % m_finished_stats.size()]);
+        }
+
+        //Each timed resume stands in for the untimed ones around it
+        for(RAOE::task_stats& task : stats)
+        {
+            task.total_ticks = task.timed_resumes > 0 ? task.timed_ticks * task.resumes / task.timed_resumes : 0;
+        }
+        return stats;
+    }
+
+    void TaskService::post_to_main(std::function<void()> func)
+    {
+        post(posted_work { std::move(func), raoe::memory::active_tag(), {}, {} });
+    }
+
+    void TaskService::post_to_main(raoe::lazy<>&& task, RAOE::task_options options, std::source_location location)
+    {
+        if(on_main_thread())
+        {
+            add_task(std::move(task), options, location);
+            return;
+        }
+        post(posted_work { std::move(task), raoe::memory::active_tag(), options, location });
+    }
+
+    void TaskService::post_to_main(std::coroutine_handle<> continuation)
+    {
+        post(posted_work { continuation, raoe::memory::active_tag(), {}, {} });
+    }
+
+    void TaskService::post(posted_work&& posted)
+    {
+        if(on_main_thread())
+        {
+            m_main_posted_work.push_back(std::move(posted));
+            return;
+        }
+        //try_push only takes the work if there's room for it
+        while(!m_posted_work.try_push(std::move(posted)))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void TaskService::run_posted_work()
+    {
+        RAOE_PROFILE_SCOPE("TaskService::run_posted_work");
+        auto run = [this](posted_work& posted) {
+            const raoe::memory::scoped_tag memory_tag(posted.memory_tag);
+            std::visit([this, &posted](auto& work) {
+                using work_type = std::decay_t<decltype(work)>;
+                if constexpr(std::is_same_v<work_type, raoe::lazy<>>)
+                {
+                    add_task(std::move(work), posted.options, posted.location);
+                }
+                else if constexpr(std::is_same_v<work_type, std::coroutine_handle<>>)
+                {
+                    work.resume();
+                }
+                else
+                {
+                    work();
+                }
+            }, posted.work);
+        };
+
+        //At most a queue's worth, so threads that keep posting can't hold up the frame forever
+        for(size_t i = 0; i < PostedWorkCapacity; i++)
+        {
+            std::optional<posted_work> posted = m_posted_work.try_pop();
+            if(!posted)
+            {
+                break;
+            }
+            run(*posted);
+        }
+
+        //Anything this posts waits for the next frame
+        m_running_posted_work.swap(m_main_posted_work);
+        for(posted_work& posted : m_running_posted_work)
+        {
+            run(posted);
+        }
+        m_running_posted_work.clear();
+    }
+
+    void TaskService::discard_tasks()
+    {
+        for(std::list<scheduled_task>& task_list : m_task_lists)
+        {
+            task_list.clear();
+        }
+        m_finished_stats.clear();
+        m_next_finished = 0;
+        //Posted coroutine handles belong to the lazies they were started from, so they're dropped here, not destroyed
+        while(m_posted_work.try_pop())
+        {
+        }
+        m_main_posted_work.clear();
     }
 
-    void TaskService::append_tasks(std::list<raoe::lazy<>>& in_list)    
+    namespace
     {
-        for(raoe::lazy<>& task : in_list)
+        raoe::lazy<> traced_startup_task(raoe::lazy<> task, std::string name)
         {
-            add_task(std::move(task));
+            RAOE_STARTUP_TRACE_SCOPE("task", name);
+            co_await task;
+        }
+    }
+
+    void TaskService::enqueue_startup_tasks(task_provider& provider, std::string_view trace_name)
+    {
+        if(raoe::startup_trace::recording())
+        {
+            for(task_provider::provided_task& provided : provider.m_startup_tasks)
+            {
+                add_task(traced_startup_task(std::move(provided.task), std::string(trace_name)), { .name = provided.name }, provided.location);
+            }
+            provider.m_startup_tasks.clear();
+            return;
+        }
+        append_tasks(provider.m_startup_tasks);
+    }
+
+    void TaskService::append_tasks(std::list<task_provider::provided_task>& in_list)    
+    {
+        for(task_provider::provided_task& provided : in_list)
+        {
+            add_task(std::move(provided.task), { .name = provided.name }, provided.location);
         }       
         in_list.clear();    
     }
 
 }
 
-void RAOE::enqueue_task(RAOE::Engine& engine, raoe::lazy<>&& task)
+std::string_view RAOE::task_priority_name(ETaskPriority priority)
+{
+    switch(priority)
+    {
+        case ETaskPriority::Critical: return "Critical";
+        case ETaskPriority::Frame: return "Frame";
+        case ETaskPriority::Background: return "Background";
+    }
+    return "Unknown";
+}
+
+std::string_view RAOE::task_phase_name(ETaskPhase phase)
+{
+    switch(phase)
+    {
+        case ETaskPhase::PreECS: return "PreECS";
+        case ETaskPhase::ECS: return "ECS";
+        case ETaskPhase::PostECS: return "PostECS";
+    }
+    return "Unknown";
+}
+
+std::string RAOE::task_stats::label() const
+{
+    if(name != nullptr)
+    {
+        return name;
+    }
+    const std::string_view file = location.file_name();
+    const size_t last_slash = file.find_last_of("/\\");
+    return fmt::format("{}:{}", last_slash == std::string_view::npos ? file : file.substr(last_slash + 1), location.line());
+}
+
+void RAOE::task_waiting_on(const char* reason) noexcept
+{
+    if(RAOE::Service::t_resuming_stats != nullptr)
+    {
+        RAOE::Service::t_resuming_stats->waiting_on = reason;
+    }
+}
+
+void RAOE::enqueue_task(RAOE::Engine& engine, raoe::lazy<>&& task, task_options options, std::source_location location)
+{
+    if(auto task_service = engine.get_service<RAOE::Service::TaskService>().lock())
+    {
+        task_service->post_to_main(std::move(task), options, location);
+    }
+}
+
+void RAOE::post_to_main(RAOE::Engine& engine, std::function<void()> func)
 {
     if(auto task_service = engine.get_service<RAOE::Service::TaskService>().lock())
     {
-        task_service->add_task(std::move(task));
+        task_service->post_to_main(std::move(func));
     }
 }
+
+RAOE::main_thread_awaiter RAOE::on_main_thread(RAOE::Engine& engine)
+{
+    return main_thread_awaiter { engine.get_service<RAOE::Service::TaskService>().lock().get() };
+}
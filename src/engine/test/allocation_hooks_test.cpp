@@ -0,0 +1,80 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "memory_tracking.hpp"
+#include <memory>
+
+namespace
+{
+    int64 live_bytes(raoe::memory::tag_id id)
+    {
+        for(const raoe::memory::tag_report& report : raoe::memory::report())
+        {
+            if(report.id == id)
+            {
+                return report.live_bytes;
+            }
+        }
+        return 0;
+    }
+
+    struct alignas(64) over_aligned
+    {
+        std::byte data[64];
+    };
+}
+
+TEST(AllocationHooks, NewIsChargedToTheActiveTag)
+{
+    if(!raoe::memory::tracking_global_allocations())
+    {
+        GTEST_SKIP() << "Engine built without RAOE_TRACK_GLOBAL_ALLOCATIONS";
+    }
+
+    const raoe::memory::tag_id tag = raoe::memory::register_tag("test:global_new");
+    std::unique_ptr<int32[]> values;
+    {
+        const raoe::memory::scoped_tag scope(tag);
+        values = std::make_unique<int32[]>(1000);
+    }
+    EXPECT_GE(live_bytes(tag), 1000 * sizeof(int32));
+
+    //Freeing outside of the scope still credits the tag that made the allocation
+    values.reset();
+    EXPECT_EQ(live_bytes(tag), 0);
+}
+
+TEST(AllocationHooks, OverAlignedNew)
+{
+    if(!raoe::memory::tracking_global_allocations())
+    {
+        GTEST_SKIP() << "Engine built without RAOE_TRACK_GLOBAL_ALLOCATIONS";
+    }
+
+    const raoe::memory::tag_id tag = raoe::memory::register_tag("test:aligned_new");
+    std::unique_ptr<over_aligned> value;
+    {
+        const raoe::memory::scoped_tag scope(tag);
+        value = std::make_unique<over_aligned>();
+    }
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(value.get()) % 64, 0);
+    EXPECT_EQ(live_bytes(tag), sizeof(over_aligned));
+    value.reset();
+    EXPECT_EQ(live_bytes(tag), 0);
+}
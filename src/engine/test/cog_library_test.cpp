@@ -0,0 +1,232 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "cogs/cog_service.hpp"
+#include "cogs/gear_service.hpp"
+#include "services/task_service.hpp"
+#include "console/command.hpp"
+#include "console/cvar.hpp"
+#include "engine.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace CogLibraryTest
+{
+    using RAOE::Console::AutoRegisterConsoleCommand;
+
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) {}
+    };
+
+    //The test cog runs these from its gear, so they count what happened inside the library
+    int32 activated_count = 0;
+    int32 deactivated_count = 0;
+    static const AutoRegisterConsoleCommand activated_command = RAOE::Console::CreateConsoleCommand(
+        "cog_library_test_activated",
+        "counts test cog activations",
+        +[]() { activated_count++; }
+    );
+    int32 restored_activations = 0;
+    static const AutoRegisterConsoleCommand restored_command = RAOE::Console::CreateConsoleCommand(
+        "cog_library_test_restored",
+        "records the state a reloaded test cog gear got back",
+        +[](int32 activations) { restored_activations = activations; }
+    );
+    static const AutoRegisterConsoleCommand deactivated_command = RAOE::Console::CreateConsoleCommand(
+        "cog_library_test_deactivated",
+        "counts test cog deactivations",
+        +[]() { deactivated_count++; }
+    );
+}
+
+TEST(CogLibrary, ParsesManifest)
+{
+    const std::string_view text =
+        "# name library dependencies...\n"
+        "\n"
+        "Pong raoe-cog-Pong.so Framework  Flecs\r\n"
+        "   Framework\traoe-cog-Framework.so\n"
+        "Broken\n";
+
+    const std::vector<RAOE::Cogs::CogManifestEntry> entries = RAOE::Cogs::parse_cog_manifest(text, "cogs");
+
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].name, "Pong");
+    EXPECT_EQ(entries[0].library, std::filesystem::path("cogs") / "raoe-cog-Pong.so");
+    EXPECT_THAT(entries[0].dependencies, testing::ElementsAre("Framework", "Flecs"));
+    EXPECT_EQ(entries[1].name, "Framework");
+    EXPECT_EQ(entries[1].library, std::filesystem::path("cogs") / "raoe-cog-Framework.so");
+    EXPECT_TRUE(entries[1].dependencies.empty());
+}
+
+TEST(CogLibrary, MissingCogsFailToLoad)
+{
+    CogLibraryTest::Engine engine;
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    ASSERT_TRUE(cog_service);
+
+    EXPECT_TRUE(cog_service->require_cog("NotInTheManifest").expired());
+
+    cog_service->add_manifest_entry({ "NoLibrary", "cogs/does-not-exist.so", {} });
+    EXPECT_TRUE(cog_service->require_cog("NoLibrary").expired());
+
+    //A cycle is caught before anything is opened
+    cog_service->add_manifest_entry({ "A", "cogs/a.so", { "B" } });
+    cog_service->add_manifest_entry({ "B", "cogs/b.so", { "A" } });
+    EXPECT_TRUE(cog_service->require_cog("A").expired());
+    EXPECT_FALSE(cog_service->is_shared_cog("A"));
+}
+
+#if !defined(_WIN32) && defined(RAOE_TEST_COG_PATH)
+TEST(CogLibrary, LoadsAndUnloads)
+{
+    CogLibraryTest::Engine engine;
+    engine.init_service<RAOE::Service::TaskService>();
+    engine.init_service<RAOE::Service::GearService>();
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    auto gear_service = engine.get_service<RAOE::Service::GearService>().lock();
+    ASSERT_TRUE(cog_service && gear_service);
+
+    //Start up like the engine does, so the cog has to catch up when it's loaded
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+    cog_service->add_manifest_entry({ "TestCog", RAOE_TEST_COG_PATH, {} });
+
+    CogLibraryTest::activated_count = 0;
+    CogLibraryTest::deactivated_count = 0;
+    const size_t gears_before = gear_service->all_gears().size();
+
+    //Twice, so a reload shows the unload left nothing behind
+    for(int32 i = 0; i < 2; i++)
+    {
+        std::shared_ptr<RAOE::Cogs::BaseCog> cog = cog_service->require_cog("TestCog").lock();
+        ASSERT_TRUE(cog);
+        EXPECT_EQ(cog->name(), "TestCog");
+        EXPECT_EQ(cog->status(), RAOE::Cogs::ECogStatus::Activated);
+        EXPECT_TRUE(cog_service->is_shared_cog("TestCog"));
+        EXPECT_EQ(cog_service->require_cog("TestCog").lock(), cog);
+        EXPECT_EQ(CogLibraryTest::activated_count, i + 1);
+        EXPECT_EQ(gear_service->all_gears().size(), gears_before + 1);
+        EXPECT_EQ(RAOE::Console::execute(engine, "test_cog_command"), RAOE::Console::EConsoleError::None);
+        cog.reset();
+
+        cog_service->unload_shared_cogs();
+        EXPECT_EQ(CogLibraryTest::deactivated_count, i + 1);
+        EXPECT_TRUE(cog_service->find_cog("TestCog").expired());
+        EXPECT_FALSE(cog_service->is_shared_cog("TestCog"));
+        EXPECT_EQ(gear_service->all_gears().size(), gears_before);
+        EXPECT_EQ(RAOE::Console::execute(engine, "test_cog_command"), RAOE::Console::EConsoleError::Command_Not_Found);
+    }
+}
+
+TEST(CogLibrary, AppliesConfigToItsCVars)
+{
+    CogLibraryTest::Engine engine;
+    engine.init_service<RAOE::Service::TaskService>();
+    engine.init_service<RAOE::Service::GearService>();
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    ASSERT_TRUE(cog_service);
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+    cog_service->add_manifest_entry({ "TestCog", RAOE_TEST_COG_PATH, {} });
+
+    //The config was read before the cog was loaded, so it has to be read again for the cog's cvars
+    const std::filesystem::path config = RAOE::Console::cvar_config_path();
+    ASSERT_FALSE(std::filesystem::exists(config));
+    {
+        std::ofstream file(config);
+        file << "test_cog_cvar 42\n";
+    }
+
+    ASSERT_FALSE(cog_service->require_cog("TestCog").expired());
+    const auto* cvar = dynamic_cast<const RAOE::Console::ICVar*>(RAOE::Console::CommandRegistry::Get().find("test_cog_cvar"));
+    ASSERT_NE(cvar, nullptr);
+    EXPECT_EQ(cvar->value_string(), "42");
+
+    cog_service->unload_shared_cogs();
+    std::filesystem::remove(config);
+}
+
+TEST(CogLibrary, Reloads)
+{
+    CogLibraryTest::Engine engine;
+    engine.init_service<RAOE::Service::TaskService>();
+    engine.init_service<RAOE::Service::GearService>();
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+    ASSERT_TRUE(cog_service && task_service);
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+
+    //Watch a copy, so the test can change it
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "raoe-cog-library-test";
+    const std::filesystem::path library = directory / std::filesystem::path(RAOE_TEST_COG_PATH).filename();
+    std::filesystem::create_directories(directory);
+    std::filesystem::copy_file(RAOE_TEST_COG_PATH, library, std::filesystem::copy_options::overwrite_existing);
+    cog_service->add_manifest_entry({ "TestCog", library, {} });
+
+    CogLibraryTest::activated_count = 0;
+    CogLibraryTest::restored_activations = 0;
+    ASSERT_FALSE(cog_service->require_cog("TestCog").expired());
+    task_service->process_tasks();
+
+    //By hand.  The gear's state comes back before it's activated again, and so do the cog's cvars
+    EXPECT_EQ(RAOE::Console::execute(engine, "test_cog_cvar 7"), RAOE::Console::EConsoleError::None);
+    EXPECT_TRUE(cog_service->reload_cog("TestCog"));
+    const auto* cvar = dynamic_cast<const RAOE::Console::ICVar*>(RAOE::Console::CommandRegistry::Get().find("test_cog_cvar"));
+    ASSERT_NE(cvar, nullptr);
+    EXPECT_EQ(cvar->value_string(), "7");
+    EXPECT_EQ(CogLibraryTest::restored_activations, 1);
+    EXPECT_EQ(CogLibraryTest::activated_count, 2);
+    EXPECT_EQ(cog_service->find_cog("TestCog").lock()->status(), RAOE::Cogs::ECogStatus::Activated);
+    EXPECT_EQ(RAOE::Console::execute(engine, "test_cog_command"), RAOE::Console::EConsoleError::None);
+    //The old library's task was dropped, the new one's runs
+    task_service->process_tasks();
+
+    //When the library changes, once it's settled
+    std::filesystem::last_write_time(library, std::filesystem::last_write_time(library) + std::chrono::seconds(10));
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(CogLibraryTest::activated_count < 3 && std::chrono::steady_clock::now() < give_up)
+    {
+        cog_service->reload_changed_cogs();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(CogLibraryTest::activated_count, 3);
+    EXPECT_EQ(CogLibraryTest::restored_activations, 2);
+    task_service->process_tasks();
+
+    //Nothing changed since, so nothing reloads
+    std::this_thread::sleep_for(RAOE::Service::CogService::ReloadPollInterval * 3);
+    cog_service->reload_changed_cogs();
+    EXPECT_EQ(CogLibraryTest::activated_count, 3);
+
+    //The copies were made in a directory of this process's own, which goes with them
+    cog_service->unload_shared_cogs();
+    EXPECT_FALSE(std::filesystem::exists(std::filesystem::temp_directory_path() / "raoe-cogs" / std::to_string(getpid())));
+    std::filesystem::remove_all(directory);
+}
+#endif
@@ -0,0 +1,246 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "cogs/cog_service.hpp"
+#include "cogs/gear_service.hpp"
+#include "cogs/gear.hpp"
+#include "engine.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace CogServiceTest
+{
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) {}
+    };
+
+    //What each cog saw when its gears were built
+    struct Record
+    {
+        std::string name;
+        std::thread::id thread;
+        std::vector<std::string> done_before; //cogs that had finished when this one started
+    };
+
+    std::mutex record_mutex;
+    std::vector<Record> records;
+    std::vector<std::string> finished;
+
+    //A and B wait here for each other, so they only both get through if they run at the same time
+    std::atomic<int32> rendezvous = 0;
+    bool use_rendezvous = true;
+    bool wait_for_both()
+    {
+        if(!use_rendezvous)
+        {
+            return false;
+        }
+        rendezvous++;
+        const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(rendezvous.load() < 2 && std::chrono::steady_clock::now() < give_up)
+        {
+            std::this_thread::yield();
+        }
+        return rendezvous.load() >= 2;
+    }
+    std::atomic<int32> overlapped = 0;
+
+    template<typename CogType>
+    struct TestGear : public RAOE::Cogs::Gear
+    {
+        TestGear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
+            : RAOE::Cogs::Gear(in_cog, in_name)
+        {
+        }
+    };
+
+    template<size_t N>
+    struct TestCog : public RAOE::Cogs::BaseCog
+    {
+        TestCog(RAOE::Engine& in_engine, std::string_view in_name, std::array<std::string_view, N> in_dependencies, bool in_main_thread_only, bool in_rendezvous)
+            : RAOE::Cogs::BaseCog(in_engine, in_name)
+            , m_dependencies(in_dependencies)
+            , m_main_thread_only(in_main_thread_only)
+            , m_rendezvous(in_rendezvous)
+        {
+        }
+
+        void register_gears() override
+        {
+            {
+                const std::scoped_lock lock(record_mutex);
+                records.push_back(Record { std::string(name()), std::this_thread::get_id(), finished });
+            }
+            if(m_rendezvous && wait_for_both())
+            {
+                overlapped++;
+            }
+            register_gear();
+            const std::scoped_lock lock(record_mutex);
+            finished.emplace_back(name());
+        }
+
+        virtual void register_gear() = 0;
+
+        [[nodiscard]] std::span<const std::string_view> dependencies() const override { return m_dependencies; }
+        [[nodiscard]] bool main_thread_only() const override { return m_main_thread_only; }
+
+        std::array<std::string_view, N> m_dependencies;
+        bool m_main_thread_only;
+        bool m_rendezvous;
+    };
+
+    //A and B don't depend on anything, C needs both, and the main thread cog M needs A
+    struct CogA : TestCog<0>
+    {
+        explicit CogA(RAOE::Engine& in_engine) : TestCog(in_engine, "A:cog", {}, false, true) {}
+        void register_gear() override { engine().get_service<RAOE::Service::GearService>().lock()->register_gear<TestGear<CogA>>(*this, "GearA", RAOE::Cogs::EGearStartup::Eager); }
+    };
+    struct CogB : TestCog<0>
+    {
+        explicit CogB(RAOE::Engine& in_engine) : TestCog(in_engine, "B:cog", {}, false, true) {}
+        void register_gear() override { engine().get_service<RAOE::Service::GearService>().lock()->register_gear<TestGear<CogB>>(*this, "GearB", RAOE::Cogs::EGearStartup::Eager); }
+    };
+    struct CogC : TestCog<3>
+    {
+        explicit CogC(RAOE::Engine& in_engine) : TestCog(in_engine, "C:cog", { "B", "A", "NotRegistered" }, false, false) {}
+        void register_gear() override { engine().get_service<RAOE::Service::GearService>().lock()->register_gear<TestGear<CogC>>(*this, "GearC", RAOE::Cogs::EGearStartup::Eager); }
+    };
+    struct CogM : TestCog<1>
+    {
+        explicit CogM(RAOE::Engine& in_engine) : TestCog(in_engine, "M:cog", { "A" }, true, false) {}
+        void register_gear() override { engine().get_service<RAOE::Service::GearService>().lock()->register_gear<TestGear<CogM>>(*this, "GearM", RAOE::Cogs::EGearStartup::Eager); }
+    };
+
+    void register_cogs(RAOE::Service::CogService& cog_service, bool in_use_rendezvous = true)
+    {
+        use_rendezvous = in_use_rendezvous;
+        records.clear();
+        finished.clear();
+        rendezvous = 0;
+        overlapped = 0;
+        cog_service.register_static_cog<CogC>();
+        cog_service.register_static_cog<CogM>();
+        cog_service.register_static_cog<CogB>();
+        cog_service.register_static_cog<CogA>();
+    }
+
+    const Record& record_of(std::string_view name)
+    {
+        auto itr = std::ranges::find(records, name, &Record::name);
+        EXPECT_NE(itr, records.end()) << name;
+        return *itr;
+    }
+}
+
+TEST(CogService, DependencyOrder)
+{
+    CogServiceTest::Engine engine;
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    CogServiceTest::register_cogs(*cog_service);
+
+    std::vector<std::string_view> order;
+    for(const auto& cog : cog_service->dependency_order())
+    {
+        order.push_back(cog->name());
+    }
+    ASSERT_EQ(order.size(), 4);
+    auto position = [&](std::string_view name) { return std::ranges::find(order, name) - order.begin(); };
+    EXPECT_LT(position("A"), position("C"));
+    EXPECT_LT(position("B"), position("C"));
+    EXPECT_LT(position("A"), position("M"));
+}
+
+TEST(CogService, ParallelTransitionFollowsDependencies)
+{
+    CogServiceTest::Engine engine;
+    engine.init_service<RAOE::Service::GearService>();
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    auto gear_service = engine.get_service<RAOE::Service::GearService>().lock();
+    CogServiceTest::register_cogs(*cog_service);
+
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears, RAOE::Cogs::ETransitionThreading::Parallel);
+
+    using testing::Contains;
+    ASSERT_EQ(CogServiceTest::records.size(), 4);
+    EXPECT_EQ(CogServiceTest::overlapped.load(), 2) << "A and B should have built their gears at the same time";
+    EXPECT_THAT(CogServiceTest::record_of("C").done_before, testing::IsSupersetOf({ "A", "B" }));
+    EXPECT_THAT(CogServiceTest::record_of("M").done_before, Contains("A"));
+    EXPECT_EQ(CogServiceTest::record_of("M").thread, std::this_thread::get_id());
+
+    for(const std::string_view name : { "A", "B", "C", "M" })
+    {
+        std::shared_ptr<RAOE::Cogs::BaseCog> cog = cog_service->find_cog(name).lock();
+        ASSERT_TRUE(cog);
+        EXPECT_EQ(cog->status(), RAOE::Cogs::ECogStatus::PreActivate);
+        ASSERT_EQ(gear_service->gears_of(*cog).size(), 1);
+        EXPECT_EQ(&gear_service->gears_of(*cog).front()->cog(), cog.get());
+    }
+    EXPECT_EQ(gear_service->all_gears().size(), 4);
+}
+
+TEST(CogService, MainThreadTransitionFollowsDependencies)
+{
+    CogServiceTest::Engine engine;
+    engine.init_service<RAOE::Service::GearService>();
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    //One at a time, A and B can't meet
+    CogServiceTest::register_cogs(*cog_service, false);
+
+    cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+
+    ASSERT_EQ(CogServiceTest::records.size(), 4);
+    for(const CogServiceTest::Record& record : CogServiceTest::records)
+    {
+        EXPECT_EQ(record.thread, std::this_thread::get_id());
+    }
+    EXPECT_THAT(CogServiceTest::record_of("C").done_before, testing::IsSupersetOf({ "A", "B" }));
+    EXPECT_THAT(CogServiceTest::record_of("M").done_before, testing::Contains("A"));
+}
+
+TEST(CogService, ParallelTransitionRethrowsWhatACogThrew)
+{
+    CogServiceTest::Engine engine;
+    engine.init_service<RAOE::Service::GearService>();
+    auto cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+    CogServiceTest::register_cogs(*cog_service, false);
+
+    //B throws on whichever thread picks it up, and C, which needs it, never starts
+    std::mutex ran_mutex;
+    std::vector<std::string> ran;
+    auto transition = [&](RAOE::Cogs::BaseCog& cog) {
+        {
+            const std::scoped_lock lock(ran_mutex);
+            ran.emplace_back(cog.name());
+        }
+        if(cog.name() == "B")
+        {
+            throw std::runtime_error("B failed");
+        }
+    };
+    EXPECT_THROW(cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, transition, RAOE::Cogs::ETransitionThreading::Parallel), std::runtime_error);
+    EXPECT_THAT(ran, testing::Contains("B"));
+    EXPECT_THAT(ran, testing::Not(testing::Contains("C")));
+}
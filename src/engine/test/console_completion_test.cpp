@@ -0,0 +1,156 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "console/console.hpp"
+#include "console/command.hpp"
+#include "console/completion.hpp"
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+
+using namespace std::literals::string_view_literals;
+
+namespace ConsoleCompletionTest
+{
+    void noop() {}
+
+    void register_command(RAOE::Console::CommandRegistry& registry, std::string name)
+    {
+        //Commands view their names, so keep them somewhere that outlives the registry
+        static std::deque<std::string> owned_names;
+        registry.register_console_element(std::make_unique<RAOE::Console::ConsoleCommandWithArgs<>>(owned_names.emplace_back(std::move(name)), "test command", noop));
+    }
+
+    std::vector<std::string_view> names(std::span<RAOE::Console::IConsoleElement* const> elements)
+    {
+        std::vector<std::string_view> result;
+        for(const RAOE::Console::IConsoleElement* element : elements)
+        {
+            result.push_back(element->name());
+        }
+        return result;
+    }
+
+    void register_defaults(RAOE::Console::CommandRegistry& registry)
+    {
+        for(const char* name : {"memory_report", "frame_arena_stats", "log_level", "exec", "cvars", "cvars_save", "profile_frame"})
+        {
+            register_command(registry, name);
+        }
+    }
+}
+
+TEST(ConsoleCompletion, PrefixRanksFirst)
+{
+    using namespace ConsoleCompletionTest;
+    RAOE::Console::CommandRegistry registry;
+    register_defaults(registry);
+    RAOE::Console::CompletionIndex index(registry);
+
+    EXPECT_THAT(names(index.query("cv")), testing::ElementsAre("cvars"sv, "cvars_save"sv));
+    EXPECT_THAT(names(index.query("frame")), testing::ElementsAre("frame_arena_stats"sv, "profile_frame"sv));
+    EXPECT_TRUE(index.query("").empty());
+}
+
+TEST(ConsoleCompletion, ToleratesTypos)
+{
+    using namespace ConsoleCompletionTest;
+    RAOE::Console::CommandRegistry registry;
+    register_defaults(registry);
+    RAOE::Console::CompletionIndex index(registry);
+
+    EXPECT_THAT(names(index.query("memroy_report")), testing::ElementsAre("memory_report"sv));
+    EXPECT_THAT(names(index.query("LOG_LEVEL trace")), testing::ElementsAre("log_level"sv));
+    EXPECT_TRUE(index.query("zzzzz").empty());
+}
+
+TEST(ConsoleCompletion, IncrementalMatchesFresh)
+{
+    using namespace ConsoleCompletionTest;
+    RAOE::Console::CommandRegistry registry;
+    register_defaults(registry);
+    RAOE::Console::CompletionIndex typed(registry);
+
+    const std::string_view final_query = "frame_arena"sv;
+    for(size_t length = 1; length <= final_query.size(); length++)
+    {
+        const std::vector<std::string_view> incremental = names(typed.query(final_query.substr(0, length)));
+        RAOE::Console::CompletionIndex fresh(registry);
+        EXPECT_EQ(incremental, names(fresh.query(final_query.substr(0, length)))) << final_query.substr(0, length);
+    }
+
+    //Backspacing isn't an extension, and starts over
+    RAOE::Console::CompletionIndex fresh(registry);
+    EXPECT_EQ(names(typed.query("fra")), names(fresh.query("fra")));
+}
+
+TEST(ConsoleCompletion, RebuildsWhenRegistryChanges)
+{
+    using namespace ConsoleCompletionTest;
+    RAOE::Console::CommandRegistry registry;
+    register_defaults(registry);
+    RAOE::Console::CompletionIndex index(registry);
+
+    EXPECT_THAT(names(index.query("exec")), testing::ElementsAre("exec"sv));
+    register_command(registry, "exec_all");
+    EXPECT_THAT(names(index.query("exec")), testing::ElementsAre("exec"sv, "exec_all"sv));
+}
+
+TEST(ConsoleCompletion, BoundedResults)
+{
+    using namespace ConsoleCompletionTest;
+    RAOE::Console::CommandRegistry registry;
+    for(int32 i = 0; i < 100; i++)
+    {
+        register_command(registry, fmt::format("bounded_{}", i));
+    }
+    RAOE::Console::CompletionIndex index(registry, 5);
+
+    EXPECT_THAT(names(index.query("bounded")), testing::ElementsAre("bounded_0"sv, "bounded_1"sv, "bounded_2"sv, "bounded_3"sv, "bounded_4"sv));
+}
+
+TEST(ConsoleCompletion, Benchmark)
+{
+    using namespace ConsoleCompletionTest;
+    RAOE::Console::CommandRegistry registry;
+    for(int32 i = 0; i < 5000; i++)
+    {
+        register_command(registry, fmt::format("subsystem_{}_command_{}", i % 50, i));
+    }
+    RAOE::Console::CompletionIndex index(registry);
+    EXPECT_FALSE(index.query("s").empty()); //Builds the index
+
+    //Typing a command out, one character at a time, then a frame of the same input
+    const std::string_view typed = "subsystem_7_command_4207"sv;
+    size_t matched = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(size_t length = 1; length <= typed.size(); length++)
+    {
+        matched += index.query(typed.substr(0, length)).size();
+        matched += index.query(typed.substr(0, length)).size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    //Every prefix matches at least the command being typed, twice
+    EXPECT_GE(matched, typed.size() * 2);
+    EXPECT_EQ(index.query(typed).front()->name(), typed);
+
+    std::cout << "Typed " << typed.size() << " characters against 5000 commands in " 
+        << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << "us" << std::endl;
+}
@@ -0,0 +1,171 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "console/cvar.hpp"
+#include "engine.hpp"
+
+#include <fstream>
+
+using namespace std::literals::string_view_literals;
+
+namespace ConsoleCVarTest
+{
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) {}
+    };
+
+    int32 notify_count = 0;
+    int32 last_notified = 0;
+    void on_changed(int32 value) 
+    { 
+        notify_count++;
+        last_notified = value;
+    }
+
+    static const RAOE::Console::AutoRegisterCVar<int32> cvar_test_int = RAOE::Console::CreateCVar<int32>(
+        "cvar_test_int",
+        "an int cvar for the cvar tests",
+        10,
+        on_changed
+    );
+
+    static const RAOE::Console::AutoRegisterCVar<bool> cvar_test_bool = RAOE::Console::CreateCVar<bool>(
+        "cvar_test_bool",
+        "a bool cvar for the cvar tests",
+        false
+    );
+}
+
+TEST(ConsoleCVar, SetThroughConsole)
+{
+    using namespace ConsoleCVarTest;
+    Engine e;
+    EXPECT_EQ(cvar_test_int.get(), 10);
+    EXPECT_EQ(RAOE::Console::execute(e, "cvar_test_int 25"sv), RAOE::Console::EConsoleError::None);
+    EXPECT_EQ(cvar_test_int.get(), 25);
+    EXPECT_EQ(RAOE::Console::execute(e, "cvar_test_bool on"sv), RAOE::Console::EConsoleError::None);
+    EXPECT_TRUE(cvar_test_bool.get());
+
+    //Bad values leave the cvar alone
+    RAOE::Console::execute(e, "cvar_test_int banana"sv);
+    RAOE::Console::execute(e, "cvar_test_int 1 2"sv);
+    EXPECT_EQ(cvar_test_int.get(), 25);
+
+    cvar_test_int.set(10);
+    cvar_test_bool.set(false);
+    RAOE::Console::flush_cvar_changes();
+}
+
+TEST(ConsoleCVar, CallbacksBatchedToFlush)
+{
+    using namespace ConsoleCVarTest;
+    RAOE::Console::flush_cvar_changes();
+    notify_count = 0;
+
+    cvar_test_int.set(1);
+    cvar_test_int.set(2);
+    cvar_test_int.set(3);
+    EXPECT_EQ(notify_count, 0);
+
+    RAOE::Console::flush_cvar_changes();
+    EXPECT_EQ(notify_count, 1);
+    EXPECT_EQ(last_notified, 3);
+
+    //Setting it away and back within a frame isn't a change
+    cvar_test_int.set(4);
+    cvar_test_int.set(3);
+    RAOE::Console::flush_cvar_changes();
+    EXPECT_EQ(notify_count, 1);
+
+    cvar_test_int.set(10);
+    RAOE::Console::flush_cvar_changes();
+}
+
+TEST(ConsoleCVar, SaveAndLoad)
+{
+    using namespace ConsoleCVarTest;
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "raoe_cvar_test.cfg";
+
+    cvar_test_int.set(42);
+    cvar_test_bool.set(true);
+    ASSERT_TRUE(RAOE::Console::save_cvars(path));
+
+    cvar_test_int.set(10);
+    cvar_test_bool.set(false);
+    {
+        std::ofstream append(path, std::ios::app);
+        append << "\n# hand written\nnot_a_cvar 1\n  cvar_test_bool   1  \n";
+    }
+    ASSERT_TRUE(RAOE::Console::load_cvars(path));
+    EXPECT_EQ(cvar_test_int.get(), 42);
+    EXPECT_TRUE(cvar_test_bool.get());
+    EXPECT_FALSE(RAOE::Console::load_cvars(path.parent_path() / "raoe_missing_cvar_file.cfg"));
+
+    std::filesystem::remove(path);
+    cvar_test_int.set(10);
+    cvar_test_bool.set(false);
+    RAOE::Console::flush_cvar_changes();
+}
+
+TEST(ConsoleCVar, SaveKeepsEntriesForUnregisteredCVars)
+{
+    using namespace ConsoleCVarTest;
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "raoe_cvar_keep_test.cfg";
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "// from a cog that isn't loaded\nunloaded_cog_cvar 7\n\ncvar_test_int 99\n";
+    }
+
+    cvar_test_int.set(42);
+    ASSERT_TRUE(RAOE::Console::save_cvars(path));
+
+    std::ifstream file(path);
+    const std::string contents { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    EXPECT_THAT(contents, testing::HasSubstr("// from a cog that isn't loaded\nunloaded_cog_cvar 7\n"));
+    EXPECT_THAT(contents, testing::HasSubstr("cvar_test_int 42\n"));
+    EXPECT_THAT(contents, testing::Not(testing::HasSubstr("cvar_test_int 99")));
+
+    std::filesystem::remove(path);
+    cvar_test_int.set(10);
+    RAOE::Console::flush_cvar_changes();
+}
+
+TEST(ConsoleCVar, DiscardedChangesDontNotify)
+{
+    using namespace ConsoleCVarTest;
+    RAOE::Console::flush_cvar_changes();
+    notify_count = 0;
+
+    cvar_test_int.set(5);
+    RAOE::Console::discard_cvar_change(cvar_test_int);
+    RAOE::Console::flush_cvar_changes();
+    EXPECT_EQ(notify_count, 0);
+
+    //It can still be queued again afterwards
+    cvar_test_int.set(10);
+    cvar_test_int.set(6);
+    RAOE::Console::flush_cvar_changes();
+    EXPECT_EQ(notify_count, 1);
+    EXPECT_EQ(last_notified, 6);
+
+    cvar_test_int.set(10);
+    RAOE::Console::flush_cvar_changes();
+}
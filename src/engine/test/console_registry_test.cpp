@@ -0,0 +1,238 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "console/console.hpp"
+#include "console/command.hpp"
+#include "engine.hpp"
+#include "services/task_service.hpp"
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+
+namespace ConsoleRegistryTest
+{
+    using RAOE::Console::AutoRegisterConsoleCommand;
+
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) {}
+    };
+
+    int32 dispatch_count = 0;
+    void count_dispatch() { dispatch_count++; }
+    void other_dispatch() {}
+
+    void register_command(RAOE::Console::CommandRegistry& registry, std::string name, void(*functor)())
+    {
+        //Commands view their names, so keep them somewhere that outlives the registry
+        static std::deque<std::string> owned_names;
+        registry.register_console_element(std::make_unique<RAOE::Console::ConsoleCommandWithArgs<>>(owned_names.emplace_back(std::move(name)), "test command", functor));
+    }
+
+    std::vector<std::string_view> names(std::span<RAOE::Console::IConsoleElement* const> elements)
+    {
+        std::vector<std::string_view> result;
+        for(const RAOE::Console::IConsoleElement* element : elements)
+        {
+            result.push_back(element->name());
+        }
+        return result;
+    }
+
+    int32 async_progress = 0;
+    static const AutoRegisterConsoleCommand async_command = RAOE::Console::CreateConsoleCommand(
+        "registry_test_async",
+        "takes a frame per step",
+        +[](int32 steps) -> raoe::lazy<> {
+            for(int32 i = 0; i < steps; i++)
+            {
+                async_progress++;
+                co_await std::suspend_always();
+            }
+        }
+    );
+    static const AutoRegisterConsoleCommand async_failing_command = RAOE::Console::CreateConsoleCommand(
+        "registry_test_async_failing",
+        "fails after a frame",
+        +[]() -> raoe::lazy<RAOE::Console::IConsoleElement::EExecuteError> {
+            co_await std::suspend_always();
+            async_progress = -1;
+            co_return RAOE::Console::IConsoleElement::EExecuteError::Command_Error;
+        }
+    );
+
+    int32 static_dispatch_count = 0;
+    static const AutoRegisterConsoleCommand static_first = RAOE::Console::CreateConsoleCommand(
+        "registry_test_static_first",
+        "statically registered",
+        +[]() { static_dispatch_count++; }
+    );
+    static const AutoRegisterConsoleCommand static_second = RAOE::Console::CreateConsoleCommand(
+        "registry_test_static_second",
+        "statically registered",
+        +[](int32 value) { static_dispatch_count += value; }
+    );
+}
+
+TEST(ConsoleRegistry, FindByName)
+{
+    using namespace ConsoleRegistryTest;
+    RAOE::Console::CommandRegistry registry;
+    register_command(registry, "alpha", other_dispatch);
+    register_command(registry, "beta", other_dispatch);
+
+    ASSERT_NE(registry.find("alpha"), nullptr);
+    EXPECT_EQ(registry.find("alpha")->name(), "alpha");
+    EXPECT_EQ(registry.find("alph"), nullptr);
+    EXPECT_EQ(registry.find("gamma"), nullptr);
+}
+
+TEST(ConsoleRegistry, FirstRegisteredNameWins)
+{
+    using namespace ConsoleRegistryTest;
+    Engine engine;
+    RAOE::Console::CommandRegistry registry;
+    dispatch_count = 0;
+    register_command(registry, "dup", count_dispatch);
+    register_command(registry, "dup", other_dispatch);
+
+    EXPECT_EQ(registry.execute(engine, "dup"), RAOE::Console::EConsoleError::None);
+    EXPECT_EQ(dispatch_count, 1);
+}
+
+TEST(ConsoleRegistry, PrefixCompletion)
+{
+    using namespace ConsoleRegistryTest;
+    RAOE::Console::CommandRegistry registry;
+    register_command(registry, "profile_toggle", other_dispatch);
+    register_command(registry, "print_resource_info", other_dispatch);
+    register_command(registry, "profile_export", other_dispatch);
+    register_command(registry, "profiler", other_dispatch);
+
+    EXPECT_THAT(names(registry.complete("prof")), testing::ElementsAre("profile_export", "profile_toggle", "profiler"));
+    EXPECT_THAT(names(registry.complete("pr")), testing::SizeIs(4));
+    EXPECT_THAT(names(registry.complete("x")), testing::IsEmpty());
+
+    //Registering again invalidates the completion order
+    const uint64 generation = registry.generation();
+    register_command(registry, "profile_a", other_dispatch);
+    EXPECT_NE(registry.generation(), generation);
+    EXPECT_THAT(names(registry.complete("profile_")), testing::ElementsAre("profile_a", "profile_export", "profile_toggle"));
+}
+
+TEST(ConsoleRegistry, StaticRegistration)
+{
+    using namespace ConsoleRegistryTest;
+    Engine engine;
+
+    //Static commands land in the global registry, in the order they were declared
+    RAOE::Console::CommandRegistry& registry = RAOE::Console::CommandRegistry::Get();
+    EXPECT_EQ(registry.find("registry_test_static_first"), &static_first);
+    EXPECT_EQ(registry.find("registry_test_static_second"), &static_second);
+    EXPECT_THAT(names(registry.complete("registry_test_static_")), testing::ElementsAre("registry_test_static_first", "registry_test_static_second"));
+    const auto elements = registry.elements();
+    EXPECT_LT(std::ranges::find(elements, &static_first), std::ranges::find(elements, &static_second));
+
+    static_dispatch_count = 0;
+    EXPECT_EQ(RAOE::Console::execute(engine, "registry_test_static_first"), RAOE::Console::EConsoleError::None);
+    EXPECT_EQ(RAOE::Console::execute(engine, "registry_test_static_second 4"), RAOE::Console::EConsoleError::None);
+    EXPECT_EQ(static_dispatch_count, 5);
+
+    //Other registries don't pick up static commands
+    RAOE::Console::CommandRegistry local_registry;
+    EXPECT_EQ(local_registry.find("registry_test_static_first"), nullptr);
+}
+
+TEST(ConsoleRegistry, AsyncCommands)
+{
+    using namespace ConsoleRegistryTest;
+    Engine engine;
+    engine.init_service<RAOE::Service::TaskService>();
+    std::shared_ptr task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    //Executing only starts the command, the task service runs it a frame at a time
+    async_progress = 0;
+    EXPECT_EQ(RAOE::Console::execute(engine, "registry_test_async 3"), RAOE::Console::EConsoleError::None);
+    EXPECT_EQ(async_progress, 0);
+    for(int32 frame = 1; frame <= 3; frame++)
+    {
+        task_service->process_tasks();
+        EXPECT_EQ(async_progress, frame);
+    }
+    task_service->process_tasks();
+
+    //Bad arguments are still reported immediately
+    EXPECT_EQ(RAOE::Console::execute(engine, "registry_test_async three"), RAOE::Console::EConsoleError::Incorrect_Arguments);
+
+    EXPECT_EQ(RAOE::Console::execute(engine, "registry_test_async_failing"), RAOE::Console::EConsoleError::None);
+    task_service->process_tasks();
+    task_service->process_tasks();
+    EXPECT_EQ(async_progress, -1);
+}
+
+TEST(ConsoleRegistry, ArgumentErrors)
+{
+    using namespace ConsoleRegistryTest;
+    using EExecuteError = RAOE::Console::IConsoleElement::EExecuteError;
+    Engine engine;
+
+    static int32 last_value = 0;
+    const RAOE::Console::ConsoleCommandWithArgs<RAOE::Engine&, int32, std::string_view> command("args", "test command",
+        +[](RAOE::Engine&, int32 value, std::string_view) { last_value = value; }
+    );
+
+    EXPECT_EQ(command.execute(engine, " 5 five"), EExecuteError::Success);
+    EXPECT_EQ(last_value, 5);
+    EXPECT_EQ(command.execute(engine, " 6"), EExecuteError::Missing_Arguments);
+    EXPECT_EQ(command.execute(engine, " six text"), EExecuteError::Invalid_Arguments);
+    EXPECT_EQ(command.execute(engine, " 6 text more"), EExecuteError::Too_Many_Arguments);
+    EXPECT_EQ(last_value, 5);
+}
+
+TEST(ConsoleRegistry, DispatchBenchmark)
+{
+    using namespace ConsoleRegistryTest;
+    constexpr int32 CommandCount = 2000;
+    constexpr int32 DispatchCount = 100000;
+
+    Engine engine;
+    RAOE::Console::CommandRegistry registry;
+    std::vector<std::string> command_names;
+    for(int32 i = 0; i < CommandCount; i++)
+    {
+        command_names.push_back(fmt::format("bench_command_{}", i));
+        register_command(registry, command_names.back(), count_dispatch);
+    }
+
+    dispatch_count = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(int32 i = 0; i < DispatchCount; i++)
+    {
+        //Stride through the registry so every lookup lands on a different command
+        const std::string& name = command_names[(static_cast<size_t>(i) * 7919) % CommandCount];
+        ASSERT_EQ(registry.execute(engine, name), RAOE::Console::EConsoleError::None);
+    }
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(dispatch_count, DispatchCount);
+    std::cout << fmt::format("[ BENCH    ] {} dispatches over {} commands: {:.2f} ms ({:.1f} ns/dispatch)", 
+        DispatchCount, CommandCount, elapsed.count(), elapsed.count() * 1000000.0 / DispatchCount) << std::endl;
+}
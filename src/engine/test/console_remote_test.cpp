@@ -0,0 +1,248 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "console/remote_console.hpp"
+#include "console/command.hpp"
+#include "engine.hpp"
+#include "spdlog/spdlog.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ConsoleRemoteTest
+{
+    using RAOE::Console::AutoRegisterConsoleCommand;
+
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) {}
+    };
+
+    int32 remote_total = 0;
+    static const AutoRegisterConsoleCommand remote_add = RAOE::Console::CreateConsoleCommand(
+        "remote_test_add",
+        "adds to a counter",
+        +[](int32 value) { remote_total += value; }
+    );
+    static const AutoRegisterConsoleCommand remote_say = RAOE::Console::CreateConsoleCommand(
+        "remote_test_say",
+        "logs its argument",
+        +[](std::string_view text) { spdlog::info("remote says {}", text); }
+    );
+
+    //The client end of a connection.  Reads whole lines, polling the console while it waits for them
+    class Client
+    {
+    public:
+        explicit Client(int in_socket) : m_socket(in_socket) {}
+        ~Client() { ::close(m_socket); }
+
+        void send(std::string_view text) { ASSERT_EQ(::send(m_socket, text.data(), text.size(), 0), static_cast<ssize_t>(text.size())); }
+
+        //Every line up to and including the first that starts with prefix, or everything read if it never came
+        std::vector<std::string> read_until(RAOE::Console::RemoteConsole& console, std::string_view prefix)
+        {
+            std::vector<std::string> lines;
+            const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while(std::chrono::steady_clock::now() < give_up)
+            {
+                console.poll();
+                char buffer[1024]; //NOLINT
+                const ssize_t received = ::recv(m_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if(received > 0)
+                {
+                    m_input.append(buffer, static_cast<size_t>(received));
+                }
+                for(size_t end = m_input.find('\n'); end != std::string::npos; end = m_input.find('\n'))
+                {
+                    lines.push_back(m_input.substr(0, end));
+                    m_input.erase(0, end + 1);
+                    if(lines.back().starts_with(prefix))
+                    {
+                        return lines;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return lines;
+        }
+
+    private:
+        int m_socket;
+        std::string m_input;
+    };
+
+    //Connects a client straight to the console, without a socket file
+    std::unique_ptr<Client> connect_pair(RAOE::Console::RemoteConsole& console)
+    {
+        int sockets[2] = { -1, -1 }; //NOLINT
+        if(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+        {
+            return nullptr;
+        }
+        console.adopt_client(sockets[0]);
+        return std::make_unique<Client>(sockets[1]);
+    }
+}
+
+TEST(RemoteConsole, ExecutesLines)
+{
+    using namespace ConsoleRemoteTest;
+    Engine engine;
+    RAOE::Console::RemoteConsole console(engine);
+    std::unique_ptr<Client> client = connect_pair(console);
+    ASSERT_NE(client, nullptr);
+
+    //A command split across sends only runs once its line is complete
+    remote_total = 0;
+    client->send("remote_test_a");
+    console.poll();
+    client->send("dd 4\r\nremote_test_add 3\nnot_a_command\nremote_test_add x\n");
+    EXPECT_THAT(client->read_until(console, "ok"), testing::Contains("ok remote_test_add 4"));
+    EXPECT_THAT(client->read_until(console, "ok"), testing::Contains("ok remote_test_add 3"));
+    EXPECT_THAT(client->read_until(console, "error"), testing::Contains("error not_found not_a_command"));
+    EXPECT_THAT(client->read_until(console, "error"), testing::Contains("error bad_arguments remote_test_add x"));
+    EXPECT_EQ(remote_total, 7);
+
+    client->send(":quit\nremote_test_add 100\n");
+    console.poll();
+    EXPECT_EQ(console.client_count(), 0);
+    EXPECT_EQ(remote_total, 7);
+}
+
+TEST(RemoteConsole, BatchReportsTimings)
+{
+    using namespace ConsoleRemoteTest;
+    Engine engine;
+    RAOE::Console::RemoteConsole console(engine);
+    std::unique_ptr<Client> client = connect_pair(console);
+    ASSERT_NE(client, nullptr);
+
+    //Nothing runs until the batch ends
+    remote_total = 0;
+    client->send(":batch\nremote_test_add 1\nnot_a_command\nremote_test_add 2\n");
+    console.poll();
+    EXPECT_EQ(remote_total, 0);
+
+    client->send(":end\n");
+    std::vector<std::string> lines = client->read_until(console, "batch");
+    std::erase_if(lines, [](const std::string& line) { return line.starts_with("log"); });
+    EXPECT_EQ(remote_total, 3);
+    ASSERT_THAT(lines, testing::SizeIs(4));
+    EXPECT_THAT(lines[0], testing::MatchesRegex("time 0 [0-9]+ ok remote_test_add 1"));
+    EXPECT_THAT(lines[1], testing::MatchesRegex("time 1 [0-9]+ not_found not_a_command"));
+    EXPECT_THAT(lines[2], testing::MatchesRegex("time 2 [0-9]+ ok remote_test_add 2"));
+    EXPECT_THAT(lines[3], testing::MatchesRegex("batch 3 [0-9]+"));
+}
+
+TEST(RemoteConsole, BatchesAreCapped)
+{
+    using namespace ConsoleRemoteTest;
+    Engine engine;
+    RAOE::Console::RemoteConsole console(engine);
+    std::unique_ptr<Client> client = connect_pair(console);
+    ASSERT_NE(client, nullptr);
+
+    //The command past the cap is refused on the spot, the rest still run when the batch ends
+    remote_total = 0;
+    std::string batch = ":batch\n";
+    for(size_t i = 0; i < RAOE::Console::RemoteConsole::MaxBatchCommands; i++)
+    {
+        batch += "remote_test_add 1\n";
+    }
+    client->send(batch);
+    client->send("remote_test_add 1000\n");
+    EXPECT_THAT(client->read_until(console, "error"), testing::Contains("error batch_full remote_test_add 1000"));
+
+    client->send(":end\n");
+    EXPECT_THAT(client->read_until(console, "batch"), testing::Contains(testing::MatchesRegex("batch 4096 [0-9]+")));
+    EXPECT_EQ(remote_total, static_cast<int32>(RAOE::Console::RemoteConsole::MaxBatchCommands));
+}
+
+TEST(RemoteConsole, DropsAClientWithALongLine)
+{
+    using namespace ConsoleRemoteTest;
+    Engine engine;
+    RAOE::Console::RemoteConsole console(engine);
+    std::unique_ptr<Client> client = connect_pair(console);
+    ASSERT_NE(client, nullptr);
+
+    //The line never ends, so the client goes as soon as it's too long
+    client->send(std::string(RAOE::Console::RemoteConsole::MaxLineLength + 1, 'x'));
+    console.poll();
+    EXPECT_EQ(console.client_count(), 0);
+}
+
+TEST(RemoteConsole, StreamsLogsOverASocketFile)
+{
+    using namespace ConsoleRemoteTest;
+    Engine engine;
+    RAOE::Console::RemoteConsole console(engine);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("raoe_remote_test_" + std::to_string(::getpid()) + ".sock");
+    ASSERT_TRUE(console.listen(path));
+    EXPECT_TRUE(std::filesystem::exists(path));
+    //Only this user may connect
+    EXPECT_EQ(std::filesystem::status(path).permissions() & std::filesystem::perms::all, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0); //NOLINT
+    Client client(socket);
+
+    client.send("remote_test_say hello\n");
+    EXPECT_THAT(client.read_until(console, "ok"), testing::Contains("ok remote_test_say hello"));
+    EXPECT_EQ(console.client_count(), 1);
+
+    //The log line comes from the logging thread, some time after the reply, and maybe after other log lines
+    std::vector<std::string> lines;
+    do
+    {
+        lines = client.read_until(console, "log");
+    } while(!lines.empty() && lines.back().find("remote says") == std::string::npos);
+    ASSERT_FALSE(lines.empty());
+    EXPECT_THAT(lines.back(), testing::HasSubstr("hello"));
+}
+
+TEST(RemoteConsole, WontReplaceAFileThatIsntASocket)
+{
+    using namespace ConsoleRemoteTest;
+    Engine engine;
+    RAOE::Console::RemoteConsole console(engine);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("raoe_remote_test_" + std::to_string(::getpid()) + ".txt");
+    {
+        std::ofstream file(path);
+        file << "not a socket";
+    }
+
+    EXPECT_FALSE(console.listen(path));
+    EXPECT_TRUE(std::filesystem::is_regular_file(path));
+    std::filesystem::remove(path);
+}
+#endif
@@ -0,0 +1,142 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "console/console.hpp"
+#include "console/command.hpp"
+#include "console/script.hpp"
+#include "engine.hpp"
+#include "resource/service.hpp"
+#include "resource/handle.hpp"
+
+using namespace std::literals::string_view_literals;
+
+namespace ConsoleScriptTest
+{
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) 
+        {
+            init_service<RAOE::Resource::Service>();
+        }
+    };
+
+    int32 total = 0;
+    void add(int32 value) { total += value; }
+
+    static const RAOE::Console::AutoRegisterConsoleCommand script_test_add = RAOE::Console::CreateConsoleCommand(
+        "script_test_add",
+        "adds to the console script test total",
+        add
+    );
+
+    std::shared_ptr<const RAOE::Console::Script> load_test_script(RAOE::Engine& engine)
+    {
+        std::shared_ptr resource_service = engine.get_service<RAOE::Resource::Service>().lock();
+        std::shared_ptr handle = resource_service->get_resource(RAOE::Resource::Tag("raoe:test/testscript"));
+        handle->load_resource_synchronously();
+        return handle->get<RAOE::Console::Script>().lock();
+    }
+}
+
+TEST(ConsoleScript, Compile)
+{
+    using namespace ConsoleScriptTest;
+    using EOp = RAOE::Console::Script::Instruction::EOp;
+    Engine e;
+    std::shared_ptr script = load_test_script(e);
+    ASSERT_TRUE(script);
+
+    const auto program = script->compiled();
+    ASSERT_EQ(program->size(), 5);
+    EXPECT_EQ((*program)[0].op, EOp::Execute);
+    EXPECT_EQ((*program)[0].element->name(), "script_test_add"sv);
+    EXPECT_EQ(script->arguments((*program)[0]), " 2"sv);
+    EXPECT_EQ((*program)[0].line, 2);
+    EXPECT_EQ(script->arguments((*program)[1]), "   3"sv);
+    EXPECT_EQ((*program)[1].line, 5);
+    EXPECT_EQ((*program)[2].op, EOp::Wait);
+    EXPECT_EQ((*program)[3].op, EOp::Unknown);
+    EXPECT_EQ(script->arguments((*program)[3]), "script_test_missing"sv);
+
+    //Compiled once, and reused until the registry changes
+    EXPECT_EQ(script->compiled(), program);
+    RAOE::Console::CommandRegistry local_registry;
+    EXPECT_NE(script->compiled(local_registry)->front().op, EOp::Execute);
+}
+
+TEST(ConsoleScript, RunsAcrossFrames)
+{
+    using namespace ConsoleScriptTest;
+    Engine e;
+    std::shared_ptr script = load_test_script(e);
+    ASSERT_TRUE(script);
+
+    total = 0;
+    raoe::lazy<> run = RAOE::Console::run_script(e, script);
+    run.resume();
+    EXPECT_EQ(total, 5); //Everything up to "wait 2"
+    run.resume();
+    EXPECT_FALSE(run.done());
+    run.resume();
+    EXPECT_EQ(total, 10);
+    EXPECT_TRUE(run.done());
+}
+
+TEST(ConsoleScript, ArgumentsAreParsedOnce)
+{
+    using namespace ConsoleScriptTest;
+    Engine e;
+    std::shared_ptr script = load_test_script(e);
+    ASSERT_TRUE(script);
+
+    //Both add lines share the registry's bound calls, which already hold the parsed value
+    const auto program = script->compiled();
+    const RAOE::Console::CommandRegistry& registry = RAOE::Console::CommandRegistry::Get();
+    EXPECT_EQ((*program)[0].call, &registry.bind(*(*program)[0].element, " 2"sv));
+    EXPECT_NE((*program)[0].call, (*program)[1].call);
+
+    total = 0;
+    EXPECT_EQ((*program)[1].call->execute(e), RAOE::Console::IConsoleElement::EExecuteError::Success);
+    EXPECT_EQ(total, 3);
+}
+
+TEST(ConsoleScript, RecompilesWhenTheRegistryChangesMidRun)
+{
+    using namespace ConsoleScriptTest;
+    Engine e;
+    std::shared_ptr script = load_test_script(e);
+    ASSERT_TRUE(script);
+
+    total = 0;
+    const auto before = script->compiled();
+    raoe::lazy<> run = RAOE::Console::run_script(e, script);
+    run.resume();
+    EXPECT_EQ(total, 5);
+
+    //The program the run started with is stale from here on
+    RAOE::Console::CommandRegistry::Get().register_console_element(
+        std::make_unique<RAOE::Console::ConsoleCommandWithArgs<int32>>("script_test_registered_mid_run", "does nothing", +[](int32) {})
+    );
+    run.resume();
+    run.resume();
+    EXPECT_TRUE(run.done());
+    EXPECT_EQ(total, 10);
+    EXPECT_NE(script->compiled(), before);
+}
@@ -0,0 +1,208 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "cogs/cog_service.hpp"
+#include "cogs/gear_service.hpp"
+#include "cogs/gear.hpp"
+#include "engine.hpp"
+#include "resource/handle.hpp"
+#include "resource/service.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace GearServiceTest
+{
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) {}
+    };
+
+    //What happened to the gears, in order
+    std::vector<std::string> events;
+
+    template<int32 N>
+    struct TestGear : public RAOE::Cogs::Gear
+    {
+        TestGear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
+            : RAOE::Cogs::Gear(in_cog, in_name)
+        {
+            events.push_back(std::string(in_name) + " built");
+        }
+        void activated() override { events.push_back(fmt::format("Gear{} activated", N)); }
+        void deactivated() override { events.push_back(fmt::format("Gear{} deactivated", N)); }
+    };
+    using LazyGear = TestGear<0>;
+    using EagerGear = TestGear<1>;
+    using NeededGear = TestGear<2>;
+    using UnusedGear = TestGear<3>;
+
+    struct NeedyGear : public TestGear<4>
+    {
+        using required_gears = std::tuple<NeededGear>;
+        using TestGear<4>::TestGear;
+    };
+
+    struct TestCog : public RAOE::Cogs::BaseCog
+    {
+        explicit TestCog(RAOE::Engine& in_engine)
+            : RAOE::Cogs::BaseCog(in_engine, "gears:cog")
+        {
+        }
+
+        void register_gears() override
+        {
+            auto gear_service = engine().get_service<RAOE::Service::GearService>().lock();
+            gear_service->register_gear<LazyGear>(*this, "Gear0");
+            EXPECT_FALSE(gear_service->register_gear<EagerGear>(*this, "Gear1", RAOE::Cogs::EGearStartup::Eager).expired());
+            gear_service->register_gear<NeededGear>(*this, "Gear2");
+            gear_service->register_gear<UnusedGear>(*this, "Gear3");
+            gear_service->register_gear<NeedyGear>(*this, "Gear4");
+            //Registering a type twice does nothing
+            EXPECT_TRUE(gear_service->register_gear<LazyGear>(*this, "Gear0").expired());
+        }
+    };
+
+    struct Fixture
+    {
+        Fixture()
+        {
+            events.clear();
+            engine.init_service<RAOE::Service::TaskService>();
+            engine.init_service<RAOE::Service::GearService>();
+            cog_service = engine.get_service<RAOE::Service::CogService>().lock();
+            gear_service = engine.get_service<RAOE::Service::GearService>().lock();
+            cog_service->register_static_cog<TestCog>();
+            cog = cog_service->find_cog("gears").lock();
+        }
+
+        Engine engine;
+        std::shared_ptr<RAOE::Service::CogService> cog_service;
+        std::shared_ptr<RAOE::Service::GearService> gear_service;
+        std::shared_ptr<RAOE::Cogs::BaseCog> cog;
+    };
+}
+
+TEST(GearService, OnlyEagerGearsAreBuiltAtStartup)
+{
+    GearServiceTest::Fixture test;
+    ASSERT_TRUE(test.cog);
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+
+    EXPECT_THAT(GearServiceTest::events, testing::ElementsAre("Gear1 built", "Gear1 activated"));
+    EXPECT_EQ(test.gear_service->gears_of(*test.cog).size(), 1);
+    EXPECT_EQ(test.gear_service->unbuilt_gear_count(), 4);
+}
+
+TEST(GearService, LazyGearsAreBuiltAndActivatedOnFirstAccess)
+{
+    GearServiceTest::Fixture test;
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+    GearServiceTest::events.clear();
+
+    std::shared_ptr<GearServiceTest::LazyGear> gear = test.gear_service->get_gear<GearServiceTest::LazyGear>().lock();
+    ASSERT_TRUE(gear);
+    EXPECT_EQ(test.gear_service->get_gear<GearServiceTest::LazyGear>().lock(), gear);
+    EXPECT_THAT(GearServiceTest::events, testing::ElementsAre("Gear0 built", "Gear0 activated"));
+
+    //Required gears are built first, and the tag finds gears that haven't been built yet
+    GearServiceTest::events.clear();
+    std::shared_ptr<RAOE::Cogs::Gear> needy = test.gear_service->get_gear(RAOE::Resource::Tag("gears:gear/Gear4")).lock();
+    ASSERT_TRUE(needy);
+    EXPECT_EQ(needy, test.gear_service->get_gear<GearServiceTest::NeedyGear>().lock());
+    EXPECT_THAT(GearServiceTest::events, testing::ElementsAre("Gear2 built", "Gear2 activated", "Gear4 built", "Gear4 activated"));
+    EXPECT_EQ(test.gear_service->unbuilt_gear_count(), 1);
+
+    //Only built gears are deactivated
+    GearServiceTest::events.clear();
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreShutdown, RAOE::TransitionFunc::ShutdownGears);
+    EXPECT_THAT(GearServiceTest::events, testing::UnorderedElementsAre("Gear0 deactivated", "Gear1 deactivated", "Gear2 deactivated", "Gear4 deactivated"));
+
+    EXPECT_EQ(test.gear_service->remove_gears(*test.cog), 4);
+    EXPECT_EQ(test.gear_service->unbuilt_gear_count(), 0);
+    EXPECT_TRUE(test.gear_service->get_gear<GearServiceTest::UnusedGear>().expired());
+    //Built gears are gone from the lookup snapshot too
+    gear.reset();
+    needy.reset();
+    EXPECT_TRUE(test.gear_service->get_gear<GearServiceTest::LazyGear>().expired());
+    EXPECT_TRUE(test.gear_service->get_gear(RAOE::Resource::Tag("gears:gear/Gear4")).expired());
+}
+
+TEST(GearService, GearsBuiltBeforeActivationWaitForTheirCog)
+{
+    GearServiceTest::Fixture test;
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    GearServiceTest::events.clear();
+
+    ASSERT_FALSE(test.gear_service->get_gear<GearServiceTest::LazyGear>().expired());
+    EXPECT_THAT(GearServiceTest::events, testing::ElementsAre("Gear0 built"));
+
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+    EXPECT_THAT(GearServiceTest::events, testing::ElementsAre("Gear0 built", "Gear1 activated", "Gear0 activated"));
+}
+
+TEST(GearService, EveryThreadGetsALazyGearBeingBuilt)
+{
+    GearServiceTest::Fixture test;
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::Activated, RAOE::TransitionFunc::activate_gears);
+
+    //Whichever thread doesn't build it has to wait for it, not find nothing
+    std::vector<std::shared_ptr<GearServiceTest::LazyGear>> found(8);
+    {
+        std::vector<std::jthread> threads;
+        for(size_t i = 0; i < found.size(); i++)
+        {
+            threads.emplace_back([&test, &found, i]() { found[i] = test.gear_service->get_gear<GearServiceTest::LazyGear>().lock(); });
+        }
+    }
+    for(const std::shared_ptr<GearServiceTest::LazyGear>& gear : found)
+    {
+        ASSERT_TRUE(gear);
+        EXPECT_EQ(gear, found.front());
+    }
+    EXPECT_EQ(std::ranges::count(GearServiceTest::events, std::string("Gear0 built")), 1);
+
+    //Built off the main thread, so it's activated on it, once the main thread gets to it
+    EXPECT_EQ(std::ranges::count(GearServiceTest::events, std::string("Gear0 activated")), 0);
+    test.engine.get_service<RAOE::Service::TaskService>().lock()->process_tasks();
+    EXPECT_EQ(std::ranges::count(GearServiceTest::events, std::string("Gear0 activated")), 1);
+}
+
+TEST(GearService, GearsBuiltOffTheMainThreadGetHandlesOnIt)
+{
+    GearServiceTest::Fixture test;
+    test.engine.init_service<RAOE::Resource::Service>();
+    std::shared_ptr<RAOE::Resource::Service> resource_service = test.engine.get_service<RAOE::Resource::Service>().lock();
+    test.cog_service->transition_cogs(RAOE::Cogs::ECogStatus::PreActivate, RAOE::TransitionFunc::register_gears);
+    EXPECT_EQ(resource_service->get_resource_weak(RAOE::Resource::Tag("gears:gear/Gear1")).lock()->resource_type(), RAOE::Resource::TypeTags::Gear);
+
+    //The handle is written on the main thread, once it gets to the work the building thread posted
+    std::jthread([&test]() { EXPECT_FALSE(test.gear_service->get_gear<GearServiceTest::LazyGear>().expired()); }).join();
+    EXPECT_TRUE(resource_service->get_resource_weak(RAOE::Resource::Tag("gears:gear/Gear0")).expired());
+    test.engine.get_service<RAOE::Service::TaskService>().lock()->process_tasks();
+    std::shared_ptr<RAOE::Resource::Handle> handle = resource_service->get_resource_weak(RAOE::Resource::Tag("gears:gear/Gear0")).lock();
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(handle->resource_type(), RAOE::Resource::TypeTags::Gear);
+}
@@ -0,0 +1,165 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "resource/service.hpp"
+#include "resource/handle.hpp"
+#include "resource/tag.hpp"
+#include "resource/type.hpp"
+#include "engine.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace ResourceServiceTest
+{
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {}) 
+        {
+            init_service<RAOE::Resource::Service>();
+        }
+    };
+
+    std::vector<RAOE::Resource::Tag> make_tags(std::string_view prefix, int32 count)
+    {
+        std::vector<RAOE::Resource::Tag> tags;
+        tags.reserve(count);
+        for(int32 i = 0; i < count; i++)
+        {
+            tags.emplace_back(prefix, fmt::format("resource/{}", i));
+        }
+        return tags;
+    }
+}
+
+TEST(ResourceService, GetResourceWeak)
+{
+    ResourceServiceTest::Engine engine;
+    auto service = engine.get_service<RAOE::Resource::Service>().lock();
+    ASSERT_TRUE(service);
+
+    const RAOE::Resource::Tag tag("test:resource/weak");
+    EXPECT_TRUE(service->get_resource_weak(tag).expired());
+    std::shared_ptr<RAOE::Resource::Handle> handle = service->get_resource(tag);
+    EXPECT_EQ(service->get_resource_weak(tag).lock(), handle);
+    EXPECT_EQ(service->get_resource(tag), handle);
+
+    EXPECT_THAT(service->handles(), testing::Contains(handle));
+    EXPECT_THAT(service->handles_of_type(RAOE::Resource::TypeTags::Unknown), testing::Contains(handle));
+    EXPECT_THAT(service->handles_of_type(RAOE::Resource::TypeTags::Type), testing::Not(testing::Contains(handle)));
+}
+
+TEST(ResourceService, ConcurrentLookupsAndInserts)
+{
+    ResourceServiceTest::Engine engine;
+    auto service = engine.get_service<RAOE::Resource::Service>().lock();
+    constexpr int32 thread_count = 8;
+    constexpr int32 shared_count = 512;
+    const std::vector<RAOE::Resource::Tag> shared_tags = ResourceServiceTest::make_tags("shared", shared_count);
+
+    //Every thread races to create the same handles, while also adding its own and reading the built in types
+    std::vector<std::vector<std::shared_ptr<RAOE::Resource::Handle>>> seen(thread_count);
+    std::atomic<int32> ready = 0;
+    {
+        std::vector<std::jthread> threads;
+        for(int32 t = 0; t < thread_count; t++)
+        {
+            threads.emplace_back([&, t]() {
+                const std::vector<RAOE::Resource::Tag> own_tags = ResourceServiceTest::make_tags(fmt::format("thread{}", t), 64);
+                ready++;
+                while(ready.load() < thread_count)
+                {
+                    std::this_thread::yield();
+                }
+                for(int32 i = 0; i < shared_count; i++)
+                {
+                    //Different threads walk the shared tags from different ends, so they meet in the middle
+                    const RAOE::Resource::Tag& tag = shared_tags[t % 2 == 0 ? i : shared_count - 1 - i];
+                    seen[t].push_back(service->get_resource(tag));
+                    EXPECT_FALSE(service->get_resource_weak(RAOE::Resource::TypeTags::Type).expired());
+                    if(i < static_cast<int32>(own_tags.size()))
+                    {
+                        service->get_resource(own_tags[i])->pin();
+                    }
+                }
+                std::ranges::sort(seen[t], {}, [](const auto& handle) { return std::string_view(handle->tag()); });
+            });
+        }
+    }
+
+    //They all got the same handle for each tag
+    for(int32 t = 1; t < thread_count; t++)
+    {
+        EXPECT_EQ(seen[t], seen[0]);
+    }
+    for(int32 t = 0; t < thread_count; t++)
+    {
+        EXPECT_FALSE(service->get_resource_weak(RAOE::Resource::Tag(fmt::format("thread{}", t), "resource/63")).expired()) << "pinned handles stay alive";
+    }
+}
+
+TEST(ResourceService, LookupBenchmark)
+{
+    ResourceServiceTest::Engine engine;
+    auto service = engine.get_service<RAOE::Resource::Service>().lock();
+    const std::vector<RAOE::Resource::Tag> tags = ResourceServiceTest::make_tags("bench", 4096);
+    std::vector<std::shared_ptr<RAOE::Resource::Handle>> handles;
+    for(const RAOE::Resource::Tag& tag : tags)
+    {
+        handles.push_back(service->get_resource(tag));
+    }
+
+    constexpr int32 lookups_per_thread = 200000;
+    double single_thread_rate = 0.0;
+    for(const int32 thread_count : { 1, 2, 4, 8, 16 })
+    {
+        std::atomic<int32> found = 0;
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(int32 t = 0; t < thread_count; t++)
+            {
+                threads.emplace_back([&, t]() {
+                    int32 thread_found = 0;
+                    for(int32 i = 0; i < lookups_per_thread; i++)
+                    {
+                        const RAOE::Resource::Tag& tag = tags[static_cast<size_t>(i * 7 + t * 131) % tags.size()];
+                        thread_found += service->get_resource_weak(tag).expired() ? 0 : 1;
+                    }
+                    found += thread_found;
+                });
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        EXPECT_EQ(found.load(), thread_count * lookups_per_thread);
+
+        const double rate = thread_count * lookups_per_thread / seconds;
+        if(thread_count == 1)
+        {
+            single_thread_rate = rate;
+        }
+        std::cout << thread_count << " threads: " << static_cast<int64>(rate / 1000.0) << "k lookups/s (" 
+            << rate / single_thread_rate << "x one thread)" << std::endl;
+    }
+}
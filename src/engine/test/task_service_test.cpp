@@ -0,0 +1,357 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "services/task_service.hpp"
+#include "console/console.hpp"
+#include "engine.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace TaskServiceTest
+{
+    class Engine : public RAOE::Engine
+    {
+    public:
+        Engine() : RAOE::Engine(RAOE::Engine::FromTest {})
+        {
+            init_service<RAOE::Service::TaskService>();
+        }
+    };
+
+    raoe::lazy<> record_thread(std::vector<std::thread::id>& threads)
+    {
+        threads.push_back(std::this_thread::get_id());
+        co_return;
+    }
+
+    //Records its name every frame, forever
+    raoe::lazy<> record_frames(std::vector<std::string>& ran, std::string name)
+    {
+        while(true)
+        {
+            ran.push_back(name);
+            co_await std::suspend_always();
+        }
+    }
+
+    //Says what it's waiting on, then waits a frame, frames times
+    raoe::lazy<> wait_frames(int32 frames)
+    {
+        for(int32 i = 0; i < frames; i++)
+        {
+            RAOE::task_waiting_on("test frame");
+            co_await std::suspend_always();
+        }
+    }
+
+    raoe::lazy<> sleep_each_frame(std::chrono::milliseconds duration)
+    {
+        while(true)
+        {
+            std::this_thread::sleep_for(duration);
+            co_await std::suspend_always();
+        }
+    }
+
+    raoe::lazy<> spin()
+    {
+        while(true)
+        {
+            co_await std::suspend_always();
+        }
+    }
+
+    raoe::lazy<> hop_to_main(RAOE::Engine& engine, std::thread::id& before, std::thread::id& after)
+    {
+        before = std::this_thread::get_id();
+        co_await RAOE::on_main_thread(engine);
+        after = std::this_thread::get_id();
+    }
+}
+
+TEST(TaskService, WorkPostedFromOtherThreadsRunsOnTheMainThread)
+{
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+    ASSERT_TRUE(task_service && task_service->on_main_thread());
+
+    //More than fits in the queue, so the posting threads have to wait for the main thread
+    constexpr int32 thread_count = 4;
+    constexpr int32 per_thread = static_cast<int32>(RAOE::Service::TaskService::PostedWorkCapacity);
+    std::vector<std::thread::id> ran_on;
+    std::atomic<int32> finished_threads = 0;
+    {
+        std::vector<std::jthread> threads;
+        for(int32 i = 0; i < thread_count; i++)
+        {
+            threads.emplace_back([&]() {
+                for(int32 j = 0; j < per_thread; j++)
+                {
+                    RAOE::post_to_main(engine, [&ran_on]() { ran_on.push_back(std::this_thread::get_id()); });
+                }
+                RAOE::enqueue_task(engine, TaskServiceTest::record_thread(ran_on));
+                finished_threads++;
+            });
+        }
+        while(finished_threads.load() < thread_count)
+        {
+            task_service->process_tasks();
+        }
+    }
+    //One frame to run the last of what was posted, and one for the tasks it added
+    task_service->process_tasks();
+    task_service->process_tasks();
+
+    EXPECT_EQ(ran_on.size(), thread_count * per_thread + thread_count);
+    EXPECT_THAT(ran_on, testing::Each(std::this_thread::get_id()));
+}
+
+TEST(TaskService, MainThreadPostsWaitForTheNextFrame)
+{
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    int32 runs = 0;
+    std::function<void()> repost = [&]() {
+        runs++;
+        RAOE::post_to_main(engine, repost);
+    };
+    RAOE::post_to_main(engine, repost);
+    task_service->process_tasks();
+    EXPECT_EQ(runs, 1);
+    task_service->process_tasks();
+    EXPECT_EQ(runs, 2);
+    task_service->discard_tasks();
+    task_service->process_tasks();
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(TaskService, OnMainThreadResumesOnTheMainThread)
+{
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    std::thread::id before;
+    std::thread::id after;
+    raoe::lazy<> task = TaskServiceTest::hop_to_main(engine, before, after);
+    std::jthread([&task]() { task.resume(); }).join();
+    EXPECT_NE(before, std::this_thread::get_id());
+    EXPECT_FALSE(task.done());
+
+    task_service->process_tasks();
+    EXPECT_TRUE(task.done());
+    EXPECT_EQ(after, std::this_thread::get_id());
+
+    //Already on the main thread, it doesn't suspend
+    raoe::lazy<> on_main = TaskServiceTest::hop_to_main(engine, before, after);
+    on_main.resume();
+    EXPECT_TRUE(on_main.done());
+}
+
+TEST(TaskService, DiscardingLeavesPostedCoroutinesToTheirOwner)
+{
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    std::thread::id before;
+    std::thread::id after;
+    std::optional<raoe::lazy<>> task = TaskServiceTest::hop_to_main(engine, before, after);
+    std::jthread([&task]() { task->resume(); }).join();
+
+    //The posted handle is dropped without being resumed, and the lazy still owns the frame, so it's the one that destroys it
+    task_service->discard_tasks();
+    task_service->process_tasks();
+    EXPECT_FALSE(task->done());
+    EXPECT_EQ(after, std::thread::id());
+    task.reset();
+}
+
+TEST(TaskService, PhasesThenPrioritiesOrderEachFrame)
+{
+    using RAOE::ETaskPhase;
+    using RAOE::ETaskPriority;
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    //Added backwards, so insertion order can't be what sorts them
+    std::vector<std::string> ran;
+    task_service->add_task(TaskServiceTest::record_frames(ran, "post_background"), { ETaskPriority::Background, ETaskPhase::PostECS });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "post_critical"), { ETaskPriority::Critical, ETaskPhase::PostECS });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "ecs"), { .phase = ETaskPhase::ECS });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "pre_background"), { .priority = ETaskPriority::Background });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "pre_frame"));
+    task_service->add_task(TaskServiceTest::record_frames(ran, "pre_critical"), { .priority = ETaskPriority::Critical });
+    EXPECT_EQ(task_service->task_count(), 6);
+
+    task_service->process_tasks();
+    EXPECT_THAT(ran, testing::ElementsAre("pre_critical", "pre_frame", "pre_background", "ecs", "post_critical", "post_background"));
+}
+
+TEST(TaskService, BackgroundTasksOverBudgetWaitTheirTurn)
+{
+    using namespace std::literals::string_view_literals;
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+    ASSERT_EQ(RAOE::Console::execute(engine, "task_background_budget_ms 0"sv), RAOE::Console::EConsoleError::None);
+
+    //With no budget, one background task gets a turn a frame, and they take turns.  Frame tasks run every frame regardless
+    std::vector<std::string> ran;
+    task_service->add_task(TaskServiceTest::record_frames(ran, "a"), { .priority = RAOE::ETaskPriority::Background });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "b"), { .priority = RAOE::ETaskPriority::Background });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "c"), { .priority = RAOE::ETaskPriority::Background });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "frame"));
+    for(int32 i = 0; i < 4; i++)
+    {
+        task_service->process_tasks();
+    }
+    EXPECT_THAT(ran, testing::ElementsAre("frame", "a", "frame", "b", "frame", "c", "frame", "a"));
+
+    //With plenty of budget, they all run every frame
+    ASSERT_EQ(RAOE::Console::execute(engine, "task_background_budget_ms 1000"sv), RAOE::Console::EConsoleError::None);
+    ran.clear();
+    task_service->process_tasks();
+    EXPECT_THAT(ran, testing::ElementsAre("frame", "b", "c", "a"));
+    RAOE::Console::execute(engine, "task_background_budget_ms 2"sv);
+}
+
+TEST(TaskService, OnlyBackgroundTasksSpendTheBudget)
+{
+    using namespace std::literals::string_view_literals;
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+    ASSERT_EQ(RAOE::Console::execute(engine, "task_background_budget_ms 20"sv), RAOE::Console::EConsoleError::None);
+
+    //The frame task takes longer than the whole budget, and the background tasks still all get a turn
+    std::vector<std::string> ran;
+    task_service->add_task(TaskServiceTest::sleep_each_frame(std::chrono::milliseconds(40)), { .priority = RAOE::ETaskPriority::Critical });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "a"), { .priority = RAOE::ETaskPriority::Background });
+    task_service->add_task(TaskServiceTest::record_frames(ran, "b"), { .priority = RAOE::ETaskPriority::Background, .phase = RAOE::ETaskPhase::PostECS });
+    task_service->process_tasks();
+    EXPECT_THAT(ran, testing::ElementsAre("a", "b"));
+    RAOE::Console::execute(engine, "task_background_budget_ms 2"sv);
+}
+
+TEST(TaskService, RecordsStatsPerTask)
+{
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    std::vector<std::string> ran;
+    task_service->add_task(TaskServiceTest::record_frames(ran, "named"), { .priority = RAOE::ETaskPriority::Critical, .name = "named task" });
+    const uint_least32_t added_on_line = std::source_location::current().line() + 1;
+    task_service->add_task(TaskServiceTest::wait_frames(2));
+    for(int32 i = 0; i < 2; i++)
+    {
+        task_service->process_tasks();
+    }
+
+    std::vector<RAOE::task_stats> stats = task_service->collect_task_stats();
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_STREQ(stats[0].name, "named task");
+    EXPECT_EQ(stats[0].label(), "named task");
+    EXPECT_EQ(stats[0].priority, RAOE::ETaskPriority::Critical);
+    EXPECT_EQ(stats[0].resumes, 2);
+    EXPECT_EQ(stats[0].waiting_on, nullptr);
+    EXPECT_GE(stats[0].max_ticks, 1);
+    EXPECT_LE(stats[0].max_ticks, stats[0].total_ticks);
+
+    EXPECT_EQ(stats[1].name, nullptr);
+    EXPECT_EQ(stats[1].location.line(), added_on_line);
+    EXPECT_EQ(stats[1].label(), fmt::format("task_service_test.cpp:{}", added_on_line));
+    EXPECT_STREQ(stats[1].waiting_on, "test frame");
+    EXPECT_FALSE(stats[1].finished);
+
+    //Finished tasks are still reported
+    task_service->process_tasks();
+    stats = task_service->collect_task_stats();
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats[0].resumes, 3);
+    EXPECT_TRUE(stats[1].finished);
+    EXPECT_EQ(stats[1].resumes, 3);
+    EXPECT_EQ(stats[1].waiting_on, nullptr);
+}
+
+TEST(TaskService, ForgetsStatsThatPointIntoAnUnloadingBinary)
+{
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    //Stands in for a string literal in a library that's about to go
+    static const char unloading_name[] = "from the library";
+    auto in_unloading = [](const void* address) { return address == static_cast<const void*>(unloading_name); };
+
+    task_service->add_task(TaskServiceTest::wait_frames(5), { .name = unloading_name });
+    task_service->add_task(TaskServiceTest::wait_frames(0), { .name = unloading_name });
+    task_service->add_task(TaskServiceTest::wait_frames(0), { .name = "kept" });
+    task_service->process_tasks();
+    ASSERT_EQ(task_service->collect_task_stats().size(), 3);
+
+    //The pending task keeps its stats without the name, and the finished task named there is forgotten
+    task_service->forget_stats_if(in_unloading);
+    const std::vector<RAOE::task_stats> stats = task_service->collect_task_stats();
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats[0].name, nullptr);
+    EXPECT_FALSE(stats[0].finished);
+    EXPECT_STREQ(stats[1].name, "kept");
+    EXPECT_TRUE(stats[1].finished);
+}
+
+TEST(TaskService, TaskStatsOverheadBenchmark)
+{
+    using namespace std::literals::string_view_literals;
+    TaskServiceTest::Engine engine;
+    auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+
+    constexpr int32 task_count = 1000;
+    constexpr int32 frames = 1000;
+    for(int32 i = 0; i < task_count; i++)
+    {
+        task_service->add_task(TaskServiceTest::spin());
+    }
+
+    //Taking turns, and keeping the fastest run of each, so whatever else the machine is doing doesn't land on one side
+    double ns_per_resume[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    for(int32 round = 0; round < 5; round++)
+    {
+        for(const bool record_stats : { false, true })
+        {
+            RAOE::Console::execute(engine, record_stats ? "task_stats 1"sv : "task_stats 0"sv);
+            task_service->process_tasks(); //warm up
+            const auto start = std::chrono::steady_clock::now();
+            for(int32 i = 0; i < frames; i++)
+            {
+                task_service->process_tasks();
+            }
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            ns_per_resume[record_stats ? 1 : 0] = std::min(ns_per_resume[record_stats ? 1 : 0], ns / (task_count * frames));
+        }
+    }
+    RAOE::Console::execute(engine, "task_stats 1"sv);
+
+    std::cout << "resume: " << ns_per_resume[0] << "ns without stats, " << ns_per_resume[1] << "ns with ("
+        << ns_per_resume[1] - ns_per_resume[0] << "ns overhead)" << std::endl;
+}
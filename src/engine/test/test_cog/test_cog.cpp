@@ -0,0 +1,110 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/*
+    A cog built as a shared library for cog_library_test, written out the way raoe_add_cog generates one
+*/
+
+#include "engine.hpp"
+#include "cogs/cog.hpp"
+#include "cogs/gear.hpp"
+#include "cogs/cog_service.hpp"
+#include "cogs/gear_service.hpp"
+#include "console/console.hpp"
+#include "console/command.hpp"
+#include "console/cvar.hpp"
+#include "from_string.hpp"
+
+namespace TestCog
+{
+    using RAOE::Console::AutoRegisterConsoleCommand;
+    static const AutoRegisterConsoleCommand test_cog_command = RAOE::Console::CreateConsoleCommand(
+        "test_cog_command",
+        "a command that lives in a shared cog",
+        +[]() { spdlog::info("test_cog_command ran"); }
+    );
+
+    static const RAOE::Console::AutoRegisterCVar<int32> test_cog_cvar = RAOE::Console::CreateCVar<int32>(
+        "test_cog_cvar",
+        "a cvar that lives in a shared cog",
+        1
+    );
+
+    struct TestCogGear : public RAOE::Cogs::Gear
+    {
+        TestCogGear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
+            : RAOE::Cogs::Gear(in_cog, in_name)
+        {
+            //Its code is in this library, so it has to be gone before the library is
+            startup_task(tick());
+        }
+
+        static raoe::lazy<> tick()
+        {
+            while(true)
+            {
+                co_await std::suspend_always();
+            }
+        }
+
+        //Calls back into the executable, so the test can see the gear was activated
+        void activated() override
+        {
+            m_activations++;
+            RAOE::Console::execute(engine(), "cog_library_test_activated");
+        }
+
+        void deactivated() override
+        {
+            RAOE::Console::execute(engine(), "cog_library_test_deactivated");
+        }
+
+        std::optional<std::string> save_reload_state() const override
+        {
+            return std::to_string(m_activations);
+        }
+
+        void restore_reload_state(std::string_view state) override
+        {
+            raoe::string::from_string(state, m_activations);
+            RAOE::Console::execute(engine(), fmt::format("cog_library_test_restored {}", m_activations));
+        }
+
+        int32 m_activations = 0;
+    };
+}
+
+RAOE_DEFINE_EAGER_GEAR(TestCogGear, TestCog::TestCogGear);
+
+namespace RAOE::Cogs::_GENERATED
+{
+    class TestCog : public RAOE::Cogs::BaseCog
+    {
+    public:
+        TestCog(RAOE::Engine& in_engine)
+            : RAOE::Cogs::BaseCog(in_engine, "TestCog:cog")
+        {
+
+        }
+
+        void register_gears() override
+        {
+            RAOE_GEAR_GENERATE_FUNC_CALL(TestCogGear);
+        }
+    };
+}
+
+__GENERATED_REGISTER_COG(TestCog, RAOE::Cogs::_GENERATED::TestCog, "TestCog:cog", __GENERATED__TestCog)
@@ -20,6 +20,9 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "services/task_service.hpp"
 #include "lazy.hpp"
 
+#include <span>
+#include <string_view>
+
 namespace RAOE
 {
     class Engine;
@@ -56,6 +59,9 @@ namespace RAOE::Framework
         virtual void begin() = 0;
         virtual void end() {};
 
+        //Cogs the game needs that may not be loaded yet (shared cogs from the manifest).  They're loaded before begin()
+        [[nodiscard]] virtual std::span<const std::string_view> required_cogs() const { return {}; }
+
         [[nodiscard]] const RAOE::Engine& engine() const { return m_engine; }       
     private:
         RAOE::Engine& m_engine;
@@ -16,10 +16,12 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 
 #include "framework.hpp"
 #include "game_components_private.hpp"
+#include "components/game_components.hpp"
 #include "engine.hpp"
 #include "cogs/cog.hpp"
 #include "cogs/gear.hpp"
 #include "cogs/gear_service.hpp"
+#include "cogs/cog_service.hpp"
 #include "resource/resources.hpp"
 #include "console/command.hpp"
 
@@ -43,6 +45,16 @@ namespace RAOE::Gears
             {
                 client_world->import<RAOE::Framework::Module>();
             }
+
+            if(auto gear_service = engine().get_service<RAOE::Service::GearService>().lock())
+            {
+                if(auto flecs_gear = gear_service->get_gear<RAOE::Gears::FlecsGear>().lock())
+                {
+                    //The server world is authoritative for transforms, the client world draws whatever it last received
+                    flecs_gear->ecs_world_server->import<RAOE::Framework::Module>();
+                    flecs_gear->replicate_component<RAOE::Framework::transform2d>();
+                }
+            }
         }
 
         std::shared_ptr<RAOE::Resource::Handle> m_active_game;
@@ -71,10 +83,22 @@ namespace RAOE::Framework
         {
             if(auto game = game_handle->get<IGame>().lock())
             {
+                if(auto cog_service = engine.get_service<RAOE::Service::CogService>().lock())
+                {
+                    for(const std::string_view cog_name : game->required_cogs())
+                    {
+                        if(cog_service->require_cog(cog_name).expired())
+                        {
+                            spdlog::error("Unable to start game {}, it requires cog {}", game_handle->tag(), cog_name);
+                            co_return;
+                        }
+                    }
+                }
+
                 game->begin(); //tell the game we are about to begin, and generate the tasks to enqueue
 
                 //Enqueue the startup tasks
-                task_service->enqueue_startup_tasks(*game);
+                task_service->enqueue_startup_tasks(*game, std::string_view(game_handle->tag()));
                 //TODO: await these tasks
             }    
 
@@ -143,16 +167,16 @@ namespace RAOE::Framework
         return {};
     }
 
-    using AutoRegisterConsoleCommand = RAOE::Console::AutoRegisterConsoleCommand;
+    using RAOE::Console::AutoRegisterConsoleCommand;
     static const AutoRegisterConsoleCommand quit_command = RAOE::Console::CreateConsoleCommand(
         "close_current_game",
         "closes the current game",
         +[](Engine& engine) {
-            enqueue_task(engine, deactivate_game(engine));
+            return deactivate_game(engine);
         }
     );
 }
 
 
 
-RAOE_DEFINE_GEAR(FrameworkGear, RAOE::Gears::FrameworkGear)
\ No newline at end of file
+RAOE_DEFINE_EAGER_GEAR(FrameworkGear, RAOE::Gears::FrameworkGear)
\ No newline at end of file
@@ -30,6 +30,7 @@ namespace RAOE::Frontend
     //NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
     void draw_frontend(flecs::entity e, FrontenedPanel& panel)
     {
+        RAOE_PROFILE_FUNCTION();
         RAOE::Engine& engine = *static_cast<RAOE::Engine*>(e.world().get_context());
         if(!RAOE::Framework::has_active_game(engine))
         {       
@@ -42,20 +43,14 @@ namespace RAOE::Frontend
                 ImGui::Text("Games: ");
                 if(auto resource_service = engine.get_service<RAOE::Resource::Service>().lock())
                 {
-                    for(const auto& [tag, handle] : resource_service->handle_map())
+                    for(const std::shared_ptr<RAOE::Resource::Handle>& game_handle : resource_service->handles_of_type(RAOE::Framework::Tags::GameType))
                     {
-                        if(auto locked_handle = handle.lock())
+                        ImGui::Text("%s", std::string(std::string_view(game_handle->tag())).c_str());
+                        ImGui::SameLine();
+                        if(ImGui::Button("Start Game"))
                         {
-                            if(locked_handle->resource_type() == RAOE::Framework::Tags::GameType)
-                            {                            
-                                ImGui::Text("%s", std::string(tag).c_str());
-                                ImGui::SameLine();
-                                if(ImGui::Button("Start Game"))
-                                {
-                                    //Transition to the game
-                                    RAOE::enqueue_task(engine, RAOE::Framework::make_active_game(engine, locked_handle));
-                                }                        
-                            }
+                            //Transition to the game
+                            RAOE::enqueue_task(engine, RAOE::Framework::make_active_game(engine, game_handle));
                         }
                     }
                 }
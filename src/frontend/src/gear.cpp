@@ -26,6 +26,8 @@ namespace RAOE::Frontend
 {
     struct Gear : public RAOE::Cogs::Gear
     {
+        using required_gears = std::tuple<RAOE::Gears::FlecsGear>;
+
         Gear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
             : RAOE::Cogs::Gear(in_cog, in_name) 
         {}
@@ -47,4 +49,4 @@ namespace RAOE::Frontend
 }
 
 
-RAOE_DEFINE_GEAR(FrontendGear, RAOE::Frontend::Gear)
\ No newline at end of file
+RAOE_DEFINE_EAGER_GEAR(FrontendGear, RAOE::Frontend::Gear)
\ No newline at end of file
@@ -82,4 +82,4 @@ namespace RAOE::Pong
 
 }
 
-RAOE_DEFINE_GEAR(PongGear, RAOE::Pong::Gear)
\ No newline at end of file
+RAOE_DEFINE_EAGER_GEAR(PongGear, RAOE::Pong::Gear)
\ No newline at end of file
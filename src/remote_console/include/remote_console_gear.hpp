@@ -0,0 +1,41 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "cogs/gear.hpp"
+#include "console/remote_console.hpp"
+
+namespace RAOE::Gears
+{
+    /***
+     * RemoteConsoleGear
+     * Serves the console over a Unix domain socket (see RAOE::Console::RemoteConsole), so a headless engine can be driven by a script.
+     * Only listens when RAOE_REMOTE_CONSOLE names a socket path
+    */
+    struct RemoteConsoleGear : public RAOE::Cogs::Gear
+    {
+        RemoteConsoleGear(RAOE::Cogs::BaseCog&, std::string_view);
+
+        void activated() override;
+        void deactivated() override;
+
+        RAOE::Console::RemoteConsole* remote_console() { return remote_console_ptr.get(); }
+
+    private:
+        std::unique_ptr<RAOE::Console::RemoteConsole> remote_console_ptr;
+    };
+}
@@ -0,0 +1,74 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "remote_console_gear.hpp"
+#include "engine.hpp"
+#include "cogs/gear_service.hpp"
+#include "profile.hpp"
+
+namespace RAOE::Gears
+{
+    raoe::lazy<> serve_remote_console(std::weak_ptr<RemoteConsoleGear> weak_gear)
+    {
+        //Runs on the main thread with every other task, so commands run where they would from the ImGui console.
+        //Only holds on to the gear while polling, and finishes once the gear is gone or has stopped listening
+        while(true)
+        {
+            {
+                const std::shared_ptr<RemoteConsoleGear> gear = weak_gear.lock();
+                RAOE::Console::RemoteConsole* const remote_console = gear ? gear->remote_console() : nullptr;
+                if(!remote_console)
+                {
+                    co_return;
+                }
+                RAOE_PROFILE_SCOPE("RemoteConsoleGear::poll");
+                remote_console->poll();
+            }
+            co_await std::suspend_always();
+        }
+    }
+
+    RemoteConsoleGear::RemoteConsoleGear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
+        : RAOE::Cogs::Gear(in_cog, in_name)
+    {
+
+    }
+
+    void RemoteConsoleGear::activated()
+    {
+        const std::optional<std::filesystem::path> path = RAOE::Console::remote_console_path();
+        if(!path)
+        {
+            return;
+        }
+
+        auto remote_console = std::make_unique<RAOE::Console::RemoteConsole>(engine());
+        std::shared_ptr<RAOE::Service::GearService> gear_service = engine().get_service<RAOE::Service::GearService>().lock();
+        if(gear_service && remote_console->listen(*path))
+        {
+            remote_console_ptr = std::move(remote_console);
+            RAOE::enqueue_task(engine(), serve_remote_console(gear_service->get_gear<RemoteConsoleGear>()), { .name = "RemoteConsoleGear::poll" });
+        }
+    }
+
+    void RemoteConsoleGear::deactivated()
+    {
+        //The serve task sees this on its next frame and finishes
+        remote_console_ptr.reset();
+    }
+}
+
+RAOE_DEFINE_EAGER_GEAR(RemoteConsoleGear, RAOE::Gears::RemoteConsoleGear)
@@ -17,20 +17,60 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #pragma once
 #include "cogs/gear.hpp"
 #include "flecs.h"
+#include "replication.hpp"
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace RAOE::Gears
 {
     extern const std::string FlecsGearName;
     struct FlecsGear : public RAOE::Cogs::Gear
     {
+        //How many times per second the server world ticks
+        static constexpr int32 ServerTickRate = 60;
+
         FlecsGear(RAOE::Cogs::BaseCog&, std::string_view);
       
         void activated() override;
         void deactivated() override;
 
+        /*
+            Replicates every T in the server world into the client world, once per server tick.
+            The server thread starts on the first frame, so this must be called before then (ie: from a gear's activated())
+        */
+        template<typename T>
+        bool replicate_component()
+        {
+            if(server_running())
+            {
+                spdlog::error("FlecsGear: Unable to replicate {}, the server world is already running", raoe::core::name_of<T>());
+                return false;
+            }
+            ecs_world_server->component<T>();
+            m_replication_channels.emplace_back(std::make_unique<RAOE::ECS::Replication::ComponentChannel<T>>(*ecs_world_server));
+            return true;
+        }
+
+        [[nodiscard]] bool server_running() const { return m_server_running.load(std::memory_order_acquire); }
+
+        void start_server_world();
+        void stop_server_world();
+
+        //Applies the latest server snapshots to the client world.  Main thread only
+        void consume_server_snapshots();
+
         std::unique_ptr<flecs::world> ecs_world_client;
-        //std::unique_ptr<flecs::world> ecs_world_server; //TODO: Server World
+        std::unique_ptr<flecs::world> ecs_world_server;
+    private:
+        void run_server_world(const std::stop_token& stop_token);
+
+        std::vector<std::unique_ptr<RAOE::ECS::Replication::IChannel>> m_replication_channels;
+        std::atomic<bool> m_server_running = false;
+
+        //Declared last so it is joined before the worlds it ticks are destroyed
+        std::jthread m_server_thread;
     };
 
     const std::unique_ptr<flecs::world>& client_world(RAOE::Engine& engine);
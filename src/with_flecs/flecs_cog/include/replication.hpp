@@ -0,0 +1,120 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include "core.hpp"
+#include "container/snapshot_buffer.hpp"
+#include "flecs.h"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace RAOE::ECS::Replication
+{
+    /*
+        A replication channel moves one component type from the server world to the client world.
+
+        publish() runs on the server thread right after the server world ticks, consume() runs on the main thread
+        right before the client world ticks.  The two only meet inside the snapshot_buffer, so neither side locks.
+    */
+    class IChannel
+    {
+    public:
+        virtual ~IChannel() = default;
+
+        virtual void publish(flecs::world& server_world, uint64 tick) = 0;
+        virtual void consume(flecs::world& client_world) = 0;
+    };
+
+    template<typename T>
+    struct Snapshot
+    {
+        uint64 tick = 0;
+        std::vector<std::pair<flecs::entity_t, T>> entries;
+    };
+
+    template<typename T>
+        requires std::is_copy_assignable_v<T>
+    class ComponentChannel : public IChannel
+    {
+    public:
+        explicit ComponentChannel(flecs::world& server_world)
+            : m_server_query(server_world.query<const T>())
+        {
+        }
+
+        void publish(flecs::world& server_world, uint64 tick) override
+        {
+            Snapshot<T>& snapshot = m_snapshots.back();
+            snapshot.tick = tick;
+            snapshot.entries.clear(); //keeps the capacity from the last time this slot was used
+            m_server_query.each([&snapshot](flecs::entity e, const T& value)
+            {
+                snapshot.entries.emplace_back(e.id(), value);
+            });
+            m_snapshots.publish();
+        }
+
+        void consume(flecs::world& client_world) override
+        {
+            if(!m_snapshots.acquire())
+            {
+                return;
+            }
+
+            const Snapshot<T>& snapshot = m_snapshots.front();
+            for(const auto& [server_entity, value] : snapshot.entries)
+            {
+                Mirror& mirror = m_mirrors[server_entity];
+                if(mirror.entity.id() == 0 || !mirror.entity.is_alive())
+                {
+                    mirror.entity = client_world.entity();
+                }
+                mirror.entity.set<T>(value);
+                mirror.last_seen_tick = snapshot.tick;
+            }
+
+            //Anything that wasn't in this snapshot no longer exists on the server
+            std::erase_if(m_mirrors, [&snapshot](auto& pair)
+            {
+                Mirror& mirror = pair.second;
+                if(mirror.last_seen_tick != snapshot.tick)
+                {
+                    if(mirror.entity.id() != 0 && mirror.entity.is_alive())
+                    {
+                        mirror.entity.destruct();
+                    }
+                    return true;
+                }
+                return false;
+            });
+        }
+
+    private:
+        struct Mirror
+        {
+            flecs::entity entity;
+            uint64 last_seen_tick = 0;
+        };
+
+        flecs::query<const T> m_server_query;
+        raoe::container::snapshot_buffer<Snapshot<T>> m_snapshots;
+
+        //Only touched from consume(), so it belongs to the main thread
+        std::unordered_map<flecs::entity_t, Mirror> m_mirrors;
+    };
+}
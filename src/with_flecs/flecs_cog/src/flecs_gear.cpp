@@ -20,38 +20,79 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "cogs/cog.hpp"
 #include "services/task_service.hpp"
 #include "lazy.hpp"
+#include "frame_arena.hpp"
+
+#include <algorithm>
 
 namespace RAOE::Gears
 {
     const std::string FlecsGearName("Flecs::ECS::FlecsGear");
 
-    void LogECS(int32 level,  const char *file,  int32 line, const char *msg)
+    constinit const raoe::log::category LogFlecs {"ecs"};
+
+    //flecs levels: 1 to 3 are debug output, 0 is tracing, -2 warnings, -3 errors, -4 fatal
+    spdlog::level::level_enum SpdlogLevelFor(int32 level)
     {
-        spdlog::level::level_enum lvl = spdlog::level::trace;
         if(level > 0)
         {
-            lvl = spdlog::level::debug;
+            return spdlog::level::trace;
+        }
+        if(level >= -1)
+        {
+            return spdlog::level::debug;
+        }
+        if(level == -2)
+        {
+            return spdlog::level::warn;
         }
-        else if(level == -2)
+        if(level == -3)
         {
-            lvl = spdlog::level::warn;
+            return spdlog::level::err;
         }
-        else if(level == -3)
+        return spdlog::level::critical;
+    }
+
+    //The most verbose flecs level that the ecs logger would keep, so flecs doesn't build messages we throw away
+    int32 FlecsLevelFor(spdlog::level::level_enum level)
+    {
+        switch(level)
         {
-            lvl = spdlog::level::err;
+            case spdlog::level::trace: return 3;
+            case spdlog::level::debug: return 0;
+            case spdlog::level::info:
+            case spdlog::level::warn: return -2;
+            case spdlog::level::err: return -3;
+            default: return -4;
         }
-        else if(level == -4)
+    }
+
+    //Follows the ecs logger's level (log_level ecs <level>).  flecs' level is a global, so only the main thread sets it
+    void SyncFlecsLogLevel()
+    {
+        static spdlog::level::level_enum applied = spdlog::level::n_levels;
+        const spdlog::level::level_enum level = LogFlecs.logger().level();
+        if(level != applied)
         {
-            lvl = spdlog::level::critical;
+            applied = level;
+            ecs_log_set_level(FlecsLevelFor(level));
         }
+    }
 
-        std::string indentation;
-        for(int32 i  = 0; i < ecs_os_api.log_indent_; i++)
+    void LogECS(int32 level,  const char *file,  int32 line, const char *msg)
+    {
+        const spdlog::level::level_enum lvl = SpdlogLevelFor(level);
+        if(!LogFlecs.should_log(lvl))
         {
-            indentation += "\t -";
+            return;
         }
 
-        spdlog::log(lvl, "|{} ({}:{}) {} ", indentation, file, line, msg);
+        //flecs indents nested log output.  Slice the indentation out of a fixed string rather than building it every call
+        constexpr std::string_view IndentUnit = "\t -";
+        constexpr std::string_view Indentation = "\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -\t -";
+        constexpr int32 MaxIndent = static_cast<int32>(Indentation.size() / IndentUnit.size());
+        const auto indent = static_cast<size_t>(std::clamp<int32>(ecs_os_api.log_indent_, 0, MaxIndent));
+
+        LogFlecs.logger().log(lvl, "|{} ({}:{}) {} ", Indentation.substr(0, indent * IndentUnit.size()), file, line, msg);
     }
 
     void InitFLECSSystem()
@@ -63,28 +104,45 @@ namespace RAOE::Gears
         api.flags_ |= EcsOsApiLogWithColors;
         ecs_os_set_api(&api);
 
-        ecs_log_set_level(0);
-        spdlog::set_level(spdlog::level::trace);
+        SyncFlecsLogLevel();
     }
 
-    raoe::lazy<> tick_ecs(Engine& engine, const std::unique_ptr<flecs::world>& world_ptr)
+    raoe::lazy<> tick_ecs(Engine& engine, FlecsGear& gear)
     {
+        const std::unique_ptr<flecs::world>& world_ptr = gear.ecs_world_client;
         while(world_ptr)
         {
-            if(!world_ptr->progress())
             {
-                engine.request_exit();
-            }      
+                RAOE_PROFILE_SCOPE("FlecsGear::tick_ecs");
+                SyncFlecsLogLevel();
+                gear.consume_server_snapshots();
+                if(!world_ptr->progress())
+                {
+                    engine.request_exit();
+                }      
+            }
             co_await std::suspend_always();      
         }
     }
 
+    raoe::lazy<> start_server_world_task(FlecsGear& gear)
+    {
+        //Runs as a startup task so every gear has had a chance to register replicated components in activated()
+        gear.start_server_world();
+        co_return;
+    }
+
     FlecsGear::FlecsGear(RAOE::Cogs::BaseCog& in_cog, std::string_view name)   
         : RAOE::Cogs::Gear(in_cog, name)
         , ecs_world_client(std::make_unique<flecs::world>())
+        , ecs_world_server(std::make_unique<flecs::world>())
     {
         ecs_world_client->set_context(&engine());
+        //Server systems run off the main thread, so they must not touch engine services through this
+        ecs_world_server->set_context(&engine());
         InitFLECSSystem();      
+
+        startup_task(start_server_world_task(*this));
     }  
 
     void FlecsGear::activated()    
@@ -93,12 +151,88 @@ namespace RAOE::Gears
         {
             ecs_world_client->import<RAOE::ECS::ClientApp::Module>();
         }   
-        RAOE::enqueue_task(engine(), tick_ecs(engine(), ecs_world_client));
+        RAOE::enqueue_task(engine(), tick_ecs(engine(), *this), { .phase = RAOE::ETaskPhase::ECS, .name = "FlecsGear::tick_ecs" });
     }
 
     void FlecsGear::deactivated()    
     {
-    
+        stop_server_world();
+    }
+
+    void FlecsGear::start_server_world()    
+    {
+        if(!ecs_world_server || server_running())
+        {
+            return;
+        }
+
+        m_server_running.store(true, std::memory_order_release);
+        m_server_thread = std::jthread([this](const std::stop_token& stop_token) { run_server_world(stop_token); });
+    }
+
+    void FlecsGear::stop_server_world()    
+    {
+        if(m_server_thread.joinable())
+        {
+            m_server_thread.request_stop();
+            m_server_thread.join();
+        }
+    }
+
+    void FlecsGear::consume_server_snapshots()    
+    {
+        if(!ecs_world_client)
+        {
+            return;
+        }
+
+        RAOE_PROFILE_SCOPE("FlecsGear::consume_server_snapshots");
+        for(const auto& channel : m_replication_channels)
+        {
+            channel->consume(*ecs_world_client);
+        }
+    }
+
+    void FlecsGear::run_server_world(const std::stop_token& stop_token)    
+    {
+        using clock = std::chrono::steady_clock;
+        const auto tick_interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / ServerTickRate));
+        const float tick_delta = 1.0F / static_cast<float>(ServerTickRate);
+
+        spdlog::info("FlecsGear: Server world running at {} ticks per second", ServerTickRate);
+
+        uint64 tick = 0;
+        auto next_tick = clock::now();
+        while(!stop_token.stop_requested())
+        {
+            {
+                RAOE_PROFILE_SCOPE("ServerWorld::tick");
+                if(!ecs_world_server->progress(tick_delta))
+                {
+                    break;
+                }
+                tick++;
+
+                for(const auto& channel : m_replication_channels)
+                {
+                    channel->publish(*ecs_world_server, tick);
+                }
+                //Server systems use this thread's arena, as main() is reset on the main thread's schedule
+                raoe::frame_arena::this_thread().end_frame();
+            }
+
+            next_tick += tick_interval;
+            const auto now = clock::now();
+            if(now > next_tick + tick_interval)
+            {
+                //We fell more than a tick behind.  Don't try to catch up by running ticks back to back
+                next_tick = now;
+            }
+            std::this_thread::sleep_until(next_tick);
+        }
+
+        m_server_running.store(false, std::memory_order_release);
+        spdlog::info("FlecsGear: Server world stopped after {} ticks", tick);
     }
 
     const std::unique_ptr<flecs::world>& client_world(RAOE::Engine& engine)    
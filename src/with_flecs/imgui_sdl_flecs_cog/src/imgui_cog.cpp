@@ -22,6 +22,8 @@ namespace RAOE::Gears
 {
     struct ImguiSdlFlecsGear : public RAOE::Cogs::Gear
     {
+        using required_gears = std::tuple<FlecsGear>;
+
         ImguiSdlFlecsGear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
             : RAOE::Cogs::Gear(in_cog, in_name)
         {
@@ -38,4 +40,4 @@ namespace RAOE::Gears
         }
     };
 }
-RAOE_DEFINE_GEAR(ImguiGear, RAOE::Gears::ImguiSdlFlecsGear)
\ No newline at end of file
+RAOE_DEFINE_EAGER_GEAR(ImguiGear, RAOE::Gears::ImguiSdlFlecsGear)
\ No newline at end of file
@@ -30,6 +30,9 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "flecs_gear.hpp"
 
 #include "console_gear.hpp"
+#include "profiler_panel.hpp"
+#include "memory_panel.hpp"
+#include "task_panel.hpp"
 
 namespace RAOE::ECS::Imgui
 {
@@ -41,10 +44,14 @@ namespace RAOE::ECS::Imgui
         bool should_show_command_palette;
         bool should_show_demo_window;
         bool should_show_console;
+        bool should_show_profiler;
+        bool should_show_memory;
+        bool should_show_tasks;
     };
 
     void NewFrame(flecs::entity e, const SDLSystem& sdl_system)
     {      
+        RAOE_PROFILE_FUNCTION();
         ImGui_ImplSDLRenderer_NewFrame();
         ImGui_ImplSDL2_NewFrame(sdl_system.window_handle.get());
         ImGui::NewFrame();   
@@ -64,6 +71,21 @@ namespace RAOE::ECS::Imgui
                 ImGui::ShowDemoWindow();
             }
 
+            if(info->should_show_profiler)
+            {
+                DrawProfilerPanel(&info->should_show_profiler);
+            }
+
+            if(info->should_show_memory)
+            {
+                DrawMemoryPanel(&info->should_show_memory);
+            }
+
+            if(info->should_show_tasks)
+            {
+                DrawTaskPanel(engine, &info->should_show_tasks);
+            }
+
             if(auto gear_service = engine.get_service<RAOE::Service::GearService>().lock())
             {
                 if(info->should_show_console)
@@ -81,6 +103,7 @@ namespace RAOE::ECS::Imgui
 
     void UpdateIO(flecs::entity e, const Events& events)
     {
+        RAOE_PROFILE_FUNCTION();
         for(const SDL_Event& event : events.events_this_frame)
         {
             ImGui_ImplSDL2_ProcessEvent(&event);
@@ -115,11 +138,12 @@ namespace RAOE::ECS::Imgui
 
     void DrawFrame(flecs::entity e, const SDLSystem& sdl_system)
     {
+        RAOE_PROFILE_FUNCTION();
         ImGui::Render();
         ImGui_ImplSDLRenderer_RenderDrawData(ImGui::GetDrawData());
     }  
 
-    using AutoRegisterConsoleCommand = RAOE::Console::AutoRegisterConsoleCommand;
+    using RAOE::Console::AutoRegisterConsoleCommand;
     static AutoRegisterConsoleCommand quit_command = RAOE::Console::CreateConsoleCommand(
         "ShowDemo",
         "Shows the Demo Window",
@@ -137,6 +161,42 @@ namespace RAOE::ECS::Imgui
         }
     );
 
+    static AutoRegisterConsoleCommand profiler_command = RAOE::Console::CreateConsoleCommand(
+        "profiler",
+        "Shows or hides the profiler flame graph",
+        +[](RAOE::Engine& e) {
+            if(const auto& client_world = RAOE::Gears::client_world(e))
+            {
+                bool& should_show_profiler = client_world->module<Module>().get_mut<ImCmdInfo>()->should_show_profiler;
+                should_show_profiler = !should_show_profiler;
+            }
+        }
+    );
+
+    static AutoRegisterConsoleCommand memory_command = RAOE::Console::CreateConsoleCommand(
+        "memory",
+        "Shows or hides the memory usage table",
+        +[](RAOE::Engine& e) {
+            if(const auto& client_world = RAOE::Gears::client_world(e))
+            {
+                bool& should_show_memory = client_world->module<Module>().get_mut<ImCmdInfo>()->should_show_memory;
+                should_show_memory = !should_show_memory;
+            }
+        }
+    );
+
+    static AutoRegisterConsoleCommand task_panel_command = RAOE::Console::CreateConsoleCommand(
+        "task_panel",
+        "Shows or hides the table of what each task costs",
+        +[](RAOE::Engine& e) {
+            if(const auto& client_world = RAOE::Gears::client_world(e))
+            {
+                bool& should_show_tasks = client_world->module<Module>().get_mut<ImCmdInfo>()->should_show_tasks;
+                should_show_tasks = !should_show_tasks;
+            }
+        }
+    );
+
     Module::Module(flecs::world& world)    
     {  
         //Setup the Dear ImGui context (Taken from the imgui SDL Renderer example)
@@ -144,7 +204,7 @@ namespace RAOE::ECS::Imgui
         ImGui::CreateContext();
         ImGuiIO& io = ImGui::GetIO(); (void)io;
 
-        world.module<Module>().set<ImCmdInfo>({false, false, false});
+        world.module<Module>().set<ImCmdInfo>({false, false, false, false, false, false});
         ImCmd::CreateContext();
        
      
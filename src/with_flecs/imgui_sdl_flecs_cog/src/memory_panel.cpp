@@ -0,0 +1,148 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "memory_panel.hpp"
+#include "core.hpp"
+#include "imgui.h"
+
+#include <chrono>
+#include <unordered_map>
+
+namespace RAOE::ECS::Imgui
+{
+    //imgui uses a lot of vararg functions.  
+    //NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+    namespace
+    {
+        constexpr auto SampleInterval = std::chrono::milliseconds(500);
+
+        struct MemoryPanelState
+        {
+            std::vector<raoe::memory::tag_report> reports;
+            std::unordered_map<raoe::memory::tag_id, double> allocation_rates; //allocations per second, over the last sample interval
+            std::chrono::steady_clock::time_point last_sample;
+
+            void sample()
+            {
+                const auto now = std::chrono::steady_clock::now();
+                const double seconds = std::chrono::duration<double>(now - last_sample).count();
+
+                std::vector<raoe::memory::tag_report> new_reports = raoe::memory::report();
+                for(const raoe::memory::tag_report& report : new_reports)
+                {
+                    if(report.id < reports.size())
+                    {
+                        allocation_rates[report.id] = static_cast<double>(report.allocations - reports[report.id].allocations) / seconds;
+                    }
+                }
+                reports = std::move(new_reports);
+                last_sample = now;
+            }
+        };
+
+        MemoryPanelState& panel_state()
+        {
+            static MemoryPanelState state;
+            return state;
+        }
+    }
+
+    void DrawMemoryPanel(bool* p_open)
+    {
+        ImGui::SetNextWindowSize(ImVec2(700, 400), ImGuiCond_FirstUseEver); //NOLINT
+        if(!ImGui::Begin("Memory", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        MemoryPanelState& state = panel_state();
+        if(std::chrono::steady_clock::now() - state.last_sample >= SampleInterval)
+        {
+            state.sample();
+        }
+
+        if(!raoe::memory::tracking_global_allocations())
+        {
+            ImGui::TextDisabled("Global allocations are not tracked (RAOE_TRACK_GLOBAL_ALLOCATIONS is off)");
+        }
+
+        constexpr ImGuiTableFlags table_flags = ImGuiTableFlags_Sortable 
+            | ImGuiTableFlags_RowBg 
+            | ImGuiTableFlags_Borders 
+            | ImGuiTableFlags_Resizable 
+            | ImGuiTableFlags_ScrollY
+            ;
+
+        if(ImGui::BeginTable("MemoryTags", 4, table_flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Tag");
+            ImGui::TableSetupColumn("Live Bytes", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("Allocations", ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("Allocs/s", ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableHeadersRow();
+
+            //Sort a list of indices so the reports stay indexed by tag id for the next sample
+            std::vector<size_t> rows(state.reports.size());
+            for(size_t i = 0; i < rows.size(); i++)
+            {
+                rows[i] = i;
+            }
+
+            if(const ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs(); sort_specs && sort_specs->SpecsCount > 0)
+            {
+                const ImGuiTableColumnSortSpecs& spec = sort_specs->Specs[0];
+                auto sort_key = [&](size_t row) -> double {
+                    const raoe::memory::tag_report& report = state.reports[row];
+                    switch(spec.ColumnIndex)
+                    {
+                        case 1: return static_cast<double>(report.live_bytes);
+                        case 2: return static_cast<double>(report.allocations);
+                        case 3: return state.allocation_rates[report.id];
+                        default: return 0.0;
+                    }
+                };
+                std::ranges::stable_sort(rows, [&](size_t lhs, size_t rhs) {
+                    if(spec.ColumnIndex == 0)
+                    {
+                        const bool less = state.reports[lhs].name < state.reports[rhs].name;
+                        return spec.SortDirection == ImGuiSortDirection_Ascending ? less : state.reports[rhs].name < state.reports[lhs].name;
+                    }
+                    return spec.SortDirection == ImGuiSortDirection_Ascending ? sort_key(lhs) < sort_key(rhs) : sort_key(rhs) < sort_key(lhs);
+                });
+            }
+
+            for(const size_t row : rows)
+            {
+                const raoe::memory::tag_report& report = state.reports[row];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(report.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%lld", static_cast<long long>(report.live_bytes));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(report.allocations));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", state.allocation_rates[report.id]);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+    //NOLINTEND(cppcoreguidelines-pro-type-vararg)
+}
@@ -0,0 +1,169 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "profiler_panel.hpp"
+#include "core.hpp"
+#include "imgui.h"
+
+#include <functional>
+#include <string>
+
+namespace RAOE::ECS::Imgui
+{
+    //imgui uses a lot of vararg functions.  
+    //NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+    namespace
+    {
+        constexpr std::string_view FrameZoneName = "Frame";
+        constexpr float RowHeight = 18.0F;
+        constexpr int32 LiveCaptureInterval = 30; //frames between captures while live.  Capturing copies every ring buffer, so don't do it every frame
+
+        struct ProfilerPanelState
+        {
+            std::vector<raoe::profile::thread_capture> captures;
+            std::vector<const raoe::profile::zone_event*> frames; //the Frame zones in the capture, oldest first
+            int32 selected_frame = 0; //counted back from the newest frame
+            bool live = true;
+            int32 frames_until_capture = 0;
+
+            void recapture()
+            {
+                captures = raoe::profile::capture();
+                frames.clear();
+                for(const auto& captured : captures)
+                {
+                    for(const auto& event : captured.events)
+                    {
+                        if(event.depth == 0 && event.name == FrameZoneName)
+                        {
+                            frames.push_back(&event);
+                        }
+                    }
+                }
+                std::ranges::sort(frames, {}, &raoe::profile::zone_event::start);
+            }
+        };
+
+        ProfilerPanelState& panel_state()
+        {
+            static ProfilerPanelState state;
+            return state;
+        }
+
+        ImU32 zone_color(std::string_view name)
+        {
+            const size_t hash = std::hash<std::string_view>{}(name);
+            return IM_COL32(96 + (hash & 0x7F), 96 + ((hash >> 8) & 0x7F), 96 + ((hash >> 16) & 0x7F), 255); //NOLINT color math
+        }
+    }
+
+    void DrawProfilerPanel(bool* p_open)
+    {
+        ImGui::SetNextWindowSize(ImVec2(900, 400), ImGuiCond_FirstUseEver); //NOLINT
+        if(!ImGui::Begin("Profiler", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        ProfilerPanelState& state = panel_state();
+
+        ImGui::Checkbox("Live", &state.live);
+        ImGui::SameLine();
+        if(ImGui::Button("Capture") || (state.live && state.frames_until_capture-- <= 0))
+        {
+            state.recapture();
+            state.selected_frame = 0;
+            state.frames_until_capture = LiveCaptureInterval;
+        }
+
+        if(state.frames.empty())
+        {
+            ImGui::Text("No frames recorded.  Is profiling paused? (profile_toggle)");
+            ImGui::End();
+            return;
+        }
+
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200); //NOLINT
+        ImGui::SliderInt("Frames ago", &state.selected_frame, 0, static_cast<int32>(state.frames.size()) - 1);
+        state.selected_frame = std::clamp(state.selected_frame, 0, static_cast<int32>(state.frames.size()) - 1);
+
+        const raoe::profile::zone_event& frame = *state.frames[state.frames.size() - 1 - state.selected_frame];
+        const double ms_per_tick = raoe::profile::ns_per_tick() / 1000000.0;
+        const double frame_ticks = static_cast<double>(frame.end - frame.start);
+        ImGui::SameLine();
+        ImGui::Text("Frame: %.3f ms", frame_ticks * ms_per_tick);
+
+        ImGui::Separator();
+        ImGui::BeginChild("FlameGraph", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+
+        ImDrawList* draw_list = ImGui::GetWindowDrawList();
+        const float width = ImGui::GetContentRegionAvail().x;
+
+        for(const raoe::profile::thread_capture& captured : state.captures)
+        {
+            ImGui::Text("Thread %u", captured.index);
+
+            //Only the zones that overlap the selected frame, and how deep they go
+            uint32 max_depth = 0;
+            for(const raoe::profile::zone_event& event : captured.events)
+            {
+                if(event.end >= frame.start && event.start <= frame.end)
+                {
+                    max_depth = std::max(max_depth, event.depth);
+                }
+            }
+
+            const ImVec2 origin = ImGui::GetCursorScreenPos();
+            const float rows_height = static_cast<float>(max_depth + 1) * RowHeight;
+            ImGui::Dummy(ImVec2(width, rows_height));
+
+            for(const raoe::profile::zone_event& event : captured.events)
+            {
+                if(event.end < frame.start || event.start > frame.end)
+                {
+                    continue;
+                }
+
+                const uint64 clamped_start = std::max(event.start, frame.start);
+                const uint64 clamped_end = std::min(event.end, frame.end);
+                const float x0 = origin.x + static_cast<float>(static_cast<double>(clamped_start - frame.start) / frame_ticks) * width;
+                const float x1 = origin.x + static_cast<float>(static_cast<double>(clamped_end - frame.start) / frame_ticks) * width;
+                const float y0 = origin.y + static_cast<float>(event.depth) * RowHeight;
+                const ImVec2 min(x0, y0);
+                const ImVec2 max(std::max(x1, x0 + 1.0F), y0 + RowHeight - 1.0F);
+
+                draw_list->AddRectFilled(min, max, zone_color(event.name));
+                if(max.x - min.x > 30.0F) //NOLINT only label zones wide enough to read
+                {
+                    draw_list->PushClipRect(min, max, true);
+                    draw_list->AddText(ImVec2(min.x + 2.0F, min.y + 1.0F), IM_COL32_BLACK, event.name.data(), event.name.data() + event.name.size());
+                    draw_list->PopClipRect();
+                }
+
+                if(ImGui::IsMouseHoveringRect(min, max))
+                {
+                    ImGui::SetTooltip("%.*s\n%.3f ms", static_cast<int32>(event.name.size()), event.name.data(), static_cast<double>(event.end - event.start) * ms_per_tick);
+                }
+            }
+        }
+
+        ImGui::EndChild();
+        ImGui::End();
+    }
+    //NOLINTEND(cppcoreguidelines-pro-type-vararg)
+}
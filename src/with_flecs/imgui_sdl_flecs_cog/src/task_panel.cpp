@@ -0,0 +1,122 @@
+/*
+Copyright 2022 Roy Awesome's Open Engine (RAOE)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "task_panel.hpp"
+#include "core.hpp"
+#include "engine.hpp"
+#include "services/task_service.hpp"
+#include "imgui.h"
+
+#include <algorithm>
+
+namespace RAOE::ECS::Imgui
+{
+    //imgui uses a lot of vararg functions.  
+    //NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+    void DrawTaskPanel(RAOE::Engine& engine, bool* p_open)
+    {
+        ImGui::SetNextWindowSize(ImVec2(900, 400), ImGuiCond_FirstUseEver); //NOLINT
+        if(!ImGui::Begin("Tasks", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        auto task_service = engine.get_service<RAOE::Service::TaskService>().lock();
+        if(!task_service)
+        {
+            ImGui::TextDisabled("There is no task service");
+            ImGui::End();
+            return;
+        }
+
+        std::vector<RAOE::task_stats> stats = task_service->collect_task_stats();
+        const double ms_per_tick = raoe::profile::ns_per_tick() / 1'000'000.0;
+
+        constexpr ImGuiTableFlags table_flags = ImGuiTableFlags_Sortable 
+            | ImGuiTableFlags_RowBg 
+            | ImGuiTableFlags_Borders 
+            | ImGuiTableFlags_Resizable 
+            | ImGuiTableFlags_ScrollY
+            ;
+
+        if(ImGui::BeginTable("Tasks", 7, table_flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Task");
+            ImGui::TableSetupColumn("Total ms", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("Max ms", ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("Resumes", ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("Priority");
+            ImGui::TableSetupColumn("Phase");
+            ImGui::TableSetupColumn("Waiting On");
+            ImGui::TableHeadersRow();
+
+            if(const ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs(); sort_specs && sort_specs->SpecsCount > 0)
+            {
+                const ImGuiTableColumnSortSpecs& spec = sort_specs->Specs[0];
+                auto sort_key = [&](const RAOE::task_stats& task) -> uint64 {
+                    switch(spec.ColumnIndex)
+                    {
+                        case 1: return task.total_ticks;
+                        case 2: return task.max_ticks;
+                        case 3: return task.resumes;
+                        case 4: return static_cast<uint64>(task.priority);
+                        case 5: return static_cast<uint64>(task.phase);
+                        default: return 0;
+                    }
+                };
+                std::ranges::stable_sort(stats, [&](const RAOE::task_stats& lhs, const RAOE::task_stats& rhs) {
+                    if(spec.ColumnIndex == 0)
+                    {
+                        return spec.SortDirection == ImGuiSortDirection_Ascending ? lhs.label() < rhs.label() : rhs.label() < lhs.label();
+                    }
+                    return spec.SortDirection == ImGuiSortDirection_Ascending ? sort_key(lhs) < sort_key(rhs) : sort_key(rhs) < sort_key(lhs);
+                });
+            }
+
+            for(const RAOE::task_stats& task : stats)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if(task.finished)
+                {
+                    ImGui::TextDisabled("%s (finished)", task.label().c_str());
+                }
+                else
+                {
+                    ImGui::TextUnformatted(task.label().c_str());
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", static_cast<double>(task.total_ticks) * ms_per_tick);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", static_cast<double>(task.max_ticks) * ms_per_tick);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(task.resumes));
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(RAOE::task_priority_name(task.priority).data());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(RAOE::task_phase_name(task.phase).data());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(task.waiting_on != nullptr ? task.waiting_on : "-");
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+    //NOLINTEND(cppcoreguidelines-pro-type-vararg)
+}
@@ -23,6 +23,8 @@ namespace RAOE::Gears
   
     struct SDLFLECSGear : public RAOE::Cogs::Gear
     {
+        using required_gears = std::tuple<FlecsGear>;
+
         SDLFLECSGear(RAOE::Cogs::BaseCog& in_cog, std::string_view in_name)
             : RAOE::Cogs::Gear(in_cog, in_name) 
         {}
@@ -36,4 +38,4 @@ namespace RAOE::Gears
     };
 }
 
-RAOE_DEFINE_GEAR(SDLGear, RAOE::Gears::SDLFLECSGear)
\ No newline at end of file
+RAOE_DEFINE_EAGER_GEAR(SDLGear, RAOE::Gears::SDLFLECSGear)
\ No newline at end of file
@@ -19,6 +19,7 @@ Copyright 2022 Roy Awesome's Open Engine (RAOE)
 #include "client_app_module.hpp"
 
 #include "flecs.h"
+#include "profile.hpp"
 
 namespace RAOE::ECS::SDL
 {
@@ -28,6 +29,7 @@ namespace RAOE::ECS::SDL
 
     void PollWindow(flecs::entity e, Events& events)
     {
+        RAOE_PROFILE_FUNCTION();
        events.events_this_frame.clear();
            
         SDL_Event event;
@@ -46,6 +48,7 @@ namespace RAOE::ECS::SDL
 
     void ClearRenderer(flecs::entity e, const System& sdl_system)
     {
+        RAOE_PROFILE_FUNCTION();
         if(sdl_system.renderer_handle)
         {
             SDL_SetRenderDrawColor(sdl_system.renderer_handle.get(), 0, 0, 0, SDL_ALPHA_OPAQUE);
@@ -55,6 +58,7 @@ namespace RAOE::ECS::SDL
 
     void PresentRender(flecs::entity e, const System& sdl_system)
     {
+        RAOE_PROFILE_FUNCTION();
         if(sdl_system.renderer_handle)
         {
             SDL_RenderPresent(sdl_system.renderer_handle.get());